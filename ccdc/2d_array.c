@@ -103,6 +103,49 @@ void **allocate_2d_array
 }
 
 
+/*************************************************************************
+NAME: set_2d_array_columns
+
+PURPOSE: Lay the rows of a 2D array out with fewer columns than it was
+         allocated with, in the same storage.
+
+RETURNS: SUCCESS or FAILURE
+
+NOTES: The rows are then contiguous at the new width, exactly as if the
+       array had been allocated with it; the data is not moved.  The
+       allocated width stays the limit of later calls.
+**************************************************************************/
+int set_2d_array_columns
+(
+    void **array_ptr, /* I/O: Pointer returned by the alloc routine */
+    int columns       /* I: Number of columns, at most the allocated ones */
+)
+{
+    int row;
+    LSRD_2D_ARRAY *array = GET_ARRAY_STRUCTURE_FROM_PTR (array_ptr);
+
+    if (array->signature != SIGNATURE)
+    {
+        RETURN_ERROR ("Invalid signature on 2D array - memory "
+                      "corruption or programming error?",
+                      "set_2d_array_columns", FAILURE);
+    }
+    if (columns < 1 || columns > array->columns)
+    {
+        RETURN_ERROR ("Columns larger than the allocated array",
+                      "set_2d_array_columns", FAILURE);
+    }
+
+    for (row = 0; row < array->rows; row++)
+    {
+        array->row_array_ptr[row] = array->data_ptr
+            + row * columns * array->member_size;
+    }
+
+    return SUCCESS;
+}
+
+
 /*************************************************************************
 NAME: free_2d_array
 
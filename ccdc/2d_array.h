@@ -21,6 +21,13 @@ int get_2d_array_size
 );
 
 
+int set_2d_array_columns
+(
+    void **array_ptr,     /* I/O: Pointer returned by the alloc routine */
+    int columns           /* I: Number of columns, at most the allocated */
+);
+
+
 int free_2d_array
 (
     void **array_ptr     /* I: Pointer returned by the alloc routine */
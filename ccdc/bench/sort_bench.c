@@ -0,0 +1,255 @@
+/******************************************************************************
+sort_bench: microbenchmarks of the shared sort routines (sort.c) against the
+quicksorts they replaced.
+
+Build and run from ccdc:  make sort_bench && ./sort_bench [repeats]
+
+For each input pattern and size, prints the mean time per sort in
+microseconds of the previous routine and of its replacement, and checks that
+both produce the same values (for the index sorts, the same keys and a
+permutation consistent with them).  The previous routines are copied below
+unchanged from misc.c and classification/qsort.c.
+******************************************************************************/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "sort.h"
+
+#include "../../classification/qsort.c"
+
+
+/* Previous misc.c quick_sort_float                                       */
+static int partition_float (float arr[], int left, int right)
+{
+    int i = left, j = right;
+    float tmp;
+    float pivot = arr[(left + right) / 2];
+
+    while (i <= j)
+    {
+        while (arr[i] < pivot)
+            i++;
+        while (arr[j] > pivot)
+            j--;
+        if (i <= j)
+        {
+            tmp = arr[i];
+            arr[i] = arr[j];
+            arr[j] = tmp;
+            i++;
+            j--;
+        }
+    }
+
+    return i;
+}
+
+static void quick_sort_float(float arr[], int left, int right)
+{
+    int index = partition_float (arr, left, right);
+
+    if (left < index - 1)
+        quick_sort_float (arr, left, index - 1);
+    if (index < right)
+        quick_sort_float (arr, index, right);
+}
+
+/* Previous misc.c quick_sort_int                                         */
+static int partition_int (int arr[], int left, int right)
+{
+    int i = left, j = right;
+    int tmp;
+    int pivot = arr[(left + right) / 2];
+
+    while (i <= j)
+    {
+        while (arr[i] < pivot)
+            i++;
+        while (arr[j] > pivot)
+            j--;
+        if (i <= j)
+        {
+            tmp = arr[i];
+            arr[i] = arr[j];
+            arr[j] = tmp;
+            i++;
+            j--;
+        }
+    }
+
+    return i;
+}
+
+static void quick_sort_int (int arr[], int left, int right)
+{
+    int index = partition_int (arr, left, right);
+
+    if (left < index - 1)
+        quick_sort_int (arr, left, index - 1);
+    if (index < right)
+        quick_sort_int (arr, index, right);
+}
+
+static int compare_double(const void *a, const void *b)
+{
+    double da = *(const double *)a;
+    double db = *(const double *)b;
+
+    return (da > db) - (da < db);
+}
+
+
+/* Input patterns                                                         */
+enum {RANDOM, SORTED, NEARLY_SORTED, REVERSED, ORGAN_PIPE, FEW_UNIQUE,
+      NUM_PATTERNS};
+static const char *pattern_name[NUM_PATTERNS] = {"random", "sorted",
+    "nearly_sorted", "reversed", "organ_pipe", "few_unique"};
+
+static double pattern_value(int pattern, int i, int n)
+{
+    switch (pattern)
+    {
+        case SORTED:
+            return 724000.0 + i;
+        case NEARLY_SORTED:
+            return 724000.0 + i + ((rand() % 100 == 0) ? rand() % 50 : 0);
+        case REVERSED:
+            return 724000.0 + n - i;
+        case ORGAN_PIPE:
+            return (i < n / 2) ? i : n - i;
+        case FEW_UNIQUE:
+            return rand() % 8;
+        default:
+            return (double)rand() / RAND_MAX * 20000.0 - 10000.0;
+    }
+}
+
+static double now_us(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e6 + ts.tv_nsec / 1e3;
+}
+
+
+int main(int argc, char *argv[])
+{
+    static const int sizes[] = {8, 64, 512, 4096, 65536};
+    int num_sizes = sizeof(sizes) / sizeof(sizes[0]);
+    int repeats = (argc > 1) ? atoi(argv[1]) : 20;
+    int p, s, r, i, n;
+    int bad = 0;
+    double t0, t_old[4], t_new[4];
+    double *src;
+    float *f_old, *f_new;
+    int *i_old, *i_new;
+    double *d_old, *d_new;
+    int *idx_old, *idx_new;
+
+    n = sizes[num_sizes - 1];
+    src = malloc(n * sizeof(double));
+    f_old = malloc(n * sizeof(float));
+    f_new = malloc(n * sizeof(float));
+    i_old = malloc(n * sizeof(int));
+    i_new = malloc(n * sizeof(int));
+    d_old = malloc(n * sizeof(double));
+    d_new = malloc(n * sizeof(double));
+    idx_old = malloc(n * sizeof(int));
+    idx_new = malloc(n * sizeof(int));
+    if (src == NULL || f_old == NULL || f_new == NULL || i_old == NULL ||
+        i_new == NULL || d_old == NULL || d_new == NULL || idx_old == NULL ||
+        idx_new == NULL)
+    {
+        fprintf(stderr, "sort_bench: out of memory\n");
+        return EXIT_FAILURE;
+    }
+
+    printf("%-14s %6s %12s %12s %12s %12s %12s %12s %12s %12s\n", "pattern",
+           "n", "qs_float", "sort_float", "qs_int", "sort_int", "qsort_dbl",
+           "sort_double", "R_qsort_I", "sort_dbl_idx");
+    srand(12345);
+    for (p = 0; p < NUM_PATTERNS; p++)
+    {
+        for (s = 0; s < num_sizes; s++)
+        {
+            n = sizes[s];
+            for (i = 0; i < 4; i++)
+                t_old[i] = t_new[i] = 0.0;
+            for (r = 0; r < repeats; r++)
+            {
+                for (i = 0; i < n; i++)
+                    src[i] = pattern_value(p, i, n);
+
+                for (i = 0; i < n; i++)
+                    f_old[i] = f_new[i] = (float)src[i];
+                t0 = now_us();
+                quick_sort_float(f_old, 0, n - 1);
+                t_old[0] += now_us() - t0;
+                t0 = now_us();
+                sort_float(f_new, n);
+                t_new[0] += now_us() - t0;
+                bad += (memcmp(f_old, f_new, n * sizeof(float)) != 0);
+
+                for (i = 0; i < n; i++)
+                    i_old[i] = i_new[i] = (int)src[i];
+                t0 = now_us();
+                quick_sort_int(i_old, 0, n - 1);
+                t_old[1] += now_us() - t0;
+                t0 = now_us();
+                sort_int(i_new, n);
+                t_new[1] += now_us() - t0;
+                bad += (memcmp(i_old, i_new, n * sizeof(int)) != 0);
+
+                memcpy(d_old, src, n * sizeof(double));
+                memcpy(d_new, src, n * sizeof(double));
+                t0 = now_us();
+                qsort(d_old, n, sizeof(double), compare_double);
+                t_old[2] += now_us() - t0;
+                t0 = now_us();
+                sort_double(d_new, n);
+                t_new[2] += now_us() - t0;
+                bad += (memcmp(d_old, d_new, n * sizeof(double)) != 0);
+
+                memcpy(d_old, src, n * sizeof(double));
+                memcpy(d_new, src, n * sizeof(double));
+                for (i = 0; i < n; i++)
+                    idx_old[i] = idx_new[i] = i + 1;
+                t0 = now_us();
+                R_qsort_I(d_old, idx_old, 1, n);
+                t_old[3] += now_us() - t0;
+                t0 = now_us();
+                sort_double_index(d_new, idx_new, n);
+                t_new[3] += now_us() - t0;
+                bad += (memcmp(d_old, d_new, n * sizeof(double)) != 0);
+                for (i = 0; i < n; i++)
+                    bad += (src[idx_new[i] - 1] != d_new[i]);
+            }
+            printf("%-14s %6d", pattern_name[p], n);
+            for (i = 0; i < 4; i++)
+                printf(" %12.2f %12.2f", t_old[i] / repeats,
+                       t_new[i] / repeats);
+            printf("\n");
+        }
+    }
+
+    free(src);
+    free(f_old);
+    free(f_new);
+    free(i_old);
+    free(i_new);
+    free(d_old);
+    free(d_new);
+    free(idx_old);
+    free(idx_new);
+
+    if (bad != 0)
+    {
+        printf("sort_bench: %d mismatches\n", bad);
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
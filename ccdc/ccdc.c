@@ -4,6 +4,7 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <sys/timeb.h>
+#include <pthread.h>
 
 #include "const.h"
 #include "2d_array.h"
@@ -11,10 +12,280 @@
 #include "input.h"
 #include "output.h"
 #include "ccdc.h"
+#include "cpu_dispatch.h"
+#include "fast_path.h"
+#include "neighbor.h"
+#include "sort.h"
+#include "out_buffer.h"
+#include "checkpoint.h"
+#include "pixel_state.h"
+#include "pool.h"
+#include "numa.h"
 #include "defines.h"
 
 const char scene_list_name[] = {"scene_list.txt"};  /* default, if none specified */
 int lasso_blist[NUM_LASSO_BANDS] = {1, 2, 3, 4, 5}; /* This is LASSO band index */
+int lazy_blist[NUM_LAZY_BANDS] = {0, 6};  /* Bands not used for change detection */
+
+/* A pixel loaded for change detection: its inputs, the buffers of the    */
+/* algorithm and the parameter independent stages, shared by all the     */
+/* parameter sets of a sweep.                                             */
+typedef struct
+{
+    int row, col;                    /* position of the pixel              */
+    char *out_path;                  /* directory of the output files      */
+    bool verbose;                    /* verbose flag                       */
+    bool std_out;                    /* output to stdout                   */
+    bool lazy_fit;                   /* fit lazy bands only for records    */
+    bool fast_path;                  /* stable curve shortcut              */
+    bool validate_fast_path;         /* full loop behind the shortcut      */
+    Precision_t precision;           /* precision policy of the kernels    */
+    int screen_cell;                 /* cell side of a screening run       */
+    bool record_cost;                /* append the cost of pixels          */
+    bool cost_only;                  /* only that, no change detection     */
+    int *fit_blist;                  /* bands refitted during monitoring   */
+    int num_fit_bands;               /* number of them                     */
+    int *all_blist;                  /* indices of all the bands           */
+    int valid_num_scenes;            /* number of valid scenes             */
+    int **buf;                       /* image bands of the valid scenes    */
+    unsigned char *updated_fmask_buf;/* cfmask of the valid scenes         */
+    int *updated_sdate_array;        /* dates of the valid scenes          */
+    int *id_range;                   /* scenes within the valid range      */
+    float clr_pct;                   /* percent clear cfmask pixels        */
+    float sn_pct;                    /* percent snow cfmask pixels         */
+    int clr_sum, water_sum, sn_sum;  /* clear (with water), water, snow    */
+    int all_sum;                     /* and non-fill cfmask counts         */
+    int *clrx;                       /* dates of the clear observations    */
+    float **clry;                    /* bands of the clear observations    */
+    Obs_store_t *obs;                /* live view of clrx, clry            */
+    Harmonic_basis_t *basis;         /* harmonic terms of every date       */
+    Season_index_t *season;          /* day-of-year index of the fit obs.  */
+    int *ids, *ids_old, *bl_ids;     /* observation index buffers          */
+    int *rmse_ids;                   /* fit obs. closest in season         */
+    float **fit_cft;                 /* fitted coefficients                */
+    float *rmse;                     /* rmse of each band                  */
+    float *vec_mag;                  /* squared z-score norm of the window */
+    float **v_dif_mag;               /* residuals of the window            */
+    float **rec_v_dif;               /* residuals of the fits              */
+    float **temp_v_dif;              /* residuals of the scratch fits      */
+    Out_buffer_t *out;               /* output of the pixel                */
+    bool variogram_done;             /* adj_rmse is computed               */
+    float adj_rmse[TOTAL_IMAGE_BANDS];/* median variogram of each band     */
+} Ccdc_pixel_t;
+
+/* The buffers a thread runs pixels with.                                 */
+typedef struct
+{
+    Ccdc_pixel_t px;                 /* pixel being run, the buffers       */
+    Obs_store_t obs;                 /* live view of clrx, clry            */
+    Harmonic_basis_t basis;          /* harmonic terms of every date       */
+    Season_index_t season;           /* day-of-year index of the fit obs.  */
+    int num_scenes;                  /* length of clrx, clry               */
+} Ccdc_workspace_t;
+
+/* A pixel of the block from read_pixel until its output is written: its  */
+/* inputs in px, and the records and counters of its run.                 */
+typedef struct
+{
+    Ccdc_pixel_t px;                 /* position, inputs of the pixel      */
+    Out_buffer_t out;                /* output of the pixel                */
+} Ccdc_slot_t;
+
+/* Neighbor warm starts: the curves of the last pixel run in each col of  */
+/* the block, per parameter set.                                          */
+typedef struct
+{
+    int block_cols;                  /* cols of the block                  */
+    Lasso_warm_t lasso_warm;         /* curves of the finished neighbors   */
+    Output_t **recs;                 /* [cfg * block_cols + col] curves    */
+    int *num_recs;                   /* their number                       */
+} Ccdc_neighbors_t;
+
+/* The pixels in flight of a block run, pixel blk in slot blk % num_slots, */
+/* and the workspace of each thread.                                      */
+typedef struct
+{
+    Ccdc_slot_t *slots;              /* pixels read and not yet written    */
+    int num_slots;                   /* number of them                     */
+    Ccdc_workspace_t *work;          /* [thread] buffers                   */
+    const Ccdc_params_t *params;     /* parameter sets of the run          */
+    int num_params;                  /* number of them                     */
+    Ccdc_neighbors_t *nb;            /* neighbor curves, NULL if not used  */
+    Checkpoint_t *cp;                /* checkpoint, NULL if not used       */
+    Out_files_t *files;              /* output files, NULL if kept in      */
+                                     /* memory                             */
+    int num_scenes;                  /* length of the pixel buffers        */
+    Harmonic_basis_t basis;          /* harmonic terms of every date of    */
+                                     /* the scenes, built once; day_row    */
+                                     /* NULL when each pixel has its own   */
+                                     /* dates (stdin)                      */
+    int max_conse;                   /* largest conse of the sets          */
+    int num_workers;                 /* threads; with NUMA placement, slot */
+                                     /* s is allocated by, and its pixels  */
+                                     /* queued to, thread s % num_workers  */
+} Ccdc_block_t;
+
+/* The write stage of a pipelined block run: a thread writing the pixels  */
+/* in block order as the pool finishes them, freeing their slots for the  */
+/* pixels main reads ahead.                                               */
+typedef struct
+{
+    Ccdc_block_t *block;             /* pixels of the run                  */
+    Pool_t *pool;                    /* pool running them                  */
+    pthread_t thread;                /* the writer                         */
+    pthread_mutex_t lock;            /* guards the fields below            */
+    pthread_cond_t changed;          /* a pixel was queued or written      */
+    int num_queued;                  /* pixels submitted to the pool, and  */
+    int num_written;                 /* written, their slots free; both    */
+                                     /* count the pixels skipped by resume */
+    bool end;                        /* no more pixels will be queued      */
+    int status;                      /* FAILURE once a pixel failed        */
+} Ccdc_writer_t;
+
+/* The opened input of a run, from which read_pixel loads the pixels of   */
+/* a block one at a time.                                                 */
+typedef struct
+{
+    bool std_in;                     /* input from stdin                   */
+    bool block;                      /* more than one pixel is read        */
+    char *data_type;                 /* tifs, bip                          */
+    int num_scenes;                  /* number of scenes of the list       */
+    char **scene_list;               /* sorted scene IDs                   */
+    char **valid_scene_list;         /* scene IDs of the valid scenes      */
+    int *sdate;                      /* dates of the scene list            */
+    Input_meta_t *meta;              /* ENVI header of the scenes          */
+    FILE ***fp_tifs;                 /* band file pointers, tifs           */
+    FILE **fp_bip;                   /* file pointers, bip                 */
+    unsigned char *fmask_buf;        /* cfmask of every scene              */
+    State_file_t *state;             /* series state, NULL if not kept     */
+} Ccdc_input_t;
+
+static void finish_pixel_inputs
+(
+    Ccdc_pixel_t *px,
+    int valid_num_scenes,
+    int clr_sum,
+    int water_sum,
+    int sn_sum,
+    int all_sum
+);
+
+static int load_pixel_arrays
+(
+    const Ccdc_arrays_t *arrays,
+    int blk,
+    Ccdc_pixel_t *px
+);
+
+static int run_parameter_set
+(
+    Ccdc_pixel_t *px,
+    const Ccdc_params_t *params,
+    int cfg,
+    int num_params,
+    Output_t **recs,
+    int *num_recs
+);
+
+static int alloc_pixel_inputs
+(
+    int num_scenes,
+    Ccdc_pixel_t *px
+);
+
+static void free_pixel_inputs
+(
+    Ccdc_pixel_t *px
+);
+
+static int alloc_workspace
+(
+    int num_scenes,
+    int max_conse,
+    Ccdc_workspace_t *ws
+);
+
+static void free_workspace
+(
+    Ccdc_workspace_t *ws
+);
+
+static void free_block
+(
+    Ccdc_block_t *block
+);
+
+static int run_pixel_task
+(
+    void *arg,
+    int worker,
+    int task
+);
+
+static int take_pixel_records
+(
+    Ccdc_block_t *block,
+    Pool_t *pool,
+    int task,
+    const char *path,
+    Output_t **recs,
+    int *num_recs,
+    int *max_recs
+);
+
+static int write_cost
+(
+    const Ccdc_pixel_t *px,
+    long usec
+);
+
+/* The stages of a run of main, left out of the library build.         */
+#ifndef CCDC_LIBRARY
+static int read_pixel
+(
+    Ccdc_input_t *in,
+    Ccdc_pixel_t *px
+);
+
+static int init_worker_task
+(
+    void *arg,
+    int worker,
+    int node
+);
+
+static int write_pixel
+(
+    Ccdc_block_t *block,
+    Pool_t *pool,
+    int task
+);
+
+static int writer_start
+(
+    Ccdc_block_t *block,
+    Pool_t *pool,
+    int first,
+    Ccdc_writer_t *writer
+);
+
+static int writer_wait_slot
+(
+    Ccdc_writer_t *writer,
+    int blk
+);
+
+static void writer_queue
+(
+    Ccdc_writer_t *writer
+);
+
+static int writer_stop
+(
+    Ccdc_writer_t *writer
+);
+#endif /* CCDC_LIBRARY */
+
 
 
 /******************************************************************************
@@ -111,124 +382,94 @@ second digit:
 8: model has 7 coefs + 1 const
 
 *******************************************************************************/
+/* Built with CCDC_LIBRARY, for the Python bindings (python/), the core */
+/* is linked without main and runs blocks through ccdc_run_arrays.     */
+#ifndef CCDC_LIBRARY
 int main (int argc, char *argv[])
 {
     char FUNC_NAME[] = "main";       /* For printing error messages           */
-    char msg_str[MAX_STR_LEN];       /* Input data scene name                 */
+    char msg_str[2 * MAX_STR_LEN];   /* Message, room for a path              */
     int status;                      /* Return value from function call       */
-    Output_t *rec_cg = NULL;         /* Output structure and metadata         */
-    bool verbose;                    /* Verbose flag for printing messages    */
-    int i, k, m, b, k_new;           /* Loop counters                         */
+    int len;                         /* Length snprintf wrote, or would have  */
+    bool verbose = false;            /* Verbose flag for printing messages    */
+    bool lazy_fit;                   /* Fit lazy bands only for curve records */
+    bool fit_band[TOTAL_IMAGE_BANDS];/* Bands refitted during monitoring      */
+    int fit_blist[TOTAL_IMAGE_BANDS];/* Indices of the fit_band bands         */
+    int num_fit_bands;               /* Number of them                        */
+    int all_blist[TOTAL_IMAGE_BANDS];/* Indices of all the bands              */
+    Precision_t precision;           /* Precision policy of the kernels       */
+    bool fast_path;                  /* Stable curve shortcut of monitoring   */
+    bool validate_fast_path;         /* Run the full loop behind the shortcut */
+    char sweep_file[MAX_STR_LEN];    /* Parameter sets of a sweep, optional   */
+    int log_level;                   /* Most verbose LOG_LEVEL_ written       */
+    char log_file[MAX_STR_LEN];      /* Log file name, optional               */
+    Ccdc_params_t *params;           /* Parameter sets of the run             */
+    int num_params;                  /* Number of them                        */
+    int max_conse;                   /* Largest conse of the parameter sets   */
+    int cfg;                         /* Parameter set being run               */
+    Ccdc_pixel_t px;                 /* Fields shared by the pixels           */
+    Ccdc_pixel_t *slot;              /* Slot the next pixel is read into      */
+    Ccdc_block_t block;              /* Slots and workspaces of the block     */
+    int num_slots;                   /* Number of pixels in flight            */
+    int num_threads;                 /* Number of threads running pixels      */
+    Pool_t pool;                     /* Their pool, with more than one        */
+    long steals;                     /* Pixels a pool thread took from another*/
+    long remote_steals;              /* Of them, from another NUMA node       */
+    bool numa;                       /* Place the buffers on NUMA nodes       */
+    bool numa_placed;                /* Placed, in a pipelined run            */
+    Numa_t nodes;                    /* The NUMA nodes                        */
+    int next_out;                    /* Next pixel to write                   */
+    int read_ahead;                  /* Pixels in flight asked for, 0 if auto */
+    int max_buffer_mb;               /* Cap of their buffers, 0 if none       */
+    long slot_bytes;                 /* Memory of a pixel in flight           */
+    bool pipelined;                  /* Read, run and write stages overlap    */
+    Ccdc_writer_t writer;            /* Write stage of a pipelined run        */
+    int checkpoint;                  /* Pixels between checkpoints, 0 if off  */
+    bool resume;                     /* Resume from the last checkpoint       */
+    Checkpoint_t cp;                 /* The checkpoint of the run             */
+    Out_files_t files;               /* Output files open during the run      */
+    char cp_key[CHECKPOINT_KEY_LEN]; /* Block, input and parameters it is of  */
+    unsigned long long digest;       /* Of the parameter sets and the scenes  */
+    char state_dir[MAX_STR_LEN];     /* Directory of the series states        */
+    bool update;                     /* Read only the scenes after the state  */
+    State_file_t state;              /* The series states of the block        */
+    char state_key[MAX_STR_LEN];     /* Block and input they are of           */
+    char tune_profile[MAX_STR_LEN];  /* Tuning profile applied, "" if none    */
+    int first;                       /* First pixel not done before resume    */
+    bool record_cost;                /* Append the cost of the pixels         */
+    bool cost_only;                  /* Only that, no change detection        */
+    Ccdc_input_t in;                 /* The opened input                      */
+    int screen_cell;                 /* Cell side of the screening pass       */
+    int block_rows, block_cols;      /* Size of the block of pixels run       */
+    int blk;                         /* Pixel of the block being run          */
+    int step;                        /* Row and col distance of two pixels    */
+    bool neighbor_warm_start;        /* Warm start lasso fits from neighbors  */
+    Ccdc_neighbors_t nb;             /* Curves of the finished neighbors      */
+    int i, k;                        /* Loop counters                         */
     char **scene_list = NULL;        /* 2-D array for list of scene IDs       */
     char **valid_scene_list = NULL;  /* 2-D array for list of filtered        */
                                      /* scene IDs                             */
     FILE *fd;                        /* File descriptor for file              */
                                      /* containing scene names                */
     int num_scenes = MAX_SCENE_LIST; /* Number of input scenes defined        */
-    int num_c = 8;                   /* Max number of coefficients for model  */
-    int num_fc = 0;                  /* Intialize NUM of Functional Curves    */
-    int rec_fc;                      /* Record num. of functional curves      */
-    float v_start[NUM_LASSO_BANDS];  /* Vector for start of observation(s)    */
-    float v_end[NUM_LASSO_BANDS];    /* Vector for end of observastion(s)     */
-    float v_slope[NUM_LASSO_BANDS];  /* Vector for anormalized slope values   */
-    float v_dif[NUM_LASSO_BANDS];    /* Vector for difference values          */
-    float **v_diff;
-    int *sdate;                      /* Pointer to list of acquisition dates  */
-    int *updated_sdate_array;        /* Sdate array after cfmask filtering    */
-    Input_meta_t *meta;              /* Structure for ENVI metadata hdr info  */
+    int *sdate = NULL;               /* Pointer to list of acquisition dates  */
+    Input_meta_t *meta = NULL;       /* Structure for ENVI metadata hdr info  */
     int row, col;                    /* The input indecies of the data frame. */
-    int clr_sum = 0;                 /* Total number of clear cfmask pixels   */
-    int sn_sum = 0;                  /* Total number of snow  cfmask pixels   */
-    int all_sum = 0;                 /* Total of all cfmask pixels            */
-    float sn_pct;                    /* Percent snow cfmask pixels            */
-    float clr_pct;                   /* Percent clear cfmask pixels           */
-    int n_sn = 0;                    /* Number of snow cfmask pixels          */
-    int n_clr = 0;                   /* Number of clear cfmask pixels         */
-    int *clrx;                       /* clear pixel curve in X direction ?    */
-    float **clry;                    /* clear pixel curve in Y direction ?    */
-    int *cpx;                        /* nunber of clear pixels X ?            */
-    float **cpy;                     /* nunber of clear pixels Y ?            */
-    int i_start;                     /* The first observation for TSFit       */
-    int end;                         /* The end of clear observations of total*/
-    float **fit_cft;                 /* Fitted coefficients 2-D array.        */
-    float *rmse;                     /* Root Mean Squared Error array.        */
-    int i_span;                      /* index for span of consecutive obs. ?  */
-    int update_num_c = 8;            /* Number of coefficients to update      */
-    int bl_train;                    /* Flag for which way to train the model.*/
-    float time_span;                 /* Span of time in no. of years.         */
-    int *bl_ids;
-    int *id_range;
-    int *ids;
-    int *ids_old;
-    int *rm_ids;
-    int rm_ids_len;
-    int i_rec;                       /* start of model before noise removal   */
-    float v_dif_norm = 0.0;
-    int i_count;                     /* Count difference of i each iteration  */
-    float **v_dif_mag;               /* vector for magnitude of differences.  */
-    int i_conse, i_b;
-    float *vec_mag; /* what is the differece */ /* they are used in 2 different branches */
-    float *vec_magg;/* these two?            */ /* this one is never freed */
-    float v_dif_mean;
-    float vec_magg_min;
-    float **rec_v_dif;
-    float **rec_v_dif_copy;
-    float **temp_v_dif;              /* for the thermal band.......           */
-    float adj_rmse[TOTAL_IMAGE_BANDS];/* Adjusted RMSE for all bands          */
-    float mini_rmse;                 /* Mimimum RMSE                          */
-    int bl_tmask; /* not used ? */
-    int n_rmse;                      /* number of RMSE values                 */
-    float tmpcg_rmse[NUM_LASSO_BANDS]; /* to temporarily change RMSE          */
-    int d_rt;
-    float *d_yr;
-    int id_last;                     /* The last stable id.                   */
-    float ts_pred_temp;
-    FILE *fp_bin_out;                /* Binary output file name.              */
-    int ids_old_len;
-    int i_break;                     /* for recording break points, i is index*/
-    int i_ini;                       /* for recording begin of time, i is index*/
-    int ini_conse;                   /* Initial CONSE.                        */
-    float break_mag;
-    int ids_len;                     /* number of ids, incremented continuously*/
-    unsigned char *fmask_buf;       /* cfmask pixel value array.              */
-    unsigned char *updated_fmask_buf;/*sub-set of fmask buf, valid pixels only*/
-    int **buf;                      /* This is the image bands buffer.        */
-    FILE ***fp_tifs;                /* Array of file pointers of multiple     */
+    unsigned char *fmask_buf = NULL;/* cfmask pixel value array.              */
+    FILE ***fp_tifs = NULL;         /* Array of file pointers of multiple     */
                                     /*     band files for specific dates.     */
-    FILE **fp_bip;                  /* Array of file pointers of BIP files    */
+    FILE **fp_bip = NULL;           /* Array of file pointers of BIP files    */
     char in_path[MAX_STR_LEN];      /* directory location of input data/files */
     char out_path[MAX_STR_LEN];     /* directory location for output files    */
     char data_type[MAX_STR_LEN];    /* tifs, bip. Future: bsq, "rods".        */
     char scene_list_filename[MAX_STR_LEN]; /* file name containing list of input sceneIDs */
     char scene_list_file[MAX_STR_LEN]; /* optional input argument for file of list of scenes */
     char tmpstr[MAX_STR_LEN];       /* char string for text manipulation      */
-    char output_binary[MAX_STR_LEN];/* directory and file name for output.bin */
-    int inputs_specified;        /* the number input scenes defined.          */
-    int valid_num_scenes;        /* number of scenes after cfmask counts and  */
-                                 /* swath overlap eliminated                  */
-    int water_sum = 0;           /* counter for cfmask water pixels.          */
-    int shadow_sum = 0;          /* counter for cfmask shadow pixels.         */
-    int cloud_sum = 0;           /* counter for cfmask cloud pixels.          */
-    int fill_sum = 0;            /* counter for cfmask fill pixels.           */
-    bool debug = 1;              /* This replaces the "ifdef 0" convention.   */
     bool std_in = 0;             /* For doing lots of ifs.  "stdin"           */
     bool std_out = 0;            /* and "stdout" are reserved words.          */
-    int prev_wrs_path = 0;       /* using the first of two scenes in a        */
-    int prev_wrs_row = 0;        /* swath, because it is recommended          */
-    int prev_year = 0;           /* to use the meta  data from the            */
-    int prev_jday = 0;           /* first for things like sun anle,           */
-    unsigned char prev_fmask_buf;/* etc. However, always removing a specific  */
-    int valid_scene_count = 0;   /* x/y location specified is not valid be-   */
-    int swath_overlap_count = 0; /* it may or may not be in an overlap area.  */
     time_t now;                  /* For logging the start, stop, and some     */
     time (&now);                 /*     intermediate times.                   */
 
-    if (verbose)
-    {
-        snprintf (msg_str, sizeof(msg_str), "CCDC version 05.01 start_time=%s\n", ctime (&now));
-        LOG_MESSAGE (msg_str, FUNC_NAME);
-    }
-
     /******************************************************************/
     /*                                                                */
     /* Initialize the input and output directory specification.       */
@@ -238,6 +479,7 @@ int main (int argc, char *argv[])
 
     strcpy(in_path, "");
     strcpy(out_path, "");
+    strcpy(sweep_file, "");
 
     /******************************************************************/
     /*                                                                */
@@ -246,7 +488,14 @@ int main (int argc, char *argv[])
     /******************************************************************/
 
     status = get_args (argc, argv, &row, &col, in_path, out_path, data_type,
-                       scene_list_file, &verbose);
+                       scene_list_file, &verbose, &lazy_fit, 
+                       &precision, &fast_path,
+                       &validate_fast_path, sweep_file, &screen_cell,
+                       &block_rows, &block_cols, &neighbor_warm_start,
+                       &log_level, log_file,
+                       &num_threads, &read_ahead, &max_buffer_mb,
+                       &record_cost, &cost_only, &checkpoint, &resume,
+                       state_dir, &update, tune_profile, &numa);
     if (status != SUCCESS)
     {
         RETURN_ERROR ("calling get_args", FUNC_NAME, EXIT_FAILURE);
@@ -254,176 +503,109 @@ int main (int argc, char *argv[])
 
     /******************************************************************/
     /*                                                                */
-    /* Check for stdin and stdout, and then allocate memory here, for */
-    /* pointers used in both stdin and file-system I/O branches,  and */
-    /* for pointers used in the ccdc algorithm portion for both cases.*/
-    /* Not all are used everywhere....                                */
+    /* Open the log.  With the records on stdout it goes to stderr,   */
+    /* so messages never mix with the values.                         */
     /*                                                                */
     /******************************************************************/
 
-    if (strcmp(in_path, "stdin") == 0)
-
+    status = log_open (log_file, (strcmp(out_path, "stdout") == 0) ?
+                       stderr : stdout, log_level);
+    if (status != SUCCESS)
     {
-        std_in = true;
-        valid_num_scenes = num_scenes; // worst case
-        // bdavis 
-        // therefore, need to move down all mallocs possible....
+        RETURN_ERROR ("Opening the log file", FUNC_NAME, EXIT_FAILURE);
     }
-    else
+    verbose = LOG_ENABLED(LOG_LEVEL_INFO);
+
+    if (verbose)
     {
-        valid_num_scenes = num_scenes; // worst case
+        snprintf (msg_str, sizeof(msg_str), "CCDC version 05.01 start_time=%s\n", ctime (&now));
+        LOG_MESSAGE (msg_str, FUNC_NAME);
+        if (strcmp(tune_profile, "") != 0)
+        {
+            snprintf (msg_str, sizeof(msg_str), "Tuning profile %s: "
+                      "threads=%d read-ahead=%d\n", tune_profile,
+                      num_threads, read_ahead);
+            LOG_MESSAGE (msg_str, FUNC_NAME);
+        }
     }
 
-    if (strcmp(out_path, "stdout") == 0)
+    /******************************************************************/
+    /*                                                                */
+    /* Read the parameter sets: the defines.h thresholds, or every    */
+    /* line of the sweep file.                                        */
+    /*                                                                */
+    /******************************************************************/
+
+    if (strcmp(sweep_file, "") == 0)
     {
-        std_out = true;
-        verbose = false;
-        debug = false;
+        params = malloc(sizeof(Ccdc_params_t));
+        if (params == NULL)
+            RETURN_ERROR("ERROR allocating params memory", FUNC_NAME, FAILURE);
+        default_ccdc_params(params);
+        num_params = 1;
+    }
+    else
+    {
+        status = read_sweep_file(sweep_file, &params, &num_params);
+        if (status != SUCCESS)
+            RETURN_ERROR("Calling read_sweep_file", FUNC_NAME, FAILURE);
     }
 
-    updated_fmask_buf = malloc(valid_num_scenes * sizeof(unsigned char));
-    if (updated_fmask_buf == NULL)
+    /* The CONSE window buffers are as wide as the largest conse.         */
+    max_conse = 0;
+    for (cfg = 0; cfg < num_params; cfg++)
     {
-        RETURN_ERROR("ERROR allocating updated_fmask_buf memory", FUNC_NAME, FAILURE);
+        if (params[cfg].conse > max_conse)
+            max_conse = params[cfg].conse;
     }
 
-    updated_sdate_array = malloc(valid_num_scenes * sizeof(int));
-    if (updated_sdate_array == NULL)
+    if (verbose)
     {
-        RETURN_ERROR("ERROR allocating updated_sdate memory", FUNC_NAME, FAILURE);
+        snprintf (msg_str, sizeof(msg_str), "CPU kernel variant=%s\n",
+                  cpu_dispatch_variant());
+        LOG_MESSAGE (msg_str, FUNC_NAME);
     }
 
     /******************************************************************/
     /*                                                                */
-    /* Allocate memory here, for pointers only used in the stdin I/O  */
-    /* branch.                                                        */
+    /* With lazy fitting, only the change detection bands are refit   */
+    /* while a curve is being monitored.                              */
     /*                                                                */
     /******************************************************************/
 
-    if (std_in)
+    for (k = 0; k < TOTAL_IMAGE_BANDS; k++)
+        fit_band[k] = !lazy_fit;
+    for (k = 0; k < NUM_LASSO_BANDS; k++)
+        fit_band[lasso_blist[k]] = true;
 
+    num_fit_bands = 0;
+    for (k = 0; k < TOTAL_IMAGE_BANDS; k++)
     {
+        all_blist[k] = k;
+        if (fit_band[k])
+            fit_blist[num_fit_bands++] = k;
+    }
 
-        buf = (int **) allocate_2d_array (TOTAL_IMAGE_BANDS, valid_num_scenes, sizeof (int));
-        if (buf == NULL)
-        {
-            RETURN_ERROR ("Allocating buf memory", FUNC_NAME, FAILURE);
-        }
-
-        ids = (int *)calloc(valid_num_scenes, sizeof(int));
-        if (ids == NULL)
-        {
-            RETURN_ERROR("ERROR allocating ids memory", FUNC_NAME, FAILURE);
-        }
-    
-        ids_old = (int *)calloc(valid_num_scenes, sizeof(int));
-        if (ids_old == NULL)
-        {
-            RETURN_ERROR("ERROR allocating ids_old memory", FUNC_NAME, FAILURE);
-        }
-    
-        bl_ids = (int *)calloc(valid_num_scenes, sizeof(int));
-        if (bl_ids == NULL)
-        {
-            RETURN_ERROR("ERROR allocating bl_ids memory", FUNC_NAME, FAILURE);
-        }
-
-        rm_ids = (int *)calloc(valid_num_scenes, sizeof(int));
-        if (rm_ids == NULL)
-        {
-            RETURN_ERROR("ERROR allocating rm_ids memory", FUNC_NAME, FAILURE);
-        }
-
-        clrx = malloc(valid_num_scenes * sizeof(int));
-        if (clrx == NULL)
-        {
-            RETURN_ERROR("ERROR allocating clrx memory", FUNC_NAME, FAILURE);
-        }
-
-        clry = (float **) allocate_2d_array (TOTAL_IMAGE_BANDS, valid_num_scenes,
-                                             sizeof (float));
-        if (clry == NULL)
-        {
-            RETURN_ERROR ("Allocating clry memory", FUNC_NAME, FAILURE);
-        }
-
-        id_range = (int *)calloc(valid_num_scenes, sizeof(int));
-        if (id_range == NULL)
-        {
-            RETURN_ERROR("ERROR allocating id_range memory", FUNC_NAME, FAILURE);
-        }
-
-        temp_v_dif = (float **)allocate_2d_array(TOTAL_IMAGE_BANDS, valid_num_scenes,
-                                         sizeof (float));
-        if (temp_v_dif == NULL)
-        {
-            RETURN_ERROR ("Allocating temp_v_dif memory",FUNC_NAME, FAILURE);
-        }
-
-        fit_cft = (float **) allocate_2d_array (TOTAL_IMAGE_BANDS, MAX_NUM_C, 
-                                             sizeof (float));
-        if (fit_cft == NULL)
-        {
-            RETURN_ERROR ("Allocating fit_cft memory", FUNC_NAME, FAILURE);
-        }
-
-        rmse = (float *)calloc(TOTAL_IMAGE_BANDS, sizeof(float));
-        if (rmse == NULL)
-        {
-            RETURN_ERROR ("Allocating rmse memory", FUNC_NAME, FAILURE);
-        }
-
-        vec_mag = (float *)calloc(NUM_LASSO_BANDS, sizeof(float));
-        if (vec_mag == NULL)
-        {
-            RETURN_ERROR ("Allocating vec_mag memory", FUNC_NAME, FAILURE);
-        }
-    
-        v_dif_mag = (float **) allocate_2d_array(TOTAL_IMAGE_BANDS, CONSE,
-                    sizeof (float));
-        if (v_dif_mag == NULL)
-        {
-            RETURN_ERROR ("Allocating v_dif_mag memory", 
-                                     FUNC_NAME, FAILURE);
-        }
-    
-        rec_v_dif = (float **)allocate_2d_array(TOTAL_IMAGE_BANDS, valid_num_scenes,
-                                         sizeof (float));
-        if (rec_v_dif == NULL)
-        {
-            RETURN_ERROR ("Allocating rec_v_dif memory",FUNC_NAME, FAILURE);
-        }
-        rec_v_dif_copy = (float **)allocate_2d_array(TOTAL_IMAGE_BANDS, valid_num_scenes,
-                                         sizeof (float));
-        if (rec_v_dif_copy == NULL)
-        {
-            RETURN_ERROR ("Allocating rec_v_dif_copy memory",FUNC_NAME, FAILURE);
-        }
-    
-        /**************************************************************/
-        /*                                                            */
-        /* For stdin:                                                 */
-        /* This assumes order of: julian date value, then 6 SR and 1  */
-        /* thermal band values, then cfmask band values, each         */
-        /* set/group together, culiminated with a newline per scene,  */
-        /* for number of scenes. For example:                         */
-        /* 2456445 94 156 164 758 807 492 2809 0                      */
-        /*                                                            */
-        /**************************************************************/
+    /******************************************************************/
+    /*                                                                */
+    /* Check for stdin and stdout, and then allocate memory here, for */
+    /* pointers used in both stdin and file-system I/O branches,  and */
+    /* for pointers used in the ccdc algorithm portion for both cases.*/
+    /* Not all are used everywhere....                                */
+    /*                                                                */
+    /******************************************************************/
 
-        status = read_stdin (updated_sdate_array, buf, updated_fmask_buf,
-                             TOTAL_IMAGE_BANDS, &clr_sum, &water_sum,
-                             &shadow_sum, &sn_sum, &cloud_sum, &fill_sum,
-                             &all_sum, &valid_num_scenes, debug);
-        if (status != SUCCESS)
-        {
-            RETURN_ERROR ("reading stdin",FUNC_NAME, FAILURE);
-        }
-        inputs_specified = all_sum;
+    if (strcmp(in_path, "stdin") == 0)
+    {
+        std_in = true;
+    }
 
-    }   // end of if std_in
+    if (strcmp(out_path, "stdout") == 0)
+    {
+        std_out = true;
+    }
 
-    else
+    if (!std_in)
 
     {   // start of not std_in
 
@@ -495,7 +677,6 @@ int main (int argc, char *argv[])
             strcat(scene_list[i], tmpstr);
         }
         num_scenes = i;
-        inputs_specified = num_scenes;
         
         /**************************************************************/
         /*                                                            */
@@ -517,11 +698,8 @@ int main (int argc, char *argv[])
         /*                                                            */
         /**************************************************************/
 
-        if (verbose)
-        {
-            printf("num_scenes %d\n", num_scenes);
-            printf("scene_list[0]=%s\n", scene_list[0]);
-        }
+        LOG_DEBUG("num_scenes %d\n", num_scenes);
+        LOG_DEBUG("scene_list[0]=%s\n", scene_list[0]);
         status = sort_scene_based_on_year_doy_row(scene_list, num_scenes, sdate);
         if (status != SUCCESS)
         {
@@ -529,18 +707,6 @@ int main (int argc, char *argv[])
                           FUNC_NAME, FAILURE);
         }
     
-        /**************************************************************/
-        /*                                                            */
-        /* Do all of the memory allocations for buffers/arrays which  */
-        /* are required to do the reading of files for pixel value    */
-        /* assessment and storage. Fill value and "pixel overlap"     */
-        /* pixels will not be saved and used to update counters.      */
-        /* Also, do the remaining allocations for all buffers/arrays  */
-        /* necessary for the ccdc algorithm, because after filling the*/
-        /* band data arrays here, that will be the next step.         */
-        /*                                                            */
-        /******************************************************************/
-
         /**************************************************************/
         /*                                                            */
         /* Allocate memory for fp_tifs and all the pointers required   */
@@ -565,109 +731,13 @@ int main (int argc, char *argv[])
                 RETURN_ERROR ("Allocating fp_bip memory", FUNC_NAME, FAILURE);
             }
         }
-    
-        clrx = malloc(num_scenes * sizeof(int));
-        if (clrx == NULL)
-        {
-            RETURN_ERROR("ERROR allocating clrx memory", FUNC_NAME, FAILURE);
-        }
-    
+
         fmask_buf = malloc(num_scenes * sizeof(unsigned char));
         if (fmask_buf == NULL)
         {
             RETURN_ERROR("ERROR allocating fmask_buf memory", FUNC_NAME, FAILURE);
         }
-    
-        id_range = (int *)calloc(num_scenes, sizeof(int));
-        if (id_range == NULL)
-        {
-            RETURN_ERROR("ERROR allocating id_range memory", FUNC_NAME, FAILURE);
-        }
-    
-        ids = (int *)calloc(num_scenes, sizeof(int));
-        if (ids == NULL)
-        {
-            RETURN_ERROR("ERROR allocating ids memory", FUNC_NAME, FAILURE);
-        }
-    
-        ids_old = (int *)calloc(num_scenes, sizeof(int));
-        if (ids_old == NULL)
-        {
-            RETURN_ERROR("ERROR allocating ids_old memory", FUNC_NAME, FAILURE);
-        }
-    
-        bl_ids = (int *)calloc(num_scenes, sizeof(int));
-        if (bl_ids == NULL)
-        {
-            RETURN_ERROR("ERROR allocating bl_ids memory", FUNC_NAME, FAILURE);
-        }
-    
-        rm_ids = (int *)calloc(num_scenes, sizeof(int));
-        if (rm_ids == NULL)
-        {
-            RETURN_ERROR("ERROR allocating rm_ids memory", FUNC_NAME, FAILURE);
-        }
-    
-        clry = (float **) allocate_2d_array (TOTAL_IMAGE_BANDS, num_scenes,
-                                             sizeof (float));
-        if (clry == NULL)
-        {
-            RETURN_ERROR ("Allocating clry memory", FUNC_NAME, FAILURE);
-        }
-    
-        fit_cft = (float **) allocate_2d_array (TOTAL_IMAGE_BANDS, MAX_NUM_C, 
-                                             sizeof (float));
-        if (fit_cft == NULL)
-        {
-            RETURN_ERROR ("Allocating fit_cft memory", FUNC_NAME, FAILURE);
-        }
-    
-        rmse = (float *)calloc(TOTAL_IMAGE_BANDS, sizeof(float));
-        if (rmse == NULL)
-        {
-            RETURN_ERROR ("Allocating rmse memory", FUNC_NAME, FAILURE);
-        }
-    
-        vec_mag = (float *)calloc(NUM_LASSO_BANDS, sizeof(float));
-        if (vec_mag == NULL)
-        {
-            RETURN_ERROR ("Allocating vec_mag memory", FUNC_NAME, FAILURE);
-        }
-    
-        v_dif_mag = (float **) allocate_2d_array(TOTAL_IMAGE_BANDS, CONSE,
-                    sizeof (float));
-        if (v_dif_mag == NULL)
-        {
-            RETURN_ERROR ("Allocating v_dif_mag memory", 
-                                     FUNC_NAME, FAILURE);
-        }
-    
-        rec_v_dif = (float **)allocate_2d_array(TOTAL_IMAGE_BANDS, num_scenes,
-                                         sizeof (float));
-        if (rec_v_dif == NULL)
-        {
-            RETURN_ERROR ("Allocating rec_v_dif memory",FUNC_NAME, FAILURE);
-        }
-        rec_v_dif_copy = (float **)allocate_2d_array(TOTAL_IMAGE_BANDS, valid_num_scenes,
-                                         sizeof (float));
-        if (rec_v_dif_copy == NULL)
-        {
-            RETURN_ERROR ("Allocating rec_v_dif_copy memory",FUNC_NAME, FAILURE);
-        }
-    
-        temp_v_dif = (float **)allocate_2d_array(TOTAL_IMAGE_BANDS, num_scenes,
-                                         sizeof (float));
-        if (temp_v_dif == NULL)
-        {
-            RETURN_ERROR ("Allocating temp_v_dif memory",FUNC_NAME, FAILURE);
-        }
-    
-        buf = (int **) allocate_2d_array (TOTAL_BANDS, num_scenes, sizeof (int));
-        if (buf == NULL)
-        {
-            RETURN_ERROR ("Allocating buf memory", FUNC_NAME, FAILURE);
-        }
-    
+
         /**************************************************************/
         /*                                                            */
         /* Create the Input metadata structure.                       */
@@ -699,26 +769,1420 @@ int main (int argc, char *argv[])
             RETURN_ERROR ("Calling read_envi_header", 
                           FUNC_NAME, FAILURE);
         }
-    
-        /******************************************************************/
-        /*                                                                */
-        /* Read the cfmask file first, determine which pixels are valid.  */
-        /*   0: clear                                                     */
-        /*   1: water                                                     */
-        /*   2: cloudShadow                                               */
-        /*   3: snow                                                      */
-        /*   4: cloud                                                     */
-        /* 255: CFMASK_FILL                                               */
-        /*                                                                */
-        /* This will determine whether or not to use this pixel, which    */
-        /* then requires subsequent reading of image bands.               */
-        /*                                                                */
-        /* While reading, update the counters for clear, water, cloud,    */
-        /* and snow, essentially skipping over fill values,               */
-        /* and update the number of "scenes" so that only the data bands  */
-        /* buffer and date information array are filled with values from  */
-        /* from valid "scenes".                                           */
-        /*                                                                */
+
+    } // end of elseif stdin bracket, meaning not stdin, read cfmask and image files
+
+    /******************************************************************/
+    /*                                                                */
+    /* The pixel fields shared by the whole block.                    */
+    /*                                                                */
+    /******************************************************************/
+
+    in.std_in = std_in;
+    in.block = (block_rows * block_cols > 1);
+    in.data_type = data_type;
+    in.num_scenes = num_scenes;
+    in.scene_list = scene_list;
+    in.valid_scene_list = valid_scene_list;
+    if (!std_in)
+    {
+        in.sdate = sdate;
+        in.meta = meta;
+        in.fp_tifs = fp_tifs;
+        in.fp_bip = fp_bip;
+        in.fmask_buf = fmask_buf;
+    }
+
+    /******************************************************************/
+    /*                                                                */
+    /* The series states: read_pixel writes the state of each pixel,  */
+    /* and updating starts from the previous one.                     */
+    /*                                                                */
+    /******************************************************************/
+
+    in.state = NULL;
+    if (strcmp(state_dir, "") != 0)
+    {
+        len = snprintf(state_key, sizeof(state_key), "row=%d col=%d "
+                       "block-rows=%d block-cols=%d screen-cell=%d "
+                       "data-type=%s", row, col, block_rows, block_cols,
+                       screen_cell, data_type);
+        if (len < 0 || len >= (int)sizeof(state_key))
+        {
+            RETURN_ERROR ("State key too long", FUNC_NAME, FAILURE);
+        }
+        status = state_open(state_dir, row, col, state_key, update, &state);
+        if (status != SUCCESS)
+        {
+            RETURN_ERROR ("Calling state_open", FUNC_NAME, FAILURE);
+        }
+        in.state = &state;
+    }
+
+    memset(&px, 0, sizeof(Ccdc_pixel_t));
+    px.out_path = out_path;
+    px.verbose = verbose;
+    px.std_out = std_out;
+    px.lazy_fit = lazy_fit;
+    px.fast_path = fast_path;
+    px.validate_fast_path = validate_fast_path;
+    px.precision = precision;
+    px.fit_blist = fit_blist;
+    px.num_fit_bands = num_fit_bands;
+    px.all_blist = all_blist;
+    px.screen_cell = screen_cell;
+    px.record_cost = record_cost;
+    px.cost_only = cost_only;
+
+    /******************************************************************/
+    /*                                                                */
+    /* Allocate the buffers: a slot per pixel in flight, holding its  */
+    /* inputs and its output, and a workspace per thread.  With more  */
+    /* than one slot the run is pipelined: main reads ahead into the  */
+    /* free slots while the pool runs the pixels and the writer       */
+    /* thread writes them.  With one, main runs each pixel as soon as */
+    /* it is read.  The output of a pixel is counted as NUM_FC curves */
+    /* of every parameter set, its usual most.                        */
+    /*                                                                */
+    /******************************************************************/
+
+    if (read_ahead > 0)
+        num_slots = read_ahead;
+    else if (num_threads > 1)
+        num_slots = num_threads * POOL_TASKS_PER_THREAD;
+    else
+        num_slots = 1;
+    slot_bytes = (long)num_scenes * (TOTAL_BANDS * sizeof(int) +
+                 sizeof(unsigned char) + 2 * sizeof(int)) +
+                 (long)num_params * NUM_FC * sizeof(Output_t);
+    if (max_buffer_mb > 0)
+    {
+        if ((long)max_buffer_mb * 1024 * 1024 < slot_bytes)
+        {
+            snprintf (msg_str, sizeof(msg_str), "max-buffer-mb is less than "
+                      "the %ld bytes of one pixel", slot_bytes);
+            RETURN_ERROR (msg_str, FUNC_NAME, FAILURE);
+        }
+        if ((long)num_slots * slot_bytes > (long)max_buffer_mb * 1024 * 1024)
+            num_slots = (long)max_buffer_mb * 1024 * 1024 / slot_bytes;
+    }
+    pipelined = (num_threads > 1 || num_slots > 1);
+    if (verbose)
+    {
+        snprintf (msg_str, sizeof(msg_str), "Pixels in flight=%d of %ld "
+                  "bytes, pipelined=%d\n", num_slots, slot_bytes, pipelined);
+        LOG_MESSAGE (msg_str, FUNC_NAME);
+    }
+
+    /******************************************************************/
+    /*                                                                */
+    /* NUMA placement: the pool threads are pinned to the nodes, and  */
+    /* each allocates its workspace and the slots it is handed, so    */
+    /* their pages are on the node of the thread computing them.      */
+    /*                                                                */
+    /******************************************************************/
+
+    numa_placed = (numa && pipelined);
+    if (numa_placed)
+    {
+        status = numa_open(NUMA_SYSFS, &nodes);
+        if (status != SUCCESS)
+        {
+            RETURN_ERROR ("Calling numa_open", FUNC_NAME, FAILURE);
+        }
+        if (verbose)
+        {
+            snprintf (msg_str, sizeof(msg_str), "NUMA nodes=%d\n",
+                      nodes.num_nodes);
+            LOG_MESSAGE (msg_str, FUNC_NAME);
+        }
+    }
+
+    block.num_slots = num_slots;
+    block.slots = calloc(num_slots, sizeof(Ccdc_slot_t));
+    block.work = calloc(num_threads, sizeof(Ccdc_workspace_t));
+    if (block.slots == NULL || block.work == NULL)
+    {
+        RETURN_ERROR ("Allocating block memory", FUNC_NAME, FAILURE);
+    }
+    for (i = 0; i < num_slots; i++)
+    {
+        block.slots[i].px = px;
+        if (!numa_placed)
+        {
+            status = alloc_pixel_inputs(num_scenes, &block.slots[i].px);
+            if (status != SUCCESS)
+            {
+                RETURN_ERROR ("Calling alloc_pixel_inputs", FUNC_NAME,
+                              FAILURE);
+            }
+        }
+        out_buffer_init(&block.slots[i].out);
+        block.slots[i].px.out = &block.slots[i].out;
+    }
+    for (i = 0; i < num_threads; i++)
+    {
+        block.work[i].px = px;
+        if (!numa_placed)
+        {
+            status = alloc_workspace(num_scenes, max_conse, &block.work[i]);
+            if (status != SUCCESS)
+            {
+                RETURN_ERROR ("Calling alloc_workspace", FUNC_NAME, FAILURE);
+            }
+        }
+    }
+    block.num_scenes = num_scenes;
+    block.max_conse = max_conse;
+    block.num_workers = num_threads;
+    block.params = params;
+    block.num_params = num_params;
+    block.nb = NULL;
+    out_files_init(&files);
+    block.files = &files;
+
+    /* The dates of every pixel read from files are some of the scenes, */
+    /* so their harmonic terms are computed once, for the scenes.  On   */
+    /* stdin each pixel comes with its dates and builds its own terms. */
+    memset(&block.basis, 0, sizeof(Harmonic_basis_t));
+    if (!std_in && num_scenes > 0)
+    {
+        status = build_harmonic_basis(sdate, num_scenes, precision,
+                                      &block.basis);
+        if (status != SUCCESS)
+        {
+            RETURN_ERROR ("Calling build_harmonic_basis", FUNC_NAME,
+                          FAILURE);
+        }
+    }
+
+    /******************************************************************/
+    /*                                                                */
+    /* With neighbor warm starts, the curves of the last pixel run in */
+    /* each col of the block are kept: the left and the upper         */
+    /* neighbor of the next pixel.                                    */
+    /*                                                                */
+    /******************************************************************/
+
+    if (neighbor_warm_start)
+    {
+        nb.block_cols = block_cols;
+        nb.recs = calloc(num_params * block_cols, sizeof(Output_t *));
+        nb.num_recs = calloc(num_params * block_cols, sizeof(int));
+        if (nb.recs == NULL || nb.num_recs == NULL)
+        {
+            RETURN_ERROR ("Allocating neighbor curves memory", FUNC_NAME,
+                          FAILURE);
+        }
+        block.nb = &nb;
+    }
+
+    /******************************************************************/
+    /*                                                                */
+    /* Checkpoints: resumed, the pixels written before the last one   */
+    /* are skipped.  The key ties a checkpoint to the block, the      */
+    /* input and the values of every parameter set; the sets and the  */
+    /* scene IDs, any number of them, go in as a digest.              */
+    /*                                                                */
+    /******************************************************************/
+
+    block.cp = NULL;
+    first = 0;
+    if (checkpoint > 0)
+    {
+        digest = CHECKPOINT_DIGEST_INIT;
+        for (cfg = 0; cfg < num_params; cfg++)
+        {
+            snprintf(tmpstr, sizeof(tmpstr), "%.17g %.17g %d %.17g %d %d",
+                     params[cfg].t_cg, params[cfg].t_max_cg,
+                     params[cfg].conse, params[cfg].lambda,
+                     params[cfg].n_times, params[cfg].min_num_c);
+            digest = checkpoint_digest(digest, tmpstr);
+        }
+        for (i = 0; !std_in && i < num_scenes; i++)
+            digest = checkpoint_digest(digest, valid_scene_list[i]);
+        len = snprintf(cp_key, sizeof(cp_key), "row=%d col=%d block-rows=%d "
+                       "block-cols=%d screen-cell=%d data-type=%s in-path=%s "
+                       "precision=%s scenes=%d params=%d digest=%016llx",
+                       row, col, block_rows, block_cols, screen_cell,
+                       data_type, in_path, (precision == PRECISION_SINGLE) ?
+                       "single" : "double", std_in ? 0 : num_scenes,
+                       num_params, digest);
+        if (len < 0 || len >= (int)sizeof(cp_key))
+        {
+            RETURN_ERROR ("Checkpoint key too long", FUNC_NAME, FAILURE);
+        }
+        status = checkpoint_open(out_path, cp_key, checkpoint, resume, &cp);
+        if (status != SUCCESS)
+        {
+            RETURN_ERROR ("Calling checkpoint_open", FUNC_NAME, FAILURE);
+        }
+        block.cp = &cp;
+        first = cp.num_done;
+        if (verbose && resume)
+        {
+            snprintf (msg_str, sizeof(msg_str), "Resuming at pixel %d\n",
+                      first);
+            LOG_MESSAGE (msg_str, FUNC_NAME);
+        }
+    }
+
+    if (pipelined)
+    {
+        status = pool_create(num_threads, num_slots, run_pixel_task,
+                             numa_placed ? init_worker_task : NULL, &block,
+                             numa_placed ? &nodes : NULL, &pool);
+        if (status != SUCCESS)
+        {
+            RETURN_ERROR ("Calling pool_create", FUNC_NAME, FAILURE);
+        }
+        status = writer_start(&block, &pool, first, &writer);
+        if (status != SUCCESS)
+        {
+            RETURN_ERROR ("Calling writer_start", FUNC_NAME, FAILURE);
+        }
+    }
+
+    /******************************************************************/
+    /*                                                                */
+    /* Run the pixels of the block in row then col order; from stdin, */
+    /* until the input ends.  The output of a pixel is written once   */
+    /* the pixels before it are out, and its slot then takes the      */
+    /* pixel num_slots after it.                                      */
+    /*                                                                */
+    /******************************************************************/
+
+    step = screen_cell;
+    next_out = first;
+    for (blk = 0; blk < block_rows * block_cols; blk++)
+    {
+        if (blk < first)
+        {
+            /* Written before the checkpoint; from stdin, read past it. */
+            if (std_in)
+            {
+                slot = &block.slots[0].px;
+                status = read_pixel(&in, slot);
+                if (status != SUCCESS)
+                {
+                    RETURN_ERROR ("Calling read_pixel", FUNC_NAME, FAILURE);
+                }
+                if (blk > 0 && slot->valid_num_scenes == 0)
+                    break;
+            }
+            continue;
+        }
+
+        if (pipelined)
+        {
+            status = writer_wait_slot(&writer, blk);
+            if (status != SUCCESS)
+            {
+                RETURN_ERROR ("Calling writer_wait_slot", FUNC_NAME, FAILURE);
+            }
+        }
+        else if (blk - next_out == num_slots)
+        {
+            status = write_pixel(&block, NULL, next_out++);
+            if (status != SUCCESS)
+            {
+                RETURN_ERROR ("Calling write_pixel", FUNC_NAME, FAILURE);
+            }
+        }
+
+        slot = &block.slots[blk % num_slots].px;
+        slot->row = row + (blk / block_cols) * step;
+        slot->col = col + (blk % block_cols) * step;
+
+        status = read_pixel(&in, slot);
+        if (status != SUCCESS)
+        {
+            RETURN_ERROR ("Calling read_pixel", FUNC_NAME, FAILURE);
+        }
+        if (std_in && blk > 0 && slot->valid_num_scenes == 0)
+            break;
+
+        if (pipelined)
+        {
+            if (numa_placed)
+                pool_submit_to(&pool, blk, (blk % num_slots) % num_threads);
+            else
+                pool_submit(&pool, blk);
+            writer_queue(&writer);
+        }
+        else
+        {
+            status = run_pixel_task(&block, 0, blk);
+            if (status != SUCCESS)
+            {
+                RETURN_ERROR ("Calling run_pixel_task", FUNC_NAME, FAILURE);
+            }
+        }
+    }
+
+    while (!pipelined && next_out < blk)
+    {
+        status = write_pixel(&block, NULL, next_out++);
+        if (status != SUCCESS)
+        {
+            RETURN_ERROR ("Calling write_pixel", FUNC_NAME, FAILURE);
+        }
+    }
+
+    if (pipelined)
+    {
+        status = writer_stop(&writer);
+        if (status != SUCCESS)
+        {
+            RETURN_ERROR ("Calling writer_stop", FUNC_NAME, FAILURE);
+        }
+        steals = pool_destroy(&pool, &remote_steals);
+        if (verbose)
+        {
+            /* A pixel stolen across nodes is read from remote memory.    */
+            snprintf (msg_str, sizeof(msg_str), "Pixels=%d threads=%d "
+                      "stolen=%ld remote=%ld\n", blk, num_threads, steals,
+                      remote_steals);
+            LOG_MESSAGE (msg_str, FUNC_NAME);
+        }
+    }
+    if (numa_placed)
+        numa_free(&nodes);
+
+    status = out_files_close(&files);
+    if (status != SUCCESS)
+    {
+        RETURN_ERROR ("Calling out_files_close", FUNC_NAME, FAILURE);
+    }
+
+    /* The last checkpoint marks the block done.                          */
+    if (checkpoint > 0)
+    {
+        status = checkpoint_write(&cp, (blk > first) ? blk : first);
+        if (status != SUCCESS)
+        {
+            RETURN_ERROR ("Calling checkpoint_write", FUNC_NAME, FAILURE);
+        }
+        checkpoint_free(&cp);
+    }
+
+    if (in.state != NULL)
+    {
+        status = state_close(&state, true);
+        if (status != SUCCESS)
+        {
+            RETURN_ERROR ("Calling state_close", FUNC_NAME, FAILURE);
+        }
+    }
+
+    /******************************************************************/
+    /*                                                                */
+    /* Free memory allocations for this section.                      */
+    /*                                                                */
+    /******************************************************************/
+
+    if (neighbor_warm_start)
+    {
+        for (i = 0; i < num_params * block_cols; i++)
+            free(nb.recs[i]);
+        free(nb.recs);
+        free(nb.num_recs);
+    }
+    free(params);
+
+    free_block(&block);
+
+    if (!std_in)
+    {
+        free(fmask_buf);
+        free(meta);
+        free(sdate);
+        if (strcmp(data_type, "tifs") == 0)
+        {
+            status = free_2d_array ((void **) fp_tifs);
+            if (status != SUCCESS)
+            {
+                RETURN_ERROR ("Freeing memory: fp_tifs\n", FUNC_NAME,
+                              FAILURE);
+            }
+        }
+        else if (strcmp(data_type, "bip") == 0)
+        {
+            free(fp_bip);
+        }
+        status = free_2d_array ((void **) scene_list);
+        if (status != SUCCESS)
+        {
+            RETURN_ERROR ("Freeing memory: scene_list\n", FUNC_NAME,
+                      FAILURE);
+        }
+        status = free_2d_array ((void **) valid_scene_list);
+        if (status != SUCCESS)
+        {
+            RETURN_ERROR ("Freeing memory: valid_scene_list\n", FUNC_NAME,
+                      FAILURE);
+        }
+    }
+
+    /******************************************************************/
+    /*                                                                */
+    /* Obtain the current time and log the final completion time.     */
+    /*                                                                */
+    /******************************************************************/
+
+    time (&now);
+
+    if (verbose)
+    {
+        snprintf (msg_str, sizeof(msg_str), "CCDC end_time=%s\n", ctime (&now));
+        LOG_MESSAGE (msg_str, FUNC_NAME);
+    }
+
+    return SUCCESS;
+}
+#endif /* CCDC_LIBRARY */
+
+
+/******************************************************************************
+MODULE:  alloc_pixel_inputs
+
+PURPOSE:  Allocate the input buffers of a pixel slot, filled by read_pixel
+
+RETURN VALUE:
+Type = int
+Value           Description
+-----           -----------
+FAILURE         Error in allocating memories
+SUCCESS         No errors encountered
+******************************************************************************/
+static int alloc_pixel_inputs
+(
+    int num_scenes,                /* I: most scenes of a pixel             */
+    Ccdc_pixel_t *px               /* I/O: pixel, its input buffers set     */
+)
+{
+    char FUNC_NAME[] = "alloc_pixel_inputs";
+
+    px->buf = (int **) allocate_2d_array (TOTAL_BANDS, num_scenes, 
+                                          sizeof (int));
+    if (px->buf == NULL)
+    {
+        RETURN_ERROR ("Allocating buf memory", FUNC_NAME, FAILURE);
+    }
+
+    px->updated_fmask_buf = malloc(num_scenes * sizeof(unsigned char));
+    if (px->updated_fmask_buf == NULL)
+    {
+        RETURN_ERROR("ERROR allocating updated_fmask_buf memory", FUNC_NAME, 
+                     FAILURE);
+    }
+
+    px->updated_sdate_array = malloc(num_scenes * sizeof(int));
+    if (px->updated_sdate_array == NULL)
+    {
+        RETURN_ERROR("ERROR allocating updated_sdate memory", FUNC_NAME, 
+                     FAILURE);
+    }
+
+    px->id_range = (int *)calloc(num_scenes, sizeof(int));
+    if (px->id_range == NULL)
+    {
+        RETURN_ERROR("ERROR allocating id_range memory", FUNC_NAME, FAILURE);
+    }
+
+    return (SUCCESS);
+}
+
+
+static void free_pixel_inputs
+(
+    Ccdc_pixel_t *px               /* I/O: pixel, its input buffers freed   */
+)
+{
+    free_2d_array ((void **) px->buf);
+    free(px->updated_fmask_buf);
+    free(px->updated_sdate_array);
+    free(px->id_range);
+}
+
+
+/******************************************************************************
+MODULE:  alloc_workspace
+
+PURPOSE:  Allocate the buffers the change detection of a pixel runs in
+
+RETURN VALUE:
+Type = int
+Value           Description
+-----           -----------
+FAILURE         Error in allocating memories
+SUCCESS         No errors encountered
+
+NOTES: Sized for the worst case, every scene of the list valid and clear.
+******************************************************************************/
+static int alloc_workspace
+(
+    int num_scenes,                /* I: most scenes of a pixel             */
+    int max_conse,                 /* I: largest conse of the sets          */
+    Ccdc_workspace_t *ws           /* I/O: workspace, its buffers set       */
+)
+{
+    char FUNC_NAME[] = "alloc_workspace";
+    Ccdc_pixel_t *px = &ws->px;
+    int status;
+
+    ws->num_scenes = num_scenes;
+    px->obs = &ws->obs;
+    px->basis = &ws->basis;
+    px->season = &ws->season;
+
+    /* One position past the scenes, for the reads past the clear       */
+    /* observations when every scene is clear.                          */
+    px->clrx = malloc((num_scenes + 1) * sizeof(int));
+    if (px->clrx == NULL)
+    {
+        RETURN_ERROR("ERROR allocating clrx memory", FUNC_NAME, FAILURE);
+    }
+
+    px->clry = (float **) allocate_2d_array (TOTAL_IMAGE_BANDS,
+                                             num_scenes + 1, sizeof (float));
+    if (px->clry == NULL)
+    {
+        RETURN_ERROR ("Allocating clry memory", FUNC_NAME, FAILURE);
+    }
+
+    px->ids = (int *)calloc(num_scenes, sizeof(int));
+    if (px->ids == NULL)
+    {
+        RETURN_ERROR("ERROR allocating ids memory", FUNC_NAME, FAILURE);
+    }
+
+    px->ids_old = (int *)calloc(num_scenes, sizeof(int));
+    if (px->ids_old == NULL)
+    {
+        RETURN_ERROR("ERROR allocating ids_old memory", FUNC_NAME, FAILURE);
+    }
+
+    px->bl_ids = (int *)calloc(num_scenes, sizeof(int));
+    if (px->bl_ids == NULL)
+    {
+        RETURN_ERROR("ERROR allocating bl_ids memory", FUNC_NAME, FAILURE);
+    }
+
+    px->fit_cft = (float **) allocate_2d_array (TOTAL_IMAGE_BANDS, MAX_NUM_C,
+                                                sizeof (float));
+    if (px->fit_cft == NULL)
+    {
+        RETURN_ERROR ("Allocating fit_cft memory", FUNC_NAME, FAILURE);
+    }
+
+    px->rmse = (float *)calloc(TOTAL_IMAGE_BANDS, sizeof(float));
+    if (px->rmse == NULL)
+    {
+        RETURN_ERROR ("Allocating rmse memory", FUNC_NAME, FAILURE);
+    }
+
+    px->vec_mag = (float *)calloc(max_conse, sizeof(float));
+    if (px->vec_mag == NULL)
+    {
+        RETURN_ERROR ("Allocating vec_mag memory", FUNC_NAME, FAILURE);
+    }
+
+    px->v_dif_mag = (float **) allocate_2d_array(TOTAL_IMAGE_BANDS, max_conse,
+                                                 sizeof (float));
+    if (px->v_dif_mag == NULL)
+    {
+        RETURN_ERROR ("Allocating v_dif_mag memory", FUNC_NAME, FAILURE);
+    }
+
+    px->rec_v_dif = (float **)allocate_2d_array(TOTAL_IMAGE_BANDS, num_scenes,
+                                                sizeof (float));
+    if (px->rec_v_dif == NULL)
+    {
+        RETURN_ERROR ("Allocating rec_v_dif memory",FUNC_NAME, FAILURE);
+    }
+
+    px->temp_v_dif = (float **)allocate_2d_array(TOTAL_IMAGE_BANDS, num_scenes,
+                                                 sizeof (float));
+    if (px->temp_v_dif == NULL)
+    {
+        RETURN_ERROR ("Allocating temp_v_dif memory",FUNC_NAME, FAILURE);
+    }
+
+    status = season_index_alloc(num_scenes, px->season);
+    if (status != SUCCESS)
+    {
+        RETURN_ERROR ("Allocating season index memory",FUNC_NAME, FAILURE);
+    }
+
+    px->rmse_ids = malloc(num_scenes * sizeof(int));
+    if (px->rmse_ids == NULL)
+    {
+        RETURN_ERROR ("Allocating rmse_ids memory",FUNC_NAME, FAILURE);
+    }
+
+    return (SUCCESS);
+}
+
+
+static void free_workspace
+(
+    Ccdc_workspace_t *ws           /* I/O: workspace, its buffers freed     */
+)
+{
+    Ccdc_pixel_t *px = &ws->px;
+
+    free(px->clrx);
+    free_2d_array ((void **) px->clry);
+    free(px->ids);
+    free(px->ids_old);
+    free(px->bl_ids);
+    free_2d_array ((void **) px->fit_cft);
+    free(px->rmse);
+    free(px->vec_mag);
+    free_2d_array ((void **) px->v_dif_mag);
+    free_2d_array ((void **) px->rec_v_dif);
+    free_2d_array ((void **) px->temp_v_dif);
+    season_index_free(&ws->season);
+    free(px->rmse_ids);
+}
+
+
+/* Free the slots and the workspaces of a block.  The ones not allocated */
+/* yet are zeroed by calloc, so a block allocated part way is freed too. */
+static void free_block
+(
+    Ccdc_block_t *block            /* I/O: block, its buffers freed         */
+)
+{
+    int i;
+
+    if (block->slots != NULL)
+    {
+        for (i = 0; i < block->num_slots; i++)
+        {
+            free_pixel_inputs(&block->slots[i].px);
+            out_buffer_free(&block->slots[i].out);
+        }
+    }
+    if (block->work != NULL)
+    {
+        for (i = 0; i < block->num_workers; i++)
+            free_workspace(&block->work[i]);
+    }
+    free(block->slots);
+    free(block->work);
+    free_harmonic_basis(&block->basis);
+}
+
+
+#ifndef CCDC_LIBRARY
+/******************************************************************************
+MODULE:  init_worker_task
+
+PURPOSE:  Allocate, on the node of a pool thread, its workspace and the
+          inputs of the slots it is handed
+
+RETURN VALUE:
+Type = int
+Value           Description
+-----           -----------
+FAILURE         Error in allocating memory
+SUCCESS         No errors encountered
+
+NOTES: Pool init function of NUMA placement: the thread is pinned to its
+       node, so the pages it touches first are on it; the pixels of slot s
+       are queued to thread s % num_workers, which runs them on local
+       memory unless another thread steals them.  The slot inputs are
+       written by read_pixel on the reading thread, so they are cleared
+       here, before that, for their pages to be placed by the worker.
+******************************************************************************/
+static int init_worker_task
+(
+    void *arg,                     /* I/O: block of the run                 */
+    int worker,                    /* I: thread, its workspace              */
+    int node                       /* I: its node                           */
+)
+{
+    char FUNC_NAME[] = "init_worker_task";
+    int status;
+    int s;
+    Ccdc_block_t *block = arg;
+    Ccdc_pixel_t *px;
+    int num_scenes = block->num_scenes;
+
+    (void)node;
+    status = alloc_workspace(num_scenes, block->max_conse,
+                             &block->work[worker]);
+    if (status != SUCCESS)
+    {
+        RETURN_ERROR ("Calling alloc_workspace", FUNC_NAME, FAILURE);
+    }
+    for (s = worker; s < block->num_slots; s += block->num_workers)
+    {
+        px = &block->slots[s].px;
+        status = alloc_pixel_inputs(num_scenes, px);
+        if (status != SUCCESS)
+        {
+            RETURN_ERROR ("Calling alloc_pixel_inputs", FUNC_NAME, FAILURE);
+        }
+        memset(px->buf[0], 0, TOTAL_BANDS * num_scenes * sizeof(int));
+        memset(px->updated_fmask_buf, 0, num_scenes * sizeof(unsigned char));
+        memset(px->updated_sdate_array, 0, num_scenes * sizeof(int));
+        memset(px->id_range, 0, num_scenes * sizeof(int));
+    }
+
+    return (SUCCESS);
+}
+#endif /* CCDC_LIBRARY */
+
+
+/******************************************************************************
+MODULE:  run_pixel_task
+
+PURPOSE:  Run every parameter set on a pixel read into its slot, with the
+          workspace of a thread
+
+RETURN VALUE:
+Type = int
+Value           Description
+-----           -----------
+FAILURE         Error in the change detection of the pixel
+SUCCESS         No errors encountered
+
+NOTES: Pool task function: task is the pixel number in the block.  The
+       records and counters go to the output buffer of the slot, written
+       in pixel order by write_pixel.  With neighbor warm starts the pixels
+       run one at a time in order, as each one starts from the curves of
+       the pixels left of and above it.
+******************************************************************************/
+static int run_pixel_task
+(
+    void *arg,                     /* I/O: block of the run                 */
+    int worker,                    /* I: thread, its workspace              */
+    int task                       /* I: pixel of the block                 */
+)
+{
+    char FUNC_NAME[] = "run_pixel_task";
+    char msg_str[MAX_STR_LEN];       /* Log message                           */
+    int status;                      /* Return value from function call       */
+    int cfg;                         /* Parameter set being run               */
+    int nb_slot;                     /* Entry of nb->recs of the pixel        */
+    Output_t *recs;                  /* Curves of the pixel                   */
+    int num_recs;                    /* Their number                          */
+    Ccdc_block_t *block = arg;
+    Ccdc_workspace_t *ws = &block->work[worker];
+    Ccdc_pixel_t *px = &ws->px;
+    const Ccdc_pixel_t *slot = &block->slots[task % block->num_slots].px;
+    const Ccdc_params_t *params = block->params;
+    int num_params = block->num_params;
+    Ccdc_neighbors_t *nb = block->nb;
+    Harmonic_basis_t *basis = px->basis;
+    int valid_num_scenes = slot->valid_num_scenes;
+    int i_b;                         /* Band index                            */
+    struct timespec t_start, t_end;  /* Time of the change detection          */
+
+    /******************************************************************/
+    /*                                                                */
+    /* The pixel read into the slot.                                  */
+    /*                                                                */
+    /******************************************************************/
+
+    px->row = slot->row;
+    px->col = slot->col;
+    px->valid_num_scenes = slot->valid_num_scenes;
+    px->buf = slot->buf;
+    px->updated_fmask_buf = slot->updated_fmask_buf;
+    px->updated_sdate_array = slot->updated_sdate_array;
+    px->id_range = slot->id_range;
+    px->clr_pct = slot->clr_pct;
+    px->sn_pct = slot->sn_pct;
+    px->clr_sum = slot->clr_sum;
+    px->water_sum = slot->water_sum;
+    px->sn_sum = slot->sn_sum;
+    px->all_sum = slot->all_sum;
+    px->out = slot->out;
+
+    /******************************************************************/
+    /*                                                                */
+    /* A few reads past the clear observations see the tail of clrx,  */
+    /* clry.  Clear them, so that the tail, hence the output, is the  */
+    /* one of a fresh run whatever pixels the workspace ran before.   */
+    /*                                                                */
+    /******************************************************************/
+
+    memset(px->clrx, 0, (ws->num_scenes + 1) * sizeof(int));
+    for (i_b = 0; i_b < TOTAL_IMAGE_BANDS; i_b++)
+        memset(px->clry[i_b], 0, (ws->num_scenes + 1) * sizeof(float));
+
+    if (px->cost_only)
+    {
+        status = write_cost(px, 0);
+        if (status != SUCCESS)
+            RETURN_ERROR("Calling write_cost", FUNC_NAME, FAILURE);
+        return (SUCCESS);
+    }
+    clock_gettime(CLOCK_MONOTONIC, &t_start);
+
+    /******************************************************************/
+    /*                                                                */
+    /* The harmonic terms of the dates, shared by all bands and model */
+    /* fits below: those of the block, the dates of the pixel being   */
+    /* some of its scenes, or, on stdin, built for the pixel.         */
+    /*                                                                */
+    /******************************************************************/
+
+    basis->day_row = NULL;
+    basis->fit_terms = NULL;
+    basis->pred_terms = NULL;
+    basis->pred_terms_f = NULL;
+    basis->precision = px->precision;
+    basis->tmask_terms = NULL;
+    if (block->basis.day_row != NULL)
+        *basis = block->basis;
+    else if (valid_num_scenes > 0)
+    {
+        status = build_harmonic_basis(px->updated_sdate_array, 
+                                      valid_num_scenes, px->precision, basis);
+        if (status != SUCCESS)
+        {
+            RETURN_ERROR ("Calling build_harmonic_basis", FUNC_NAME, 
+                          FAILURE);
+        }
+    }
+    basis->lasso_warm = NULL;
+
+    status = obs_store_alloc(px->clrx, px->clry, valid_num_scenes + 1, 
+                             px->obs);
+    if (status != SUCCESS)
+    {
+        RETURN_ERROR ("Calling obs_store_alloc", FUNC_NAME, FAILURE);
+    }
+
+    /******************************************************************/
+    /*                                                                */
+    /* Run every parameter set on the loaded pixel.                   */
+    /*                                                                */
+    /******************************************************************/
+
+    px->variogram_done = false;
+    for (cfg = 0; cfg < num_params; cfg++)
+    {
+        if (px->verbose && num_params > 1)
+        {
+            snprintf (msg_str, sizeof(msg_str), "Parameter set %d: "
+                      "t_cg=%f t_max_cg=%f conse=%d lambda=%f "
+                      "n_times=%d min_num_c=%d\n", cfg, params[cfg].t_cg,
+                      params[cfg].t_max_cg, params[cfg].conse,
+                      params[cfg].lambda, params[cfg].n_times,
+                      params[cfg].min_num_c);
+            LOG_MESSAGE (msg_str, FUNC_NAME);
+        }
+        if (nb == NULL)
+        {
+            status = run_parameter_set(px, &params[cfg], cfg, num_params,
+                                       NULL, NULL);
+            if (status != SUCCESS)
+                RETURN_ERROR("Calling run_parameter_set", FUNC_NAME, 
+                             FAILURE);
+            continue;
+        }
+
+        nb_slot = cfg * nb->block_cols + task % nb->block_cols;
+        nb->lasso_warm.recs[0] = NULL;
+        nb->lasso_warm.num_recs[0] = 0;
+        if (task % nb->block_cols > 0)
+        {
+            nb->lasso_warm.recs[0] = nb->recs[nb_slot - 1];
+            nb->lasso_warm.num_recs[0] = nb->num_recs[nb_slot - 1];
+        }
+        nb->lasso_warm.recs[1] = nb->recs[nb_slot];
+        nb->lasso_warm.num_recs[1] = nb->num_recs[nb_slot];
+        memset(&nb->lasso_warm.stats, 0, sizeof(Neighbor_stats_t));
+        basis->lasso_warm = &nb->lasso_warm;
+
+        status = run_parameter_set(px, &params[cfg], cfg, num_params,
+                                   &recs, &num_recs);
+        if (status != SUCCESS)
+            RETURN_ERROR("Calling run_parameter_set", FUNC_NAME, FAILURE);
+        free(nb->recs[nb_slot]);
+        nb->recs[nb_slot] = recs;
+        nb->num_recs[nb_slot] = num_recs;
+    }
+
+    if (block->basis.day_row == NULL)
+        free_harmonic_basis(basis);
+    obs_store_free(px->obs);
+
+    if (px->record_cost)
+    {
+        clock_gettime(CLOCK_MONOTONIC, &t_end);
+        status = write_cost(px, (t_end.tv_sec - t_start.tv_sec) * 1000000L +
+                            (t_end.tv_nsec - t_start.tv_nsec) / 1000);
+        if (status != SUCCESS)
+            RETURN_ERROR("Calling write_cost", FUNC_NAME, FAILURE);
+    }
+
+    return (SUCCESS);
+}
+
+
+/******************************************************************************
+MODULE:  write_cost
+
+PURPOSE:  Append the cost record of a pixel to cost.txt
+
+RETURN VALUE:
+Type = int
+Value           Description
+-----           -----------
+FAILURE         Error in opening the file
+SUCCESS         No errors encountered
+
+NOTES: One line per pixel:
+           row col path valid_num_scenes clr_sum water_sum sn_sum all_sum
+           usec
+       path is the branch run_parameter_set takes on the cfmask counts:
+       full (Fmask works), snow (permanent snow) or fmask_fail, and usec
+       the time of the change detection of every parameter set, 0 with
+       --cost-only.  scripts/calibrateCost.pl fits the cost model on these
+       records, and scripts/scheduleCost.pl sizes the jobs of a tile with
+       it.
+******************************************************************************/
+static int write_cost
+(
+    const Ccdc_pixel_t *px,        /* I: pixel run                          */
+    long usec                      /* I: microseconds of its run            */
+)
+{
+    char FUNC_NAME[] = "write_cost";
+    char output_cost[MAX_STR_LEN];   /* directory and file name, cost.txt     */
+    FILE *fp_cost_out;               /* Its stream                            */
+    const char *path;                /* Branch of the pixel                   */
+
+    if (px->clr_pct >= T_CLR)
+        path = "full";
+    else if (px->sn_pct > T_SN)
+        path = "snow";
+    else
+        path = "fmask_fail";
+
+    snprintf(output_cost, sizeof(output_cost), "%s/cost.txt", px->out_path);
+    fp_cost_out = out_buffer_open(px->out, output_cost);
+    if (fp_cost_out == NULL)
+    {
+        RETURN_ERROR ("Opening cost.txt file\n", FUNC_NAME, FAILURE);
+    }
+    fprintf(fp_cost_out, "%d %d %s %d %d %d %d %d %ld\n", px->row, px->col,
+            path, px->valid_num_scenes, px->clr_sum, px->water_sum,
+            px->sn_sum, px->all_sum, usec);
+
+    return (SUCCESS);
+}
+
+
+#ifndef CCDC_LIBRARY
+/******************************************************************************
+MODULE:  write_pixel
+
+PURPOSE:  Write the output of a pixel of the block, once its run finished
+
+RETURN VALUE:
+Type = int
+Value           Description
+-----           -----------
+FAILURE         Error in the run or in writing the output
+SUCCESS         No errors encountered
+
+NOTES: main, or the writer thread of a pipelined run, writes the pixels
+       in block order, whatever order the threads finish them in, so the
+       output files do not depend on the number of threads.
+******************************************************************************/
+static int write_pixel
+(
+    Ccdc_block_t *block,           /* I/O: block of the run                 */
+    Pool_t *pool,                  /* I/O: pool running the pixels, NULL    */
+                                   /*      when run by main                 */
+    int task                       /* I: pixel of the block                 */
+)
+{
+    char FUNC_NAME[] = "write_pixel";
+    int status;
+    int i;
+    Out_buffer_t *out = &block->slots[task % block->num_slots].out;
+    Checkpoint_t *cp = block->cp;
+
+    if (pool != NULL)
+    {
+        status = pool_wait(pool, task);
+        if (status != SUCCESS)
+        {
+            RETURN_ERROR ("Calling run_pixel_task", FUNC_NAME, FAILURE);
+        }
+    }
+
+    if (cp != NULL)
+    {
+        for (i = 0; i < out->num_streams; i++)
+        {
+            status = checkpoint_add_file(cp, out->streams[i]->path);
+            if (status != SUCCESS)
+            {
+                RETURN_ERROR ("Calling checkpoint_add_file", FUNC_NAME, 
+                              FAILURE);
+            }
+        }
+    }
+
+    status = out_buffer_write(out, block->files);
+    if (status != SUCCESS)
+    {
+        RETURN_ERROR ("Calling out_buffer_write", FUNC_NAME, FAILURE);
+    }
+
+    if (cp != NULL && (task + 1) % cp->every == 0)
+    {
+        status = out_files_flush(block->files);
+        if (status != SUCCESS)
+        {
+            RETURN_ERROR ("Calling out_files_flush", FUNC_NAME, FAILURE);
+        }
+        status = checkpoint_write(cp, task + 1);
+        if (status != SUCCESS)
+        {
+            RETURN_ERROR ("Calling checkpoint_write", FUNC_NAME, FAILURE);
+        }
+    }
+
+    return (SUCCESS);
+}
+
+
+/******************************************************************************
+MODULE:  writer_thread
+
+PURPOSE:  Write the pixels of a pipelined block run in block order, as the
+          pool finishes them
+
+RETURN VALUE:
+Type = void *
+Value           Description
+-----           -----------
+NULL            All queued pixels written, or one failed (writer->status)
+******************************************************************************/
+static void *writer_thread
+(
+    void *arg                      /* I/O: writer                           */
+)
+{
+    Ccdc_writer_t *writer = arg;
+    int task;
+    int status;
+
+    for (task = writer->num_written; ; task++)
+    {
+        pthread_mutex_lock(&writer->lock);
+        while (task >= writer->num_queued && !writer->end)
+            pthread_cond_wait(&writer->changed, &writer->lock);
+        if (task >= writer->num_queued)
+        {
+            pthread_mutex_unlock(&writer->lock);
+            break;
+        }
+        pthread_mutex_unlock(&writer->lock);
+
+        status = write_pixel(writer->block, writer->pool, task);
+
+        pthread_mutex_lock(&writer->lock);
+        if (status != SUCCESS)
+            writer->status = FAILURE;
+        else
+            writer->num_written++;
+        pthread_cond_broadcast(&writer->changed);
+        pthread_mutex_unlock(&writer->lock);
+        if (status != SUCCESS)
+            break;
+    }
+
+    return NULL;
+}
+
+
+/******************************************************************************
+MODULE:  writer_start
+
+PURPOSE:  Start the write stage of a pipelined block run
+
+RETURN VALUE:
+Type = int
+Value           Description
+-----           -----------
+FAILURE         Error in starting the thread
+SUCCESS         No errors encountered
+
+NOTES: The pipeline has three stages, overlapping the input, the change
+       detection and the output of the pixels: main reads the pixels into
+       the free slots, the pool runs them, and the writer writes them out.
+       The slots bound the pixels in flight, so the memory of a run does
+       not grow with the block.
+******************************************************************************/
+static int writer_start
+(
+    Ccdc_block_t *block,           /* I: pixels of the run                  */
+    Pool_t *pool,                  /* I: pool running them                  */
+    int first,                     /* I: first pixel of the run             */
+    Ccdc_writer_t *writer          /* O: running writer                     */
+)
+{
+    char FUNC_NAME[] = "writer_start";
+
+    writer->block = block;
+    writer->pool = pool;
+    writer->num_queued = first;
+    writer->num_written = first;
+    writer->end = false;
+    writer->status = SUCCESS;
+    pthread_mutex_init(&writer->lock, NULL);
+    pthread_cond_init(&writer->changed, NULL);
+
+    if (pthread_create(&writer->thread, NULL, writer_thread, writer) != 0)
+    {
+        RETURN_ERROR ("Starting the writer thread", FUNC_NAME, FAILURE);
+    }
+
+    return (SUCCESS);
+}
+
+
+/******************************************************************************
+MODULE:  writer_wait_slot
+
+PURPOSE:  Wait until the slot of pixel blk is free, its previous pixel
+          written
+
+RETURN VALUE:
+Type = int
+Value           Description
+-----           -----------
+FAILURE         A pixel failed, the writer stopped
+SUCCESS         No errors encountered
+******************************************************************************/
+static int writer_wait_slot
+(
+    Ccdc_writer_t *writer,         /* I/O: writer                           */
+    int blk                        /* I: pixel to be read                   */
+)
+{
+    char FUNC_NAME[] = "writer_wait_slot";
+    int status;
+
+    pthread_mutex_lock(&writer->lock);
+    while (blk - writer->num_written >= writer->block->num_slots &&
+           writer->status == SUCCESS)
+        pthread_cond_wait(&writer->changed, &writer->lock);
+    status = writer->status;
+    pthread_mutex_unlock(&writer->lock);
+
+    if (status != SUCCESS)
+    {
+        RETURN_ERROR ("Writing the pixels", FUNC_NAME, FAILURE);
+    }
+
+    return (SUCCESS);
+}
+
+
+/* Hand the pixel just submitted to the pool to the writer.               */
+static void writer_queue
+(
+    Ccdc_writer_t *writer          /* I/O: writer                           */
+)
+{
+    pthread_mutex_lock(&writer->lock);
+    writer->num_queued++;
+    pthread_cond_broadcast(&writer->changed);
+    pthread_mutex_unlock(&writer->lock);
+}
+
+
+/******************************************************************************
+MODULE:  writer_stop
+
+PURPOSE:  Let the writer write the queued pixels, and join it
+
+RETURN VALUE:
+Type = int
+Value           Description
+-----           -----------
+FAILURE         A pixel failed
+SUCCESS         No errors encountered
+******************************************************************************/
+static int writer_stop
+(
+    Ccdc_writer_t *writer          /* I/O: writer, joined                   */
+)
+{
+    char FUNC_NAME[] = "writer_stop";
+
+    pthread_mutex_lock(&writer->lock);
+    writer->end = true;
+    pthread_cond_broadcast(&writer->changed);
+    pthread_mutex_unlock(&writer->lock);
+
+    pthread_join(writer->thread, NULL);
+    pthread_mutex_destroy(&writer->lock);
+    pthread_cond_destroy(&writer->changed);
+
+    if (writer->status != SUCCESS)
+    {
+        RETURN_ERROR ("Writing the pixels", FUNC_NAME, FAILURE);
+    }
+
+    return (SUCCESS);
+}
+
+
+/******************************************************************************
+MODULE:  read_pixel
+
+PURPOSE:  Load the inputs of the pixel at px->row, px->col: dates, bands
+          and cfmask of its valid scenes, their cfmask percentages and the
+          observations within the physical ranges
+
+RETURN VALUE:
+Type = int
+Value           Description
+-----           -----------
+FAILURE         Error reading the input
+SUCCESS         No errors encountered
+
+NOTES: From stdin the pixel is the next one of the input, in block mode
+       ended by a blank line; px->valid_num_scenes is 0 once it is over.
+       The buffers of px are as large as the scene list, so every pixel of
+       a block reuses them.
+******************************************************************************/
+static int read_pixel
+(
+    Ccdc_input_t *in,              /* I/O: opened input of the run          */
+    Ccdc_pixel_t *px               /* I/O: pixel position and buffers       */
+)
+{
+    char FUNC_NAME[] = "read_pixel";
+    char msg_str[MAX_STR_LEN];       /* Log message                           */
+    int status;                      /* Return value from function call       */
+    int i, k;                        /* Loop counters                         */
+    int cell_bands[TOTAL_IMAGE_BANDS];/* Band values of a screening cell      */
+    int first_row, first_col;        /* 0-based upper left of the cell        */
+    int clr_sum = 0;                 /* Total number of clear cfmask pixels   */
+    int sn_sum = 0;                  /* Total number of snow  cfmask pixels   */
+    int all_sum = 0;                 /* Total of all cfmask pixels            */
+    int water_sum = 0;           /* counter for cfmask water pixels.          */
+    int shadow_sum = 0;          /* counter for cfmask shadow pixels.         */
+    int cloud_sum = 0;           /* counter for cfmask cloud pixels.          */
+    int fill_sum = 0;            /* counter for cfmask fill pixels.           */
+    int inputs_specified;        /* the number input scenes defined.          */
+    int prev_wrs_path = 0;       /* using the first of two scenes in a        */
+    int prev_wrs_row = 0;        /* swath, because it is recommended          */
+    int prev_year = 0;           /* to use the meta  data from the            */
+    int prev_jday = 0;           /* first for things like sun anle,           */
+    unsigned char prev_fmask_buf;/* etc. However, always removing a specific  */
+    int valid_scene_count = 0;   /* x/y location specified is not valid be-   */
+    int swath_overlap_count = 0; /* it may or may not be in an overlap area.  */
+    time_t now;                  /* For logging the read time.                */
+    float sn_pct;                    /* Percent snow cfmask pixels            */
+    float clr_pct;                   /* Percent clear cfmask pixels           */
+    int valid_num_scenes;        /* number of scenes after cfmask counts and  */
+                                 /* swath overlap eliminated                  */
+    int first_scene = 0;         /* first scene of the list read              */
+    Pixel_state_t ps;            /* series state of the pixel                 */
+
+    /* The input and the pixel.                                           */
+    bool std_in = in->std_in;
+    char *data_type = in->data_type;
+    int num_scenes = in->num_scenes;
+    char **scene_list = in->scene_list;
+    char **valid_scene_list = in->valid_scene_list;
+    int *sdate = in->sdate;
+    Input_meta_t *meta = in->meta;
+    FILE ***fp_tifs = in->fp_tifs;
+    FILE **fp_bip = in->fp_bip;
+    unsigned char *fmask_buf = in->fmask_buf;
+    int row = px->row;
+    int col = px->col;
+    bool verbose = px->verbose;
+    int screen_cell = px->screen_cell;
+    int **buf = px->buf;
+    unsigned char *updated_fmask_buf = px->updated_fmask_buf;
+    int *updated_sdate_array = px->updated_sdate_array;
+
+    if (std_in)
+    {
+        /**************************************************************/
+        /*                                                            */
+        /* For stdin:                                                 */
+        /* This assumes order of: julian date value, then 6 SR and 1  */
+        /* thermal band values, then cfmask band values, each         */
+        /* set/group together, culiminated with a newline per scene,  */
+        /* for number of scenes. For example:                         */
+        /* 2456445 94 156 164 758 807 492 2809 0                      */
+        /*                                                            */
+        /**************************************************************/
+
+        status = read_stdin (updated_sdate_array, buf, updated_fmask_buf,
+                             TOTAL_IMAGE_BANDS, &clr_sum, &water_sum,
+                             &shadow_sum, &sn_sum, &cloud_sum, &fill_sum,
+                             &all_sum, &valid_num_scenes, in->block);
+        if (status != SUCCESS)
+        {
+            RETURN_ERROR ("reading stdin",FUNC_NAME, FAILURE);
+        }
+        inputs_specified = all_sum;
+    }
+    else
+    {
+        inputs_specified = num_scenes;
+
+        /**************************************************************/
+        /*                                                            */
+        /* A screening cell is the block whose upper left pixel is    */
+        /* row, col; it has to be within the image.  bip rows and     */
+        /* cols are 1-based.                                          */
+        /*                                                            */
+        /**************************************************************/
+
+        first_row = row;
+        first_col = col;
+        if (strcmp(data_type, "tifs") != 0)
+        {
+            first_row--;
+            first_col--;
+        }
+        if ((screen_cell > 1) && ((first_row + screen_cell > meta->lines) ||
+            (first_col + screen_cell > meta->samples)))
+        {
+            RETURN_ERROR ("Screening cell is outside the image",
+                          FUNC_NAME, FAILURE);
+        }
+
+        /******************************************************************/
+        /*                                                                */
+        /* Read the cfmask file first, determine which pixels are valid.  */
+        /*   0: clear                                                     */
+        /*   1: water                                                     */
+        /*   2: cloudShadow                                               */
+        /*   3: snow                                                      */
+        /*   4: cloud                                                     */
+        /* 255: CFMASK_FILL                                               */
+        /*                                                                */
+        /* This will determine whether or not to use this pixel, which    */
+        /* then requires subsequent reading of image bands.               */
+        /*                                                                */
+        /* While reading, update the counters for clear, water, cloud,    */
+        /* and snow, essentially skipping over fill values,               */
+        /* and update the number of "scenes" so that only the data bands  */
+        /* buffer and date information array are filled with values from  */
+        /* from valid "scenes".                                           */
+        /*                                                                */
         /* Previously, all data was read, then cfmask was checked after   */
         /* the last loop, and was accidentally checked because the cfmask */
         /* file just happend to be the last file read.  However, when     */
@@ -736,14 +2200,50 @@ int main (int argc, char *argv[])
         /* user environment variables could be defined and parsed.        */
         /*                                                                */
         /******************************************************************/
-    
+
         valid_num_scenes = 0;
         prev_fmask_buf = 254;
 
-        for (i = 0; i < num_scenes; i++)
+        /******************************************************************/
+        /*                                                                */
+        /* Updating, the scenes read by the previous run are not read     */
+        /* again: their observations and the counts are restored from     */
+        /* the state of the pixel, and the reading goes on from there.    */
+        /*                                                                */
+        /******************************************************************/
+
+        if (in->state != NULL && in->state->in != NULL)
+        {
+            status = state_read(in->state, row, col, scene_list, num_scenes,
+                                &ps, updated_sdate_array, updated_fmask_buf,
+                                buf);
+            if (status != SUCCESS)
+            {
+                RETURN_ERROR ("Calling state_read", FUNC_NAME, FAILURE);
+            }
+            first_scene = ps.num_read;
+            prev_wrs_path = ps.prev_wrs_path;
+            prev_wrs_row = ps.prev_wrs_row;
+            prev_year = ps.prev_year;
+            prev_jday = ps.prev_jday;
+            prev_fmask_buf = ps.prev_fmask;
+            swath_overlap_count = ps.swath_overlap_count;
+            clr_sum = ps.clr_sum;
+            water_sum = ps.water_sum;
+            shadow_sum = ps.shadow_sum;
+            sn_sum = ps.sn_sum;
+            cloud_sum = ps.cloud_sum;
+            fill_sum = ps.fill_sum;
+            all_sum = ps.all_sum;
+            valid_num_scenes = ps.num_valid;
+            valid_scene_count = ps.num_valid;
+        }
+
+        for (i = first_scene; i < num_scenes; i++)
         {
             status = read_cfmask(i, data_type, scene_list, row, col,
                                  meta->samples, fp_tifs, fp_bip, fmask_buf,
+                                 screen_cell, cell_bands,
                                  &prev_wrs_path, &prev_wrs_row, &prev_year,
                                  &prev_jday, &prev_fmask_buf, &valid_scene_count,
                                  &swath_overlap_count, valid_scene_list,
@@ -760,15 +2260,18 @@ int main (int argc, char *argv[])
                 /*                                                    */
                 /******************************************************/
 
-                if (debug)
+                LOG_TRACE("%d %d %d", i, valid_scene_count -1, updated_sdate_array[valid_scene_count - 1]);
+                if (screen_cell > 1)
                 {
-                    printf("%d %d %d", i, valid_scene_count -1, updated_sdate_array[valid_scene_count - 1]);
+                    /* read_cfmask already aggregated the cell        */
+                    for (k = 0; k < TOTAL_IMAGE_BANDS; k++)
+                        buf[k][valid_scene_count - 1] = cell_bands[k];
                 }
-                if (strcmp(data_type, "tifs") == 0)
+                else if (strcmp(data_type, "tifs") == 0)
                 {
                     status = read_tifs(valid_scene_list[valid_scene_count - 1],
                                        fp_tifs, (valid_scene_count - 1), row, col,
-                                       meta->samples, debug, buf);
+                                       meta->samples, buf);
                     if (status != SUCCESS)
                     {
                         RETURN_ERROR ("Calling read_tifs", 
@@ -778,7 +2281,7 @@ int main (int argc, char *argv[])
                 else if ((strcmp(data_type, "bip")       == 0) ||
                          (strcmp(data_type, "bip_lines") == 0))
                 {
-                    printf ("reading bip ");
+                    LOG_TRACE ("reading bip ");
                     status = read_bip(valid_scene_list[valid_scene_count - 1],
                                       fp_bip, (valid_scene_count - 1), row, col,
                                       meta->samples, buf);
@@ -791,16 +2294,44 @@ int main (int argc, char *argv[])
 //                                            meta->samples, buf);
 //                }
 
-                if (debug)
-                {
-                    printf("%d\n", updated_fmask_buf[valid_scene_count - 1]);
-                }
+                LOG_TRACE("%d\n", updated_fmask_buf[valid_scene_count - 1]);
 
             }
 
         }
 
-    } // end of elseif stdin bracket, meaning not stdin, read cfmask and image files
+        if (in->state != NULL)
+        {
+            memset(&ps, 0, sizeof(Pixel_state_t));
+            ps.row = row;
+            ps.col = col;
+            ps.num_read = num_scenes;
+            if (num_scenes > 0)
+                snprintf(ps.last_scene, sizeof(ps.last_scene), "%s",
+                         scene_list[num_scenes - 1]);
+            ps.prev_wrs_path = prev_wrs_path;
+            ps.prev_wrs_row = prev_wrs_row;
+            ps.prev_year = prev_year;
+            ps.prev_jday = prev_jday;
+            ps.prev_fmask = prev_fmask_buf;
+            ps.swath_overlap_count = swath_overlap_count;
+            ps.clr_sum = clr_sum;
+            ps.water_sum = water_sum;
+            ps.shadow_sum = shadow_sum;
+            ps.sn_sum = sn_sum;
+            ps.cloud_sum = cloud_sum;
+            ps.fill_sum = fill_sum;
+            ps.all_sum = all_sum;
+            ps.num_valid = valid_num_scenes;
+            status = state_write(in->state, &ps, updated_sdate_array,
+                                 updated_fmask_buf, buf);
+            if (status != SUCCESS)
+            {
+                RETURN_ERROR ("Calling state_write", FUNC_NAME, FAILURE);
+            }
+        }
+    }
+    time (&now);
 
     if ((verbose) && (!std_in))
     {
@@ -810,16 +2341,16 @@ int main (int argc, char *argv[])
         /*                                                            */
         /**************************************************************/
 
-        printf ("DEBUG: Number of input lines: %d\n", meta->lines);
-        printf ("DEBUG: Number of input samples: %d\n", meta->samples);
-        printf ("DEBUG: UL_MAP_CORNER: %d, %d\n", meta->upper_left_x,
-                meta->upper_left_y);
-        printf ("DEBUG: ENVI data type: %d\n", meta->data_type);
-        printf ("DEBUG: ENVI byte order: %d\n", meta->byte_order);
-        printf ("DEBUG: UTM zone number: %d\n", meta->utm_zone);
-        printf ("DEBUG: Pixel size: %d\n", meta->pixel_size);
-        printf ("DEBUG: Envi save format: %s\n", meta->interleave);
-        printf ("DEBUG: Number of pixel overlap scenes removed: %d\n", swath_overlap_count);
+        LOG_DEBUG ("DEBUG: Number of input lines: %d\n", meta->lines);
+        LOG_DEBUG ("DEBUG: Number of input samples: %d\n", meta->samples);
+        LOG_DEBUG ("DEBUG: UL_MAP_CORNER: %d, %d\n", meta->upper_left_x,
+                   meta->upper_left_y);
+        LOG_DEBUG ("DEBUG: ENVI data type: %d\n", meta->data_type);
+        LOG_DEBUG ("DEBUG: ENVI byte order: %d\n", meta->byte_order);
+        LOG_DEBUG ("DEBUG: UTM zone number: %d\n", meta->utm_zone);
+        LOG_DEBUG ("DEBUG: Pixel size: %d\n", meta->pixel_size);
+        LOG_DEBUG ("DEBUG: Envi save format: %s\n", meta->interleave);
+        LOG_DEBUG ("DEBUG: Number of pixel overlap scenes removed: %d\n", swath_overlap_count);
 
         /**************************************************************/
         /*                                                            */
@@ -832,13 +2363,67 @@ int main (int argc, char *argv[])
 
     }
 
+    finish_pixel_inputs(px, valid_num_scenes, clr_sum, water_sum, sn_sum,
+                        all_sum);
+    clr_pct = px->clr_pct;
+    sn_pct = px->sn_pct;
+
+    if (verbose)
+    {
+        LOG_INFO("  Number inputs specified      = %d\n", inputs_specified);
+        LOG_INFO("  Number of non-overlap pixels = %d\n", (inputs_specified - swath_overlap_count));
+        LOG_INFO("  Number of fill (255)  pixels = %d\n", fill_sum);
+        LOG_INFO("  Number of non-fill    pixels = %d\n", all_sum);
+        LOG_INFO("  Number of clear  (0)  pixels = %d\n", clr_sum);
+        LOG_INFO("  Number of water  (1)  pixels = %d\n", water_sum);
+        LOG_INFO("  Number of shadow (2)  pixels = %d\n", shadow_sum);
+        LOG_INFO("  Number of snow   (3)  pixels = %d\n", sn_sum);
+        LOG_INFO("  Number of cloud  (4)  pixels = %d\n", cloud_sum);
+        LOG_INFO("  Number of clear+water pixels = %d\n", clr_sum);
+        LOG_INFO("  Percent of clear pixels      = %f (of non-fill pixels)\n", clr_pct);
+        LOG_INFO("  Percent of clear pixels      = %f (of non-fill, non-cloud, non-shadow pixels)\n",
+                 (float) clr_sum / (float) (clr_sum + sn_sum) * 100);
+        LOG_INFO("  Percent of snow  pixels      = %f (of non-fill, non-cloud, non-shadow pixels)\n", (sn_pct * 100));
+    }
+
+    return (SUCCESS);
+}
+#endif /* CCDC_LIBRARY */
+
+
+/******************************************************************************
+MODULE:  finish_pixel_inputs
+
+PURPOSE:  Set the cfmask percentages of a loaded pixel, and mark its
+          observations within the physical ranges
+
+RETURN VALUE:
+Type = None
+
+NOTES: The thermal band is converted from Kelvin to Celsius in place, so
+       it is called once per load of the buffers.
+******************************************************************************/
+static void finish_pixel_inputs
+(
+    Ccdc_pixel_t *px,              /* I/O: pixel, its inputs loaded         */
+    int valid_num_scenes,          /* I: number of valid scenes             */
+    int clr_sum,                   /* I: clear (with water) cfmask pixels   */
+    int water_sum,                 /* I: water cfmask pixels                */
+    int sn_sum,                    /* I: snow cfmask pixels                 */
+    int all_sum                    /* I: non-fill cfmask pixels             */
+)
+{
+    int i;                           /* Loop counter                          */
+    int **buf = px->buf;
+    int *id_range = px->id_range;
+
     /******************************************************************/
     /*                                                                */
     /* Percent of clear pixels: clear (0) or water (1).               */    
     /*                                                                */
     /******************************************************************/
 
-    clr_pct = (float) clr_sum / (float) all_sum * 100;
+    px->clr_pct = (float) clr_sum / (float) all_sum * 100;
 
     /******************************************************************/
     /*                                                                */
@@ -847,27 +2432,9 @@ int main (int argc, char *argv[])
     /******************************************************************/
 
     if ((clr_sum + sn_sum) != 0)
-        sn_pct =  (float) sn_sum / (float)(clr_sum + sn_sum); 
+        px->sn_pct =  (float) sn_sum / (float)(clr_sum + sn_sum); 
     else
-        sn_pct = (float)sn_sum;
-
-    if (verbose)
-    {
-        printf("  Number inputs specified      = %d\n", inputs_specified);
-        printf("  Number of non-overlap pixels = %d\n", (inputs_specified - swath_overlap_count));
-        printf("  Number of fill (255)  pixels = %d\n", fill_sum);
-        printf("  Number of non-fill    pixels = %d\n", all_sum);
-        printf("  Number of clear  (0)  pixels = %d\n", clr_sum);
-        printf("  Number of water  (1)  pixels = %d\n", water_sum);
-        printf("  Number of shadow (2)  pixels = %d\n", shadow_sum);
-        printf("  Number of snow   (3)  pixels = %d\n", sn_sum);
-        printf("  Number of cloud  (4)  pixels = %d\n", cloud_sum);
-        printf("  Number of clear+water pixels = %d\n", clr_sum);
-        printf("  Percent of clear pixels      = %f (of non-fill pixels)\n", clr_pct);
-        printf("  Percent of clear pixels      = %f (of non-fill, non-cloud, non-shadow pixels)\n",
-               (float) clr_sum / (float) (clr_sum + sn_sum) * 100);
-        printf("  Percent of snow  pixels      = %f (of non-fill, non-cloud, non-shadow pixels)\n", (sn_pct * 100));
-    }
+        px->sn_pct = (float)sn_sum;
 
     /******************************************************************/
     /*                                                                */
@@ -922,14 +2489,271 @@ int main (int argc, char *argv[])
 	}
     }
 
+    px->valid_num_scenes = valid_num_scenes;
+    px->clr_sum = clr_sum;
+    px->water_sum = water_sum;
+    px->sn_sum = sn_sum;
+    px->all_sum = all_sum;
+}
+
+
+/******************************************************************************
+MODULE:  load_pixel_arrays
+
+PURPOSE:  Load the inputs of a pixel of a block held in memory, as
+          read_pixel does from the files
+
+RETURN VALUE:
+Type = int
+Value           Description
+-----           -----------
+FAILURE         A cfmask value is not one of cfmask
+SUCCESS         No errors encountered
+
+NOTES: Scenes of fill cfmask are left out and the others counted, as by
+       read_cfmask; there is no swath overlap filter, the arrays carry no
+       WRS rows, so the caller drops the overlap scenes.  The values are
+       read from the arrays of the caller where they are, each once, into
+       the buffers of the slot, which the change detection edits.
+******************************************************************************/
+static int load_pixel_arrays
+(
+    const Ccdc_arrays_t *arrays,   /* I: block of pixels                    */
+    int blk,                       /* I: pixel of the block                 */
+    Ccdc_pixel_t *px               /* I/O: pixel position and buffers       */
+)
+{
+    char FUNC_NAME[] = "load_pixel_arrays";
+    int status;                      /* Return value from function call       */
+    int i, k;                        /* Loop counters                         */
+    int clr_sum = 0;                 /* cfmask counts, as read_pixel          */
+    int water_sum = 0;
+    int shadow_sum = 0;
+    int sn_sum = 0;
+    int cloud_sum = 0;
+    int fill_sum = 0;
+    int all_sum = 0;
+    int valid_num_scenes = 0;        /* Scenes of non-fill cfmask             */
+    unsigned char fmask;             /* cfmask of the scene                   */
+    short int value;                 /* Band value of the scene               */
+    const char *bands = arrays->bands +
+                        (blk / arrays->cols) * arrays->band_strides[0] +
+                        (blk % arrays->cols) * arrays->band_strides[1];
+    const char *qa = arrays->qa + (blk / arrays->cols) * arrays->qa_strides[0] +
+                     (blk % arrays->cols) * arrays->qa_strides[1];
+
+    px->row = arrays->row + blk / arrays->cols;
+    px->col = arrays->col + blk % arrays->cols;
+
+    for (i = 0; i < arrays->num_scenes; i++)
+    {
+        fmask = *(const unsigned char *)(qa + i * arrays->qa_strides[2]);
+        status = assign_cfmask_values(fmask, &clr_sum, &water_sum,
+                                      &shadow_sum, &sn_sum, &cloud_sum,
+                                      &fill_sum, &all_sum);
+        if (status != SUCCESS)
+        {
+            RETURN_ERROR ("Calling assign_cfmask_values", FUNC_NAME, 
+                          FAILURE);
+        }
+        if (fmask >= CFMASK_FILL)
+            continue;
+
+        memcpy(&px->updated_sdate_array[valid_num_scenes],
+               arrays->sdate + i * arrays->sdate_stride, sizeof(int));
+        px->updated_fmask_buf[valid_num_scenes] = fmask;
+        for (k = 0; k < TOTAL_IMAGE_BANDS; k++)
+        {
+            memcpy(&value, bands + k * arrays->band_strides[2] +
+                   i * arrays->band_strides[3], sizeof(short int));
+            px->buf[k][valid_num_scenes] = value;
+        }
+        valid_num_scenes++;
+    }
+
+    finish_pixel_inputs(px, valid_num_scenes, clr_sum, water_sum, sn_sum,
+                        all_sum);
+
+    return (SUCCESS);
+}
+
+
+/******************************************************************************
+MODULE:  run_parameter_set
+
+PURPOSE:  Run the change detection of one parameter set on a loaded pixel
+          and write its curve records
+
+RETURN VALUE:
+Type = int
+Value           Description
+-----           -----------
+FAILURE         Error in the change detection or the output
+SUCCESS         No errors encountered
+
+NOTES: Everything that does not depend on the parameters (the inputs, the
+       harmonic basis, the buffers and the median variogram) lives in px and
+       is shared by all the sets of a sweep.  The clear observations are
+       selected again by each set, since the curve fits edit them in place.
+       With more than one set, the records of set cfg go to output_<cfg>.bin
+       (and fast_path_<cfg>.txt) instead of output.bin.  When recs is not
+       NULL the curve records are handed over instead of freed, as the
+       neighbor curves of the next pixels of a block.
+******************************************************************************/
+static int run_parameter_set
+(
+    Ccdc_pixel_t *px,              /* I/O: loaded pixel and shared buffers  */
+    const Ccdc_params_t *params,   /* I: parameters of this run             */
+    int cfg,                       /* I: index of the parameter set         */
+    int num_params,                /* I: number of parameter sets           */
+    Output_t **recs,               /* O: curve records, NULL to free them   */
+    int *num_recs                  /* O: their number                       */
+)
+{
+    char FUNC_NAME[] = "run_parameter_set";
+    char msg_str[MAX_STR_LEN];       /* Input data scene name                 */
+    int status;                      /* Return value from function call       */
+    int i, k, m, b;                  /* Loop counters                         */
+    time_t now;                      /* For logging the init time             */
+    char time_str[26];               /* ctime_r of now, pixels run in threads */
+
+    Output_t *rec_cg = NULL;         /* Output structure and metadata         */
+    Fit_range_t cur_fit;             /* Fit of the current curve              */
+    const Ts_kernels_t *ini_kern;    /* CONSE kernels of the initial fit      */
+    const Ts_kernels_t *conse_kern;  /* CONSE kernels of update_num_c         */
+    Fast_path_stats_t fast_stats;    /* How often the shortcut was taken      */
+    Output_t fast_rec;               /* Curve record of the shortcut          */
+    bool fast_stable;                /* The shortcut proved the curve stable  */
+    int fast_fc = -1;                /* Curve to validate, -1 if none         */
+    FILE *fp_fast_out;               /* Fast path counters file               */
+    Lazy_window_t lazy_win;          /* CONSE window record of lazy bands     */
+    int num_c = 8;                   /* Max number of coefficients for model  */
+    int num_fc = 0;                  /* Intialize NUM of Functional Curves    */
+    bool open_curve = false;         /* rec_cg[num_fc] holds the last curve   */
+    int rec_fc;                      /* Record num. of functional curves      */
+    float v_start[NUM_LASSO_BANDS];  /* Vector for start of observation(s)    */
+    float v_end[NUM_LASSO_BANDS];    /* Vector for end of observastion(s)     */
+    float v_slope[NUM_LASSO_BANDS];  /* Vector for anormalized slope values   */
+    float v_dif[NUM_LASSO_BANDS];    /* Vector for difference values          */
+    float z_rmse[NUM_LASSO_BANDS];   /* z-score rmse of the detection bands   */
+    int conse_head = 0;              /* slot of the oldest CONSE window obs.  */
+    int n_sn = 0;                    /* Number of snow cfmask pixels          */
+    int n_clr = 0;                   /* Number of clear cfmask pixels         */
+    int i_start;                     /* The first observation for TSFit       */
+    int end;                         /* The end of clear observations of total*/
+    int i_span = 0;                  /* index for span of consecutive obs. ?  */
+    int update_num_c = 8;            /* Number of coefficients to update      */
+    int bl_train;                    /* Flag for which way to train the model.*/
+    float time_span;                 /* Span of time in no. of years.         */
+    int rm_ids_len;                  /* number of observations removed        */
+    int k_first, k_last;             /* first and last kept Tmask positions   */
+    int i_rec;                       /* start of model before noise removal   */
+    float v_dif_norm = 0.0;
+    int i_count;                     /* Count difference of i each iteration  */
+    int i_conse, i_b;
+    float *vec_magg;/* these two?            */ /* this one is never freed */
+    float v_dif_mean;
+    float vec_magg_min;
+    int n_rmse_ids;                  /* number of them                        */
+    float mini_rmse;                 /* Mimimum RMSE                          */
+    int n_rmse;                      /* number of RMSE values                 */
+    float tmpcg_rmse[NUM_LASSO_BANDS]; /* to temporarily change RMSE          */
+    int id_last = 0;                 /* The last stable id.                   */
+    FILE *fp_bin_out;                /* Binary output file name.              */
+    int ids_old_len = 0;             /* fit observations of the season index  */
+    int i_break = 1;                 /* for recording break points, i is index*/
+    int i_ini;                       /* for recording begin of time, i is index*/
+    int ini_conse = 0;               /* Initial CONSE.                        */
+    float break_mag;
+    int ids_len;                     /* number of ids, incremented continuously*/
+    char output_binary[MAX_STR_LEN];/* directory and file name for output.bin */
+    char output_fast[MAX_STR_LEN];  /* directory and file name, fast_path.txt */
+    char output_priority[MAX_STR_LEN];/* directory and file, priority.txt     */
+    FILE *fp_priority_out;           /* Screening priority file               */
+    char output_neighbor[MAX_STR_LEN];/* directory and file, neighbor.txt     */
+    FILE *fp_neighbor_out;           /* Neighbor warm start counters file     */
+    FILE *fp_rec_out;                /* Records when the output is stdout     */
+    int n_break;                     /* Number of curves ended by a break     */
+
+    /* Thresholds of this run.                                            */
+    double t_cg = params->t_cg;
+    double t_max_cg = params->t_max_cg;
+    int conse = params->conse;
+    double lambda = params->lambda;
+    int n_times = params->n_times;
+    int min_num_c = params->min_num_c;
+
+    /* The loaded pixel.                                                  */
+    int row = px->row;
+    int col = px->col;
+    char *out_path = px->out_path;
+    bool verbose = px->verbose;
+    bool std_out = px->std_out;
+    bool lazy_fit = px->lazy_fit;
+    bool fast_path = px->fast_path;
+    bool validate_fast_path = px->validate_fast_path;
+    Precision_t precision = px->precision;
+    int screen_cell = px->screen_cell;
+    int *fit_blist = px->fit_blist;
+    int num_fit_bands = px->num_fit_bands;
+    int *all_blist = px->all_blist;
+    int valid_num_scenes = px->valid_num_scenes;
+    int **buf = px->buf;
+    unsigned char *updated_fmask_buf = px->updated_fmask_buf;
+    int *updated_sdate_array = px->updated_sdate_array;
+    int *id_range = px->id_range;
+    float clr_pct = px->clr_pct;
+    float sn_pct = px->sn_pct;
+    int *clrx = px->clrx;
+    float **clry = px->clry;
+    Obs_store_t *obs = px->obs;
+    Harmonic_basis_t *basis = px->basis;
+    Season_index_t *season = px->season;
+    float *adj_rmse = px->adj_rmse;
+    int *ids = px->ids;
+    int *ids_old = px->ids_old;
+    int *bl_ids = px->bl_ids;
+    int *rmse_ids = px->rmse_ids;
+    float **fit_cft = px->fit_cft;
+    float *rmse = px->rmse;
+    float *vec_mag = px->vec_mag;
+    float **v_dif_mag = px->v_dif_mag;
+    float **rec_v_dif = px->rec_v_dif;
+    float **temp_v_dif = px->temp_v_dif;
+
+    /******************************************************************/
+    /*                                                                */
+    /* The window buffers are allocated for the largest conse of a    */
+    /* sweep.  The median of the magnitude at the end of the series   */
+    /* can read the slot before a band's row, the last slot of the    */
+    /* band before: lay v_dif_mag out conse wide, as in a run of      */
+    /* this set alone.                                                */
+    /*                                                                */
+    /******************************************************************/
+
+    if (set_2d_array_columns((void **)v_dif_mag, conse) != SUCCESS)
+    {
+        RETURN_ERROR("Setting the v_dif_mag window width", FUNC_NAME,
+                     FAILURE);
+    }
+
+    fast_stats.checked = 0;
+    fast_stats.fired = 0;
+    fast_stats.mismatch = 0;
+
+    ini_kern = select_ts_kernels(TOTAL_IMAGE_BANDS, min_num_c, precision);
+    conse_kern = select_ts_kernels(TOTAL_IMAGE_BANDS, update_num_c, 
+                                   precision);
 
     /******************************************************************/
     /*                                                                */
-    /* Allocate memory for rec_cg.                                    */ 
+    /* Allocate memory for rec_cg.  Zeroed, as a pixel without curves */
+    /* still writes rec_cg[0], which must not depend on the heap of   */
+    /* the thread running it.                                         */
     /*                                                                */
     /******************************************************************/
 
-    rec_cg = malloc(NUM_FC * sizeof(Output_t));
+    rec_cg = calloc(NUM_FC, sizeof(Output_t));
     if (rec_cg == NULL)
     {
         RETURN_ERROR("ERROR allocating rec_cg memory", FUNC_NAME, FAILURE);
@@ -975,8 +2799,9 @@ int main (int argc, char *argv[])
             /**********************************************************/
 
             matlab_unique(clrx, clry, n_sn, &end);
+            obs_store_reset(obs, end);
 
-            if (n_sn < N_TIMES * MIN_NUM_C) // not enough snow pixels
+            if (n_sn < n_times * min_num_c) // not enough snow pixels
             {
                 RETURN_ERROR ("Not enough good snow observations\n", 
                      FUNC_NAME, FAILURE);
@@ -988,9 +2813,8 @@ int main (int argc, char *argv[])
             /*                                                        */
             /**********************************************************/
 
-            if (verbose)
-                printf ("Fit permanent snow observations, now pixel = %f\n", 
-                       100.0 * sn_pct); 
+            LOG_INFO ("Fit permanent snow observations, now pixel = %f\n", 
+                      100.0 * sn_pct); 
 
             i_start = 1; /* the first observation for TSFit */
 
@@ -1014,12 +2838,12 @@ int main (int argc, char *argv[])
                             i_span++;
                         }
 
-                        if (i_span < MIN_NUM_C * N_TIMES)
+                        if (i_span < min_num_c * n_times)
                             fit_cft[i][k] = 10000; // fixed value for saturated pixels
                         else
                         {
-                            status = auto_ts_fit(clrx, clry, k, 0, i_span-1, MIN_NUM_C, 
-                                     fit_cft, &rmse[k], temp_v_dif); 
+                            status = auto_ts_fit(obs, basis, k, 0, i_span-1, min_num_c, 
+                                     lambda, fit_cft, &rmse[k], temp_v_dif); 
                             if (status != SUCCESS)  
                                 RETURN_ERROR ("Calling auto_ts_fit1\n", 
                                        FUNC_NAME, EXIT_FAILURE);
@@ -1035,8 +2859,8 @@ int main (int argc, char *argv[])
                             i_span++;
                         }
                             
-                        status = auto_ts_fit(clrx, clry, k, 0, i_span-1, MIN_NUM_C, fit_cft, 
-                                 &rmse[k], temp_v_dif); 
+                        status = auto_ts_fit(obs, basis, k, 0, i_span-1, min_num_c, 
+                                 lambda, fit_cft, &rmse[k], temp_v_dif); 
                         if (status != SUCCESS)  
                             RETURN_ERROR ("Calling auto_ts_fit2\n", 
                                   FUNC_NAME, EXIT_FAILURE);
@@ -1099,7 +2923,7 @@ int main (int argc, char *argv[])
 
             rec_cg[num_fc].change_prob = 0.0; 
             rec_cg[num_fc].num_obs = n_sn; 
-            rec_cg[num_fc].category = 50 + MIN_NUM_C; /* snow pixel */
+            rec_cg[num_fc].category = 50 + min_num_c; /* snow pixel */
 
             for (i_b = 0; i_b < TOTAL_IMAGE_BANDS; i_b++)
             {
@@ -1169,6 +2993,7 @@ int main (int argc, char *argv[])
             /**********************************************************/
 
             matlab_unique(clrx, clry, n_clr, &end);
+            obs_store_reset(obs, end);
 
             /**********************************************************/
             /*                                                        */
@@ -1176,12 +3001,12 @@ int main (int argc, char *argv[])
             /*                                                        */
             /**********************************************************/
 
-            printf ("Fmask failed, clear pixel = %f\n", 
-                   100.0 * clr_pct); 
+            LOG_INFO ("Fmask failed, clear pixel = %f\n", 
+                      100.0 * clr_pct); 
 
 	    n_clr = 0;
 	    float band2_median; // probably not good practice to declare here....
-            quick_sort_float(clry[1], 0, end - 1);
+            sort_float(clry[1], end);
             matlab_2d_float_median(clry, 1, end, &band2_median);
 
             n_clr = 0;
@@ -1207,7 +3032,7 @@ int main (int argc, char *argv[])
 
             i_start = 1; /* the first observation for TSFit */
 
-            if (n_clr < N_TIMES * MIN_NUM_C)
+            if (n_clr < n_times * min_num_c)
             {
                 RETURN_ERROR("Not enough good clear observations\n", 
                             FUNC_NAME, FAILURE);
@@ -1216,8 +3041,8 @@ int main (int argc, char *argv[])
             {
                 for (i_b = 0; i_b < TOTAL_IMAGE_BANDS; i_b++)
                 {
-                    status = auto_ts_fit(clrx, clry, i_b, 0, end-1, MIN_NUM_C, 
-                                         fit_cft, &rmse[k], temp_v_dif); 
+                    status = auto_ts_fit(obs, basis, i_b, 0, end-1, min_num_c, 
+                                         lambda, fit_cft, &rmse[k], temp_v_dif); 
                     if (status != SUCCESS)
 		    {  
                         RETURN_ERROR ("Calling auto_ts_fit for clear persistent pixels\n", 
@@ -1283,7 +3108,7 @@ int main (int argc, char *argv[])
             /**********************************************************/
             rec_cg[num_fc].change_prob = 0.0; 
             rec_cg[num_fc].num_obs = n_clr; 
-            rec_cg[num_fc].category = 40 + MIN_NUM_C; 
+            rec_cg[num_fc].category = 40 + min_num_c; 
 
             for (i_b = 0; i_b < TOTAL_IMAGE_BANDS; i_b++)
 	    {
@@ -1322,11 +3147,8 @@ int main (int argc, char *argv[])
     }
     else /* clear land or water pixels */
     {
-        if (verbose)
-        {
-            printf("Seasonal Snow (Snow < %f)\n", 100.0 * sn_pct);
-            printf("Fmask works, clear pixels (land/water) = %f\n", clr_pct);
-        }
+        LOG_INFO("Seasonal Snow (Snow < %f)\n", 100.0 * sn_pct);
+        LOG_INFO("Fmask works, clear pixels (land/water) = %f\n", clr_pct);
 
         n_clr = 0;
         for (i = 0; i < valid_num_scenes; i++)
@@ -1342,10 +3164,7 @@ int main (int argc, char *argv[])
             }   
         }
         end = n_clr;
-        if (debug)
-        {
-            printf("end_clr=%d\n",end);
-        }
+        LOG_DEBUG("end_clr=%d\n",end);
 
         /**************************************************************/
         /*                                                            */
@@ -1354,37 +3173,40 @@ int main (int argc, char *argv[])
         /**************************************************************/
 
         matlab_unique(clrx, clry, n_clr, &end);
+        obs_store_reset(obs, end);
 
         /**************************************************************/
         /*                                                            */
-        /* Calculate median variogram.                                */
+        /* Calculate median variogram, once per pixel.                */
         /*                                                            */
         /**************************************************************/
 
-	for (k = 0; k < TOTAL_IMAGE_BANDS; k++)
-	{
-            adj_rmse[k] = 0.0;
-	} 
-        status = median_variogram(clry, TOTAL_IMAGE_BANDS, 0, end-1, adj_rmse);
-        if (status != SUCCESS)
-	{
-            RETURN_ERROR("ERROR calling median_variogram routine", FUNC_NAME, 
-                         FAILURE);
-	}
-
-        if (!std_out)
+        if (!px->variogram_done)
         {
             for (k = 0; k < TOTAL_IMAGE_BANDS; k++)
-                printf("k,adj_rmse[k]=%d,%f\n",k,adj_rmse[k]);
+            {
+                adj_rmse[k] = 0.0;
+            } 
+            status = median_variogram(clry, TOTAL_IMAGE_BANDS, 0, end-1, 
+                                      adj_rmse);
+            if (status != SUCCESS)
+            {
+                RETURN_ERROR("ERROR calling median_variogram routine", 
+                             FUNC_NAME, FAILURE);
+            }
+            px->variogram_done = true;
         }
 
+        for (k = 0; k < TOTAL_IMAGE_BANDS; k++)
+            LOG_DEBUG("k,adj_rmse[k]=%d,%f\n",k,adj_rmse[k]);
+
         /**************************************************************/
         /*                                                            */
         /* Start with mininum requirement of clear obs.               */
         /*                                                            */
         /**************************************************************/
 
-        i = N_TIMES * MIN_NUM_C;
+        i = n_times * min_num_c;
 
         /**************************************************************/
         /*                                                            */
@@ -1410,14 +3232,6 @@ int main (int argc, char *argv[])
         /**************************************************************/
         rec_fc = num_fc;
 
-        /**************************************************************/
-        /*                                                            */
-        /* Record the start of Tmask (0=>initial;1=>done)             */
-        /*                                                            */
-        /**************************************************************/
-
-        bl_tmask = 0;
-
         /**************************************************************/
         /*                                                            */
         /* If verbose, record the start time of just the CDCD         */
@@ -1428,7 +3242,9 @@ int main (int argc, char *argv[])
 
         if (verbose)
         {
-            snprintf (msg_str, sizeof(msg_str), "CCDC init_time=%s\n", ctime (&now));
+            time (&now);
+            snprintf (msg_str, sizeof(msg_str), "CCDC init_time=%s\n", 
+                      ctime_r (&now, time_str));
             LOG_MESSAGE (msg_str, FUNC_NAME);
         }
 
@@ -1438,7 +3254,7 @@ int main (int argc, char *argv[])
         /*                                                            */
         /**************************************************************/
 
-        while (i <= end - CONSE)
+        while (i <= end - conse)
         {
             /**********************************************************/
             /*                                                        */
@@ -1453,7 +3269,7 @@ int main (int argc, char *argv[])
             /* span of time (num of years)                            */
             /*                                                        */
             /**********************************************************/
-            time_span = (float)(clrx[i-1] - clrx[i_start-1]) / NUM_YEARS;
+            time_span = (float)(OBS_T(obs, i-1) - OBS_T(obs, i_start-1)) / NUM_YEARS;
 
             /**********************************************************/
             /*                                                        */
@@ -1462,7 +3278,7 @@ int main (int argc, char *argv[])
             /*                                                        */
             /**********************************************************/
 
-            if ((i_span >= N_TIMES * MIN_NUM_C) && (time_span >= (float)MIN_YEARS))
+            if ((i_span >= n_times * min_num_c) && (time_span >= (float)MIN_YEARS))
             {
                 /******************************************************/
                 /*                                                    */
@@ -1478,8 +3294,8 @@ int main (int argc, char *argv[])
                     /*                                                */
                     /**************************************************/
 
-                    status = auto_mask(clrx, clry, i_start-1, i+CONSE-1,
-                                   (float)(clrx[i+CONSE-1]-clrx[i_start-1]) / NUM_YEARS, 
+                    status = auto_mask(obs, basis, i_start-1, i+conse-1,
+                                   (float)(OBS_T(obs, i+conse-1)-OBS_T(obs, i_start-1)) / NUM_YEARS, 
                                    adj_rmse[1], adj_rmse[4], T_CONST, bl_ids);
                     if (status != SUCCESS)
 		    {
@@ -1489,45 +3305,38 @@ int main (int argc, char *argv[])
 
                     /**************************************************/
                     /*                                                */
-                    /* Clear the IDs buffers.                         */
-                    /*                                                */
-                    /**************************************************/
-
-                    for (k = 0; k < valid_num_scenes; k++)
-                        ids[k] = 0;
-
-                    /**************************************************/
-                    /*                                                */
-                    /* IDs to be removed.                             */
+                    /* Count the observations to be removed between   */
+                    /* i_start & i, and find the first and last ones  */
+                    /* that are kept.                                 */
                     /*                                                */
                     /**************************************************/
 
-                    for (k = i_start-1; k < i+CONSE; k++)
-		    {
-                        ids[k-i_start+1] = k;
-		    }
-                    m= 0;
+                    rm_ids_len = 0;
                     i_span = 0;
+                    k_first = -1;
+                    k_last = -1;
                     for (k = 0; k < i-i_start+1; k++)
                     {
                         if (bl_ids[k] == 1) 
                         {
-                            rm_ids[m] = ids[k];
-                            m++;
+                            rm_ids_len++;
                         }
                         else
+                        {
                             i_span++;  /* update i_span after noise removal */
+                            if (k_first < 0)
+                                k_first = k;
+                            k_last = k;
+                        }
                     }
 
-                    rm_ids_len = m;
-
                     /**************************************************/
                     /*                                                */
                     /* Check if there are enough observation.         */
                     /*                                                */
                     /**************************************************/
 
-                    if (i_span < (N_TIMES * MIN_NUM_C))
+                    if (i_span < (n_times * min_num_c))
                     {
                         /**********************************************/
                         /*                                            */
@@ -1543,51 +3352,13 @@ int main (int argc, char *argv[])
                         /*                                            */
                         /**********************************************/
 
-                        continue;
-                    }
-
-		    if (end == 0)
-                        RETURN_ERROR("No available data point", FUNC_NAME, FAILURE);
-
-                    /**************************************************/
-                    /*                                                */
-                    /* Allocate memory for cpx, cpy.                  */
-                    /*                                                */
-                    /**************************************************/
-
-                    cpx = malloc(end * sizeof(int));
-                    if (cpx == NULL)
-                        RETURN_ERROR("ERROR allocating cpx memory", FUNC_NAME, FAILURE);
-
-                    cpy = (float **) allocate_2d_array (TOTAL_IMAGE_BANDS, end,
-                                     sizeof (float));
-                    if (cpy == NULL)
-                    {
-                        RETURN_ERROR ("Allocating cpy memory", FUNC_NAME, FAILURE);
-                    }
-
-                    /**************************************************/
-                    /*                                                */
-                    /* Remove noise pixels between i_start & i.       */
-                    /*                                                */
-                    /**************************************************/
-
-                    m = 0;
-                    for (k = 0, k_new=0; k < end; k++)
-                    {
-                        if (m < rm_ids_len && k == rm_ids[m])
-                        {
-                            m++;
-			    continue;
-                        }
-                        cpx[k_new] = clrx[k];
-                        for (b = 0; b < TOTAL_IMAGE_BANDS; b++)
-			{
-                            cpy[b][k_new] = clry[b][k];
-			}
-                        k_new++;
+                        continue;
                     }
-                    end = k_new;
+
+		    if (end == 0)
+                        RETURN_ERROR("No available data point", FUNC_NAME, FAILURE);
+
+                    end -= rm_ids_len;
 
                     /**************************************************/
                     /*                                                */
@@ -1616,7 +3387,8 @@ int main (int argc, char *argv[])
                     /*                                                */
                     /**************************************************/
 
-                    time_span=(cpx[i-1] - cpx[i_start-1]) / NUM_YEARS;
+                    time_span=(OBS_T(obs, i_start-1+k_last) - 
+                               OBS_T(obs, i_start-1+k_first)) / NUM_YEARS;
 
                     /**************************************************/
                     /*                                                */
@@ -1627,6 +3399,7 @@ int main (int argc, char *argv[])
                     if (time_span < MIN_YEARS)
                     {
                         i = i_rec;   /* keep the original i */
+                        obs_store_truncate(obs, end);
 
                         /**********************************************/
                         /*                                            */
@@ -1635,38 +3408,17 @@ int main (int argc, char *argv[])
                         /**********************************************/
 
                         i++;        
-                        free(cpx);
-                        status = free_2d_array ((void **) cpy);
-                        if (status != SUCCESS)
-			{
-                              RETURN_ERROR ("Freeing memory: cpy\n", 
-                                    FUNC_NAME, FAILURE);
-			}
                         continue;    /* not enough time */
                     }
 
                     /**************************************************/
                     /*                                                */
-                    /* Remove noise in original arrays.               */
+                    /* Remove noise pixels between i_start & i.       */
                     /*                                                */
                     /**************************************************/
 
-                    for (k = 0; k < end; k++)
-                    {
-                        clrx[k] = cpx[k];
-                        for (m = 0; m < TOTAL_IMAGE_BANDS; m++)
-			{
-                            clry[m][k] = cpy[m][k];
-			}
-                    }
-
-                    free(cpx);
-                    status = free_2d_array ((void **) cpy);
-                    if (status != SUCCESS)
-		    {
-                        RETURN_ERROR ("Freeing memory: cpy\n", 
-                             FUNC_NAME, FAILURE);
-		    }
+                    obs_store_compact(obs, i_start-1, i_rec-i_start+1,
+                                      bl_ids);
 
                     /**************************************************/
                     /*                                                */
@@ -1675,22 +3427,19 @@ int main (int argc, char *argv[])
                     /*                                                */
                     /**************************************************/
 
-                    for (b = 0; b < TOTAL_IMAGE_BANDS; b++)
-                    {
-
-                        /**********************************************/
-                        /*                                            */
-                        /* Initial model fit.                         */
-                        /*                                            */
-                        /**********************************************/
+                    /**************************************************/
+                    /*                                                */
+                    /* Initial model fit.                             */
+                    /*                                                */
+                    /**************************************************/
 
-                        status = auto_ts_fit(clrx, clry, b, i_start-1, i-1, 
-                                 MIN_NUM_C, fit_cft, &rmse[b], rec_v_dif); 
-                        if (status != SUCCESS)  
-			{
-                            RETURN_ERROR ("Calling auto_ts_fit during model initilization\n", 
-                                 FUNC_NAME, FAILURE);
-			}
+                    status = auto_ts_fit_bands(obs, basis, fit_blist, num_fit_bands,
+                             i_start-1, i-1, min_num_c, lambda, fit_cft, rmse, 
+                             rec_v_dif); 
+                    if (status != SUCCESS)  
+                    {
+                        RETURN_ERROR ("Calling auto_ts_fit during model initilization\n", 
+                             FUNC_NAME, FAILURE);
                     }
 
                     v_dif_norm = 0.0;
@@ -1728,7 +3477,7 @@ int main (int argc, char *argv[])
                         /*                                            */
                         /**********************************************/
                         v_slope[b] = fit_cft[lasso_blist[b]][1] *
-                                        (clrx[i-1]-clrx[i_start-1])/mini_rmse;
+                                        (OBS_T(obs, i-1)-OBS_T(obs, i_start-1))/mini_rmse;
 
                         /**********************************************/
                         /*                                            */
@@ -1745,7 +3494,7 @@ int main (int argc, char *argv[])
                     /* Find stable start for each curve.              */
                     /*                                                */
                     /**************************************************/
-                    if (v_dif_norm > T_CG)
+                    if (v_dif_norm > t_cg)
                     {
                         /**********************************************/
                         /*                                            */
@@ -1809,7 +3558,7 @@ int main (int argc, char *argv[])
 
                         for (k = 0; k < end; k++) 
                         {
-                            if (clrx[k] >= rec_cg[num_fc-1].t_break)
+                            if (OBS_T(obs, k) >= rec_cg[num_fc-1].t_break)
                             {
                                 i_break = k + 1;
                                 break;
@@ -1826,17 +3575,45 @@ int main (int argc, char *argv[])
                         /*                                            */
                         /**********************************************/
 
+                        if (lazy_fit)
+                        {
+                            /******************************************/
+                            /*                                        */
+                            /* The backward check predicts all bands, */
+                            /* fit the lazy bands now, before false   */
+                            /* changes shift the observations.        */
+                            /*                                        */
+                            /******************************************/
+
+                            status = auto_ts_fit_bands(obs, basis, lazy_blist, 
+                                     NUM_LAZY_BANDS, i_start-1, i-1, min_num_c, 
+                                     lambda, fit_cft, rmse, temp_v_dif); 
+                            if (status != SUCCESS)  
+                            {
+                                RETURN_ERROR ("Calling auto_ts_fit for lazy bands "
+                                     "during model initilization\n", FUNC_NAME, FAILURE);
+                            }
+                        }
+
                         for(i_ini = i_start-2; i_ini >= i_break-1; i_ini--)
                         {
-                            if ((i_start - i_break) < CONSE)
+                            if ((i_start - i_break) < conse)
 			    {
                                 ini_conse = i_start - i_break;
 			    }
                             else
 			    {
-                                ini_conse = CONSE;
+                                ini_conse = conse;
 			    }
 
+                            /* Smaller sweep thresholds can break early   */
+                            /* enough for the window to start before the  */
+                            /* first observation.                         */
+                            if (ini_conse > i_ini + 1)
+                            {
+                                ini_conse = i_ini + 1;
+                            }
+
 			    if (ini_conse == 0)
                             {
                                 RETURN_ERROR ("No data point for model fit at "
@@ -1845,20 +3622,11 @@ int main (int argc, char *argv[])
 
                             /******************************************/
                             /*                                        */
-                            /* Allocate memory for model_v_dif,       */ 
-                            /* v_diff, vec_magg for the non-stdin     */ 
-                            /* branch here.                           */
+                            /* Allocate memory for vec_magg for the   */ 
+                            /* non-stdin branch here.                 */
                             /*                                        */
                             /******************************************/
 
-                            v_diff = (float **) allocate_2d_array(NUM_LASSO_BANDS,
-                                        ini_conse, sizeof (float));
-                            if (v_diff == NULL)
-                            {
-                                RETURN_ERROR ("Allocating v_diff memory", 
-                                               FUNC_NAME, FAILURE);
-                            }
- 
                             vec_magg = (float *) malloc(ini_conse * sizeof (float));
                             if (vec_magg == NULL)
                             {
@@ -1875,54 +3643,25 @@ int main (int argc, char *argv[])
                             /*                                        */
                             /******************************************/
 
+                            for (b = 0; b < NUM_LASSO_BANDS; b++)
+                            {
+                                z_rmse[b] = max(adj_rmse[lasso_blist[b]], 
+                                                rmse[lasso_blist[b]]);
+                            }
+
                             vec_magg_min = 9999.0;
                             for (i_conse = 0; i_conse < ini_conse; i_conse++)
                             {
-                                v_dif_norm = 0.0;
-                                for (i_b = 0; i_b < TOTAL_IMAGE_BANDS; i_b++)
+                                status = auto_ts_predict_conse(obs, basis, 
+                                             fit_cft, ini_kern, i_ini-i_conse, 1,
+                                             lasso_blist, NUM_LASSO_BANDS, z_rmse,
+                                             i_conse, conse, vec_magg, v_dif_mag);
+                                if (status != SUCCESS)
                                 {
-                                    /**********************************/
-                                    /*                                */
-                                    /* Absolute differences.          */
-                                    /*                                */
-                                    /**********************************/
-
-        			    auto_ts_predict(clrx, fit_cft, MIN_NUM_C, i_b, i_ini-i_conse,
-                                                    i_ini-i_conse, &ts_pred_temp);
-                                    v_dif_mag[i_b][i_conse] = (float)clry[i_b][i_ini-i_conse] - 
-                                                       ts_pred_temp;
-
-                                    /**********************************/
-                                    /*                                */
-                                    /* Normalize to z-score.          */
-                                    /*                                */
-                                    /**********************************/
-
-                                    for (b = 0; b < NUM_LASSO_BANDS; b++)
-                                    {
-                                        if (i_b == lasso_blist[b])
-                                        {
-                                            /**************************/
-                                            /*                        */
-                                            /* Minimum rmse.          */ 
-                                            /*                        */
-                                            /**************************/
-
-                                            mini_rmse = max(adj_rmse[i_b], rmse[i_b]);
-
-                                            /**************************/
-                                            /*                        */
-                                            /* z-scores.              */
-                                            /*                        */
-                                            /**************************/
-
-                                            v_diff[b][i_conse] = v_dif_mag[i_b][i_conse] 
-                                                                          / mini_rmse;
-                                            v_dif_norm += v_diff[b][i_conse] * v_diff[b][i_conse];
-                                        }
-                                    }
+                                    RETURN_ERROR ("Calling auto_ts_predict_conse "
+                                                  "during model initialization\n", 
+                                                  FUNC_NAME, FAILURE);
                                 }
-                                vec_magg[i_conse] = v_dif_norm; 
 
                                 if (vec_magg_min > vec_magg[i_conse])
 				{
@@ -1936,20 +3675,13 @@ int main (int argc, char *argv[])
                             /*                                        */
                             /******************************************/
 
-                            if (vec_magg_min > T_CG) /* change detected */
+                            if (vec_magg_min > t_cg) /* change detected */
 			    {
                                 break;
 			    }
-                            else if (vec_magg[0] > T_MAX_CG) /* false change */
+                            else if (vec_magg[0] > t_max_cg) /* false change */
                             {
-                                for (k = i_ini; k < end - 1; k++)
-                                {
-                                    clrx[k] = clrx[k+1];
-                                    for (b = 0; b < TOTAL_IMAGE_BANDS; b++)
-				    {
-                                        clry[b][k] = clry[b][k+1];
-				    }
-                                }
+                                obs_store_remove(obs, i_ini);
                                 i--;
                                 end--;
 
@@ -1970,12 +3702,6 @@ int main (int argc, char *argv[])
                             /******************************************/
 
                             free(vec_magg);
-                            status = free_2d_array ((void **) v_diff);
-                            if (status != SUCCESS)
-			    {
-                                RETURN_ERROR ("Freeing memory: v_diff\n", 
-                                              FUNC_NAME, FAILURE);
-			    }
                         }
                     }
 
@@ -1985,7 +3711,7 @@ int main (int argc, char *argv[])
                     /*                                                */
                     /**************************************************/
 
-                    if ((num_fc == rec_fc) && ((i_start - i_break) >= CONSE))
+                    if ((num_fc == rec_fc) && ((i_start - i_break) >= conse))
 		    {
                         /**********************************************/
                         /*                                            */
@@ -1993,15 +3719,13 @@ int main (int argc, char *argv[])
                         /*                                            */
                         /**********************************************/
 
-                        for (i_b = 0; i_b < TOTAL_IMAGE_BANDS; i_b++)
-                        {
-                            status = auto_ts_fit(clrx, clry, i_b, i_break-1, i_start-2, 
-                                     MIN_NUM_C, fit_cft, &rmse[i_b], temp_v_dif); 
-                            if (status != SUCCESS)
-         		    {  
-                                  RETURN_ERROR ("Calling auto_ts_fit with enough observations\n", 
-                                             FUNC_NAME, FAILURE);
-	      	            }
+                        status = auto_ts_fit_bands(obs, basis, all_blist, 
+                                 TOTAL_IMAGE_BANDS, i_break-1, i_start-2, 
+                                 min_num_c, lambda, fit_cft, rmse, temp_v_dif); 
+                        if (status != SUCCESS)
+                        {  
+                              RETURN_ERROR ("Calling auto_ts_fit with enough observations\n", 
+                                         FUNC_NAME, FAILURE);
                         }
 
                         /**********************************************/
@@ -2011,13 +3735,13 @@ int main (int argc, char *argv[])
                         /*                                            */
                         /**********************************************/
 
-                        rec_cg[num_fc].t_end = clrx[i_start-2]; 
+                        rec_cg[num_fc].t_end = OBS_T(obs, i_start-2); 
                         rec_cg[num_fc].pos.row = row; 
                         rec_cg[num_fc].pos.col = col; 
 
                         for (i_b = 0; i_b < TOTAL_IMAGE_BANDS; i_b++)
                         {
-                            for (k = 0; k < MIN_NUM_C; k++)
+                            for (k = 0; k < min_num_c; k++)
 			    {
                                 /**************************************/
                                 /*                                    */
@@ -2045,15 +3769,15 @@ int main (int argc, char *argv[])
                         /*                                            */
                         /**********************************************/
 
-			rec_cg[num_fc].t_break = clrx[i_start -1];
-			rec_cg[num_fc].category = 10 + MIN_NUM_C;
+			rec_cg[num_fc].t_break = OBS_T(obs, i_start -1);
+			rec_cg[num_fc].category = 10 + min_num_c;
 			rec_cg[num_fc].change_prob = 1.0;
-			rec_cg[num_fc].t_start = clrx[0];
+			rec_cg[num_fc].t_start = OBS_T(obs, 0);
 			rec_cg[num_fc].num_obs = i_start - i_break;
 
                         for (i_b = 0; i_b < TOTAL_IMAGE_BANDS; i_b++)
                         {
-                            quick_sort_float(v_dif_mag[i_b], 0, ini_conse-1);
+                            sort_float(v_dif_mag[i_b], ini_conse);
                             matlab_2d_float_median(v_dif_mag, i_b, ini_conse, 
                                                   &v_dif_mean);
                             rec_cg[num_fc].magnitude[i_b] = -v_dif_mean; 
@@ -2085,20 +3809,6 @@ int main (int argc, char *argv[])
 		    }
 		} /* end of initializing model */
  
-                /******************************************************/
-                /*                                                    */
-                /* Allocate memory for v_diff for the non-stdin branch*/ 
-                /*                                                    */
-                /******************************************************/
-
-                v_diff = (float **) allocate_2d_array(NUM_LASSO_BANDS,
-                                  CONSE, sizeof (float));
-                if (v_diff == NULL)
-                {
-                    RETURN_ERROR ("Allocating v_diff memory", 
-                                  FUNC_NAME, FAILURE);
-                }
-
                 /******************************************************/
                 /*                                                    */
                 /* Continuous monitoring started!!!                   */
@@ -2107,6 +3817,52 @@ int main (int argc, char *argv[])
 
                 if (bl_train == 1)
                 {
+                    /**************************************************/
+                    /*                                                */
+                    /* First step of a curve: if no break can be      */
+                    /* found in the rest of the series, record the    */
+                    /* curve and go to the end of the series.  When   */
+                    /* validating, the loop goes on and is compared.  */
+                    /*                                                */
+                    /**************************************************/
+
+                    if (fast_path && !lazy_fit && i_count == 0)
+                    {
+                        fast_stats.checked++;
+                        status = stable_fast_path(obs, basis, fit_blist, 
+                                     num_fit_bands, lasso_blist, adj_rmse, num_c, 
+                                     params, precision, i_start, i, end, fit_cft, rmse, 
+                                     rec_v_dif, vec_mag, v_dif_mag, &fast_rec, 
+                                     &fast_stable);
+                        if (status != SUCCESS)
+                        {
+                            RETURN_ERROR ("Calling stable_fast_path\n", 
+                                          FUNC_NAME, FAILURE);
+                        }
+                        if (fast_stable)
+                        {
+                            fast_stats.fired++;
+                            fast_rec.pos.row = row;
+                            fast_rec.pos.col = col;
+                            if (!validate_fast_path)
+                            {
+                                /**************************************/
+                                /*                                    */
+                                /* State of the last monitoring step. */
+                                /*                                    */
+                                /**************************************/
+
+                                rec_cg[num_fc] = fast_rec;
+                                conse_head = 0;
+                                i_span = end - conse - i_start + 1;
+                                update_cft(i_span, n_times, min_num_c, MID_NUM_C, 
+                                           MAX_NUM_C, num_c, &update_num_c);
+                                break;
+                            }
+                            fast_fc = num_fc;
+                        }
+                    }
+
                     /**************************************************/
                     /*                                                */
                     /* Clears the IDs buffers.                        */
@@ -2138,8 +3894,11 @@ int main (int argc, char *argv[])
                     /*                                                */
                     /**************************************************/
 
-                    update_cft(i_span, N_TIMES, MIN_NUM_C, MID_NUM_C, MAX_NUM_C, 
+                    update_cft(i_span, n_times, min_num_c, MID_NUM_C, MAX_NUM_C, 
                               num_c, &update_num_c);
+                    if (conse_kern == NULL || conse_kern->df != update_num_c)
+                        conse_kern = select_ts_kernels(TOTAL_IMAGE_BANDS, 
+                                                       update_num_c, precision);
 
                     /************************************************************/
                     /*                                                          */
@@ -2148,7 +3907,7 @@ int main (int argc, char *argv[])
                     /*                                                          */
                     /************************************************************/
 
-                    if (i_count == 0 || i_span <= (N_TIMES * MAX_NUM_C))
+                    if (i_count == 0 || i_span <= (n_times * MAX_NUM_C))
                     {
                         /**********************************************/
                         /*                                            */
@@ -2156,18 +3915,19 @@ int main (int argc, char *argv[])
                         /*                                            */
                         /**********************************************/
 
-                        i_count = clrx[i-1] - clrx[i_start-1];
+                        i_count = OBS_T(obs, i-1) - OBS_T(obs, i_start-1);
 
-                        for (i_b = 0; i_b < TOTAL_IMAGE_BANDS; i_b++)
-                        {
-                            status = auto_ts_fit(clrx, clry, i_b, i_start-1, i-1, update_num_c, 
-                                                 fit_cft, &rmse[i_b], rec_v_dif); 
-                            if (status != SUCCESS) 
-			    { 
-                                RETURN_ERROR ("Calling auto_ts_fit during continuous monitoring\n", 
-                                              FUNC_NAME, FAILURE);
-			    }
+                        status = auto_ts_fit_bands(obs, basis, fit_blist, num_fit_bands,
+                                     i_start-1, i-1, update_num_c, lambda, fit_cft, 
+                                     rmse, rec_v_dif); 
+                        if (status != SUCCESS) 
+                        { 
+                            RETURN_ERROR ("Calling auto_ts_fit during continuous monitoring\n", 
+                                          FUNC_NAME, FAILURE);
                         }
+                        cur_fit.start = i_start-1;
+                        cur_fit.end = i-1;
+                        cur_fit.df = update_num_c;
 
                         /**********************************************/
                         /*                                            */
@@ -2177,8 +3937,8 @@ int main (int argc, char *argv[])
                         /*                                            */
                         /**********************************************/
 
-                        rec_cg[num_fc].t_start = clrx[i_start-1]; 
-                        rec_cg[num_fc].t_end = clrx[i-1]; 
+                        rec_cg[num_fc].t_start = OBS_T(obs, i_start-1); 
+                        rec_cg[num_fc].t_end = OBS_T(obs, i-1); 
 
                         /**********************************************/
                         /*                                            */
@@ -2245,45 +4005,27 @@ int main (int argc, char *argv[])
                         /*                                            */
                         /**********************************************/
 
-                        for (i_conse = 0; i_conse < CONSE; i_conse++)
+                        for (b = 0; b < NUM_LASSO_BANDS; b++)
                         {
-                            v_dif_norm = 0.0;
-                            for (i_b = 0; i_b < TOTAL_IMAGE_BANDS; i_b++)
-                            {
-                                /**************************************/
-                                /*                                    */
-                                /* Absolute differences.              */
-                                /*                                    */
-                                /**************************************/
-
-        	 	        auto_ts_predict(clrx, fit_cft, update_num_c, i_b, i+i_conse, i+i_conse, 
-                                                &ts_pred_temp);
-                                v_dif_mag[i_b][i_conse] = (float)clry[i_b][i+i_conse] - ts_pred_temp; 
-
-                                /**************************************/
-                                /*                                    */
-                                /* Normalize to z-score.              */
-                                /*                                    */
-                                /**************************************/
+                            z_rmse[b] = max(adj_rmse[lasso_blist[b]], 
+                                            rmse[lasso_blist[b]]);
+                        }
 
-                                for (b = 0; b < NUM_LASSO_BANDS; b++)
-                                {
-                                    if (i_b == lasso_blist[b])
-                                    {
-                                        /******************************/
-                                        /*                            */
-                                        /* Minimum rmse,              */ 
-                                        /* z-scores.                  */
-                                        /*                            */
-                                        /******************************/
-
-                                        mini_rmse = max(adj_rmse[i_b], rmse[i_b]);
-                                        v_diff[b][i_conse] = v_dif_mag[i_b][i_conse] / mini_rmse;
-                                        v_dif_norm += v_diff[b][i_conse] * v_diff[b][i_conse];
-                                    }
-                                }
-                            }
-                            vec_mag[i_conse] = v_dif_norm;
+                        status = auto_ts_predict_conse(obs, basis, fit_cft, 
+                                     conse_kern, i, conse, lasso_blist, 
+                                     NUM_LASSO_BANDS, z_rmse, 0, conse, vec_mag, 
+                                     v_dif_mag);
+                        if (status != SUCCESS)
+                        {
+                            RETURN_ERROR ("Calling auto_ts_predict_conse during "
+                                          "continuous monitoring\n", FUNC_NAME, FAILURE);
+                        }
+                        conse_head = 0;
+                        if (lazy_fit)
+                        {
+                            for (i_conse = 0; i_conse < conse; i_conse++)
+                                record_lazy_slot(&lazy_win, i_conse, obs, i+i_conse, 
+                                                 lazy_blist, &cur_fit);
                         }
 
                         /**********************************************/
@@ -2308,11 +4050,12 @@ int main (int argc, char *argv[])
                             ids_old[k] = ids[k];
 			}
                         ids_old_len = ids_len;
+                        season_index_build(season, obs, ids_old, ids_old_len);
 
                     }
                     else
                     {
-        		if ((float)(clrx[i-1] - clrx[i_start-1]) >= (1.33*(float)i_count))
+        		if ((float)(OBS_T(obs, i-1) - OBS_T(obs, i_start-1)) >= (1.33*(float)i_count))
                         {
                             /******************************************/
                             /*                                        */
@@ -2320,18 +4063,19 @@ int main (int argc, char *argv[])
                             /*                                        */
                             /******************************************/
 
-                            i_count = clrx[i-1] - clrx[i_start-1];
+                            i_count = OBS_T(obs, i-1) - OBS_T(obs, i_start-1);
 
-                            for (i_b = 0; i_b < TOTAL_IMAGE_BANDS; i_b++)
+                            status = auto_ts_fit_bands(obs, basis, fit_blist, 
+                                         num_fit_bands, i_start-1, i-1, update_num_c, 
+                                         lambda, fit_cft, rmse, rec_v_dif); 
+                            if (status != SUCCESS)  
                             {
-                                status = auto_ts_fit(clrx, clry, i_b, i_start-1, i-1, update_num_c, 
-                                                 fit_cft, &rmse[i_b], rec_v_dif); 
-                                if (status != SUCCESS)  
-				{
-                                    RETURN_ERROR ("Calling auto_ts_fit for change detection with "
-                                         "enough observations\n", FUNC_NAME, FAILURE);
-				}
+                                RETURN_ERROR ("Calling auto_ts_fit for change detection with "
+                                     "enough observations\n", FUNC_NAME, FAILURE);
                             }
+                            cur_fit.start = i_start-1;
+                            cur_fit.end = i-1;
+                            cur_fit.df = update_num_c;
 
                             /******************************************/
                             /*                                        */
@@ -2390,6 +4134,8 @@ int main (int argc, char *argv[])
                                 ids_old[k] = ids[k];
 			    }
                             ids_old_len = ids_len;
+                            season_index_build(season, obs, ids_old, 
+                                               ids_old_len);
 
                         }
 
@@ -2399,7 +4145,7 @@ int main (int argc, char *argv[])
                         /*                                            */
                         /**********************************************/
 
-                        rec_cg[num_fc].t_end = clrx[i-1];
+                        rec_cg[num_fc].t_end = OBS_T(obs, i-1);
 
                         /**********************************************/
                         /*                                            */
@@ -2407,12 +4153,13 @@ int main (int argc, char *argv[])
                         /*                                            */
                         /**********************************************/
 
-                        n_rmse = N_TIMES * rec_cg[num_fc].category;
+                        n_rmse = n_times * rec_cg[num_fc].category;
 
                         /**********************************************/
                         /*                                            */
                         /* Better days counting for RMSE calculating  */
-                        /* relative days distance.                    */
+                        /* relative days distance: the n_rmse fit     */
+                        /* observations closest in day of year.       */
                         /*                                            */
                         /**********************************************/
 
@@ -2422,34 +4169,8 @@ int main (int argc, char *argv[])
                                          FUNC_NAME, FAILURE);
 			}
 
-                        d_yr = malloc(ids_old_len * sizeof(float));
-                        if (d_yr == NULL)
-			{
-                            RETURN_ERROR ("Allocating d_yr memory", 
-                                         FUNC_NAME, FAILURE);
-			}
- 
-                        for(m = 0; m < ids_old_len; m++)
-                        {
-                            d_rt = clrx[ids_old[m]] - clrx[i+CONSE-1]; 
-                            d_yr[m] = fabs(round((float)d_rt / NUM_YEARS) * NUM_YEARS - (float)d_rt);
-                        }
-
-                        for (b = 0; b < TOTAL_IMAGE_BANDS; b++)
-                        {
-                            for (m = 0; m < ids_old_len; m++)
-                                rec_v_dif_copy[b][m] = rec_v_dif[b][m];
-                        }
-
-                        /**********************************************/
-                        /*                                            */
-                        /* Sort the rec_v_dif based on d_yr.          */
-                        /*                                            */
-                        /**********************************************/
-
-                        quick_sort_2d_float(d_yr, rec_v_dif_copy, 0, ids_old_len-1);
-                        for(b = 0; b < NUM_LASSO_BANDS; b++)
-                            tmpcg_rmse[b] = 0.0;
+                        n_rmse_ids = season_index_closest(season, 
+                                         OBS_T(obs, i+conse-1), n_rmse, rmse_ids);
 
                         /**********************************************/
                         /*                                            */
@@ -2459,82 +4180,42 @@ int main (int argc, char *argv[])
 
                         for (b = 0; b < NUM_LASSO_BANDS; b++)
                         {
-                            matlab_2d_array_norm(rec_v_dif_copy, lasso_blist[b], n_rmse,
-                                             &tmpcg_rmse[b]);
+                            matlab_2d_array_norm_ids(rec_v_dif, lasso_blist[b], 
+                                             rmse_ids, n_rmse_ids, &tmpcg_rmse[b]);
                             tmpcg_rmse[b] /= sqrt(n_rmse - rec_cg[num_fc].category);
                         }
 
                         /**********************************************/
                         /*                                            */
-                        /* Free allocated memories.                   */
-                        /*                                            */
-                        /**********************************************/
-                        free(d_yr);
-
-                        /**********************************************/
-                        /*                                            */
-                        /* Move the ith col to i-1th col.             */
+                        /* Slide the window: the newest observation   */
+                        /* replaces the oldest slot of the ring.      */
                         /*                                            */
                         /**********************************************/
 
-                        for (m = 0; m < CONSE-1; m++)
+                        for (b = 0; b < NUM_LASSO_BANDS; b++)
                         {
-                            vec_mag[m] = vec_mag[m+1];
-                            for (b = 0; b < NUM_LASSO_BANDS; b++)
-                                v_diff[b][m] = v_diff[b][m+1];
-                            for (b = 0; b < TOTAL_IMAGE_BANDS; b++)
-                                v_dif_mag[b][m] = v_dif_mag[b][m+1];
+                            z_rmse[b] = max(adj_rmse[lasso_blist[b]], tmpcg_rmse[b]);
                         }
 
-                        for (b = 0; b < NUM_LASSO_BANDS; b++)
-                            v_diff[b][CONSE-1] = 0.0;
-                        for (b = 0; b < TOTAL_IMAGE_BANDS; b++)
-                            v_dif_mag[b][CONSE-1] = 0.0;
-                        vec_mag[CONSE-1] = 0.0;
-
-                        for (i_b = 0; i_b < TOTAL_IMAGE_BANDS; i_b++)
+                        status = auto_ts_predict_conse(obs, basis, fit_cft, 
+                                     conse_kern, i+conse-1, 1, lasso_blist, 
+                                     NUM_LASSO_BANDS, z_rmse, conse_head, conse, 
+                                     vec_mag, v_dif_mag);
+                        if (status != SUCCESS)
                         {
-                            /******************************************/
-                            /*                                        */
-                            /* Absolute difference for all bands.     */
-                            /*                                        */
-                            /******************************************/
-
-        		    auto_ts_predict(clrx, fit_cft, update_num_c, i_b, i+CONSE-1, 
-                                 i+CONSE-1, &ts_pred_temp);
-                            v_dif_mag[i_b][CONSE-1] = clry[i_b][i+CONSE-1] - ts_pred_temp;
-
-                            /******************************************/
-                            /*                                        */
-                            /* Normalized to z-scores.                */
-                            /*                                        */
-                            /******************************************/
-                            for (b = 0; b < NUM_LASSO_BANDS; b++)
-                            {
-                                if (i_b == lasso_blist[b])
-                                {
-                                    /**********************************/
-                                    /*                                */
-                                    /* Minimum rmse.                  */
-                                    /*                                */
-                                    /**********************************/
-                                    mini_rmse = max(adj_rmse[i_b], tmpcg_rmse[b]);
-
-                                    /**********************************/
-                                    /*                                */
-                                    /* Z-score.                       */
-                                    /*                                */
-                                    /**********************************/
-
-                                    v_diff[b][CONSE-1] = v_dif_mag[i_b][CONSE-1] / mini_rmse;
-                                    vec_mag[CONSE-1] += v_diff[b][CONSE-1] * v_diff[b][CONSE-1]; 
-                                }         
-                            }
+                            RETURN_ERROR ("Calling auto_ts_predict_conse for change "
+                                          "detection\n", FUNC_NAME, FAILURE);
+                        }
+                        if (lazy_fit)
+                        {
+                            record_lazy_slot(&lazy_win, conse_head, obs, i+conse-1, 
+                                             lazy_blist, &cur_fit);
                         }
+                        conse_head = (conse_head + 1) % conse;
 		    }
 
                     break_mag = 9999.0;
-                    for (m = 0; m < CONSE; m++)
+                    for (m = 0; m < conse; m++)
                     {
                         if (break_mag > vec_mag[m])
 			{
@@ -2542,13 +4223,10 @@ int main (int argc, char *argv[])
 			}
                     }
 
-                    if (break_mag > T_CG)
+                    if (break_mag > t_cg)
                     {
 
-                        if (verbose)
-                        {
-                            printf("Change Magnitude = %.2f\n", break_mag - T_CG);
-                        }
+                        LOG_INFO("Change Magnitude = %.2f\n", break_mag - t_cg);
 
                         /**********************************************/
                         /*                                            */
@@ -2556,13 +4234,39 @@ int main (int argc, char *argv[])
                         /*                                            */
                         /**********************************************/
 
-                        rec_cg[num_fc].t_break = clrx[i];
+                        rec_cg[num_fc].t_break = OBS_T(obs, i);
                         rec_cg[num_fc].change_prob = 1.0;
 
+                        if (lazy_fit)
+                        {
+                            /******************************************/
+                            /*                                        */
+                            /* Curve is recorded, fit the lazy bands. */
+                            /*                                        */
+                            /******************************************/
+
+                            status = fit_lazy_bands(obs, basis, lazy_blist, 
+                                         &lazy_win, conse_head, &cur_fit, params, 
+                                         fit_cft, rmse, v_dif_mag, temp_v_dif);
+                            if (status != SUCCESS)
+                            {
+                                RETURN_ERROR ("Calling fit_lazy_bands at a break\n", 
+                                              FUNC_NAME, FAILURE);
+                            }
+                            for (k = 0; k < NUM_LAZY_BANDS; k++)
+                            {
+                                for (m = 0; m < MAX_NUM_C; m++)
+                                    rec_cg[num_fc].coefs[lazy_blist[k]][m] = 
+                                        fit_cft[lazy_blist[k]][m];
+                                rec_cg[num_fc].rmse[lazy_blist[k]] = rmse[lazy_blist[k]];
+                            }
+                        }
+
+                        rotate_conse_window(vec_mag, v_dif_mag, conse, &conse_head);
                         for (i_b = 0; i_b < TOTAL_IMAGE_BANDS; i_b++)
 			{
-                            quick_sort_float(v_dif_mag[i_b], 0, CONSE-1);
-                            matlab_2d_float_median(v_dif_mag, i_b, CONSE,
+                            sort_float(v_dif_mag[i_b], conse);
+                            matlab_2d_float_median(v_dif_mag, i_b, conse,
                                                    &rec_cg[num_fc].magnitude[i_b]);
 			}
                         /**********************************************/
@@ -2607,7 +4311,7 @@ int main (int argc, char *argv[])
 
                         bl_train = 0;
                     }
-                    else if (vec_mag[0] > T_MAX_CG)
+                    else if (vec_mag[conse_head] > t_max_cg)
                     {
                         /**********************************************/
                         /*                                            */
@@ -2615,21 +4319,18 @@ int main (int argc, char *argv[])
                         /*                                            */
                         /**********************************************/
 
-                        for (m = i; m < end -1; m++)
-                        {
-                            clrx[m] = clrx[m+1];
-                            for (b = 0; b < TOTAL_IMAGE_BANDS; b++)
-                                clry[b][m] = clry[b][m+1];
-                        }
+                        /**********************************************/
+                        /*                                            */
+                        /* The series keeps its length, the last      */
+                        /* observation is repeated.                   */
+                        /*                                            */
+                        /**********************************************/
+
+                        obs_store_remove(obs, i);
+                        obs_store_extend(obs);
 
                         i--;   /* stay & check again after noise removal */
                     }
-                    status = free_2d_array ((void **) v_diff);
-                    if (status != SUCCESS)
-		    {
-                        RETURN_ERROR ("Freeing memory: v_diff\n", 
-                                      FUNC_NAME, FAILURE);
-		    }
 		} /* end of continuous monitoring */ 
 	    }  /* end of checking basic requrirements */ 
 
@@ -2659,9 +4360,35 @@ int main (int argc, char *argv[])
             /*                                                        */
             /**********************************************************/
 
-            for (i_conse = CONSE - 1; i_conse >= 0; i_conse--)
+            if (lazy_fit)
+            {
+                /******************************************************/
+                /*                                                    */
+                /* Last curve is recorded, fit the lazy bands.        */
+                /*                                                    */
+                /******************************************************/
+
+                status = fit_lazy_bands(obs, basis, lazy_blist, &lazy_win, 
+                             conse_head, &cur_fit, params, fit_cft, rmse, 
+                             v_dif_mag, temp_v_dif);
+                if (status != SUCCESS)
+                {
+                    RETURN_ERROR ("Calling fit_lazy_bands at the end of time series\n", 
+                                  FUNC_NAME, FAILURE);
+                }
+                for (k = 0; k < NUM_LAZY_BANDS; k++)
+                {
+                    for (m = 0; m < MAX_NUM_C; m++)
+                        rec_cg[num_fc].coefs[lazy_blist[k]][m] = 
+                            fit_cft[lazy_blist[k]][m];
+                    rec_cg[num_fc].rmse[lazy_blist[k]] = rmse[lazy_blist[k]];
+                }
+            }
+
+            rotate_conse_window(vec_mag, v_dif_mag, conse, &conse_head);
+            for (i_conse = conse - 1; i_conse >= 0; i_conse--)
             {
-                if (vec_mag[i_conse] <= T_CG)
+                if (vec_mag[i_conse] <= t_cg)
                 {
                     /**************************************************/
                     /*                                                */
@@ -2680,8 +4407,9 @@ int main (int argc, char *argv[])
             /*                                                        */
             /**********************************************************/
 
-            rec_cg[num_fc].change_prob = (CONSE - id_last) / CONSE; 
-            rec_cg[num_fc].t_end = clrx[end - CONSE + id_last];
+            rec_cg[num_fc].change_prob = (conse - id_last) / conse; 
+            rec_cg[num_fc].t_end = OBS_T(obs, end - conse + id_last);
+            open_curve = true;
 
             /**********************************************************/
             /*                                                        */
@@ -2689,7 +4417,7 @@ int main (int argc, char *argv[])
             /*                                                        */
             /**********************************************************/
 
-            if (CONSE > id_last)
+            if (conse > id_last)
             {
                 /******************************************************/
                 /*                                                    */
@@ -2697,7 +4425,7 @@ int main (int argc, char *argv[])
                 /*                                                    */
                 /******************************************************/
 
-                rec_cg[num_fc].t_break = clrx[end-CONSE+id_last+1];
+                rec_cg[num_fc].t_break = OBS_T(obs, end-conse+id_last+1);
 
                 /******************************************************/
                 /*                                                    */
@@ -2707,8 +4435,8 @@ int main (int argc, char *argv[])
 
                 for (i_b = 0; i_b < TOTAL_IMAGE_BANDS; i_b++)
 		{
-                    quick_sort_float(v_dif_mag[i_b], id_last, CONSE-2);
-                    matlab_float_2d_partial_median(v_dif_mag, i_b, id_last, CONSE-1,
+                    sort_float(&v_dif_mag[i_b][id_last], conse - 1 - id_last);
+                    matlab_float_2d_partial_median(v_dif_mag, i_b, id_last, conse-1,
                                          &rec_cg[num_fc].magnitude[i_b]);
 		}
 	    }
@@ -2739,7 +4467,7 @@ int main (int argc, char *argv[])
             {
                 for (k = 0; k < valid_num_scenes; k++) 
                 {
-                     if (clrx[k] >= rec_cg[num_fc-1].t_break)
+                     if (OBS_T(obs, k) >= rec_cg[num_fc-1].t_break)
 		     {
                          i_start = k + 1;
 			 break;
@@ -2752,7 +4480,7 @@ int main (int argc, char *argv[])
                 bl_ids[m] = 0;
 	    }
 
-	    if ((end - i_start + 1) > CONSE)
+	    if ((end - i_start + 1) > conse)
 	    {
                 /******************************************************/
                 /*                                                    */
@@ -2760,8 +4488,8 @@ int main (int argc, char *argv[])
                 /*                                                    */
                 /******************************************************/
 
-                status = auto_mask(clrx, clry, i_start-1, end-1,
-                               (float)(clrx[end-1]-clrx[i_start-1]) / NUM_YEARS, 
+                status = auto_mask(obs, basis, i_start-1, end-1,
+                               (float)(OBS_T(obs, end-1)-OBS_T(obs, i_start-1)) / NUM_YEARS, 
                                adj_rmse[1], adj_rmse[4], T_CONST, bl_ids);
                 if (status != SUCCESS)
                     RETURN_ERROR("ERROR calling auto_mask at the end of time series", 
@@ -2769,72 +4497,45 @@ int main (int argc, char *argv[])
 
                 /******************************************************/
                 /*                                                    */
-                /* Clears the IDs buffers.                            */
-                /*                                                    */
-                /******************************************************/
-
-                for (m = 0; m < valid_num_scenes-1; m++)
-        	{
-                    ids[m] = 0;
-	        }
-
-                /******************************************************/
-                /*                                                    */
-                /* IDs to be removed.                                 */
+                /* Remove noise pixels between i_start & i.  As       */
+                /* before, the flagged positions are matched against  */
+                /* the first end-i_start+1 positions of the series,   */
+                /* which is all that is kept.                         */
                 /*                                                    */
                 /******************************************************/
 
-                for (k = i_start-1; k < end; k++)
-		{
-                    ids[k-i_start+1] = k;
-      	        }
-                m= 0;
                 i_span = 0;
                 for (k = 0; k < end-i_start+1; k++)
                 {
-                    if (bl_ids[k] == 1) 
-                    {
-                        rm_ids[m] = ids[k];
-                        m++;
-                    }
-                    else
+                    if (bl_ids[k] != 1)
                         i_span++;  /* update i_span after noise removal */
                 }
-                rm_ids_len = m;
-
-                /******************************************************/
-                /*                                                    */
-                /* Remove noise pixels between i_start & i .          */
-                /*                                                    */
-                /******************************************************/
 
-                m = 0;
-                for (k = 0, k_new=0; k < end-i_start+1; k++)
-                {
-                    if (m < rm_ids_len && k == rm_ids[m])
-                    {
-                        m++;
-			continue;
-                    }
-                    clrx[k_new] = clrx[k];
-                    for (i_b = 0; i_b < TOTAL_IMAGE_BANDS; i_b++)
-                        clry[i_b][k_new] = clry[i_b][k];
-                    k_new++;
-                }
-                end = k_new;
+                obs_store_truncate(obs, end - i_start + 1);
+                obs_store_compact(obs, i_start-1, end-i_start+1, bl_ids);
+                end = obs->len;
 	    }
 
-	    if ((end - i_start + 1) >= CONSE)
+            /**********************************************************/
+            /*                                                        */
+            /* The noise removal of the monitoring loop repeats the   */
+            /* last observation, so with a large conse the window can */
+            /* hold a single date.  Every predictor is then constant  */
+            /* and no model of any df can be fit: no curve is         */
+            /* recorded, as for a window shorter than conse.          */
+            /*                                                        */
+            /**********************************************************/
+
+	    if ((end - i_start + 1) >= conse &&
+                OBS_T(obs, end-1) > OBS_T(obs, i_start-1))
 	    {
-                for (i_b = 0; i_b < TOTAL_IMAGE_BANDS; i_b++)
+                status = auto_ts_fit_bands(obs, basis, all_blist, TOTAL_IMAGE_BANDS,
+                             i_start-1, end-1, min_num_c, lambda, fit_cft, rmse, 
+                             temp_v_dif); 
+                if (status != SUCCESS)  
                 {
-                    status = auto_ts_fit(clrx, clry, i_b, i_start-1, end-1, MIN_NUM_C, 
-                                         fit_cft, &rmse[i_b], temp_v_dif); 
-                    if (status != SUCCESS)  
-		    {
-                         RETURN_ERROR ("Calling auto_ts_fit at the end of time series\n", 
-                                FUNC_NAME, FAILURE);
-		    }
+                     RETURN_ERROR ("Calling auto_ts_fit at the end of time series\n", 
+                            FUNC_NAME, FAILURE);
                 }
 
                 /******************************************************/
@@ -2846,13 +4547,13 @@ int main (int argc, char *argv[])
 
 	        if (num_fc == rec_fc)
 	        {
-                    rec_cg[num_fc].t_start = clrx[0];
+                    rec_cg[num_fc].t_start = OBS_T(obs, 0);
 	        }
 	        else
 	        {
                     rec_cg[num_fc].t_start = rec_cg[num_fc-1].t_break;
 	        }
-                rec_cg[num_fc].t_end = clrx[end-1];
+                rec_cg[num_fc].t_end = OBS_T(obs, end-1);
                 rec_cg[num_fc].t_break = 0;
                 rec_cg[num_fc].pos.row = row;
                 rec_cg[num_fc].pos.col = col;
@@ -2881,7 +4582,7 @@ int main (int argc, char *argv[])
 
                 rec_cg[num_fc].change_prob = 0.0;
                 rec_cg[num_fc].num_obs = i_span;
-                rec_cg[num_fc].category = 20 + MIN_NUM_C; /* simple model fit at the end */
+                rec_cg[num_fc].category = 20 + min_num_c; /* simple model fit at the end */
 
                 /******************************************************/
                 /*                                                    */
@@ -2911,101 +4612,29 @@ int main (int argc, char *argv[])
 		}
 	    }
         }
-    }
-
-    free(updated_fmask_buf);
-    status = free_2d_array ((void **) buf);
-    if (status != SUCCESS)
-    {
-        RETURN_ERROR ("Freeing memory: buf\n", 
-                      FUNC_NAME, FAILURE);
-    }
-
-    /******************************************************************/
-    /*                                                                */
-    /* Free memory allocations for this section.                      */
-    /*                                                                */
-    /******************************************************************/
 
-    free(updated_sdate_array);
-    free(clrx);
-    free(rmse);
-    free(vec_mag);
-    free(id_range);
-    status = free_2d_array ((void **) rec_v_dif);
-    if (status != SUCCESS)
-    {
-        RETURN_ERROR ("Freeing memory: rec_v_dif\n", 
-                      FUNC_NAME, FAILURE);
-    }
-    status = free_2d_array ((void **) rec_v_dif_copy);
-    if (status != SUCCESS)
-    {
-        RETURN_ERROR ("Freeing memory: rec_v_dif_copy\n",
-                      FUNC_NAME, FAILURE);
-    }
-    status = free_2d_array ((void **) v_dif_mag);
-    if (status != SUCCESS)
-    {
-        RETURN_ERROR ("Freeing memory: v_dif_mag\n", 
-                   FUNC_NAME, FAILURE);
-    }
+        /**************************************************************/
+        /*                                                            */
+        /* The full loop ran behind the shortcut: it must have kept   */
+        /* the curve open and recorded it the same way.               */
+        /*                                                            */
+        /**************************************************************/
 
-    if (!std_in)
-    {
-        free(fmask_buf);
-        free(meta);
-        free(sdate);
-        if (strcmp(data_type, "tifs") == 0)
+        if (fast_fc >= 0)
         {
-            status = free_2d_array ((void **) fp_tifs);
-            if (status != SUCCESS)
+            if (num_fc != fast_fc || !same_curve_record(&rec_cg[fast_fc], 
+                                                        &fast_rec))
             {
-                RETURN_ERROR ("Freeing memory: fp_tifs\n", FUNC_NAME,
-                              FAILURE);
+                fast_stats.mismatch++;
+                if (!std_out)
+                {
+                    snprintf (msg_str, sizeof(msg_str), "Stable fast path "
+                              "record of row %d col %d differs from the full "
+                              "loop\n", row, col);
+                    WARNING_MESSAGE (msg_str, FUNC_NAME);
+                }
             }
         }
-        else if (strcmp(data_type, "bip") == 0)
-        {
-            free(fp_bip);
-        }
-        status = free_2d_array ((void **) scene_list);
-        if (status != SUCCESS)
-        {
-            RETURN_ERROR ("Freeing memory: scene_list\n", FUNC_NAME,
-                      FAILURE);
-        }
-        status = free_2d_array ((void **) valid_scene_list);
-        if (status != SUCCESS)
-        {
-            RETURN_ERROR ("Freeing memory: valid_scene_list\n", FUNC_NAME,
-                      FAILURE);
-        }
-    }
-
-    free(ids);
-    free(ids_old);
-    free(rm_ids);
-    free(bl_ids);
-    status = free_2d_array ((void **) temp_v_dif);
-    if (status != SUCCESS)
-    {
-        RETURN_ERROR ("Freeing memory: temp_v_dif\n", 
-                      FUNC_NAME, FAILURE);
-    }
-
-    status = free_2d_array ((void **) clry);
-    if (status != SUCCESS)
-    {
-        RETURN_ERROR ("Freeing memory: clry\n", FUNC_NAME,
-                      FAILURE);
-    }
-
-    status = free_2d_array ((void **) fit_cft);
-    if (status != SUCCESS)
-    {
-        RETURN_ERROR ("Freeing memory: fit_cft\n", FUNC_NAME,
-                      FAILURE);
     }
 
     /******************************************************************/
@@ -3017,14 +4646,45 @@ int main (int argc, char *argv[])
     /*                                                                */
     /******************************************************************/
 
-    if (!std_out)
+    if (!std_out && screen_cell > 1)
+    {
+        /**************************************************************/
+        /*                                                            */
+        /* A screening run only ranks its cell: one line per cell,    */
+        /* row col cell breaks, for schedulePriority.pl.              */
+        /*                                                            */
+        /**************************************************************/
+
+        n_break = 0;
+        for (i = 0; i < num_fc; i++)
+        {
+            if (rec_cg[i].t_break != 0)
+                n_break++;
+        }
+        if (num_params > 1)
+            snprintf(output_priority, sizeof(output_priority),
+                     "%s/priority_%d.txt", out_path, cfg);
+        else
+            snprintf(output_priority, sizeof(output_priority),
+                     "%s/priority.txt", out_path);
+        fp_priority_out = out_buffer_open(px->out, output_priority);
+        if (fp_priority_out == NULL)
+        {
+            RETURN_ERROR ("Opening priority.txt file\n", FUNC_NAME,
+                          FAILURE);
+        }
+        fprintf(fp_priority_out, "%d %d %d %d\n", row, col, screen_cell,
+                n_break);
+    }
+    else if (!std_out)
     {
-        strcpy(output_binary, out_path);
-        strcat(output_binary, "/output.bin");
-        if (access(output_binary, F_OK) != 0) /* File does not exist */
-            fp_bin_out = fopen(output_binary, "wb");
+        if (num_params > 1)
+            snprintf(output_binary, sizeof(output_binary), "%s/output_%d.bin", 
+                     out_path, cfg);
         else
-            fp_bin_out = fopen(output_binary, "ab");
+            snprintf(output_binary, sizeof(output_binary), "%s/output.bin", 
+                     out_path);
+        fp_bin_out = out_buffer_open(px->out, output_binary);
         if (fp_bin_out == NULL)
         {
             RETURN_ERROR ("Opening output.bin file\n", FUNC_NAME,
@@ -3046,7 +4706,83 @@ int main (int argc, char *argv[])
                 RETURN_ERROR ("Writing output.bin file\n", FUNC_NAME, FAILURE);
             }
         }
-        fclose(fp_bin_out);   
+
+        /**************************************************************/
+        /*                                                            */
+        /* Fast path counters of the pixel, one line per run:         */
+        /* row col checked fired mismatch.                            */
+        /*                                                            */
+        /**************************************************************/
+
+        if (fast_path)
+        {
+            if (num_params > 1)
+                snprintf(output_fast, sizeof(output_fast), 
+                         "%s/fast_path_%d.txt", out_path, cfg);
+            else
+                snprintf(output_fast, sizeof(output_fast), 
+                         "%s/fast_path.txt", out_path);
+            fp_fast_out = out_buffer_open(px->out, output_fast);
+            if (fp_fast_out == NULL)
+            {
+                RETURN_ERROR ("Opening fast_path.txt file\n", FUNC_NAME,
+                              FAILURE);
+            }
+            fprintf(fp_fast_out, "%d %d %d %d %d\n", row, col, 
+                    fast_stats.checked, fast_stats.fired, fast_stats.mismatch);
+        }
+
+        /**************************************************************/
+        /*                                                            */
+        /* Neighbor warm start counters of the pixel, one line per    */
+        /* run: row col fits warm first_pass warm_passes cold_passes  */
+        /* mismatch.                                                  */
+        /*                                                            */
+        /**************************************************************/
+
+        if (basis->lasso_warm != NULL)
+        {
+            if (num_params > 1)
+                snprintf(output_neighbor, sizeof(output_neighbor), 
+                         "%s/neighbor_%d.txt", out_path, cfg);
+            else
+                snprintf(output_neighbor, sizeof(output_neighbor), 
+                         "%s/neighbor.txt", out_path);
+            fp_neighbor_out = out_buffer_open(px->out, output_neighbor);
+            if (fp_neighbor_out == NULL)
+            {
+                RETURN_ERROR ("Opening neighbor.txt file\n", FUNC_NAME,
+                              FAILURE);
+            }
+            fprintf(fp_neighbor_out, "%d %d %d %d %d %ld %ld %d\n", row, col,
+                    basis->lasso_warm->stats.fits, 
+                    basis->lasso_warm->stats.warm,
+                    basis->lasso_warm->stats.first_pass, 
+                    basis->lasso_warm->stats.warm_passes,
+                    basis->lasso_warm->stats.cold_passes, 
+                    basis->lasso_warm->stats.mismatch);
+        }
+    }
+
+    if (verbose && fast_path)
+    {
+        snprintf (msg_str, sizeof(msg_str), "Stable fast path checked=%d "
+                  "fired=%d mismatch=%d\n", fast_stats.checked, 
+                  fast_stats.fired, fast_stats.mismatch);
+        LOG_MESSAGE (msg_str, FUNC_NAME);
+    }
+
+    if (verbose && basis->lasso_warm != NULL)
+    {
+        snprintf (msg_str, sizeof(msg_str), "Neighbor warm start fits=%d "
+                  "warm=%d first_pass=%d warm_passes=%ld cold_passes=%ld "
+                  "mismatch=%d\n", basis->lasso_warm->stats.fits,
+                  basis->lasso_warm->stats.warm,
+                  basis->lasso_warm->stats.first_pass,
+                  basis->lasso_warm->stats.warm_passes,
+                  basis->lasso_warm->stats.cold_passes,
+                  basis->lasso_warm->stats.mismatch);
+        LOG_MESSAGE (msg_str, FUNC_NAME);
     }
 
     /******************************************************************/
@@ -3057,55 +4793,49 @@ int main (int argc, char *argv[])
     /*                                                                */
     /******************************************************************/
 
-    if (verbose)
+    if (LOG_ENABLED(LOG_LEVEL_DEBUG))
     {
         if (num_fc == 0)
 	{
-            printf("rec_cg[0].t_start=%d\n",rec_cg[0].t_start);
-            printf("rec_cg[0].t_end=%d\n",rec_cg[0].t_end);
-            printf("rec_cg[0].t_break=%d\n",rec_cg[0].t_break);
-            printf("rec_cg[0].pos.row=%d\n",rec_cg[0].pos.row);
-            printf("rec_cg[0].pos.col=%d\n",rec_cg[0].pos.col);
-            printf("rec_cg[0].num_obs=%d\n",rec_cg[0].num_obs);
-            printf("rec_cg[0].category=%d\n",rec_cg[0].category);
+            LOG_DEBUG("rec_cg[0].t_start=%d\n",rec_cg[0].t_start);
+            LOG_DEBUG("rec_cg[0].t_end=%d\n",rec_cg[0].t_end);
+            LOG_DEBUG("rec_cg[0].t_break=%d\n",rec_cg[0].t_break);
+            LOG_DEBUG("rec_cg[0].pos.row=%d\n",rec_cg[0].pos.row);
+            LOG_DEBUG("rec_cg[0].pos.col=%d\n",rec_cg[0].pos.col);
+            LOG_DEBUG("rec_cg[0].num_obs=%d\n",rec_cg[0].num_obs);
+            LOG_DEBUG("rec_cg[0].category=%d\n",rec_cg[0].category);
             for (i_b = 0; i_b < TOTAL_IMAGE_BANDS; i_b++)
             {
                 for (k = 0; k < update_num_c; k++)
 		{
-                    if (debug)
-                    {
-                        printf("i_b,k,rec_cg[0].coefs[i_b][k] = %d,%d,%f\n", 
-                                i_b,k,rec_cg[0].coefs[i_b][k]); 
-                    }
+                    LOG_DEBUG("i_b,k,rec_cg[0].coefs[i_b][k] = %d,%d,%f\n", 
+                              i_b,k,rec_cg[0].coefs[i_b][k]); 
 		}
-                if (debug)
-                {
-                    printf("rec_cg[0].rmse[%d] = %f\n",i_b,rec_cg[0].rmse[i_b]);
-                    printf("rec_cg[0].magnitude[%d]=%f\n",i_b,rec_cg[0].magnitude[i_b]); 
-                }
+                LOG_DEBUG("rec_cg[0].rmse[%d] = %f\n",i_b,rec_cg[0].rmse[i_b]);
+                LOG_DEBUG("rec_cg[0].magnitude[%d]=%f\n",i_b,rec_cg[0].magnitude[i_b]); 
             }
 	}
 	else
 	{
             for (i = 0; i < num_fc; i++)
             {
-                printf("i=%d\n",i);
-                printf("rec_cg[%d].t_start=%d\n",i,rec_cg[i].t_start);
-                printf("rec_cg[%d].t_end=%d\n",i,rec_cg[i].t_end);
-                printf("rec_cg[%d].t_break=%d\n",i,rec_cg[i].t_break);
-                printf("rec_cg[%d].pos.row=%d\n",i,rec_cg[i].pos.row);
-                printf("rec_cg[%d].pos.col=%d\n",i,rec_cg[i].pos.col);
-                printf("rec_cg[%d].num_obs=%d\n",i,rec_cg[i].num_obs);
-                printf("rec_cg[%d].category=%d\n",i,rec_cg[i].category);
+                LOG_DEBUG("i=%d\n",i);
+                LOG_DEBUG("rec_cg[%d].t_start=%d\n",i,rec_cg[i].t_start);
+                LOG_DEBUG("rec_cg[%d].t_end=%d\n",i,rec_cg[i].t_end);
+                LOG_DEBUG("rec_cg[%d].t_break=%d\n",i,rec_cg[i].t_break);
+                LOG_DEBUG("rec_cg[%d].pos.row=%d\n",i,rec_cg[i].pos.row);
+                LOG_DEBUG("rec_cg[%d].pos.col=%d\n",i,rec_cg[i].pos.col);
+                LOG_DEBUG("rec_cg[%d].num_obs=%d\n",i,rec_cg[i].num_obs);
+                LOG_DEBUG("rec_cg[%d].category=%d\n",i,rec_cg[i].category);
                 for (i_b = 0; i_b < TOTAL_IMAGE_BANDS; i_b++)
                 {
                     for (k = 0; k < update_num_c; k++)
 		    {
-                        printf("i_b,k,rec_cg[%d].coefs[i_b][k] = %d,%d,%f\n", 
-                             i,i_b,k,rec_cg[i].coefs[i_b][k]); 
+                        LOG_DEBUG("i_b,k,rec_cg[%d].coefs[i_b][k] = %d,%d,%f\n", 
+                                  i,i_b,k,rec_cg[i].coefs[i_b][k]); 
 		    }
-                    printf("rec_cg[%d].rmse[i_b] = %f\n",i,rec_cg[i].rmse[i_b]);
-                    printf("rec_cg[%d].magnitude[i_b]=%f\n",i,rec_cg[i].magnitude[i_b]); 
+                    LOG_DEBUG("rec_cg[%d].rmse[i_b] = %f\n",i,rec_cg[i].rmse[i_b]);
+                    LOG_DEBUG("rec_cg[%d].magnitude[i_b]=%f\n",i,rec_cg[i].magnitude[i_b]); 
                 }
 	    }
         }
@@ -3120,30 +4850,30 @@ int main (int argc, char *argv[])
 
     if (std_out)
     {
+        fp_rec_out = out_buffer_open(px->out, NULL);
+        if (fp_rec_out == NULL)
+        {
+            RETURN_ERROR ("Opening the stdout records\n", FUNC_NAME,
+                          FAILURE);
+        }
         if (num_fc == 0)
 	{
-            printf("%d\n",rec_cg[0].t_start);
-            printf("%d\n",rec_cg[0].t_end);
-            printf("%d\n",rec_cg[0].t_break);
-            printf("%d\n",rec_cg[0].pos.row);
-            printf("%d\n",rec_cg[0].pos.col);
-            printf("%d\n",rec_cg[0].num_obs);
-            printf("%d\n",rec_cg[0].category);
+            fprintf(fp_rec_out, "%d\n",rec_cg[0].t_start);
+            fprintf(fp_rec_out, "%d\n",rec_cg[0].t_end);
+            fprintf(fp_rec_out, "%d\n",rec_cg[0].t_break);
+            fprintf(fp_rec_out, "%d\n",rec_cg[0].pos.row);
+            fprintf(fp_rec_out, "%d\n",rec_cg[0].pos.col);
+            fprintf(fp_rec_out, "%d\n",rec_cg[0].num_obs);
+            fprintf(fp_rec_out, "%d\n",rec_cg[0].category);
             for (i_b = 0; i_b < TOTAL_IMAGE_BANDS; i_b++)
             {
                 for (k = 0; k < update_num_c; k++)
 		{
-                    if ((debug) || (std_out))
-                    {
-                        printf("%f\n", 
-                                rec_cg[0].coefs[i_b][k]); 
-                    }
+                    fprintf(fp_rec_out, "%f\n", 
+                            rec_cg[0].coefs[i_b][k]); 
 		}
-                if ((debug) || (std_out))
-                {
-                    printf("%f\n",rec_cg[0].rmse[i_b]);
-                    printf("%f\n",rec_cg[0].magnitude[i_b]); 
-                }
+                fprintf(fp_rec_out, "%f\n",rec_cg[0].rmse[i_b]);
+                fprintf(fp_rec_out, "%f\n",rec_cg[0].magnitude[i_b]); 
             }
 	}
 	else
@@ -3151,13 +4881,13 @@ int main (int argc, char *argv[])
             for (i = 0; i < num_fc; i++)
             {
                 //printf("i=%d\n",i);
-                printf("%d\n",rec_cg[i].t_start);
-                printf("%d\n",rec_cg[i].t_end);
-                printf("%d\n",rec_cg[i].t_break);
-                printf("%d\n",rec_cg[i].pos.row);
-                printf("%d\n",rec_cg[i].pos.col);
-                printf("%d\n",rec_cg[i].num_obs);
-                printf("%d\n",rec_cg[i].category);
+                fprintf(fp_rec_out, "%d\n",rec_cg[i].t_start);
+                fprintf(fp_rec_out, "%d\n",rec_cg[i].t_end);
+                fprintf(fp_rec_out, "%d\n",rec_cg[i].t_break);
+                fprintf(fp_rec_out, "%d\n",rec_cg[i].pos.row);
+                fprintf(fp_rec_out, "%d\n",rec_cg[i].pos.col);
+                fprintf(fp_rec_out, "%d\n",rec_cg[i].num_obs);
+                fprintf(fp_rec_out, "%d\n",rec_cg[i].category);
                 for (i_b = 0; i_b < TOTAL_IMAGE_BANDS; i_b++)
                 {
                     for (k = 0; k < update_num_c; k++)
@@ -3166,13 +4896,13 @@ int main (int argc, char *argv[])
                         // I belive the indecies being printed were incorrect.
                         // changed i_b,k,i
                         // to      i,i_b,k
-                        printf("%f\n", 
+                        fprintf(fp_rec_out, "%f\n", 
                              rec_cg[i].coefs[i_b][k]); 
                         //printf("i_b,k,rec_cg[%d].coefs[i_b][k] = %d,%d,%f\n", 
                         //     i_b,k,i,rec_cg[i].coefs[i_b][k]); 
 		    }
-                    printf("%f\n",rec_cg[i].rmse[i_b]);
-                    printf("%f\n",rec_cg[i].magnitude[i_b]); 
+                    fprintf(fp_rec_out, "%f\n",rec_cg[i].rmse[i_b]);
+                    fprintf(fp_rec_out, "%f\n",rec_cg[i].magnitude[i_b]); 
                 }
 	    }
         }
@@ -3180,27 +4910,20 @@ int main (int argc, char *argv[])
 
     /******************************************************************/
     /*                                                                */
-    /* Free rec_cg memory, for the final time.                        */
-    /*                                                                */
-    /******************************************************************/
-
-    free(rec_cg);
-
-    /******************************************************************/
-    /*                                                                */
-    /* Obtain the current time and log the final completion time.     */
+    /* Free rec_cg memory, for the final time, unless the caller      */
+    /* keeps it.                                                      */
     /*                                                                */
     /******************************************************************/
 
-    time (&now);
-
-    if (verbose)
+    if (recs != NULL)
     {
-        snprintf (msg_str, sizeof(msg_str), "CCDC end_time=%s\n", ctime (&now));
-        LOG_MESSAGE (msg_str, FUNC_NAME);
+        *recs = rec_cg;
+        *num_recs = open_curve ? num_fc + 1 : num_fc;
     }
+    else
+        free(rec_cg);
 
-    return SUCCESS;
+    return (SUCCESS);
 }
 
 
@@ -3234,6 +4957,23 @@ usage ()
             " [--out-path=<output directory[>"
             " [--data-type=<tifs|bip[>"
             " [--scene-list-file=<file with list of sceneIDs>]"
+            " [--lazy-fit]"
+            " [--precision=<single|double>]"
+            " [--stable-fast-path]"
+            " [--validate-fast-path]"
+            " [--sweep-file=<file with parameter sets>]"
+            " [--screen-cell=<cell side in pixels>]"
+            " [--block-rows=<rows>] [--block-cols=<cols>]"
+            " [--neighbor-warm-start]"
+            " [--log-level=<error|warn|info|debug|trace>]"
+            " [--log-file=<file>]"
+            " [--threads=<threads>]"
+            " [--read-ahead=<pixels>] [--max-buffer-mb=<MB>]"
+            " [--record-cost] [--cost-only]"
+            " [--checkpoint=<pixels>] [--resume]"
+            " [--state-dir=<directory>] [--update]"
+            " [--tune-profile=<file>]"
+            " [--numa]"
             " [--verbose]\n");
 
     printf ("\n");
@@ -3247,6 +4987,84 @@ usage ()
     printf ("    --data-type=: type of input data files to ingest\n");
     printf ("    --scene-list-file=: file name containing list of sceneIDs"
             " (default is all files in in-path)\n");
+    printf ("    --lazy-fit: fit the bands not used for change detection"
+            " only when a curve is recorded (default is false)\n");
+    printf ("    --precision=: single runs the prediction kernels in"
+            " float, falling back to double where that is not"
+            " accurate enough (default is double)\n");
+    printf ("    --stable-fast-path: record a curve without the monitoring"
+            " loop when its model provably finds no break in the rest of"
+            " the series, counted in fast_path.txt; not used with"
+            " --lazy-fit (default is false)\n");
+    printf ("    --validate-fast-path: take the stable fast path, but also"
+            " run the monitoring loop and report records that differ"
+            " (default is false)\n");
+    printf ("    --sweep-file=: file of parameter sets, one per line as"
+            " t_cg t_max_cg conse lambda n_times min_num_c; the pixel is"
+            " read once and every set is run on it, set n writing to"
+            " output_<n>.bin (default is the defines.h values)\n");
+    printf ("    --screen-cell=: screening pass; the cell of that side at"
+            " row, col is aggregated to one coarse pixel (cfmask majority,"
+            " band medians) and its number of breaks is appended to"
+            " priority.txt instead of writing output.bin, for"
+            " scripts/schedulePriority.pl; tifs and bip only, at most 16"
+            " (default is 1, off)\n");
+    printf ("    --block-rows=, --block-cols=: run the block of pixels of"
+            " that size whose upper left pixel is row, col, in row then col"
+            " order (cells with --screen-cell); from stdin, the pixels"
+            " follow each other separated by a blank line (default is 1)\n");
+    printf ("    --neighbor-warm-start: in a block, start each lasso fit from"
+            " the curve of the left or upper pixel that overlaps it most,"
+            " also fit it cold and keep the cold result when the two"
+            " differ, so the output is that of cold fits; counters go to"
+            " neighbor.txt (default is false)\n");
+    printf ("    --log-level=: most verbose messages written, error, warn,"
+            " info, debug or trace; trace, the per scene values read, is"
+            " compiled out of make release (default is warn, info with"
+            " --verbose)\n");
+    printf ("    --log-file=: append the messages to this file (default is"
+            " stdout, stderr with --out-path=stdout)\n");
+    printf ("    --threads=: threads running the pixels of the block;"
+            " the output is the same for any number, not used with"
+            " --neighbor-warm-start (default is 1)\n");
+    printf ("    --read-ahead=: pixels of the block in flight; with more"
+            " than one, reading, change detection and writing run in"
+            " their own threads and overlap (default is 4 per thread with"
+            " --threads, else 1)\n");
+    printf ("    --max-buffer-mb=: cap of the buffers of the pixels in"
+            " flight, lowering --read-ahead to fit (default is no cap)\n");
+    printf ("    --record-cost: append the cfmask counts and the run time"
+            " of each pixel to cost.txt, for scripts/calibrateCost.pl"
+            " (default is false)\n");
+    printf ("    --cost-only: only read the pixels and append their cfmask"
+            " counts to cost.txt, for scripts/scheduleCost.pl; implies"
+            " --record-cost (default is false)\n");
+    printf ("    --checkpoint=: every that many pixels of the block, flush"
+            " the output files to disk and record in checkpoint.txt the"
+            " pixels done and the size of the files; not with"
+            " --out-path=stdout (default is 0, off)\n");
+    printf ("    --resume: truncate the output files to the sizes of"
+            " checkpoint.txt, dropping any partly written pixel, and run"
+            " the pixels of the block after those it lists; the block and"
+            " parameters must be those of the checkpointed run (default"
+            " is false)\n");
+    printf ("    --state-dir=: keep the observations read of each pixel"
+            " of the block, and how far in the scene list they go, in"
+            " state_<row>_<col>.bin of this directory; tifs and bip only,"
+            " not with --resume (default is none)\n");
+    printf ("    --update: read only the scenes added to the end of the"
+            " scene list since the state of --state-dir was written, the"
+            " earlier ones coming from the state, and run the change"
+            " detection over the whole series; the output is that of a run"
+            " over the whole list (default is false)\n");
+    printf ("    --tune-profile=: take --threads and --read-ahead, when"
+            " not given, from this profile of scripts/tuneCcdc.pl"
+            " (default is in-path/tune_<host name>.txt if it exists)\n");
+    printf ("    --numa: pin the threads of --threads to the NUMA nodes,"
+            " each allocating the buffers of the pixels it is handed on"
+            " its node and stealing pixels from its own node first;"
+            " pixels stolen across nodes are counted as remote in the"
+            " --verbose report (default is false)\n");
     printf ("    -verbose: should intermediate messages be printed?"
             " (default is false)\n");
     printf ("\n");
@@ -3277,3 +5095,302 @@ usage ()
     printf ("      If in-path or out-path are not specified, current working directory is assumed.\n");
     printf ("      If scene-file-name is not specified, all scenes in in-path are processed.\n\n");
 }
+
+
+/******************************************************************************
+MODULE:  take_pixel_records
+
+PURPOSE:  Append the curve records of a pixel run in memory to the records
+          of the block, once its run finished
+
+RETURN VALUE:
+Type = int
+Value           Description
+-----           -----------
+FAILURE         Error in the run or in allocating memory
+SUCCESS         No errors encountered
+
+NOTES: The records are the ones run_parameter_set writes to output.bin,
+       taken from the output buffer of the slot instead.
+******************************************************************************/
+static int take_pixel_records
+(
+    Ccdc_block_t *block,           /* I/O: block of the run                 */
+    Pool_t *pool,                  /* I/O: pool running the pixels, NULL    */
+                                   /*      when run by the caller           */
+    int task,                      /* I: pixel of the block                 */
+    const char *path,              /* I: output.bin of the run              */
+    Output_t **recs,               /* I/O: records of the block             */
+    int *num_recs,                 /* I/O: their number                     */
+    int *max_recs                  /* I/O: allocated length of recs         */
+)
+{
+    char FUNC_NAME[] = "take_pixel_records";
+    int status;
+    char *data;                      /* Records of the pixel                  */
+    size_t len;                      /* Their size in bytes                   */
+    int n;                           /* Their number                          */
+    Output_t *grown;                 /* recs reallocated                      */
+
+    if (pool != NULL)
+    {
+        status = pool_wait(pool, task);
+        if (status != SUCCESS)
+        {
+            RETURN_ERROR ("Calling run_pixel_task", FUNC_NAME, FAILURE);
+        }
+    }
+
+    status = out_buffer_take(&block->slots[task % block->num_slots].out,
+                             path, &data, &len);
+    if (status != SUCCESS)
+    {
+        RETURN_ERROR ("Calling out_buffer_take", FUNC_NAME, FAILURE);
+    }
+
+    n = len / sizeof(Output_t);
+    if (*num_recs + n > *max_recs)
+    {
+        *max_recs = max(2 * *max_recs, *num_recs + n);
+        grown = realloc(*recs, *max_recs * sizeof(Output_t));
+        if (grown == NULL)
+        {
+            free(data);
+            RETURN_ERROR ("Allocating records memory", FUNC_NAME, FAILURE);
+        }
+        *recs = grown;
+    }
+    if (n > 0)
+        memcpy(*recs + *num_recs, data, n * sizeof(Output_t));
+    *num_recs += n;
+    free(data);
+
+    return (SUCCESS);
+}
+
+
+/******************************************************************************
+MODULE:  ccdc_run_arrays
+
+PURPOSE:  Run the change detection of a block of pixels held in memory by
+          the caller, and return their curve records
+
+RETURN VALUE:
+Type = int
+Value           Description
+-----           -----------
+FAILURE         Error in the arguments, in a pixel or in allocating memory
+SUCCESS         No errors encountered
+
+NOTES: The library entry of the core, for the Python bindings, which call
+       it with the interpreter lock released.  The pixels are loaded and
+       run as by a block run of main: on one thread in the calling thread,
+       on more in the pool, each thread with its workspace, the caller
+       loading the pixels ahead into the free slots.  The records are the
+       ones output.bin would get, in block order, whatever the threads; the
+       caller frees *recs.  The run uses the default options of main, one
+       parameter set and no output files.
+******************************************************************************/
+int ccdc_run_arrays
+(
+    const Ccdc_arrays_t *arrays, /* I: block of pixels                  */
+    const Ccdc_params_t *params, /* I: thresholds of the run            */
+    int num_threads,             /* I: threads running the pixels       */
+    Output_t **recs,             /* O: curve records, in block order    */
+    int *num_recs                /* O: their number                     */
+)
+{
+    char FUNC_NAME[] = "ccdc_run_arrays";
+    char errmsg[MAX_STR_LEN];        /* For printing error messages           */
+    int status = SUCCESS;            /* Return value from function call       */
+    char out_path[] = ".";           /* Output directory, nothing is written  */
+    char output_binary[MAX_STR_LEN]; /* output.bin taken from the slots       */
+    int fit_blist[TOTAL_IMAGE_BANDS];/* Bands refitted, all of them           */
+    int all_blist[TOTAL_IMAGE_BANDS];/* Indices of all the bands              */
+    Ccdc_pixel_t px;                 /* Fields shared by the pixels           */
+    Ccdc_block_t block;              /* Slots and workspaces of the block     */
+    Pool_t pool;                     /* Threads running pixels, more than one */
+    bool pipelined;                  /* The pool runs the pixels              */
+    int num_pixels;                  /* Pixels of the block                   */
+    int num_slots;                   /* Number of pixels in flight            */
+    int max_recs = 0;                /* Allocated length of recs              */
+    int next_out;                    /* Next pixel to take the records of     */
+    int blk;                         /* Pixel of the block being run          */
+    int *dates;                      /* Dates of the scenes                   */
+    int i;                           /* Loop counter                          */
+
+    *recs = NULL;
+    *num_recs = 0;
+
+    if (arrays->rows < 1 || arrays->cols < 1 || arrays->num_scenes < 1)
+    {
+        RETURN_ERROR ("Empty block", FUNC_NAME, FAILURE);
+    }
+    if (num_threads < 1 || num_threads > MAX_THREADS)
+    {
+        snprintf(errmsg, sizeof(errmsg), "threads must be between 1 and %d",
+                 MAX_THREADS);
+        RETURN_ERROR (errmsg, FUNC_NAME, FAILURE);
+    }
+    if (!ccdc_params_valid(params))
+    {
+        RETURN_ERROR ("Invalid parameter set", FUNC_NAME, FAILURE);
+    }
+    dates = malloc(arrays->num_scenes * sizeof(int));
+    if (dates == NULL)
+    {
+        RETURN_ERROR ("Allocating dates memory", FUNC_NAME, FAILURE);
+    }
+    for (i = 0; i < arrays->num_scenes; i++)
+    {
+        memcpy(&dates[i], arrays->sdate + i * arrays->sdate_stride,
+               sizeof(int));
+        if (i > 0 && dates[i] < dates[i - 1])
+        {
+            free(dates);
+            RETURN_ERROR ("Dates are not in ascending order", FUNC_NAME,
+                          FAILURE);
+        }
+    }
+
+    for (i = 0; i < TOTAL_IMAGE_BANDS; i++)
+    {
+        fit_blist[i] = i;
+        all_blist[i] = i;
+    }
+    memset(&px, 0, sizeof(Ccdc_pixel_t));
+    px.out_path = out_path;
+    px.precision = PRECISION_DOUBLE;
+    px.fit_blist = fit_blist;
+    px.num_fit_bands = TOTAL_IMAGE_BANDS;
+    px.all_blist = all_blist;
+    px.screen_cell = 1;
+
+    /******************************************************************/
+    /*                                                                */
+    /* The harmonic terms of the dates, for all the pixels, then the  */
+    /* slots and the workspaces, as main does.                        */
+    /*                                                                */
+    /******************************************************************/
+
+    status = build_harmonic_basis(dates, arrays->num_scenes, px.precision,
+                                  &block.basis);
+    free(dates);
+    if (status != SUCCESS)
+    {
+        RETURN_ERROR ("Calling build_harmonic_basis", FUNC_NAME, FAILURE);
+    }
+
+    num_pixels = arrays->rows * arrays->cols;
+    pipelined = (num_threads > 1);
+    num_slots = pipelined ? num_threads * POOL_TASKS_PER_THREAD : 1;
+    block.num_slots = num_slots;
+    block.num_workers = num_threads;
+    block.slots = calloc(num_slots, sizeof(Ccdc_slot_t));
+    block.work = calloc(num_threads, sizeof(Ccdc_workspace_t));
+    if (block.slots == NULL || block.work == NULL)
+    {
+        free_block(&block);
+        RETURN_ERROR ("Allocating block memory", FUNC_NAME, FAILURE);
+    }
+    for (i = 0; i < num_slots; i++)
+    {
+        block.slots[i].px = px;
+        status = alloc_pixel_inputs(arrays->num_scenes, &block.slots[i].px);
+        if (status != SUCCESS)
+        {
+            free_block(&block);
+            RETURN_ERROR ("Calling alloc_pixel_inputs", FUNC_NAME, FAILURE);
+        }
+        out_buffer_init(&block.slots[i].out);
+        block.slots[i].px.out = &block.slots[i].out;
+    }
+    for (i = 0; i < num_threads; i++)
+    {
+        block.work[i].px = px;
+        status = alloc_workspace(arrays->num_scenes, params->conse,
+                                 &block.work[i]);
+        if (status != SUCCESS)
+        {
+            free_block(&block);
+            RETURN_ERROR ("Calling alloc_workspace", FUNC_NAME, FAILURE);
+        }
+    }
+    block.num_scenes = arrays->num_scenes;
+    block.max_conse = params->conse;
+    block.params = params;
+    block.num_params = 1;
+    block.nb = NULL;
+    block.cp = NULL;
+    block.files = NULL;
+
+    if (pipelined)
+    {
+        status = pool_create(num_threads, num_slots, run_pixel_task, NULL,
+                             &block, NULL, &pool);
+        if (status != SUCCESS)
+        {
+            free_block(&block);
+            RETURN_ERROR ("Calling pool_create", FUNC_NAME, FAILURE);
+        }
+    }
+
+    /******************************************************************/
+    /*                                                                */
+    /* Run the pixels in row then col order, taking the records of a  */
+    /* pixel before its slot takes the pixel num_slots after it.  A   */
+    /* failed pixel stops the run, the pool finishing the pixels in   */
+    /* flight before the buffers are freed.                           */
+    /*                                                                */
+    /******************************************************************/
+
+    snprintf(output_binary, sizeof(output_binary), "%s/output.bin", out_path);
+    next_out = 0;
+    for (blk = 0; blk < num_pixels && status == SUCCESS; blk++)
+    {
+        if (blk - next_out == num_slots)
+        {
+            status = take_pixel_records(&block, pipelined ? &pool : NULL,
+                                        next_out++, output_binary, recs,
+                                        num_recs, &max_recs);
+            if (status != SUCCESS)
+                break;
+        }
+
+        status = load_pixel_arrays(arrays, blk,
+                                   &block.slots[blk % num_slots].px);
+        if (status != SUCCESS)
+            break;
+
+        if (pipelined)
+            pool_submit(&pool, blk);
+        else
+        {
+            status = run_pixel_task(&block, 0, blk);
+            if (status == SUCCESS)
+                status = take_pixel_records(&block, NULL, next_out++,
+                                            output_binary, recs, num_recs,
+                                            &max_recs);
+        }
+    }
+    while (status == SUCCESS && next_out < num_pixels)
+    {
+        status = take_pixel_records(&block, pipelined ? &pool : NULL,
+                                    next_out++, output_binary, recs,
+                                    num_recs, &max_recs);
+    }
+
+    if (pipelined)
+        pool_destroy(&pool, NULL);
+    free_block(&block);
+
+    if (status != SUCCESS)
+    {
+        free(*recs);
+        *recs = NULL;
+        *num_recs = 0;
+        RETURN_ERROR ("Running the pixels", FUNC_NAME, FAILURE);
+    }
+
+    return (SUCCESS);
+}
@@ -10,6 +10,70 @@
 #include <stdbool.h>
 
 #include "input.h"
+#include "output.h"
+#include "harmonic.h"
+#include "obs_store.h"
+#include "season_index.h"
+#include "ts_kernels.h"
+
+/* Observation range and number of coefficients of a time series fit.  */
+typedef struct
+{
+    int start;            /* index of the first observation of the fit  */
+    int end;              /* index of the last observation of the fit   */
+    int df;               /* number of coefficients                     */
+} Fit_range_t;
+
+/* What the non-detection (lazy) bands need to rebuild the residuals of */
+/* the CONSE window once a curve is recorded: the fit that was current  */
+/* when each slot was filled, and the slot's date and observed values.  */
+/* Values are kept because noise removal changes the live positions.   */
+typedef struct
+{
+    Fit_range_t fit[MAX_CONSE];     /* fit used for the slot            */
+    int t[MAX_CONSE];               /* date of the slot                 */
+    float y[NUM_LAZY_BANDS][MAX_CONSE]; /* observed lazy band values    */
+} Lazy_window_t;
+
+/* Thresholds of the change detection.  A run uses the defines.h values */
+/* unless a parameter sweep gives one set per configuration.            */
+typedef struct
+{
+    double t_cg;          /* change threshold (T_CG)                    */
+    double t_max_cg;      /* noise removal threshold (T_MAX_CG)         */
+    int conse;            /* observations to confirm a change (CONSE)   */
+    double lambda;        /* lasso penalty of the fits (LAMBDA)         */
+    int n_times;          /* observations per coefficient (N_TIMES)     */
+    int min_num_c;        /* coefficients of the first model (MIN_NUM_C)*/
+} Ccdc_params_t;
+
+/* A block of pixels held in memory by the caller of ccdc_run_arrays,    */
+/* every pixel a series over the same dates.  The values are read where  */
+/* they are, through byte strides, so any array layout (a NumPy view of  */
+/* a stack, for the Python bindings) is used without a copy.             */
+typedef struct
+{
+    int rows, cols;       /* pixels of the block                        */
+    int row, col;         /* position of its upper left pixel, the pos  */
+                          /* of the records                             */
+    int num_scenes;       /* dates of the series                        */
+    const char *sdate;    /* int julian dates, ascending                */
+    long sdate_stride;    /* bytes between scenes                       */
+    const char *bands;    /* int16 values of the TOTAL_IMAGE_BANDS      */
+                          /* bands, thermal in Kelvin as the files      */
+    long band_strides[4]; /* bytes between rows, cols, bands, scenes    */
+    const char *qa;       /* unsigned char cfmask values                */
+    long qa_strides[3];   /* bytes between rows, cols, scenes           */
+} Ccdc_arrays_t;
+
+int ccdc_run_arrays
+(
+    const Ccdc_arrays_t *arrays, /* I: block of pixels                  */
+    const Ccdc_params_t *params, /* I: thresholds of the run            */
+    int num_threads,             /* I: threads running the pixels       */
+    Output_t **recs,             /* O: curve records, in block order    */
+    int *num_recs                /* O: their number                     */
+);
 
 int get_args
 (
@@ -21,7 +85,54 @@ int get_args
     char *out_path,        /* O: direcotry location of output files         */
     char *data_type,       /* O: data type: tifs, bip, stdin, bip_lines.    */
     char *scene_list_file, /* O: optional file name of list of sceneIDs     */
-    bool *verbose          /* O: verbose flag                               */
+    bool *verbose,         /* O: verbose flag                               */
+    bool *lazy_fit,        /* O: fit non-detection bands only when a curve  */
+                           /*    is recorded                                */
+    Precision_t *precision,/* O: precision policy of the kernels            */
+    bool *fast_path,       /* O: stable curve shortcut of the monitoring    */
+    bool *validate_fast_path,/* O: compare the shortcut with the full loop  */
+    char *sweep_file,      /* O: optional file name of parameter sets       */
+    int *screen_cell,      /* O: cell side of the screening pass, 1 if off  */
+    int *block_rows,       /* O: rows of the block of pixels run            */
+    int *block_cols,       /* O: cols of the block of pixels run            */
+    bool *neighbor_warm_start,/* O: warm start lasso fits from neighbors    */
+    int *log_level,        /* O: most verbose LOG_LEVEL_ written            */
+    char *log_file,        /* O: optional file name of the log              */
+    int *num_threads,      /* O: threads running the pixels of the block    */
+    int *read_ahead,       /* O: pixels in flight, 0 for the default        */
+    int *max_buffer_mb,    /* O: cap of their buffers in MB, 0 if none      */
+    bool *record_cost,     /* O: append the cost of the pixels to cost.txt  */
+    bool *cost_only,       /* O: only that, no change detection             */
+    int *checkpoint,       /* O: pixels between checkpoints, 0 if off       */
+    bool *resume,          /* O: resume from the last checkpoint            */
+    char *state_dir,       /* O: directory of the series states, "" if off  */
+    bool *update,          /* O: read only the scenes after the state       */
+    char *tune_profile,    /* O: tuning profile applied, "" if none         */
+    bool *numa             /* O: place the threads and buffers on nodes     */
+);
+
+void default_ccdc_params
+(
+    Ccdc_params_t *params   /* O: thresholds of a run                       */
+);
+
+bool ccdc_params_valid
+(
+    const Ccdc_params_t *params /* I: thresholds of a run                   */
+);
+
+int read_sweep_file
+(
+    const char *sweep_file, /* I: file name of the parameter sets           */
+    Ccdc_params_t **params, /* O: parameter sets                            */
+    int *num_params         /* O: number of parameter sets                  */
+);
+
+int read_tune_profile
+(
+    const char *profile,    /* I: file name of the tuning profile           */
+    int *num_threads,       /* O: threads, unchanged if not in the file     */
+    int *read_ahead         /* O: pixels in flight, unchanged if not in it  */
 );
 
 void get_scenename
@@ -53,14 +164,6 @@ int sort_scene_based_on_year_doy_row
     int *sdate              /* O: year plus date since 0000          */
 );
 
-void quick_sort_2d_float
-(
-    float arr[],
-    float *brr[],
-    int left,
-    int right
-);
-
 void update_cft
 (
     int i_span,
@@ -158,6 +261,15 @@ void matlab_2d_array_norm
     float  *output_norm  /* O: output norm value                   */
 );
 
+void matlab_2d_array_norm_ids
+(
+    float **array,       /* I: input array                         */
+    int dim1_index,      /* I: 1st dimension index                 */
+    const int *ids,      /* I: 2nd dimension indices of elements   */
+    int num_ids,         /* I: number of elements                  */
+    float  *output_norm  /* O: output norm value                   */
+);
+
 void get_ids_length
 (
     int *id_array,        /* I: input array */
@@ -176,8 +288,8 @@ void matlab_unique
 
 int auto_mask
 (
-    int *clrx,
-    float **clry,
+    const Obs_store_t *obs,
+    const Harmonic_basis_t *basis,
     int start,
     int end,
     float years,
@@ -189,12 +301,28 @@ int auto_mask
 
 int auto_ts_fit
 (
-    int *clrx,
-    float **clry,
+    const Obs_store_t *obs,
+    const Harmonic_basis_t *basis,
     int band_index,
     int start,
     int end,
     int df,
+    double lambda,
+    float **coefs,
+    float *rmse,
+    float **v_dif
+);
+
+int auto_ts_fit_bands
+(
+    const Obs_store_t *obs,
+    const Harmonic_basis_t *basis,
+    const int *band_list,
+    int num_bands,
+    int start,
+    int end,
+    int df,
+    double lambda,
     float **coefs,
     float *rmse,
     float **v_dif
@@ -203,6 +331,7 @@ int auto_ts_fit
 int auto_ts_predict
 (
     int *clrx,
+    const Harmonic_basis_t *basis,
     float **coefs,
     int df,
     int band_index,
@@ -211,6 +340,56 @@ int auto_ts_predict
     float *pred_y
 );
 
+int auto_ts_predict_conse
+(
+    const Obs_store_t *obs,
+    const Harmonic_basis_t *basis,
+    float **coefs,
+    const Ts_kernels_t *kern,
+    int start,
+    int nums,
+    const int *blist,
+    int num_blist,
+    const float *blist_rmse,
+    int slot,
+    int conse,
+    float *vec_mag,
+    float **v_dif_mag
+);
+
+void rotate_conse_window
+(
+    float *vec_mag,
+    float **v_dif_mag,
+    int conse,
+    int *head
+);
+
+void record_lazy_slot
+(
+    Lazy_window_t *lazy,
+    int slot,
+    const Obs_store_t *obs,
+    int index,
+    const int *lazy_blist,
+    const Fit_range_t *fit
+);
+
+int fit_lazy_bands
+(
+    const Obs_store_t *obs,
+    const Harmonic_basis_t *basis,
+    const int *lazy_blist,
+    const Lazy_window_t *lazy,
+    int head,
+    const Fit_range_t *cur_fit,
+    const Ccdc_params_t *params,
+    float **fit_cft,
+    float *rmse,
+    float **v_dif_mag,
+    float **v_dif
+);
+
 extern void elnet_(
     
 // input:
@@ -257,6 +436,8 @@ extern void elnet_(
 			//      intr = 0/1 => don't/do include intercept in model
     int *maxit,		//   maxit = maximum allowed number of passes over the data for all lambda
 			//      values (suggested values, maxit = 100000)
+    double *winit,	//   winit(ni) = starting coefficient values (original scale)
+    int *iwarm,		//   iwarm = 0/1 => start from 0 / from winit (ka=1 only)
 
 // output:
 
@@ -282,6 +463,29 @@ extern void elnet_(
 			//            exceeds nx (see above) at kth lamda value.
 );
 
+/*--------------------------------------------------------------------
+c several responses on the same dense predictors, covariance updating
+c (ka=1) and no deletion flags; each response is solved as by elnet:
+c
+c call elnetb(parm,no,ni,x,nb,y,w,vp,cl,ne,nx,nlam,flmin,ulam,thr,isd,
+c             intr,maxit,winit,iwarm,lmu,a0,ca,ia,nin,rsq,alm,nlp,jerr)
+c
+c   nb = number of responses
+c   y(no,nb), winit(ni,nb), iwarm(nb) = y, winit and iwarm of each
+c   lmu(nb), a0(nlam,nb), ca(nx,nlam,nb), ia(nx,nb), nin(nlam,nb),
+c   rsq(nlam,nb), alm(nlam,nb), nlp(nb) = the outputs of each
+c   jerr = error flag of the first response that failed, the later
+c          ones are not solved
+----------------------------------------------------------------------*/
+extern void elnetb_(
+    double *parm, int *no, int *ni, double *x, int *nb, double *y,
+    double *w, double *vp, double cl[][2], int *ne, int *nx, int *nlam,
+    double *flmin, double *ulam, double *thr, int *isd, int *intr,
+    int *maxit, double *winit, int *iwarm, int *lmu, double *a0,
+    double *ca, int *ia, int *nin, double *rsq, double *alm, int *nlp,
+    int *jerr
+);
+
 extern void spelnet_(
     
 // input:
@@ -385,9 +589,28 @@ extern int c_glmnet(
     int nlam,		   // number of lambda values
     double *ulam,	   // value of lambda values, of dimentions (nlam)
     double parm,	   // the alpha variable
+    const double *init,	   // starting coefficients (ni), NULL for a cold start
 
     int *lmu,		   // lmu = actual number of lamda values (solutions)
-    double cfs[nlam][ni+1] // results = cfs[lmu][ni + 1]
+    double cfs[nlam][ni+1], // results = cfs[lmu][ni + 1]
+    int *nlp		   // number of coordinate descent passes
+);
+
+extern int c_glmnet_bands(
+    int no,		   // number of observations (no)
+    int ni,		   // number of predictor variables (ni)
+    double *x,		   // input matrix, x[ni][no], shared by the responses
+    int nb,		   // number of responses (bands)
+    double *y,		   // responses, y[nb][no]
+    int nlam,		   // number of lambda values
+    double *ulam,	   // value of lambda values, of dimentions (nlam)
+    double parm,	   // the alpha variable
+    double init[nb][ni],   // starting coefficients of each response
+    const bool *warm,	   // warm[b]: start response b from init[b]
+
+    int *lmu,		   // lmu[nb] = actual number of lamda values
+    double cfs[nb][nlam][ni+1], // results of each response
+    int *nlp		   // nlp[nb] = coordinate descent passes
 );
 
 #endif /* CCDC_H */
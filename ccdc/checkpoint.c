@@ -0,0 +1,450 @@
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <libgen.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+
+#include "const.h"
+#include "utilities.h"
+#include "checkpoint.h"
+
+
+/* Flush a file or directory to disk.                                     */
+static int sync_path
+(
+    const char *path
+)
+{
+    int fd;
+    int status;
+
+    fd = open(path, O_RDONLY);
+    if (fd < 0)
+        return FAILURE;
+    status = fsync(fd);
+    close(fd);
+
+    return (status == 0) ? SUCCESS : FAILURE;
+}
+
+
+/* Size of a file, 0 if it does not exist yet, -1 on error.               */
+static long file_size
+(
+    const char *path
+)
+{
+    struct stat st;
+
+    if (stat(path, &st) != 0)
+        return (errno == ENOENT) ? 0 : -1;
+
+    return (long)st.st_size;
+}
+
+
+/* Make room for more listed files; on failure the list is unchanged.     */
+static int grow_files
+(
+    Checkpoint_t *cp
+)
+{
+    int max_files = 2 * cp->max_files + 4;
+    char (*files)[MAX_STR_LEN];
+    long *offsets;
+
+    files = realloc(cp->files, max_files * MAX_STR_LEN);
+    if (files == NULL)
+        return FAILURE;
+    cp->files = files;
+    offsets = realloc(cp->offsets, max_files * sizeof(long));
+    if (offsets == NULL)
+        return FAILURE;
+    cp->offsets = offsets;
+    cp->max_files = max_files;
+
+    return SUCCESS;
+}
+
+
+/******************************************************************************
+MODULE:  save_checkpoint
+
+PURPOSE:  Replace the checkpoint file by the current checkpoint
+
+RETURN VALUE:
+Type = int
+Value           Description
+-----           -----------
+FAILURE         Error in writing the file
+SUCCESS         No errors encountered
+
+NOTES: Written to a temporary file, flushed to disk and renamed over the
+       checkpoint, so the checkpoint file is always a whole one.
+******************************************************************************/
+static int save_checkpoint
+(
+    Checkpoint_t *cp        /* I: checkpoint                                */
+)
+{
+    char FUNC_NAME[] = "save_checkpoint";
+    char tmp_path[MAX_STR_LEN + 8];
+    char dir_path[MAX_STR_LEN];
+    FILE *fp;
+    int i;
+
+    snprintf(tmp_path, sizeof(tmp_path), "%s.tmp", cp->path);
+    fp = fopen(tmp_path, "w");
+    if (fp == NULL)
+    {
+        RETURN_ERROR ("Opening the checkpoint file", FUNC_NAME, FAILURE);
+    }
+    fprintf(fp, "ccdc checkpoint\n");
+    fprintf(fp, "key %s\n", cp->key);
+    fprintf(fp, "pixels %d\n", cp->num_done);
+    for (i = 0; i < cp->num_files; i++)
+        fprintf(fp, "file %ld %s\n", cp->offsets[i], cp->files[i]);
+    if (fflush(fp) != 0 || fsync(fileno(fp)) != 0)
+    {
+        fclose(fp);
+        RETURN_ERROR ("Writing the checkpoint file", FUNC_NAME, FAILURE);
+    }
+    fclose(fp);
+
+    if (rename(tmp_path, cp->path) != 0)
+    {
+        RETURN_ERROR ("Renaming the checkpoint file", FUNC_NAME, FAILURE);
+    }
+    snprintf(dir_path, sizeof(dir_path), "%s", cp->path);
+    if (sync_path(dirname(dir_path)) != SUCCESS)
+    {
+        RETURN_ERROR ("Flushing the checkpoint directory", FUNC_NAME,
+                      FAILURE);
+    }
+
+    return (SUCCESS);
+}
+
+
+/******************************************************************************
+MODULE:  load_checkpoint
+
+PURPOSE:  Read the checkpoint file of a run to resume, and truncate the
+          output files back to it
+
+RETURN VALUE:
+Type = int
+Value           Description
+-----           -----------
+FAILURE         Error in reading the file, or it is of another run
+SUCCESS         No errors encountered
+******************************************************************************/
+static int load_checkpoint
+(
+    Checkpoint_t *cp        /* I/O: checkpoint, read                        */
+)
+{
+    char FUNC_NAME[] = "load_checkpoint";
+    char line[CHECKPOINT_KEY_LEN + MAX_STR_LEN];
+    char msg_str[CHECKPOINT_KEY_LEN + 2 * MAX_STR_LEN];
+    char *key;
+    FILE *fp;
+    long offset;
+    long size;
+    int pos;
+    int len;
+    int status = SUCCESS;
+
+    fp = fopen(cp->path, "r");
+    if (fp == NULL)
+    {
+        snprintf(msg_str, sizeof(msg_str), "No %s, starting from the first "
+                 "pixel", cp->path);
+        WARNING_MESSAGE (msg_str, FUNC_NAME);
+        return (SUCCESS);
+    }
+
+    if (fgets(line, sizeof(line), fp) == NULL ||
+        strcmp(line, "ccdc checkpoint\n") != 0)
+        status = FAILURE;
+    if (status == SUCCESS && (fgets(line, sizeof(line), fp) == NULL ||
+        strncmp(line, "key ", 4) != 0))
+        status = FAILURE;
+    if (status == SUCCESS)
+    {
+        key = line + 4;
+        key[strcspn(key, "\n")] = '\0';
+        if (strcmp(key, cp->key) != 0)
+        {
+            fclose(fp);
+            len = snprintf(msg_str, sizeof(msg_str), "%s is of another "
+                           "run: %s", cp->path, key);
+            if (len < 0 || len >= (int)sizeof(msg_str))
+                snprintf(msg_str, sizeof(msg_str), "%s is of another run",
+                         cp->path);
+            RETURN_ERROR (msg_str, FUNC_NAME, FAILURE);
+        }
+    }
+    if (status == SUCCESS && (fgets(line, sizeof(line), fp) == NULL ||
+        sscanf(line, "pixels %d", &cp->num_done) != 1))
+        status = FAILURE;
+
+    while (status == SUCCESS && fgets(line, sizeof(line), fp) != NULL)
+    {
+        if (sscanf(line, "file %ld %n", &offset, &pos) != 1)
+        {
+            status = FAILURE;
+            break;
+        }
+        line[strcspn(line, "\n")] = '\0';
+        if (cp->num_files == cp->max_files && grow_files(cp) != SUCCESS)
+        {
+            fclose(fp);
+            RETURN_ERROR ("Allocating checkpoint memory", FUNC_NAME, FAILURE);
+        }
+        snprintf(cp->files[cp->num_files], MAX_STR_LEN, "%s", line + pos);
+        cp->offsets[cp->num_files] = offset;
+        cp->num_files++;
+    }
+    fclose(fp);
+    if (status != SUCCESS)
+    {
+        snprintf(msg_str, sizeof(msg_str), "Reading %s", cp->path);
+        RETURN_ERROR (msg_str, FUNC_NAME, FAILURE);
+    }
+
+    /* Drop what was written after the checkpoint.                        */
+    for (pos = 0; pos < cp->num_files; pos++)
+    {
+        size = file_size(cp->files[pos]);
+        if (size < cp->offsets[pos])
+        {
+            snprintf(msg_str, sizeof(msg_str), "%s is shorter than at the "
+                     "checkpoint", cp->files[pos]);
+            RETURN_ERROR (msg_str, FUNC_NAME, FAILURE);
+        }
+        if (size > cp->offsets[pos] &&
+            truncate(cp->files[pos], cp->offsets[pos]) != 0)
+        {
+            snprintf(msg_str, sizeof(msg_str), "Truncating %s",
+                     cp->files[pos]);
+            RETURN_ERROR (msg_str, FUNC_NAME, FAILURE);
+        }
+    }
+
+    return (SUCCESS);
+}
+
+
+/******************************************************************************
+MODULE:  checkpoint_open
+
+PURPOSE:  Start the checkpoints of a block run, or resume from the last one
+
+RETURN VALUE:
+Type = int
+Value           Description
+-----           -----------
+FAILURE         Error in reading or writing the checkpoint
+SUCCESS         No errors encountered
+
+NOTES: The key is compared on resume, so that a checkpoint is not applied
+       to another block, input or parameter sets.  Without resume any
+       previous checkpoint is replaced.
+******************************************************************************/
+int checkpoint_open
+(
+    const char *out_path,   /* I: directory of the output files             */
+    const char *key,        /* I: block, input and parameters of the run    */
+    int every,              /* I: pixels between checkpoints                */
+    bool resume,            /* I: resume from the checkpoint file           */
+    Checkpoint_t *cp        /* O: checkpoint, num_done the pixels to skip   */
+)
+{
+    char FUNC_NAME[] = "checkpoint_open";
+    int status;
+    int len;
+
+    cp->every = every;
+    cp->num_done = 0;
+    cp->num_files = 0;
+    cp->max_files = 0;
+    cp->files = NULL;
+    cp->offsets = NULL;
+    len = snprintf(cp->path, sizeof(cp->path), "%s/%s", out_path,
+                   CHECKPOINT_FILE);
+    if (len < 0 || len >= (int)sizeof(cp->path))
+    {
+        RETURN_ERROR ("Checkpoint file name too long", FUNC_NAME, FAILURE);
+    }
+    len = snprintf(cp->key, sizeof(cp->key), "%s", key);
+    if (len < 0 || len >= (int)sizeof(cp->key))
+    {
+        RETURN_ERROR ("Checkpoint key too long", FUNC_NAME, FAILURE);
+    }
+
+    if (resume)
+    {
+        status = load_checkpoint(cp);
+        if (status != SUCCESS)
+        {
+            RETURN_ERROR ("Calling load_checkpoint", FUNC_NAME, FAILURE);
+        }
+    }
+
+    status = save_checkpoint(cp);
+    if (status != SUCCESS)
+    {
+        RETURN_ERROR ("Calling save_checkpoint", FUNC_NAME, FAILURE);
+    }
+
+    return (SUCCESS);
+}
+
+
+/******************************************************************************
+MODULE:  checkpoint_add_file
+
+PURPOSE:  List an output file before a pixel first writes it
+
+RETURN VALUE:
+Type = int
+Value           Description
+-----           -----------
+FAILURE         Error in reading its size or saving the checkpoint
+SUCCESS         No errors encountered
+
+NOTES: The file is listed at its size now, which is its size at the last
+       checkpoint too, as no pixel wrote it since; the checkpoint is saved
+       at once, so a resume truncates whatever is appended to it next.
+******************************************************************************/
+int checkpoint_add_file
+(
+    Checkpoint_t *cp,       /* I/O: checkpoint                              */
+    const char *path        /* I: output file about to be written           */
+)
+{
+    char FUNC_NAME[] = "checkpoint_add_file";
+    long size;
+    int i;
+
+    for (i = 0; i < cp->num_files; i++)
+    {
+        if (strcmp(cp->files[i], path) == 0)
+            return (SUCCESS);
+    }
+
+    size = file_size(path);
+    if (size < 0)
+    {
+        RETURN_ERROR ("Reading the size of an output file", FUNC_NAME,
+                      FAILURE);
+    }
+    if (cp->num_files == cp->max_files && grow_files(cp) != SUCCESS)
+    {
+        RETURN_ERROR ("Allocating checkpoint memory", FUNC_NAME, FAILURE);
+    }
+    snprintf(cp->files[cp->num_files], MAX_STR_LEN, "%s", path);
+    cp->offsets[cp->num_files] = size;
+    cp->num_files++;
+
+    return save_checkpoint(cp);
+}
+
+
+/******************************************************************************
+MODULE:  checkpoint_write
+
+PURPOSE:  Checkpoint the run once num_done pixels are written
+
+RETURN VALUE:
+Type = int
+Value           Description
+-----           -----------
+FAILURE         Error in flushing the output files or saving the checkpoint
+SUCCESS         No errors encountered
+
+NOTES: The output files are flushed to disk before the checkpoint that
+       lists their new sizes is.
+******************************************************************************/
+int checkpoint_write
+(
+    Checkpoint_t *cp,       /* I/O: checkpoint                              */
+    int num_done            /* I: pixels written                            */
+)
+{
+    char FUNC_NAME[] = "checkpoint_write";
+    char msg_str[2 * MAX_STR_LEN];
+    int i;
+
+    for (i = 0; i < cp->num_files; i++)
+    {
+        cp->offsets[i] = file_size(cp->files[i]);
+        if (cp->offsets[i] > 0 && sync_path(cp->files[i]) != SUCCESS)
+        {
+            snprintf(msg_str, sizeof(msg_str), "Flushing %s", cp->files[i]);
+            RETURN_ERROR (msg_str, FUNC_NAME, FAILURE);
+        }
+        if (cp->offsets[i] < 0)
+        {
+            snprintf(msg_str, sizeof(msg_str), "Reading the size of %s",
+                     cp->files[i]);
+            RETURN_ERROR (msg_str, FUNC_NAME, FAILURE);
+        }
+    }
+    cp->num_done = num_done;
+
+    return save_checkpoint(cp);
+}
+
+
+
+/******************************************************************************
+MODULE:  checkpoint_digest
+
+PURPOSE:  Add a text to the digest of the parameter sets and the input of a
+          run, kept in its checkpoint key
+
+RETURN VALUE:
+Type = unsigned long long
+Value           Description
+-----           -----------
+digest          The 64-bit FNV-1a hash of the texts added so far
+
+NOTES: Each text is ended by a newline in the hash, so "ab", "c" and "a",
+       "bc" give different digests.  The digest only has to tell two runs
+       apart, it is not a checksum of the files.
+******************************************************************************/
+unsigned long long checkpoint_digest
+(
+    unsigned long long digest, /* I: digest so far, CHECKPOINT_DIGEST_INIT  */
+    const char *text        /* I: text to add                               */
+)
+{
+    const unsigned char *c;
+
+    for (c = (const unsigned char *)text; *c != '\0'; c++)
+    {
+        digest ^= *c;
+        digest *= 1099511628211ULL;
+    }
+    digest ^= '\n';
+    digest *= 1099511628211ULL;
+
+    return (digest);
+}
+
+void checkpoint_free
+(
+    Checkpoint_t *cp        /* I/O: checkpoint                              */
+)
+{
+    free(cp->files);
+    free(cp->offsets);
+    cp->files = NULL;
+    cp->offsets = NULL;
+}
@@ -0,0 +1,70 @@
+#ifndef CHECKPOINT_H
+#define CHECKPOINT_H
+
+
+#include <stdbool.h>
+
+#include "const.h"
+
+
+#define CHECKPOINT_FILE "checkpoint.txt"
+
+/* Longest key of a run: the block, the input path and a digest.          */
+#define CHECKPOINT_KEY_LEN (2 * MAX_STR_LEN)
+
+/* Start value of checkpoint_digest (the 64-bit FNV-1a offset basis).     */
+#define CHECKPOINT_DIGEST_INIT 14695981039346656037ULL
+
+/* Checkpoint of a block run, in checkpoint.txt of the out-path.  The     */
+/* pixels of a block are written in block order, so the pixels done are   */
+/* the first num_done ones; with them, the checkpoint keeps the size each */
+/* output file had once they were written.  A resumed run truncates the   */
+/* files back to those sizes, dropping the records of the pixels after    */
+/* the checkpoint, partly written ones included, and starts from pixel    */
+/* num_done.  A file is listed, at its size then, the first time a pixel  */
+/* writes it, so the output of earlier runs appended to is kept.          */
+typedef struct
+{
+    char path[MAX_STR_LEN];   /* checkpoint file                            */
+    char key[CHECKPOINT_KEY_LEN]; /* block, input and parameters of the run */
+    int every;                /* pixels between checkpoints                 */
+    int num_done;             /* pixels done at the last checkpoint         */
+    int num_files;            /* output files listed                        */
+    int max_files;            /* allocated length of files and offsets      */
+    char (*files)[MAX_STR_LEN]; /* their paths                              */
+    long *offsets;            /* their sizes at the last checkpoint         */
+} Checkpoint_t;
+
+int checkpoint_open
+(
+    const char *out_path,   /* I: directory of the output files             */
+    const char *key,        /* I: block, input and parameters of the run    */
+    int every,              /* I: pixels between checkpoints                */
+    bool resume,            /* I: resume from the checkpoint file           */
+    Checkpoint_t *cp        /* O: checkpoint, num_done the pixels to skip   */
+);
+
+int checkpoint_add_file
+(
+    Checkpoint_t *cp,       /* I/O: checkpoint                              */
+    const char *path        /* I: output file about to be written           */
+);
+
+int checkpoint_write
+(
+    Checkpoint_t *cp,       /* I/O: checkpoint                              */
+    int num_done            /* I: pixels written                            */
+);
+
+unsigned long long checkpoint_digest
+(
+    unsigned long long digest, /* I: digest so far, CHECKPOINT_DIGEST_INIT  */
+    const char *text        /* I: text to add                               */
+);
+
+void checkpoint_free
+(
+    Checkpoint_t *cp        /* I/O: checkpoint                              */
+);
+
+#endif /* CHECKPOINT_H */
@@ -0,0 +1,31 @@
+#include "cpu_dispatch.h"
+
+
+/******************************************************************************
+MODULE:  cpu_dispatch_variant
+
+PURPOSE:  Name the variant of the CPU_DISPATCH kernels used on this CPU
+
+RETURN VALUE:
+Type = const char *
+Value           Description
+-----           -----------
+name            "avx2", "sse4.2", "default", or "none" when the
+                kernels are built without dispatch
+
+NOTES: Checks the CPU features in the priority order the target_clones
+       resolvers use, so it reports the variant they select.
+******************************************************************************/
+const char *cpu_dispatch_variant(void)
+{
+#if CPU_DISPATCH_ENABLED
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2"))
+        return "avx2";
+    if (__builtin_cpu_supports("sse4.2"))
+        return "sse4.2";
+    return "default";
+#else
+    return "none";
+#endif
+}
@@ -0,0 +1,26 @@
+#ifndef CPU_DISPATCH_H
+#define CPU_DISPATCH_H
+
+
+/* Runtime CPU dispatch of the hot kernels.  Built with                   */
+/* -DCCDC_CPU_DISPATCH, each function marked CPU_DISPATCH is compiled for */
+/* AVX2 and SSE4.2 as well as the baseline, and the loader picks the best */
+/* variant the CPU supports (cpuid), so one binary runs on every x86-64   */
+/* node.  Otherwise CPU_DISPATCH is empty.  The kernels are short scalar  */
+/* chains, and no variant has measured faster than the baseline, so the   */
+/* release builds leave it off.  No AVX-512 variant: its clone keeps the  */
+/* scalars in zmm16-31 with 512-bit moves, slower than the baseline.      */
+#if defined(CCDC_CPU_DISPATCH) && (defined(__x86_64__) || defined(__i386__)) \
+    && ((defined(__clang__) && __clang_major__ >= 14) || \
+        (!defined(__clang__) && defined(__GNUC__) && __GNUC__ >= 8))
+#define CPU_DISPATCH_ENABLED 1
+#define CPU_DISPATCH \
+            __attribute__((target_clones("avx2", "sse4.2", "default")))
+#else
+#define CPU_DISPATCH_ENABLED 0
+#define CPU_DISPATCH
+#endif
+
+const char *cpu_dispatch_variant(void);
+
+#endif /* CPU_DISPATCH_H */
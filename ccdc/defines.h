@@ -8,10 +8,16 @@
                           /* and Selection Operator LASSO regressions */
 #define TOTAL_IMAGE_BANDS 7 /* Number of image bands, for loops.      */
 #define TOTAL_BANDS 8     /* Total image plus mask bands, for loops.  */
+#define NUM_LAZY_BANDS (TOTAL_IMAGE_BANDS - NUM_LASSO_BANDS) /* bands not */
+                          /* used for change detection                */
 #define MIN_NUM_C 4       /* Minimum number of coefficients           */
 #define MID_NUM_C 6       /* Mid-point number of coefficients         */
 #define MAX_NUM_C 8       /* Maximum number of coefficients           */
 #define CONSE 6           /* No. of CONSEquential pixels 4 bldg. model*/
+#define MAX_CONSE 12      /* Largest CONSE of a parameter sweep       */
+#define MAX_SCREEN_CELL 16 /* Largest cell side of the screening pass */
+#define MAX_THREADS 256   /* Most threads running the pixels of a block */
+#define MAX_READ_AHEAD 4096 /* Most pixels in flight in a block run     */
 #define N_TIMES 3         /* number of clear observations/coefficients*/
 #define NUM_YEARS 365.25  /* average number of days per year          */
 #define NUM_FC 10         /* Values change with number of pixels run  */
@@ -22,6 +28,10 @@
 #define T_CG 15.0863      /* chi-square inversed T_cg (0.99) for noise removal */
 #define T_MAX_CG 35.8882  /* chi-square inversed T_max_cg (1e-6) for 
                              last step noise removal                  */
+#define LAMBDA 20.0       /* lasso penalty of the time series fits    */
+#define SINGLE_PRED_TOL 0.05 /* largest rounding error bound accepted for
+                             a single precision model prediction, in
+                             the units of the observations            */
 
 
 /* from 2darray.c */
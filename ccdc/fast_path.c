@@ -0,0 +1,283 @@
+#include <stdlib.h>
+#include <stdbool.h>
+
+#include "const.h"
+#include "utilities.h"
+#include "ccdc.h"
+#include "fast_path.h"
+#include "defines.h"
+
+
+/******************************************************************************
+MODULE:  window_quiet
+
+PURPOSE:  Check that a CONSE window can neither break nor drop its oldest
+          observation as noise
+
+RETURN VALUE:
+Type = bool
+Value           Description
+-----           -----------
+true            smallest bound within T_CG, oldest bound within T_MAX_CG
+
+NOTES: Same tests as the monitoring loop, applied to upper bounds of the
+       squared z-score norms, so true is a sufficient condition.
+******************************************************************************/
+static bool window_quiet
+(
+    const float *vec_mag,   /* I: norm bound of each window slot            */
+    int head,               /* I: slot of the oldest observation            */
+    const Ccdc_params_t *params /* I: thresholds of the run                 */
+)
+{
+    float break_mag = 9999.0;
+    int m;
+
+    for (m = 0; m < params->conse; m++)
+    {
+        if (break_mag > vec_mag[m])
+            break_mag = vec_mag[m];
+    }
+
+    return (break_mag <= params->t_cg && vec_mag[head] <= params->t_max_cg);
+}
+
+
+/******************************************************************************
+MODULE:  stable_fast_path
+
+PURPOSE:  Decide from the first monitoring step of a curve whether the
+          monitoring loop can find no break in the rest of the series, and
+          build the curve record it would produce
+
+RETURN VALUE:
+Type = int
+Value           Description
+-----           -----------
+FAILURE         error in a fit or prediction
+SUCCESS         no error encounted
+
+NOTES: i is the monitoring step the model became ready at (i_count == 0).
+       The screen fits [i_start, end] once and runs the monitoring window
+       over it; a window that would break or drop noise stops here.  The
+       proof then replays the monitoring schedule: the df and fit span of
+       each step, the per step refits up to N_TIMES * MAX_NUM_C observations
+       and the refits on 1.33 times the last fitted time span after that.
+       The z-score denominators are max(adj_rmse, rmse) or max(adj_rmse,
+       temporary rmse) in the loop, so adj_rmse alone gives upper bounds of
+       its norms at no temporary rmse cost.  If every window is quiet and
+       the last one is all within T_CG, the loop would end with the last
+       scheduled fit as the curve and no change at the end of the series.
+       Only the fitted bands are recorded, so it is not used with lazy fit.
+******************************************************************************/
+int stable_fast_path
+(
+    const Obs_store_t *obs,        /* I: clear observations                 */
+    const Harmonic_basis_t *basis, /* I: harmonic terms of every date       */
+    const int *fit_blist,          /* I: bands fitted while monitoring      */
+    int num_fit_bands,             /* I: number of them                     */
+    const int *lasso_blist,        /* I: change detection bands             */
+    const float *adj_rmse,         /* I: adjusted rmse of every band        */
+    int num_c,                     /* I: largest number of coefficients     */
+    const Ccdc_params_t *params,   /* I: thresholds of the run              */
+    Precision_t precision,         /* I: precision policy of the kernels    */
+    int i_start,                   /* I: first observation of the curve     */
+    int i,                         /* I: first monitoring step              */
+    int end,                       /* I: live observations, obs->len        */
+    float **fit_cft,               /* O: coefficients of the last fit       */
+    float *rmse,                   /* O: rmse of the last fit               */
+    float **v_dif,                 /* O: residuals (scratch)                */
+    float *vec_mag,                /* O: norm bounds of the last window     */
+    float **v_dif_mag,             /* O: residuals of the window (scratch)  */
+    Output_t *rec,                 /* O: curve record, when stable          */
+    bool *stable                   /* O: the curve has no break             */
+)
+{
+    char FUNC_NAME[] = "stable_fast_path";
+    const Ts_kernels_t *kern;
+    float z_rmse[NUM_LASSO_BANDS]; /* adj_rmse of the detection bands       */
+    float mag[MAX_CONSE];          /* norm bound of each window slot        */
+    int conse = params->conse;
+    int n_times = params->n_times;
+    int df;                        /* number of coefficients of a step      */
+    int i_count = 0;               /* time span of the last fit             */
+    int i_span;
+    int head;
+    int ii, j, b, k;
+    int status;
+    bool refit;
+
+    *stable = false;
+
+    /* end is the live length of the store, see the curve end below */
+    if (end != obs->len)
+        RETURN_ERROR ("end is not the number of live observations",
+                      FUNC_NAME, FAILURE);
+
+    for (b = 0; b < NUM_LASSO_BANDS; b++)
+        z_rmse[b] = adj_rmse[lasso_blist[b]];
+
+    /******************************************************************/
+    /*                                                                */
+    /* Screen: one fit of the whole series.                           */
+    /*                                                                */
+    /******************************************************************/
+
+    update_cft(end - i_start + 1, n_times, params->min_num_c, MID_NUM_C,
+               MAX_NUM_C, num_c, &df);
+    kern = select_ts_kernels(TOTAL_IMAGE_BANDS, df, precision);
+    status = auto_ts_fit_bands(obs, basis, fit_blist, num_fit_bands,
+                 i_start-1, end-1, df, params->lambda, fit_cft, rmse, v_dif);
+    if (status != SUCCESS)
+        RETURN_ERROR ("Calling auto_ts_fit_bands for the screen", FUNC_NAME,
+                      FAILURE);
+    status = auto_ts_predict_conse(obs, basis, fit_cft, kern, i, conse,
+                 lasso_blist, NUM_LASSO_BANDS, z_rmse, 0, conse, mag, v_dif_mag);
+    if (status != SUCCESS)
+        RETURN_ERROR ("Calling auto_ts_predict_conse for the screen",
+                      FUNC_NAME, FAILURE);
+    if (!window_quiet(mag, 0, params))
+        return (SUCCESS);
+    head = 0;
+    for (j = i + conse; j < end; j++)
+    {
+        auto_ts_predict_conse(obs, basis, fit_cft, kern, j, 1, lasso_blist,
+            NUM_LASSO_BANDS, z_rmse, head, conse, mag, v_dif_mag);
+        head = (head + 1) % conse;
+        if (!window_quiet(mag, head, params))
+            return (SUCCESS);
+    }
+
+    /******************************************************************/
+    /*                                                                */
+    /* Proof: the models of the monitoring schedule.                  */
+    /*                                                                */
+    /******************************************************************/
+
+    for (ii = i; ii <= end - conse; ii++)
+    {
+        i_span = ii - i_start + 1;
+        update_cft(i_span, n_times, params->min_num_c, MID_NUM_C, MAX_NUM_C,
+                   num_c, &df);
+        kern = select_ts_kernels(TOTAL_IMAGE_BANDS, df, precision);
+
+        if (ii == i || i_span <= n_times * MAX_NUM_C)
+            refit = true;
+        else
+            refit = ((float)(OBS_T(obs, ii-1) - OBS_T(obs, i_start-1)) >=
+                     (1.33*(float)i_count));
+
+        if (refit)
+        {
+            i_count = OBS_T(obs, ii-1) - OBS_T(obs, i_start-1);
+            status = auto_ts_fit_bands(obs, basis, fit_blist, num_fit_bands,
+                         i_start-1, ii-1, df, params->lambda, fit_cft, rmse,
+                         v_dif);
+            if (status != SUCCESS)
+                RETURN_ERROR ("Calling auto_ts_fit_bands for the proof",
+                              FUNC_NAME, FAILURE);
+            for (b = 0; b < TOTAL_IMAGE_BANDS; b++)
+            {
+                for (k = 0; k < MAX_NUM_C; k++)
+                    rec->coefs[b][k] = fit_cft[b][k];
+                rec->rmse[b] = rmse[b];
+            }
+            rec->num_obs = ii - i_start + 1;
+            rec->category = 0 + df;
+        }
+
+        if (ii == i || i_span <= n_times * MAX_NUM_C)
+        {
+            /**********************************************************/
+            /*                                                        */
+            /* The whole window under the new model.                  */
+            /*                                                        */
+            /**********************************************************/
+
+            auto_ts_predict_conse(obs, basis, fit_cft, kern, ii, conse,
+                lasso_blist, NUM_LASSO_BANDS, z_rmse, 0, conse, mag,
+                v_dif_mag);
+            head = 0;
+        }
+        else
+        {
+            auto_ts_predict_conse(obs, basis, fit_cft, kern, ii+conse-1, 1,
+                lasso_blist, NUM_LASSO_BANDS, z_rmse, head, conse, mag,
+                v_dif_mag);
+            head = (head + 1) % conse;
+        }
+
+        if (!window_quiet(mag, head, params))
+            return (SUCCESS);
+    }
+
+    /******************************************************************/
+    /*                                                                */
+    /* No change at the end of the series either.                     */
+    /*                                                                */
+    /******************************************************************/
+
+    for (j = 0; j < conse; j++)
+    {
+        if (mag[j] > params->t_cg)
+            return (SUCCESS);
+    }
+
+    /* With every slot within T_CG the loop ends with id_last = conse, */
+    /* and t_end = OBS_T(obs, end - conse + id_last): position end, one */
+    /* past the last live one, which holds the observation the former  */
+    /* array kept there (see obs_store.h).  That is only the same slot  */
+    /* because end == obs->len and nothing was removed on the way.      */
+    for (j = 0; j < conse; j++)
+        vec_mag[j] = mag[j];
+    rec->t_start = OBS_T(obs, i_start-1);
+    rec->t_end = OBS_T(obs, end);
+    rec->t_break = 0;
+    rec->change_prob = 0.0;
+    for (b = 0; b < TOTAL_IMAGE_BANDS; b++)
+        rec->magnitude[b] = 0.0;
+    *stable = true;
+
+    return (SUCCESS);
+}
+
+
+/******************************************************************************
+MODULE:  same_curve_record
+
+PURPOSE:  Compare two curve records field by field
+
+RETURN VALUE:
+Type = bool
+Value           Description
+-----           -----------
+true            all fields are equal
+******************************************************************************/
+bool same_curve_record
+(
+    const Output_t *a,             /* I: curve record                       */
+    const Output_t *b              /* I: curve record                       */
+)
+{
+    int i_b, k;
+
+    if (a->t_start != b->t_start || a->t_end != b->t_end ||
+        a->t_break != b->t_break || a->pos.row != b->pos.row ||
+        a->pos.col != b->pos.col || a->change_prob != b->change_prob ||
+        a->num_obs != b->num_obs || a->category != b->category)
+        return false;
+
+    for (i_b = 0; i_b < NUM_BANDS; i_b++)
+    {
+        for (k = 0; k < NUM_COEFFS; k++)
+        {
+            if (a->coefs[i_b][k] != b->coefs[i_b][k])
+                return false;
+        }
+        if (a->rmse[i_b] != b->rmse[i_b] ||
+            a->magnitude[i_b] != b->magnitude[i_b])
+            return false;
+    }
+
+    return true;
+}
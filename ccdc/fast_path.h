@@ -0,0 +1,54 @@
+#ifndef FAST_PATH_H
+#define FAST_PATH_H
+
+
+#include <stdbool.h>
+
+#include "ccdc.h"
+#include "output.h"
+
+/* Stable curve shortcut of the monitoring loop.  Once a model is ready,  */
+/* the full series is fitted once and its observations are screened       */
+/* against T_CG; if none is above it, the fits of the monitoring schedule */
+/* (which depends only on the dates while nothing changes) are run with   */
+/* the z-score denominators at their adj_rmse floor.  That floor bounds   */
+/* the squared z-score norm of every observation from above, so when all  */
+/* the bounds are within T_CG no break and no noise removal can happen    */
+/* and the curve record is the one of the last scheduled fit.             */
+typedef struct
+{
+    int checked;          /* curves screened                                */
+    int fired;            /* curves recorded by the shortcut                */
+    int mismatch;         /* validated curves that differ from the full path*/
+} Fast_path_stats_t;
+
+int stable_fast_path
+(
+    const Obs_store_t *obs,        /* I: clear observations                 */
+    const Harmonic_basis_t *basis, /* I: harmonic terms of every date       */
+    const int *fit_blist,          /* I: bands fitted while monitoring      */
+    int num_fit_bands,             /* I: number of them                     */
+    const int *lasso_blist,        /* I: change detection bands             */
+    const float *adj_rmse,         /* I: adjusted rmse of every band        */
+    int num_c,                     /* I: largest number of coefficients     */
+    const Ccdc_params_t *params,   /* I: thresholds of the run              */
+    Precision_t precision,         /* I: precision policy of the kernels    */
+    int i_start,                   /* I: first observation of the curve     */
+    int i,                         /* I: first monitoring step              */
+    int end,                       /* I: live observations, obs->len        */
+    float **fit_cft,               /* O: coefficients of the last fit       */
+    float *rmse,                   /* O: rmse of the last fit               */
+    float **v_dif,                 /* O: residuals (scratch)                */
+    float *vec_mag,                /* O: norm bounds of the last window     */
+    float **v_dif_mag,             /* O: residuals of the window (scratch)  */
+    Output_t *rec,                 /* O: curve record, when stable          */
+    bool *stable                   /* O: the curve has no break             */
+);
+
+bool same_curve_record
+(
+    const Output_t *a,             /* I: curve record                       */
+    const Output_t *b              /* I: curve record                       */
+);
+
+#endif /* FAST_PATH_H */
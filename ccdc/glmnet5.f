@@ -714,8 +714,9 @@ c
       return                                                                
       end                                                                   
       subroutine elnet  (ka,parm,no,ni,x,y,w,jd,vp,cl,ne,nx,nlam,flmin,u    
-     *lam,thr,isd,intr,maxit,  lmu,a0,ca,ia,nin,rsq,alm,nlp,jerr)
-      real x(no,ni),y(no),w(no),vp(ni),ca(nx,nlam),cl(2,ni)                 
+     *lam,thr,isd,intr,maxit,winit,iwarm,  lmu,a0,ca,ia,nin,rsq,alm,nlp,
+     *jerr)
+      real x(no,ni),y(no),w(no),vp(ni),ca(nx,nlam),cl(2,ni),winit(ni)
       real ulam(nlam),a0(nlam),rsq(nlam),alm(nlam)                          
       integer jd(*),ia(nx),nin(nlam)                                        
       real, dimension (:), allocatable :: vq;                                   
@@ -729,7 +730,7 @@ c
       vq=vq*ni/sum(vq)                                                      
       if(ka .ne. 1)goto 10041                                               
       call elnetu  (parm,no,ni,x,y,w,jd,vq,cl,ne,nx,nlam,flmin,ulam,thr,    
-     *isd,intr,maxit,  lmu,a0,ca,ia,nin,rsq,alm,nlp,jerr)
+     *isd,intr,maxit,winit,iwarm,  lmu,a0,ca,ia,nin,rsq,alm,nlp,jerr)
       goto 10051                                                            
 10041 continue                                                              
       call elnetn (parm,no,ni,x,y,w,jd,vq,cl,ne,nx,nlam,flmin,ulam,thr,i    
@@ -740,11 +741,12 @@ c
       return                                                                
       end                                                                   
       subroutine elnetu  (parm,no,ni,x,y,w,jd,vp,cl,ne,nx,nlam,flmin,ula    
-     *m,thr,isd,intr,maxit,  lmu,a0,ca,ia,nin,rsq,alm,nlp,jerr)
-      real x(no,ni),y(no),w(no),vp(ni),ulam(nlam),cl(2,ni)                  
+     *m,thr,isd,intr,maxit,winit,iwarm,  lmu,a0,ca,ia,nin,rsq,alm,nlp,
+     *jerr)
+      real x(no,ni),y(no),w(no),vp(ni),ulam(nlam),cl(2,ni),winit(ni)
       real ca(nx,nlam),a0(nlam),rsq(nlam),alm(nlam)                         
       integer jd(*),ia(nx),nin(nlam)                                        
-      real, dimension (:), allocatable :: xm,xs,g,xv,vlam                       
+      real, dimension (:), allocatable :: xm,xs,g,xv,vlam,ai
       integer, dimension (:), allocatable :: ju                                 
       allocate(g(1:ni),stat=jerr)                                           
       allocate(xm(1:ni),stat=ierr)                                          
@@ -757,6 +759,8 @@ c
       jerr=jerr+ierr                                                        
       allocate(vlam(1:nlam),stat=ierr)                                      
       jerr=jerr+ierr                                                        
+      allocate(ai(1:ni),stat=ierr)
+      jerr=jerr+ierr
       if(jerr.ne.0) return                                                  
       call chkvars(no,ni,x,ju)                                              
       if(jd(1).gt.0) ju(jd(2:(jd(1)+1)))=0                                  
@@ -774,8 +778,12 @@ c
 10102 continue                                                              
 10091 continue                                                              
       if(flmin.ge.1.0) vlam=ulam/ys                                         
+c warm start coefficients, on the standardized scale
+      ai=0.0
+      if(iwarm.ne.0) where(ju.ne.0) ai=winit*xs/ys
+c no gram matrix: elnet1 does not read xx (xv stands in for it)
       call elnet1(parm,ni,ju,vp,cl,g,no,ne,nx,x,nlam,flmin,vlam,thr,maxi    
-     *t,xv,  lmu,ca,ia,nin,rsq,alm,nlp,jerr)
+     *t,xv,ai,iwarm,xv,0,  lmu,ca,ia,nin,rsq,alm,nlp,jerr)
       if(jerr.gt.0) return                                                  
 10110 do 10111 k=1,lmu                                                      
       alm(k)=ys*alm(k)                                                      
@@ -788,9 +796,96 @@ c
       if(intr.ne.0) a0(k)=ym-dot_product(ca(1:nk,k),xm(ia(1:nk)))           
 10111 continue                                                              
 10112 continue                                                              
-      deallocate(xm,xs,g,ju,xv,vlam)                                        
+      deallocate(xm,xs,g,ju,xv,vlam,ai)
       return                                                                
       end                                                                   
+c several responses y(:,ib) on the same predictors, each solved as elnetu
+c does: the checks and standardization of x and, for more than one
+c response, the inner products of its columns are done once for all
+      subroutine elnetb (parm,no,ni,x,nb,y,w,vp,cl,ne,nx,nlam,flmin,
+     *ulam,thr,isd,intr,maxit,winit,iwarm,  lmu,a0,ca,ia,nin,rsq,alm,
+     *nlp,jerr)
+      real x(no,ni),y(no,nb),w(no),vp(ni),ulam(nlam),cl(2,ni)
+      real winit(ni,nb),ca(nx,nlam,nb),a0(nlam,nb),rsq(nlam,nb)
+      real alm(nlam,nb)
+      integer iwarm(nb),lmu(nb),ia(nx,nb),nin(nlam,nb),nlp(nb)
+      real, dimension (:), allocatable :: vq,xm,xs,g,xv,vlam,ai,v
+      real, dimension (:,:), allocatable :: xx,cb
+      integer, dimension (:), allocatable :: ju
+      if(maxval(vp) .gt. 0.0)goto 10061
+      jerr=10000
+      return
+10061 continue
+      allocate(vq(1:ni),stat=jerr)
+      allocate(xm(1:ni),stat=ierr)
+      jerr=jerr+ierr
+      allocate(xs(1:ni),stat=ierr)
+      jerr=jerr+ierr
+      allocate(g(1:ni),stat=ierr)
+      jerr=jerr+ierr
+      allocate(xv(1:ni),stat=ierr)
+      jerr=jerr+ierr
+      allocate(vlam(1:nlam),stat=ierr)
+      jerr=jerr+ierr
+      allocate(ai(1:ni),stat=ierr)
+      jerr=jerr+ierr
+      allocate(v(1:no),stat=ierr)
+      jerr=jerr+ierr
+      allocate(xx(1:ni,1:ni),stat=ierr)
+      jerr=jerr+ierr
+      allocate(cb(1:2,1:ni),stat=ierr)
+      jerr=jerr+ierr
+      allocate(ju(1:ni),stat=ierr)
+      jerr=jerr+ierr
+      if(jerr.ne.0) return
+      vq=max(0.0,vp)
+      vq=vq*ni/sum(vq)
+      call chkvars(no,ni,x,ju)
+      if(maxval(ju) .gt. 0)goto 10062
+      jerr=7777
+      goto 10069
+10062 continue
+      call standx(no,ni,x,w,isd,intr,ju,xm,xs,xv,v)
+      igram=0
+      if(nb .le. 1)goto 10063
+      igram=1
+      do 10064 k=1,ni
+      if(ju(k).eq.0)goto 10064
+      do 10065 j=1,ni
+      if(ju(j).ne.0) xx(j,k)=dot_product(x(:,j),x(:,k))
+10065 continue
+10064 continue
+10063 continue
+      do 10066 ib=1,nb
+      call standy(no,ni,x,y(1,ib),w,v,intr,ju,g,ym,ys)
+      cb=cl/ys
+      if(isd .le. 0)goto 10067
+      do 10068 j=1,ni
+      cb(:,j)=cb(:,j)*xs(j)
+10068 continue
+10067 continue
+      if(flmin.ge.1.0) vlam=ulam/ys
+      ai=0.0
+      if(iwarm(ib).ne.0) where(ju.ne.0) ai=winit(:,ib)*xs/ys
+      call elnet1(parm,ni,ju,vq,cb,g,no,ne,nx,x,nlam,flmin,vlam,thr,
+     *maxit,xv,ai,iwarm(ib),xx,igram,  lmu(ib),ca(1,1,ib),ia(1,ib),
+     *nin(1,ib),rsq(1,ib),alm(1,ib),nlp(ib),jerr)
+      if(jerr.ne.0) goto 10069
+      do 10070 k=1,lmu(ib)
+      alm(k,ib)=ys*alm(k,ib)
+      nk=nin(k,ib)
+      do 10071 l=1,nk
+      ca(l,k,ib)=ys*ca(l,k,ib)/xs(ia(l,ib))
+10071 continue
+      a0(k,ib)=0.0
+      if(intr.ne.0) a0(k,ib)=ym-dot_product(ca(1:nk,k,ib),
+     *xm(ia(1:nk,ib)))
+10070 continue
+10066 continue
+10069 continue
+      deallocate(vq,xm,xs,g,xv,vlam,ai,v,xx,cb,ju)
+      return
+      end
       subroutine standard (no,ni,x,y,w,isd,intr,ju,g,xm,xs,ym,ys,xv,jerr    
      *)
       real x(no,ni),y(no),w(no),g(ni),xm(ni),xs(ni),xv(ni)                  
@@ -798,13 +893,18 @@ c
       real, dimension (:), allocatable :: v                                     
       allocate(v(1:no),stat=jerr)                                           
       if(jerr.ne.0) return                                                  
+      call standx(no,ni,x,w,isd,intr,ju,xm,xs,xv,v)
+      call standy(no,ni,x,y,w,v,intr,ju,g,ym,ys)
+      deallocate(v)                                                         
+      return                                                                
+      end                                                                   
+c the predictor part of standard: normalizes w, returns v=sqrt(w)
+      subroutine standx (no,ni,x,w,isd,intr,ju,xm,xs,xv,v)
+      real x(no,ni),w(no),xm(ni),xs(ni),xv(ni),v(no)
+      integer ju(ni)
       w=w/sum(w)                                                            
       v=sqrt(w)                                                             
       if(intr .ne. 0)goto 10141                                             
-      ym=0.0                                                                
-      y=v*y                                                                 
-      ys=sqrt(dot_product(y,y)-dot_product(v,y)**2)                         
-      y=y/ys                                                                
 10150 do 10151 j=1,ni                                                       
       if(ju(j).eq.0)goto 10151                                              
       xm(j)=0.0                                                             
@@ -823,7 +923,7 @@ c
 10161 continue                                                              
 10151 continue                                                              
 10152 continue                                                              
-      goto 10191                                                            
+      return
 10141 continue                                                              
 10200 do 10201 j=1,ni                                                       
       if(ju(j).eq.0)goto 10201                                              
@@ -844,25 +944,36 @@ c
 10242 continue                                                              
       xv=1.0                                                                
 10231 continue                                                              
+      return
+      end
+c the response part of standard, on the x and v of standx
+      subroutine standy (no,ni,x,y,w,v,intr,ju,g,ym,ys)
+      real x(no,ni),y(no),w(no),v(no),g(ni)
+      integer ju(ni)
+      if(intr .ne. 0)goto 10211
+      ym=0.0                                                                
+      y=v*y                                                                 
+      ys=sqrt(dot_product(y,y)-dot_product(v,y)**2)                         
+      y=y/ys                                                                
+      goto 10191
 10211 continue                                                              
       ym=dot_product(w,y)                                                   
       y=v*(y-ym)                                                            
       ys=sqrt(dot_product(y,y))                                             
       y=y/ys                                                                
 10191 continue                                                              
-10131 continue                                                              
       g=0.0                                                                 
 10250 do 10251 j=1,ni                                                       
       if(ju(j).ne.0) g(j)=dot_product(y,x(:,j))                             
 10251 continue                                                              
 10252 continue                                                              
-      deallocate(v)                                                         
       return                                                                
       end                                                                   
       subroutine elnet1 (beta,ni,ju,vp,cl,g,no,ne,nx,x,nlam,flmin,ulam,t    
-     *hr,maxit,xv,  lmu,ao,ia,kin,rsqo,almo,nlp,jerr)
+     *hr,maxit,xv,ainit,iwarm,xx,igram,  lmu,ao,ia,kin,rsqo,almo,nlp,
+     *jerr)
       real vp(ni),g(ni),x(no,ni),ulam(nlam),ao(nx,nlam),rsqo(nlam),almo(     
-     *nlam),xv(ni)
+     *nlam),xv(ni),ainit(ni),xx(ni,*)
       real cl(2,ni)                                                         
       integer ju(ni),ia(nx),kin(nlam)                                       
       real, dimension (:), allocatable :: a,da                                  
@@ -890,6 +1001,35 @@ c
       nin=nlp                                                               
       iz=0                                                                  
       mnl=min(mnlam,nlam)                                                   
+c warm start: enter the nonzero ainit coefficients into the active set
+c and update the gradient and rsq as coordinate steps from 0 would
+      if(iwarm.ne.0) then
+         do k=1,ni
+            if(ju(k).eq.0 .or. ainit(k).eq.0.0) cycle
+            if(nin.ge.nx) exit
+            nin=nin+1
+            do j=1,ni
+               if(ju(j).eq.0) cycle
+               if(mm(j).ne.0) then
+                  c(j,nin)=c(k,mm(j))
+               else if(j.eq.k) then
+                  c(j,nin)=xv(j)
+               else if(igram.ne.0) then
+                  c(j,nin)=xx(j,k)
+               else
+                  c(j,nin)=dot_product(x(:,j),x(:,k))
+               end if
+            end do
+            mm(k)=nin
+            ia(nin)=k
+            del=ainit(k)
+            a(k)=del
+            rsq=rsq+del*(2.0*g(k)-del*xv(k))
+            do j=1,ni
+               if(ju(j).ne.0) g(j)=g(j)-c(j,nin)*del
+            end do
+         end do
+      end if
 10280 do 10281 m=1,nlam                                                     
       if(flmin .lt. 1.0)goto 10301                                          
       alm=ulam(m)                                                           
@@ -942,6 +1082,11 @@ c
       c(j,nin)=xv(j)                                                        
       goto 10401                                                            
 10441 continue                                                              
+c the inner products of the standardized x, precomputed by elnetb
+      if(igram .eq. 0)goto 10443
+      c(j,nin)=xx(j,k)
+      goto 10401
+10443 continue
       c(j,nin)=dot_product(x(:,j),x(:,k))                                   
 10401 continue                                                              
 10402 continue                                                              
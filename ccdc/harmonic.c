@@ -0,0 +1,204 @@
+#include <stdlib.h>
+#include <math.h>
+
+#include "const.h"
+#include "2d_array.h"
+#include "utilities.h"
+#include "harmonic.h"
+#include "defines.h"
+
+
+/******************************************************************************
+MODULE:  build_harmonic_basis
+
+PURPOSE:  Precompute the harmonic (cos/sin) terms of the time series models
+          for every acquisition date in a scene set
+
+RETURN VALUE:
+Type = int
+ERROR error in allocating memories
+SUCCESS no error encounted
+
+NOTES: The float/double mix of each term deliberately mirrors the inline
+       expressions previously used by auto_ts_fit (2nd and 3rd harmonics in
+       double), auto_ts_predict (all harmonics in float) and auto_mask, so
+       that gathering from the table does not change any result.
+******************************************************************************/
+int build_harmonic_basis
+(
+    const int *dates,          /* I: acquisition dates (julian, any order) */
+    int num_dates,             /* I: number of dates                       */
+    Precision_t precision,     /* I: precision policy of the kernels       */
+    Harmonic_basis_t *basis    /* O: precomputed basis table               */
+)
+{
+    char FUNC_NAME[] = "build_harmonic_basis";
+    int i, k;
+    int row;
+    int last_date;
+    float t;                   /* date as used by the kernels              */
+    float w, w2, w3;           /* angular frequencies, float as in kernels */
+    float wy;                  /* Tmask w / years                          */
+    float p;                   /* float phase                              */
+
+    basis->day_row = NULL;
+    basis->fit_terms = NULL;
+    basis->pred_terms = NULL;
+    basis->pred_terms_f = NULL;
+    basis->tmask_terms = NULL;
+    basis->precision = precision;
+    basis->lasso_warm = NULL;
+
+    if (num_dates <= 0)
+    {
+        RETURN_ERROR ("No acquisition dates for the harmonic basis",
+                      FUNC_NAME, ERROR);
+    }
+
+    basis->first_date = dates[0];
+    last_date = dates[0];
+    for (i = 1; i < num_dates; i++)
+    {
+        if (dates[i] < basis->first_date)
+            basis->first_date = dates[i];
+        if (dates[i] > last_date)
+            last_date = dates[i];
+    }
+    basis->num_days = last_date - basis->first_date + 1;
+
+    basis->day_row = malloc(basis->num_days * sizeof(int));
+    if (basis->day_row == NULL)
+    {
+        RETURN_ERROR ("Allocating day_row memory", FUNC_NAME, ERROR);
+    }
+    for (i = 0; i < basis->num_days; i++)
+        basis->day_row[i] = -1;
+
+    /******************************************************************/
+    /*                                                                */
+    /* Assign a table row to every distinct date, in date order.      */
+    /*                                                                */
+    /******************************************************************/
+
+    for (i = 0; i < num_dates; i++)
+        basis->day_row[dates[i] - basis->first_date] = 0;
+    basis->num_dates = 0;
+    for (i = 0; i < basis->num_days; i++)
+    {
+        if (basis->day_row[i] == 0)
+            basis->day_row[i] = basis->num_dates++;
+        else
+            basis->day_row[i] = -1;
+    }
+
+    basis->fit_terms = (double **)allocate_2d_array(basis->num_dates,
+                       NUM_HARMONIC_TERMS, sizeof(double));
+    basis->pred_terms = (double **)allocate_2d_array(basis->num_dates,
+                       NUM_HARMONIC_TERMS, sizeof(double));
+    if (basis->fit_terms == NULL || basis->pred_terms == NULL)
+    {
+        free_harmonic_basis(basis);
+        RETURN_ERROR ("Allocating harmonic terms memory", FUNC_NAME, ERROR);
+    }
+    if (precision == PRECISION_SINGLE)
+    {
+        basis->pred_terms_f = (float **)allocate_2d_array(basis->num_dates,
+                              NUM_HARMONIC_TERMS, sizeof(float));
+        if (basis->pred_terms_f == NULL)
+        {
+            free_harmonic_basis(basis);
+            RETURN_ERROR ("Allocating float harmonic terms memory", FUNC_NAME,
+                          ERROR);
+        }
+    }
+
+    /******************************************************************/
+    /*                                                                */
+    /* Tmask uses w2 = w / years with years = ceil(span in years), so */
+    /* one column pair per possible year count of the scene set.      */
+    /*                                                                */
+    /******************************************************************/
+
+    basis->max_years = (int)ceil((float)(last_date - basis->first_date) /
+                       NUM_YEARS) + 1;
+    basis->tmask_terms = (double **)allocate_2d_array(basis->max_years + 1,
+                         2 * basis->num_dates, sizeof(double));
+    if (basis->tmask_terms == NULL)
+    {
+        free_harmonic_basis(basis);
+        RETURN_ERROR ("Allocating Tmask terms memory", FUNC_NAME, ERROR);
+    }
+
+    w = TWO_PI / AVE_DAYS_IN_A_YEAR;
+    w2 = 2.0 * w;
+    w3 = 3.0 * w;
+
+    for (i = 0; i < basis->num_days; i++)
+    {
+        row = basis->day_row[i];
+        if (row < 0)
+            continue;
+        t = (float)(basis->first_date + i);
+
+        /* auto_ts_fit: 1st harmonic in float, 2nd and 3rd in double */
+        p = w * t;
+        basis->fit_terms[row][0] = cos(p);
+        basis->fit_terms[row][1] = sin(p);
+        basis->fit_terms[row][2] = cos(2.0 * w * t);
+        basis->fit_terms[row][3] = sin(2.0 * w * t);
+        basis->fit_terms[row][4] = cos(3.0 * w * t);
+        basis->fit_terms[row][5] = sin(3.0 * w * t);
+
+        /* auto_ts_predict: all harmonics in float */
+        p = t * w;
+        basis->pred_terms[row][0] = cos(p);
+        basis->pred_terms[row][1] = sin(p);
+        p = t * w2;
+        basis->pred_terms[row][2] = cos(p);
+        basis->pred_terms[row][3] = sin(p);
+        p = t * w3;
+        basis->pred_terms[row][4] = cos(p);
+        basis->pred_terms[row][5] = sin(p);
+        if (basis->pred_terms_f != NULL)
+        {
+            for (k = 0; k < NUM_HARMONIC_TERMS; k++)
+                basis->pred_terms_f[row][k] = (float)basis->pred_terms[row][k];
+        }
+
+        /* auto_mask: w2 = w / years, in float */
+        for (k = 1; k <= basis->max_years; k++)
+        {
+            wy = w / (float)k;
+            p = wy * t;
+            basis->tmask_terms[k][2 * row] = cos(p);
+            basis->tmask_terms[k][2 * row + 1] = sin(p);
+        }
+    }
+
+    return (SUCCESS);
+}
+
+
+/******************************************************************************
+MODULE:  free_harmonic_basis
+
+PURPOSE:  Release the memory of a harmonic basis table
+
+RETURN VALUE: None
+******************************************************************************/
+void free_harmonic_basis
+(
+    Harmonic_basis_t *basis    /* I/O: basis table to release              */
+)
+{
+    free(basis->day_row);
+    basis->day_row = NULL;
+    free_2d_array((void **)basis->fit_terms);
+    basis->fit_terms = NULL;
+    free_2d_array((void **)basis->pred_terms);
+    basis->pred_terms = NULL;
+    free_2d_array((void **)basis->pred_terms_f);
+    basis->pred_terms_f = NULL;
+    free_2d_array((void **)basis->tmask_terms);
+    basis->tmask_terms = NULL;
+}
@@ -0,0 +1,64 @@
+#ifndef HARMONIC_H
+#define HARMONIC_H
+
+
+#include "defines.h"
+
+/* Number of harmonic terms (cos/sin pairs of the 1, 2 and 3 per year   */
+/* frequencies) used by the largest (8 coefficient) time series model.  */
+#define NUM_HARMONIC_TERMS (LASSO_COEFFS - 2)
+
+/* Precision policy of the prediction kernels.  Fits with glmnet and the  */
+/* Tmask robust fits are double in either case.                           */
+typedef enum
+{
+    PRECISION_DOUBLE,     /* double accumulation, the reference results     */
+    PRECISION_SINGLE      /* float accumulation, with a fallback to double  */
+                          /* where the float result is not accurate enough  */
+} Precision_t;
+
+/* Precomputed harmonic basis for every acquisition date of a scene set.  */
+/* Every pixel in a tile shares the same dates, so the cos/sin terms are  */
+/* evaluated once here and gathered by the fit, predict and Tmask kernels */
+/* instead of calling libm inside their inner loops.  The values are      */
+/* computed with exactly the same float/double arithmetic that each       */
+/* kernel used inline, so results are bit-for-bit unchanged.              */
+typedef struct
+{
+    int first_date;       /* first julian date covered by day_row           */
+    int num_days;         /* number of days covered by day_row              */
+    int *day_row;         /* julian date - first_date -> table row, or -1   */
+    int num_dates;        /* number of distinct acquisition dates (rows)    */
+    double **fit_terms;   /* [row][NUM_HARMONIC_TERMS] auto_ts_fit design   */
+                          /* cos(wt) sin(wt) cos(2wt) sin(2wt) cos(3wt)     */
+                          /* sin(3wt)                                       */
+    double **pred_terms;  /* [row][NUM_HARMONIC_TERMS] auto_ts_predict terms*/
+    Precision_t precision;/* precision policy of the kernels using the basis*/
+    float **pred_terms_f; /* pred_terms rounded to float, single precision  */
+                          /* policy only (NULL otherwise)                   */
+    int max_years;        /* largest Tmask year count with a precomputed    */
+                          /* w2 = w / years column                          */
+    double **tmask_terms; /* [years][2 * row] cos(w2 t), sin(w2 t) for      */
+                          /* years = 1 .. max_years                         */
+    struct Lasso_warm_s *lasso_warm; /* neighbor warm starts of the lasso   */
+                          /* fits of the pixel, NULL for cold fits          */
+} Harmonic_basis_t;
+
+/* Table row of an acquisition date, which must be part of the scene set. */
+#define HARMONIC_ROW(basis, date) \
+            ((basis)->day_row[(date) - (basis)->first_date])
+
+int build_harmonic_basis
+(
+    const int *dates,          /* I: acquisition dates (julian, any order) */
+    int num_dates,             /* I: number of dates                       */
+    Precision_t precision,     /* I: precision policy of the kernels       */
+    Harmonic_basis_t *basis    /* O: precomputed basis table               */
+);
+
+void free_harmonic_basis
+(
+    Harmonic_basis_t *basis    /* I/O: basis table to release              */
+);
+
+#endif /* HARMONIC_H */
@@ -3,6 +3,7 @@
 *****************************************************************************/
 
 #include "input.h"
+#include "ccdc.h"
 #include "utilities.h"
 #include "defines.h"
 
@@ -186,15 +187,19 @@ int read_envi_header
     else if (strcmp(data_type, "bip") == 0)
     {
         len = strlen(scene_name);
-        strncpy(short_scene, scene_name, len-5);
+        snprintf(short_scene, sizeof(short_scene), "%.*s", len-5, scene_name);
         split_directory_scenename(scene_name, directory, scene_list_name);
         if (strncmp(short_scene, ".", 1) == 0)
         {
-            strncpy(tmpstr, short_scene + 2, len - 2);
-            sprintf(filename, "%s/%s_MTLstack.hdr", tmpstr, scene_list_name);
+            snprintf(tmpstr, sizeof(tmpstr), "%s", short_scene + 2);
+            len = snprintf(filename, sizeof(filename), "%s/%s_MTLstack.hdr",
+                           tmpstr, scene_list_name);
         }
         else
-            sprintf(filename, "%s/%s_MTLstack.hdr", short_scene, scene_list_name);
+            len = snprintf(filename, sizeof(filename), "%s/%s_MTLstack.hdr",
+                           short_scene, scene_list_name);
+        if (len < 0 || len >= (int)sizeof(filename))
+            RETURN_ERROR("Header file name too long", FUNC_NAME, FAILURE);
     }
 
     in=fopen(filename, "r");
@@ -313,13 +318,15 @@ int read_stdin
     int           *fill_sum,            /* O:   accumulator for clear pixels  */
     int           *all_sum,             /* O:   accumulator for clear pixels  */
     int           *valid_num_scenes,    /* O:   total scenes read             */
-    bool          debug                 /* I:   flag for printing mesgs/info  */
+    bool          block                 /* I:   a blank line ends the pixel   */
 )
 
 {
     bool end_of_file = 0;               /* To identify end of stdin.          */
     int i, j;                           /* loop counters.                     */
     int status;                         /* function return status.            */
+    int c;                              /* character ahead of a scene.        */
+    int num_newlines;                   /* newlines ahead of a scene.         */
 
     /**************************************************************/
     /*                                                            */
@@ -331,11 +338,28 @@ int read_stdin
     /* number of scenes. For example:                             */
     /* 2456445 94 156 164 758 807 492 2809 0                      */
     /*                                                            */
+    /* In block mode the pixels follow each other, separated by   */
+    /* a blank line.                                              */
+    /*                                                            */
     /**************************************************************/
 
     i = 0;
     while (!end_of_file)
     {
+        if (block)
+        {
+            num_newlines = 0;
+            while ((c = getchar()) != EOF && isspace(c))
+            {
+                if (c == '\n')
+                    num_newlines++;
+            }
+            if (c != EOF)
+                ungetc(c, stdin);
+            if (num_newlines >= 2 && i > 0)
+                break;
+        }
+
         /**************************************************************/
         /*                                                            */
         /* Read Julian date/time value.                               */
@@ -349,8 +373,7 @@ int read_stdin
         }
         else
         {
-            if (debug)
-                printf( "You entered: %d\n", updated_sdate_array[i]);
+            LOG_TRACE("You entered: %d\n", updated_sdate_array[i]);
         }
 
         /**************************************************************/
@@ -362,8 +385,7 @@ int read_stdin
         for (j = 0; j < num_bands; j++)
         {
             scanf("%d", &buf[j][i]);
-            if (debug)
-                printf( "You entered: %d\n", buf[j][i]);
+            LOG_TRACE("You entered: %d\n", buf[j][i]);
         }
 
         /**************************************************************/
@@ -373,8 +395,7 @@ int read_stdin
         /**************************************************************/
 
         scanf("%hhu", &updated_cfmask_buf[i]);
-        if (debug)
-            printf( "You entered: %u\n", updated_cfmask_buf[i]);
+        LOG_TRACE("You entered: %u\n", updated_cfmask_buf[i]);
 
         /**************************************************************/
         /*                                                            */
@@ -390,7 +411,7 @@ int read_stdin
                                        cloud_sum, fill_sum, all_sum);
         if (status != SUCCESS)
         {
-            printf ("Error calling assign_cfmask_values.");
+            LOG_ERROR ("Error calling assign_cfmask_values.\n");
             return (FAILURE);
         }
 
@@ -399,8 +420,7 @@ int read_stdin
     }
 
     *valid_num_scenes = i;
-    if (debug)
-        printf ("\n");
+    LOG_TRACE ("\n");
 
     return (SUCCESS);
 
@@ -468,7 +488,7 @@ int assign_cfmask_values
             (*fill_sum)++;
             break;
         default:
-            printf ("Unknown cfmask value %d", cfmask_value);
+            LOG_ERROR ("Unknown cfmask value %d\n", cfmask_value);
             return (FAILURE);
             break;
         }
@@ -510,7 +530,6 @@ int read_tifs
     int  row,            /* I:   the row (Y) location within img/grid   */
     int  col,            /* I:   the col (X) location within img/grid   */
     int  num_samples,    /* I:   number of image samples (X width)      */
-    bool debug,          /* I:   flag for printing debug messages       */
     int  **image_buf     /* O:   pointer to 2-D image band values array */
 )
 
@@ -520,6 +539,7 @@ int read_tifs
     int  landsat_number;        /* numeric mission number to make names */
     char filename[MAX_STR_LEN]; /* file name constructed from sceneID   */
     int  status;                /* return status of system call(s)      */
+    short int value;            /* band value read                      */
 
 
     /******************************************************************/
@@ -551,21 +571,19 @@ int read_tifs
 
         fp_tifs[k][curr_scene_num] = open_raw_binary(filename,"rb");
         if (fp_tifs[k][curr_scene_num] == NULL)
-            printf("error open %d scene, %d bands files\n",curr_scene_num, k+1);
+            LOG_ERROR("error open %d scene, %d bands files\n",curr_scene_num, k+1);
 
         status = fseek(fp_tifs[k][curr_scene_num], ((row * num_samples) + col) * sizeof(short int), SEEK_SET);
         if (status != 0)
-            printf("error seeking %d scene, %d bands\n", curr_scene_num, (k + 1));
+            LOG_ERROR("error seeking %d scene, %d bands\n", curr_scene_num, (k + 1));
 
-        if (read_raw_binary(fp_tifs[k][curr_scene_num], 1, 1, sizeof(short int), &image_buf[k][curr_scene_num]) != 0)
-            printf("error reading %d scene, %d bands\n", curr_scene_num, (k + 1));
+        if (read_raw_binary(fp_tifs[k][curr_scene_num], 1, 1, sizeof(short int), &value) != 0)
+            LOG_ERROR("error reading %d scene, %d bands\n", curr_scene_num, (k + 1));
+        image_buf[k][curr_scene_num] = value;
     
         close_raw_binary(fp_tifs[k][curr_scene_num]);
 
-        if (debug)
-        {
-            printf("%d ", (short int)image_buf[k][curr_scene_num]);
-        }
+        LOG_TRACE("%d ", (short int)image_buf[k][curr_scene_num]);
 
     }
 
@@ -614,7 +632,7 @@ int read_bip
     char scene_name[MAX_STR_LEN];
     char tmpstr[MAX_STR_LEN];   /* for string manipulation              */
     char errmsg[MAX_STR_LEN];   /* for printing error text to the log.  */
-    bool debug = true;          /* for debug printing                   */
+    short int value;            /* band value read                      */
 
 
     /******************************************************************/
@@ -624,25 +642,31 @@ int read_bip
     /******************************************************************/
 
     len = strlen(curr_scene_name);
-    strncpy(shorter_name, curr_scene_name, len-5);
-    // somebody is trashing memory and I cannot find him...
-    shorter_name[len-5] = '\0';
+    snprintf(shorter_name, sizeof(shorter_name), "%.*s", len-5,
+             curr_scene_name);
 
     split_directory_scenename(curr_scene_name, directory, scene_name);
 
     if (strncmp(shorter_name, ".", 1) == 0)
     {
-        strncpy(tmpstr, shorter_name + 2, len - 2);
-        sprintf(filename, "%s/%s_MTLstack", tmpstr, scene_name);
+        snprintf(tmpstr, sizeof(tmpstr), "%s", shorter_name + 2);
+        len = snprintf(filename, sizeof(filename), "%s/%s_MTLstack", tmpstr,
+                       scene_name);
     }
     else
-        sprintf(filename, "%s/%s_MTLstack", shorter_name, scene_name);
+        len = snprintf(filename, sizeof(filename), "%s/%s_MTLstack",
+                       shorter_name, scene_name);
+    if (len < 0 || len >= (int)sizeof(filename))
+    {
+        LOG_ERROR("BIP file name of scene %d too long\n", curr_scene_num);
+        return (FAILURE);
+    }
 
     fp_bip[curr_scene_num] = open_raw_binary(filename,"rb");
     if (fp_bip[curr_scene_num] == NULL)
     {
         sprintf(errmsg, "Opening %d scene files\n", curr_scene_num);
-        printf(errmsg);
+        LOG_ERROR("%s", errmsg);
         return (FAILURE);
     }
 
@@ -658,14 +682,14 @@ int read_bip
     for (k = 0; k < TOTAL_IMAGE_BANDS; k++)
     {
         if (read_raw_binary(fp_bip[curr_scene_num], 1, 1,
-                sizeof(short int), &image_buf[k][curr_scene_num]) != 0)
+                sizeof(short int), &value) != 0)
         {
     	    sprintf(errmsg, "error reading %d scene, %d bands\n",curr_scene_num, k+1);
-            printf(errmsg);
+            LOG_ERROR("%s", errmsg);
             return (FAILURE);
         }
-        if (debug)
-            printf("%d ", (short int)image_buf[k][curr_scene_num]);
+        image_buf[k][curr_scene_num] = value;
+        LOG_TRACE("%d ", (short int)image_buf[k][curr_scene_num]);
     }
         close_raw_binary(fp_bip[curr_scene_num]);
 
@@ -673,6 +697,301 @@ int read_bip
 }
 
 
+/*******************************************************************************
+MODULE: read_block
+
+PURPOSE: Reads one value of each pixel of a cell x cell block of an image
+         file, given the byte offset of its upper left pixel.
+
+RETURN VALUE:
+Type = int
+Value           Description
+-----           -----------
+ERROR           Error seeking or reading the file
+SUCCESS         No errors encountered
+
+NOTES: value_size is 1 for the cfmask files of tifs, and 2 (short int)
+       otherwise.
+*******************************************************************************/
+
+static int read_block
+(
+    FILE *fp,            /* I:   opened image file                      */
+    long offset,         /* I:   byte offset of the upper left pixel    */
+    long line_size,      /* I:   bytes of one image line                */
+    long pixel_size,     /* I:   bytes of one pixel                     */
+    int  value_size,     /* I:   bytes of the value read                */
+    int  cell,           /* I:   side of the block, in pixels           */
+    int  *values         /* O:   cell * cell values, line by line       */
+)
+{
+    char FUNC_NAME[] = "read_block";
+    unsigned char byte_value;
+    short int short_value;
+    int r, c;
+
+    for (r = 0; r < cell; r++)
+    {
+        for (c = 0; c < cell; c++)
+        {
+            if (fseek(fp, offset + r * line_size + c * pixel_size,
+                      SEEK_SET) != 0)
+                RETURN_ERROR("Seeking a cell pixel", FUNC_NAME, ERROR);
+
+            if (value_size == 1)
+            {
+                if (read_raw_binary(fp, 1, 1, 1, &byte_value) != 0)
+                    RETURN_ERROR("Reading a cell pixel", FUNC_NAME, ERROR);
+                values[r * cell + c] = byte_value;
+            }
+            else
+            {
+                if (read_raw_binary(fp, 1, 1, sizeof(short int),
+                                    &short_value) != 0)
+                    RETURN_ERROR("Reading a cell pixel", FUNC_NAME, ERROR);
+                values[r * cell + c] = short_value;
+            }
+        }
+    }
+
+    return (SUCCESS);
+}
+
+
+/*******************************************************************************
+MODULE: cell_member
+
+PURPOSE: Tells whether a pixel of a cell is of the cfmask class of the cell:
+         clear land and water are one class, the other values their own.
+
+RETURN VALUE:
+Type = bool
+*******************************************************************************/
+
+static bool cell_member
+(
+    int fmask,             /* I:   cfmask of the pixel                    */
+    unsigned char cell_fmask /* I: cfmask of the cell                     */
+)
+{
+    if (cell_fmask <= CFMASK_WATER)
+        return (fmask <= CFMASK_WATER);
+
+    return (fmask == cell_fmask);
+}
+
+
+/*******************************************************************************
+MODULE: read_cell
+
+PURPOSE: Reads the cfmask and image bands of a cell x cell block of pixels
+         of one scene, and aggregates them to one coarse pixel for the
+         screening pass.
+
+RETURN VALUE:
+Type = int
+Value           Description
+-----           -----------
+ERROR           Error opening or reading the scene files
+SUCCESS         No errors encountered
+
+NOTES: The block starts at (row, col), numbered as for a single pixel of the
+       data type.  The cell is clear (or water, whichever has more pixels)
+       when any of its pixels is clear land or water; otherwise it takes the
+       most frequent of the shadow, snow and cloud values, and is fill when
+       all its pixels are.  Each band is the median of the pixels of the
+       class of the cell, so clouds do not leak into a clear cell.
+*******************************************************************************/
+
+int read_cell
+(
+    char *data_type,       /* I:   type of files, tifs or single BIP         */
+    char *scene_name,      /* I:   current scene name in list of sceneIDs    */
+    int  row,              /* I:   upper left row (Y) of the block           */
+    int  col,              /* I:   upper left col (X) of the block           */
+    int  num_samples,      /* I:   number of image samples (X width)         */
+    int  cell,             /* I:   side of the block, in pixels              */
+    unsigned char *cell_fmask, /* O: cfmask of the cell                      */
+    int  *cell_bands       /* O:   [TOTAL_IMAGE_BANDS] values of the cell    */
+)
+{
+    char FUNC_NAME[] = "read_cell";
+    char filename[MAX_STR_LEN];
+    char short_scene[MAX_STR_LEN];
+    char directory[MAX_STR_LEN];
+    char name[MAX_STR_LEN];
+    int fmask[MAX_SCREEN_CELL * MAX_SCREEN_CELL];
+    int values[MAX_SCREEN_CELL * MAX_SCREEN_CELL];
+    int count[CFMASK_CLOUD + 1];
+    FILE *fp = NULL;
+    bool tifs = (strcmp(data_type, "tifs") == 0);
+    long offset = 0;
+    long line_size = 0;
+    long pixel_size = 0;
+    int landsat_number = 0;
+    int len;
+    int name_len;              /* snprintf length of filename           */
+    int n, num, i, j, k, v;
+    int status;
+
+    len = strlen(scene_name);
+    if (tifs)
+    {
+        landsat_number = atoi(sub_string(scene_name, (len-19), 1));
+        name_len = snprintf(filename, sizeof(filename), "%s_cfmask.img",
+                            scene_name);
+        offset = (long)row * num_samples + col;
+        line_size = num_samples;
+        pixel_size = 1;
+    }
+    else
+    {
+        snprintf(short_scene, sizeof(short_scene), "%.*s", len-5, scene_name);
+        split_directory_scenename(scene_name, directory, name);
+        if (strncmp(short_scene, ".", 1) == 0)
+            name_len = snprintf(filename, sizeof(filename), "%s/%s_MTLstack",
+                                short_scene + 2, name);
+        else
+            name_len = snprintf(filename, sizeof(filename), "%s/%s_MTLstack",
+                                short_scene, name);
+        offset = ((long)(row - 1) * num_samples + col - 1) * TOTAL_BANDS *
+                 sizeof(short int);
+        line_size = (long)num_samples * TOTAL_BANDS * sizeof(short int);
+        pixel_size = TOTAL_BANDS * sizeof(short int);
+    }
+    if (name_len < 0 || name_len >= (int)sizeof(filename))
+        RETURN_ERROR("Scene file name too long", FUNC_NAME, ERROR);
+
+    /******************************************************************/
+    /*                                                                */
+    /* cfmask of the cell.                                            */
+    /*                                                                */
+    /******************************************************************/
+
+    fp = open_raw_binary(filename, "rb");
+    if (fp == NULL)
+        RETURN_ERROR("Opening the cfmask of a cell", FUNC_NAME, ERROR);
+    if (tifs)
+        status = read_block(fp, offset, line_size, pixel_size, 1, cell, fmask);
+    else
+        status = read_block(fp, offset + TOTAL_IMAGE_BANDS * sizeof(short int),
+                            line_size, pixel_size, 2, cell, fmask);
+    if (tifs || status != SUCCESS)
+        close_raw_binary(fp);
+    if (status != SUCCESS)
+        RETURN_ERROR("Reading the cfmask of a cell", FUNC_NAME, ERROR);
+
+    for (v = 0; v <= CFMASK_CLOUD; v++)
+        count[v] = 0;
+    for (n = 0; n < cell * cell; n++)
+    {
+        if (fmask[n] >= 0 && fmask[n] <= CFMASK_CLOUD)
+            count[fmask[n]]++;
+    }
+
+    if (count[CFMASK_CLEAR] + count[CFMASK_WATER] > 0)
+    {
+        *cell_fmask = (count[CFMASK_WATER] > count[CFMASK_CLEAR]) ?
+                      CFMASK_WATER : CFMASK_CLEAR;
+    }
+    else
+    {
+        *cell_fmask = CFMASK_FILL;
+        for (v = CFMASK_SHADOW; v <= CFMASK_CLOUD; v++)
+        {
+            if (count[v] > 0 && (*cell_fmask == CFMASK_FILL ||
+                                 count[v] > count[*cell_fmask]))
+                *cell_fmask = v;
+        }
+    }
+
+    if (*cell_fmask == CFMASK_FILL)
+    {
+        if (!tifs)
+            close_raw_binary(fp);
+        return (SUCCESS);
+    }
+
+    /******************************************************************/
+    /*                                                                */
+    /* Median of each band over the pixels of the class of the cell.  */
+    /*                                                                */
+    /******************************************************************/
+
+    for (k = 0; k < TOTAL_IMAGE_BANDS; k++)
+    {
+        if (tifs)
+        {
+            if (landsat_number != 8)
+            {
+                if (k == 5)
+                    name_len = snprintf(filename, sizeof(filename),
+                                        "%s_sr_band%d.img", scene_name, k+2);
+                else if (k == 6)
+                    name_len = snprintf(filename, sizeof(filename),
+                                        "%s_toa_band6.img", scene_name);
+                else
+                    name_len = snprintf(filename, sizeof(filename),
+                                        "%s_sr_band%d.img", scene_name, k+1);
+            }
+            else
+            {
+                if (k == 6)
+                    name_len = snprintf(filename, sizeof(filename),
+                                        "%s_toa_band10.img", scene_name);
+                else
+                    name_len = snprintf(filename, sizeof(filename),
+                                        "%s_sr_band%d.img", scene_name, k+2);
+            }
+            if (name_len < 0 || name_len >= (int)sizeof(filename))
+                RETURN_ERROR("Scene file name too long", FUNC_NAME, ERROR);
+            fp = open_raw_binary(filename, "rb");
+            if (fp == NULL)
+                RETURN_ERROR("Opening a band of a cell", FUNC_NAME, ERROR);
+            status = read_block(fp, offset * sizeof(short int),
+                                line_size * sizeof(short int),
+                                sizeof(short int), 2, cell, values);
+            close_raw_binary(fp);
+        }
+        else
+        {
+            status = read_block(fp, offset + k * sizeof(short int), line_size,
+                                pixel_size, 2, cell, values);
+        }
+        if (status != SUCCESS)
+        {
+            if (!tifs)
+                close_raw_binary(fp);
+            RETURN_ERROR("Reading a band of a cell", FUNC_NAME, ERROR);
+        }
+
+        /* Insertion sort of the member values, at most MAX_SCREEN_CELL^2 */
+        num = 0;
+        for (n = 0; n < cell * cell; n++)
+        {
+            if (!cell_member(fmask[n], *cell_fmask))
+                continue;
+            v = values[n];
+            for (i = num; i > 0 && values[i-1] > v; i--)
+                values[i] = values[i-1];
+            values[i] = v;
+            num++;
+        }
+
+        j = num / 2;
+        if (num % 2 == 0)
+            cell_bands[k] = (values[j-1] + values[j]) / 2;
+        else
+            cell_bands[k] = values[j];
+    }
+
+    if (!tifs)
+        close_raw_binary(fp);
+
+    return (SUCCESS);
+}
+
+
 int read_cfmask
 (
     int  curr_scene_num, /* I:   current num. in list of scenes to read       */
@@ -684,6 +1003,8 @@ int read_cfmask
     FILE ***fp_tifs,     /* I/O: file ptr array for tif band file names       */
     FILE **fp_bip,       /* I/O: file pointer array for BIP file names        */
     unsigned char *fmask_buf,/* O:   pointer to cfmask band values            */
+    int  cell,           /* I:   side of the screening cell, 1 for a pixel    */
+    int  *cell_bands,    /* O:   band values of the cell, when cell > 1       */
                          /* I/O: Worldwide Reference System path and row for  */
                          /* I/O: the current swath, this group of variables   */
                          /* I/O: is for filtering out swath overlap, and      */
@@ -711,14 +1032,12 @@ int read_cfmask
 {
 
     int len;             /* for strlen call                             */
-    int landsat_number;  /* mission number for determining file names   */
     char scene_name[MAX_STR_LEN]; /* current scene id name              */
     char filename[MAX_STR_LEN];   /* temp for constructing file name    */
-    int wrs_path;        /* Worldwide Reference System path             */
+    int wrs_path = 0;    /* Worldwide Reference System path             */
     int wrs_row = 0;     /* WRS row                                     */
-    int year;            /* Year of acquisition date of current scene   */
-    int jday;            /* Julian day since 0 of current scene date    */
-    bool debug = 1;      /* for debug printing                          */
+    int year = 0;        /* Year of acquisition date of current scene   */
+    int jday = 0;        /* Julian day since 0 of current scene date    */
     int status;          /* for return status of function calls         */
     char short_scene[MAX_STR_LEN]; /* for parsing file names            */
     char directory[MAX_STR_LEN]; /* for parsing file names              */
@@ -737,7 +1056,6 @@ int read_cfmask
         /**************************************************************/
     
         len = strlen(scene_list[curr_scene_num]);
-        landsat_number = atoi(sub_string(scene_list[curr_scene_num],(len-19),1));
         wrs_path = atoi(sub_string(scene_list[curr_scene_num],(len-18),3));
         wrs_row =  atoi(sub_string(scene_list[curr_scene_num],(len-15),3));
         year = atoi(sub_string(scene_list[curr_scene_num],(len-12),4));
@@ -761,14 +1079,14 @@ int read_cfmask
     
         fp_tifs[CFMASK_BAND][curr_scene_num] = open_raw_binary(filename,"rb");
         if (fp_tifs[CFMASK_BAND][curr_scene_num] == NULL)
-            printf("error open %d scene, %d bands files\n", curr_scene_num, CFMASK_BAND+1);
+            LOG_ERROR("error open %d scene, %d bands files\n", curr_scene_num, CFMASK_BAND+1);
     
         fseek(fp_tifs[CFMASK_BAND][curr_scene_num], (row * num_samples + col)*sizeof(unsigned char), 
             SEEK_SET);
     
         if (read_raw_binary(fp_tifs[CFMASK_BAND][curr_scene_num], 1, 1,
             sizeof(unsigned char), &fmask_buf[curr_scene_num]) != 0)
-            printf("error reading %d scene, %d bands\n", curr_scene_num, CFMASK_BAND+1);
+            LOG_ERROR("error reading %d scene, %d bands\n", curr_scene_num, CFMASK_BAND+1);
 
         close_raw_binary(fp_tifs[CFMASK_BAND][curr_scene_num]);
     }
@@ -778,15 +1096,20 @@ int read_cfmask
     {
 
         len = strlen(scene_list[curr_scene_num]);
-        strncpy(short_scene, scene_list[curr_scene_num], len-5);
+        snprintf(short_scene, sizeof(short_scene), "%.*s", len-5,
+                 scene_list[curr_scene_num]);
         split_directory_scenename(scene_list[curr_scene_num], directory, scene_name);
         if (strncmp(short_scene, ".", 1) == 0)
         {
-            strncpy(tmpstr, short_scene + 2, len - 2);
-            sprintf(filename, "%s/%s_MTLstack", tmpstr, scene_name);
+            snprintf(tmpstr, sizeof(tmpstr), "%s", short_scene + 2);
+            len = snprintf(filename, sizeof(filename), "%s/%s_MTLstack",
+                           tmpstr, scene_name);
         }
         else
-            sprintf(filename, "%s/%s_MTLstack", short_scene, scene_name);
+            len = snprintf(filename, sizeof(filename), "%s/%s_MTLstack",
+                           short_scene, scene_name);
+        if (len < 0 || len >= (int)sizeof(filename))
+            RETURN_ERROR("BIP file name too long", FUNC_NAME, ERROR);
         fp_bip[curr_scene_num] = open_raw_binary(filename,"rb");
         if (fp_bip[curr_scene_num] == NULL)
         {
@@ -809,6 +1132,21 @@ int read_cfmask
 
     }
 
+    /******************************************************************/
+    /*                                                                */
+    /* For the screening pass, the cell replaces the pixel.           */
+    /*                                                                */
+    /******************************************************************/
+
+    if (cell > 1)
+    {
+        status = read_cell(data_type, scene_list[curr_scene_num], row, col,
+                           num_samples, cell, &fmask_buf[curr_scene_num],
+                           cell_bands);
+        if (status != SUCCESS)
+            RETURN_ERROR("Calling read_cell", FUNC_NAME, FAILURE);
+    }
+
     /******************************************************************/
     /*                                                                */
     /* Check for swath overlap pixels.  If consecutive temporal       */
@@ -826,10 +1164,7 @@ int read_cfmask
     {
         (*swath_overlap_count)++;
         strcpy(valid_scene_list[(*valid_scene_count) - 1], scene_list[curr_scene_num]);
-        if (debug)
-        {
-            printf("i = %d swath overlap %s\n", curr_scene_num, scene_list[curr_scene_num -1]);
-        }
+        LOG_DEBUG("i = %d swath overlap %s\n", curr_scene_num, scene_list[curr_scene_num -1]);
     }
 
     else
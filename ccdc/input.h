@@ -91,6 +91,8 @@ int read_cfmask
     FILE ***fp_tifs,     /* I/O: file ptr array for tif band file names       */
     FILE **fp_bip,       /* I/O: file pointer array for BIP file names        */
     unsigned char *fmask_buf,/* O:   pointer to cfmask band values            */
+    int  cell,           /* I:   side of the screening cell, 1 for a pixel    */
+    int  *cell_bands,    /* O:   band values of the cell, when cell > 1       */
                          /* I/O: Worldwide Reference System path and row for  */
                          /* I/O: the current swath, this group of variables   */
                          /* I/O: is for filtering out swath overlap, and      */
@@ -130,7 +132,7 @@ int read_stdin
     int           *fill_sum,            /* accumulator for fill   pixels. */
     int           *all_sum,             /* accumulator for all    pixels. */
     int           *valid_num_scenes,    /* total scenes read.             */
-    bool          debug                 /* flag for printing mesgs/info.  */
+    bool          block                 /* a blank line ends the pixel.   */
 );
 
 
@@ -147,6 +149,19 @@ int assign_cfmask_values
 );
 
 
+int read_cell
+(
+    char *data_type,       /* I:   type of files, tifs or single BIP         */
+    char *scene_name,      /* I:   current scene name in list of sceneIDs    */
+    int  row,              /* I:   upper left row (Y) of the block           */
+    int  col,              /* I:   upper left col (X) of the block           */
+    int  num_samples,      /* I:   number of image samples (X width)         */
+    int  cell,             /* I:   side of the block, in pixels              */
+    unsigned char *cell_fmask, /* O: cfmask of the cell                      */
+    int  *cell_bands       /* O:   [TOTAL_IMAGE_BANDS] values of the cell    */
+);
+
+
 int read_tifs
 (
     char *sceneID_name,  /* I:   current file name in list of sceneIDs  */
@@ -155,7 +170,6 @@ int read_tifs
     int  row,            /* I:   the row (Y) location within img/grid   */
     int  col,            /* I:   the col (X) location within img/grid   */
     int  num_samples,    /* I:   number of image samples (X width)      */
-    bool debug,          /* I:   flag for printing debug messages       */
     int  **image_buf     /* O:   pointer to 2-D image band values array */
 );
 
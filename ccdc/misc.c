@@ -7,11 +7,18 @@
 #include <string.h>
 #include <limits.h>
 #include <errno.h>
+#include <unistd.h>
 
 #include "2d_array.h"
 #include "const.h"
 #include "utilities.h"
 #include "ccdc.h"
+#include "harmonic.h"
+#include "obs_store.h"
+#include "ts_kernels.h"
+#include "cpu_dispatch.h"
+#include "neighbor.h"
+#include "sort.h"
 #include <gsl/gsl_multifit.h>
 #include <gsl/gsl_randist.h>
 
@@ -56,22 +63,81 @@ int get_args
     char *out_path,        /* O: directory location for output files        */
     char *data_type,       /* O: data type:tif,bip,stdin.Future: bsq,"rods".*/
     char *scene_list_file, /* O: opitonal file name of list of sceneIDs     */
-    bool *verbose          /* O: verbose flag                               */
+    bool *verbose,         /* O: verbose flag                               */
+    bool *lazy_fit,        /* O: fit non-detection bands only when a curve  */
+                           /*    is recorded                                */
+    Precision_t *precision,/* O: precision policy of the kernels            */
+    bool *fast_path,       /* O: stable curve shortcut of the monitoring    */
+    bool *validate_fast_path,/* O: compare the shortcut with the full loop  */
+    char *sweep_file,      /* O: optional file name of parameter sets       */
+    int *screen_cell,      /* O: cell side of the screening pass, 1 if off  */
+    int *block_rows,       /* O: rows of the block of pixels run            */
+    int *block_cols,       /* O: cols of the block of pixels run            */
+    bool *neighbor_warm_start,/* O: warm start lasso fits from neighbors    */
+    int *log_level,        /* O: most verbose LOG_LEVEL_ written            */
+    char *log_file,        /* O: optional file name of the log              */
+    int *num_threads,      /* O: threads running the pixels of the block    */
+    int *read_ahead,       /* O: pixels in flight, 0 for the default        */
+    int *max_buffer_mb,    /* O: cap of their buffers in MB, 0 if none      */
+    bool *record_cost,     /* O: append the cost of the pixels to cost.txt  */
+    bool *cost_only,       /* O: only that, no change detection             */
+    int *checkpoint,       /* O: pixels between checkpoints, 0 if off       */
+    bool *resume,          /* O: resume from the last checkpoint            */
+    char *state_dir,       /* O: directory of the series states, "" if off  */
+    bool *update,          /* O: read only the scenes after the state       */
+    char *tune_profile,    /* O: tuning profile applied, "" if none         */
+    bool *numa             /* O: place the threads and buffers on nodes     */
 )
 {
     int c;                         /* current argument index                */
     int option_index;              /* index for the command-line option     */
     static int verbose_flag = 0;   /* verbose flag                          */
-    char errmsg[MAX_STR_LEN];      /* error message                         */
+    static int lazy_fit_flag = 0;  /* lazy fitting flag                     */
+    static int fast_path_flag = 0; /* stable fast path flag                 */
+    static int validate_fast_flag = 0; /* fast path validation flag         */
+    static int neighbor_warm_flag = 0; /* neighbor warm start flag          */
+    static int record_cost_flag = 0;  /* cost record flag                    */
+    static int cost_only_flag = 0;    /* cost records only flag              */
+    static int resume_flag = 0;       /* resume from checkpoint flag         */
+    static int update_flag = 0;       /* update from the series state flag   */
+    static int numa_flag = 0;         /* NUMA placement flag                 */
+    bool threads_given = false;    /* --threads on the command line         */
+    bool read_ahead_given = false; /* --read-ahead on the command line      */
+    char host[MAX_STR_LEN];        /* node name, of the default profile     */
+    int threads, ahead;            /* values of the tuning profile          */
+    int len;                       /* length of the default profile name    */
+    char errmsg[2 * MAX_STR_LEN];  /* error message, room for a path        */
     char FUNC_NAME[] = "get_args"; /* function name                         */
     static struct option long_options[] = {
         {"verbose", no_argument, &verbose_flag, 1},
+        {"lazy-fit", no_argument, &lazy_fit_flag, 1},
+        {"stable-fast-path", no_argument, &fast_path_flag, 1},
+        {"validate-fast-path", no_argument, &validate_fast_flag, 1},
+        {"neighbor-warm-start", no_argument, &neighbor_warm_flag, 1},
+        {"record-cost", no_argument, &record_cost_flag, 1},
+        {"cost-only", no_argument, &cost_only_flag, 1},
+        {"resume", no_argument, &resume_flag, 1},
+        {"update", no_argument, &update_flag, 1},
+        {"numa", no_argument, &numa_flag, 1},
+        {"checkpoint", required_argument, 0, 'k'},
+        {"state-dir", required_argument, 0, 'S'},
+        {"tune-profile", required_argument, 0, 'P'},
+        {"precision", required_argument, 0, 'p'},
         {"row", required_argument, 0, 'r'},
         {"col", required_argument, 0, 'c'},
         {"in-path", required_argument, 0, 'i'},
         {"out-path", required_argument, 0, 'o'},
         {"data-type", required_argument, 0, 'd'},
         {"scene-list-file", required_argument, 0, 's'},
+        {"sweep-file", required_argument, 0, 'w'},
+        {"screen-cell", required_argument, 0, 'g'},
+        {"block-rows", required_argument, 0, 'R'},
+        {"block-cols", required_argument, 0, 'C'},
+        {"log-level", required_argument, 0, 'L'},
+        {"log-file", required_argument, 0, 'l'},
+        {"threads", required_argument, 0, 'T'},
+        {"read-ahead", required_argument, 0, 'A'},
+        {"max-buffer-mb", required_argument, 0, 'M'},
         {"help", no_argument, 0, 'h'},
         {0, 0, 0, 0}
     };
@@ -83,6 +149,18 @@ int get_args
     /******************************************************************/
 
     opterr = 0;
+    *precision = PRECISION_DOUBLE;
+    *screen_cell = 1;
+    *block_rows = 1;
+    *block_cols = 1;
+    *log_level = -1;
+    strcpy (log_file, "");
+    *num_threads = 1;
+    *read_ahead = 0;
+    *max_buffer_mb = 0;
+    *checkpoint = 0;
+    strcpy (state_dir, "");
+    strcpy (tune_profile, "");
 
     /******************************************************************/
     /*                                                                */
@@ -151,6 +229,10 @@ int get_args
                 strcpy (data_type, optarg);
                 break;
 
+            case 'w':
+                strcpy (sweep_file, optarg);
+                break;
+
             case 'r':             
                 *row = atoi (optarg);
                 break;
@@ -159,6 +241,70 @@ int get_args
                 *col = atoi (optarg);
                 break;
 
+            case 'g':
+                *screen_cell = atoi (optarg);
+                break;
+
+            case 'R':
+                *block_rows = atoi (optarg);
+                break;
+
+            case 'C':
+                *block_cols = atoi (optarg);
+                break;
+
+            case 'L':
+                *log_level = log_level_from_name (optarg);
+                if (*log_level < 0)
+                {
+                    sprintf (errmsg, "log-level must be one of: error, warn, "
+                             "info, debug, trace");
+                    RETURN_ERROR(errmsg, FUNC_NAME, FAILURE);
+                }
+                break;
+
+            case 'l':
+                strcpy (log_file, optarg);
+                break;
+
+            case 'T':
+                *num_threads = atoi (optarg);
+                threads_given = true;
+                break;
+
+            case 'A':
+                *read_ahead = atoi (optarg);
+                read_ahead_given = true;
+                break;
+
+            case 'M':
+                *max_buffer_mb = atoi (optarg);
+                break;
+
+            case 'k':
+                *checkpoint = atoi (optarg);
+                break;
+
+            case 'S':
+                strcpy (state_dir, optarg);
+                break;
+
+            case 'P':
+                strcpy (tune_profile, optarg);
+                break;
+
+            case 'p':
+                if (strcmp(optarg, "single") == 0)
+                    *precision = PRECISION_SINGLE;
+                else if (strcmp(optarg, "double") == 0)
+                    *precision = PRECISION_DOUBLE;
+                else
+                {
+                    sprintf (errmsg, "precision must be one of: single, double");
+                    RETURN_ERROR(errmsg, FUNC_NAME, FAILURE);
+                }
+                break;
+
             case '?':
             default:
                 sprintf (errmsg, "Unknown option %s", argv[optind - 1]);
@@ -168,6 +314,41 @@ int get_args
         }
     }
 
+    /******************************************************************/
+    /*                                                                */
+    /* The tuning profile of scripts/tuneCcdc.pl sets the threads and */
+    /* the pixels in flight not given on the command line.  Without   */
+    /* --tune-profile, the one of this node in in-path is used if     */
+    /* there is one, so the batch runs of a tile pick it up.          */
+    /*                                                                */
+    /******************************************************************/
+
+    if ((strcmp(tune_profile, "") == 0) && (strcmp(in_path, "stdin") != 0) &&
+        (gethostname(host, sizeof(host)) == 0))
+    {
+        host[sizeof(host) - 1] = '\0';
+        len = snprintf (tune_profile, MAX_STR_LEN, "%s/tune_%s.txt",
+                        (strlen(in_path) > 0) ? in_path : ".", host);
+        if (len < 0 || len >= MAX_STR_LEN || access(tune_profile, R_OK) != 0)
+            strcpy (tune_profile, "");
+    }
+    if (strcmp(tune_profile, "") != 0)
+    {
+        threads = *num_threads;
+        ahead = *read_ahead;
+        if (read_tune_profile (tune_profile, &threads, &ahead) != SUCCESS)
+        {
+            snprintf (errmsg, sizeof(errmsg), "Reading tune-profile %s",
+                      tune_profile);
+            RETURN_ERROR(errmsg, FUNC_NAME, FAILURE);
+        }
+        /* a neighbor warm start runs on one thread, see below */
+        if (!threads_given && !neighbor_warm_flag)
+            *num_threads = threads;
+        if (!read_ahead_given)
+            *read_ahead = ahead;
+    }
+
     /******************************************************************/
     /*                                                                */
     /* Check the input values                                         */
@@ -186,6 +367,97 @@ int get_args
         RETURN_ERROR(errmsg, FUNC_NAME, FAILURE);
     }
 
+    if ((*screen_cell < 1) || (*screen_cell > MAX_SCREEN_CELL))
+    {
+        sprintf (errmsg, "screen-cell must be between 1 and %d",
+                 MAX_SCREEN_CELL);
+        RETURN_ERROR(errmsg, FUNC_NAME, FAILURE);
+    }
+
+    if ((*screen_cell > 1) && (strcmp(in_path, "stdin") == 0))
+    {
+        sprintf (errmsg, "screen-cell needs tifs or bip input, not stdin");
+        RETURN_ERROR(errmsg, FUNC_NAME, FAILURE);
+    }
+
+    if ((*block_rows < 1) || (*block_cols < 1))
+    {
+        sprintf (errmsg, "block-rows and block-cols must be > 0");
+        RETURN_ERROR(errmsg, FUNC_NAME, FAILURE);
+    }
+
+    if ((*num_threads < 1) || (*num_threads > MAX_THREADS))
+    {
+        sprintf (errmsg, "threads must be between 1 and %d", MAX_THREADS);
+        RETURN_ERROR(errmsg, FUNC_NAME, FAILURE);
+    }
+
+    if ((*read_ahead < 0) || (*read_ahead > MAX_READ_AHEAD))
+    {
+        sprintf (errmsg, "read-ahead must be between 1 and %d",
+                 MAX_READ_AHEAD);
+        RETURN_ERROR(errmsg, FUNC_NAME, FAILURE);
+    }
+
+    if (*max_buffer_mb < 0)
+    {
+        sprintf (errmsg, "max-buffer-mb must be > 0");
+        RETURN_ERROR(errmsg, FUNC_NAME, FAILURE);
+    }
+
+    if (*checkpoint < 0)
+    {
+        sprintf (errmsg, "checkpoint must be > 0");
+        RETURN_ERROR(errmsg, FUNC_NAME, FAILURE);
+    }
+
+    if (resume_flag)
+        *resume = true;
+    else
+        *resume = false;
+
+    if ((*resume) && (*checkpoint == 0))
+    {
+        sprintf (errmsg, "resume needs checkpoint");
+        RETURN_ERROR(errmsg, FUNC_NAME, FAILURE);
+    }
+
+    if ((*checkpoint > 0) && (strcmp(out_path, "stdout") == 0))
+    {
+        sprintf (errmsg, "checkpoint needs an out-path directory, not "
+                 "stdout");
+        RETURN_ERROR(errmsg, FUNC_NAME, FAILURE);
+    }
+
+    if (update_flag)
+        *update = true;
+    else
+        *update = false;
+
+    if (numa_flag)
+        *numa = true;
+    else
+        *numa = false;
+
+    if ((*update) && (strcmp(state_dir, "") == 0))
+    {
+        sprintf (errmsg, "update needs state-dir");
+        RETURN_ERROR(errmsg, FUNC_NAME, FAILURE);
+    }
+
+    if ((strcmp(state_dir, "") != 0) && (strcmp(in_path, "stdin") == 0))
+    {
+        sprintf (errmsg, "state-dir needs tifs or bip input, not stdin");
+        RETURN_ERROR(errmsg, FUNC_NAME, FAILURE);
+    }
+
+    if ((strcmp(state_dir, "") != 0) && (*resume))
+    {
+        sprintf (errmsg, "state-dir is not used with resume, which does "
+                 "not read the pixels done");
+        RETURN_ERROR(errmsg, FUNC_NAME, FAILURE);
+    }
+
     /******************************************************************/
     /*                                                                */
     /* If in_path and out_path were not specified, assign local       */
@@ -236,6 +508,56 @@ int get_args
     else
         *verbose = false;
 
+    /* --verbose is --log-level=info unless a level was given.            */
+    if (*log_level < 0)
+        *log_level = (*verbose) ? LOG_LEVEL_INFO : LOG_LEVEL_WARN;
+
+    if (lazy_fit_flag)
+        *lazy_fit = true;
+    else
+        *lazy_fit = false;
+
+    if (validate_fast_flag)
+        *validate_fast_path = true;
+    else
+        *validate_fast_path = false;
+
+    if (neighbor_warm_flag)
+        *neighbor_warm_start = true;
+    else
+        *neighbor_warm_start = false;
+
+    /* a neighbor warm start reads the curves of the pixels before it */
+    if ((*neighbor_warm_start) && (*num_threads > 1))
+    {
+        sprintf (errmsg, "neighbor-warm-start needs threads=1");
+        RETURN_ERROR(errmsg, FUNC_NAME, FAILURE);
+    }
+
+    /* the cost records only imply writing them */
+    if (record_cost_flag || cost_only_flag)
+        *record_cost = true;
+    else
+        *record_cost = false;
+
+    if (cost_only_flag)
+        *cost_only = true;
+    else
+        *cost_only = false;
+
+    if ((*record_cost) && (strcmp(out_path, "stdout") == 0))
+    {
+        sprintf (errmsg, "record-cost needs an out-path directory, not "
+                 "stdout");
+        RETURN_ERROR(errmsg, FUNC_NAME, FAILURE);
+    }
+
+    /* validating the fast path implies taking it */
+    if (fast_path_flag || validate_fast_flag)
+        *fast_path = true;
+    else
+        *fast_path = false;
+
     /******************************************************************/
     /*                                                                */
     /* We should to do this only here, not back in main. After        */
@@ -252,8 +574,31 @@ int get_args
         printf ("in-path = %s\n", in_path);
         printf ("out-path = %s\n", out_path);
         printf ("scene-list-file = %s\n", scene_list_file);
+        printf ("sweep-file = %s\n", sweep_file);
         printf ("data-type = %s\n", data_type);
         printf ("verbose = %d\n", *verbose);
+        printf ("lazy-fit = %d\n", *lazy_fit);
+        printf ("precision = %s\n", (*precision == PRECISION_SINGLE) ?
+                "single" : "double");
+        printf ("stable-fast-path = %d\n", *fast_path);
+        printf ("validate-fast-path = %d\n", *validate_fast_path);
+        printf ("screen-cell = %d\n", *screen_cell);
+        printf ("block-rows = %d\n", *block_rows);
+        printf ("block-cols = %d\n", *block_cols);
+        printf ("neighbor-warm-start = %d\n", *neighbor_warm_start);
+        printf ("log-level = %d\n", *log_level);
+        printf ("log-file = %s\n", log_file);
+        printf ("threads = %d\n", *num_threads);
+        printf ("read-ahead = %d\n", *read_ahead);
+        printf ("max-buffer-mb = %d\n", *max_buffer_mb);
+        printf ("record-cost = %d\n", *record_cost);
+        printf ("cost-only = %d\n", *cost_only);
+        printf ("checkpoint = %d\n", *checkpoint);
+        printf ("resume = %d\n", *resume);
+        printf ("state-dir = %s\n", state_dir);
+        printf ("update = %d\n", *update);
+        printf ("tune-profile = %s\n", tune_profile);
+        printf ("numa = %d\n", *numa);
     }
 
     return (SUCCESS);
@@ -417,171 +762,215 @@ int create_scene_list
 
 
 /******************************************************************************
-MODULE:  partition
-
-PURPOSE:  partition used for the quick_sort routine
-
-RETURN VALUE:
-Type = int
-Value           Description
------           -----------
-i               partitioned value   
+MODULE:  default_ccdc_params
 
-HISTORY:
-Date        Programmer       Reason
---------    ---------------  -------------------------------------
-1/23/2015   Song Guo         Original Development
+PURPOSE:  Set the change detection thresholds to their defines.h values
 
-NOTES:
+RETURN VALUE: None
 ******************************************************************************/
-int partition (int arr[], char *brr[], int crr[], int left, int right)
+void default_ccdc_params
+(
+    Ccdc_params_t *params   /* O: thresholds of a run                       */
+)
 {
-    int i = left, j = right;
-    int tmp, tmp2;
-    char temp[MAX_STR_LEN];
-    int pivot = arr[(left + right) / 2];
-
-    while (i <= j)
-    {
-        while (arr[i] < pivot)
-	{
-            i++;
-	}
-        while (arr[j] > pivot)
-	{
-            j--;
-	}
-        if (i <= j)
-        {
-            tmp = arr[i];
-            strcpy(&temp[0], brr[i]);
-            tmp2 = crr[i];
-            arr[i] = arr[j];
-            strcpy(brr[i], brr[j]);
-            crr[i] = crr[j];
-            arr[j] = tmp;
-            strcpy(brr[j],&temp[0]);
-            crr[j] = tmp2;
-            i++;
-            j--;
-        }
-    }
-
-    return i;
+    params->t_cg = T_CG;
+    params->t_max_cg = T_MAX_CG;
+    params->conse = CONSE;
+    params->lambda = LAMBDA;
+    params->n_times = N_TIMES;
+    params->min_num_c = MIN_NUM_C;
 }
 
-/******************************************************************************
-MODULE:  quick_sort
 
-PURPOSE:  sort the scene_list & sdate based on yeardoy string
+/******************************************************************************
+MODULE:  ccdc_params_valid
 
-RETURN VALUE: None
+PURPOSE:  Check the thresholds of a parameter set
 
-HISTORY:
-Date        Programmer       Reason
---------    ---------------  -------------------------------------
-1/23/2015   Song Guo         Original Development
+RETURN VALUE:
+Type = bool
+Value           Description
+-----           -----------
+true            The set can be run
+false           A value is out of range
 
-NOTES:
+NOTES: conse is at most MAX_CONSE, the buffers of a pixel are allocated
+       for it, and min_num_c must be a df the time series kernels are
+       compiled for.
 ******************************************************************************/
-void quick_sort (int arr[], char *brr[], int crr[], int left, int right)
+bool ccdc_params_valid
+(
+    const Ccdc_params_t *params /* I: thresholds of a run                   */
+)
 {
-    int index = partition (arr, brr, crr, left, right);
-
-    if (left < index - 1)
-    {
-        quick_sort (arr, brr, crr, left, index - 1);
-    }
-    if (index < right)
-    {
-        quick_sort (arr, brr, crr, index, right);
-    }
+    return (params->t_cg > 0.0 && params->t_max_cg >= params->t_cg &&
+            params->conse >= 1 && params->conse <= MAX_CONSE &&
+            params->lambda >= 0.0 && params->n_times >= 1 &&
+            params->min_num_c <= MID_NUM_C &&
+            select_ts_kernels(TOTAL_IMAGE_BANDS, params->min_num_c,
+                              PRECISION_DOUBLE) != NULL);
 }
 
 
 /******************************************************************************
-MODULE:  partition_2d_float
+MODULE:  read_sweep_file
 
-PURPOSE:  partition used for the quick_sort routine
+PURPOSE:  Read the parameter sets of a sweep, one configuration per line:
+          t_cg t_max_cg conse lambda n_times min_num_c
 
 RETURN VALUE:
 Type = int
 Value           Description
 -----           -----------
-i               partitioned value   
-
-HISTORY:
-Date        Programmer       Reason
---------    ---------------  -------------------------------------
-1/21/2016   Song Guo         Original Development
+ERROR           Error opening or reading the file, or a value out of range
+SUCCESS         No errors encountered
 
-NOTES:
+NOTES: Empty lines and lines starting with # are skipped, and every set is
+       checked by ccdc_params_valid.  The caller frees *params.
 ******************************************************************************/
-int partition_2d_float (float arr[], float *brr[], int left, int right)
+int read_sweep_file
+(
+    const char *sweep_file, /* I: file name of the parameter sets           */
+    Ccdc_params_t **params, /* O: parameter sets                            */
+    int *num_params         /* O: number of parameter sets                  */
+)
 {
-    int i = left, j = right;
-    float tmp;
-    float tmp2[TOTAL_IMAGE_BANDS];
-    float pivot = arr[(left + right) / 2];
-    int b;
+    char FUNC_NAME[] = "read_sweep_file";
+    char errmsg[MAX_STR_LEN];
+    char line[MAX_STR_LEN];
+    FILE *fd;
+    Ccdc_params_t p;
+    Ccdc_params_t *list = NULL;
+    Ccdc_params_t *grown;
+    int num = 0;
+    int line_num = 0;
+    char *c;
+
+    fd = fopen(sweep_file, "r");
+    if (fd == NULL)
+    {
+        RETURN_ERROR("Opening sweep file", FUNC_NAME, ERROR);
+    }
 
-    while (i <= j)
+    while (fgets(line, sizeof(line), fd) != NULL)
     {
-        while (arr[i] < pivot)
-	{
-            i++;
-	}
-        while (arr[j] > pivot)
-	{
-            j--;
-	}
-        if (i <= j)
+        line_num++;
+        for (c = line; *c == ' ' || *c == '\t'; c++)
+            ;
+        if (*c == '#' || *c == '\n' || *c == '\0')
+            continue;
+
+        if (sscanf(c, "%lf %lf %d %lf %d %d", &p.t_cg, &p.t_max_cg,
+                   &p.conse, &p.lambda, &p.n_times, &p.min_num_c) != 6 ||
+            !ccdc_params_valid(&p))
+        {
+            fclose(fd);
+            free(list);
+            snprintf(errmsg, sizeof(errmsg), "Invalid parameter set at line "
+                     "%d of %s", line_num, sweep_file);
+            RETURN_ERROR(errmsg, FUNC_NAME, ERROR);
+        }
+
+        grown = realloc(list, (num + 1) * sizeof(Ccdc_params_t));
+        if (grown == NULL)
         {
-            tmp = arr[i];
-	    for (b = 0; b < TOTAL_IMAGE_BANDS; b++)
-                tmp2[b] = brr[b][i];
-            arr[i] = arr[j];
-	    for (b = 0; b < TOTAL_IMAGE_BANDS; b++)
-                brr[b][i] = brr[b][j];
-            arr[j] = tmp;
-	    for (b = 0; b < TOTAL_IMAGE_BANDS; b++)
-                brr[b][j] = tmp2[b];
-            i++;
-            j--;
+            fclose(fd);
+            free(list);
+            RETURN_ERROR("Allocating parameter sets", FUNC_NAME, ERROR);
         }
+        list = grown;
+        list[num++] = p;
+    }
+    fclose(fd);
+
+    if (num == 0)
+    {
+        snprintf(errmsg, sizeof(errmsg), "No parameter set in %s",
+                 sweep_file);
+        RETURN_ERROR(errmsg, FUNC_NAME, ERROR);
     }
 
-    return i;
+    *params = list;
+    *num_params = num;
+
+    return (SUCCESS);
 }
 
-/******************************************************************************
-MODULE:  quick_sort_2d_float
 
-PURPOSE:  sort the scene_list & sdate based on yeardoy string
+/******************************************************************************
+MODULE:  read_tune_profile
 
-RETURN VALUE: None
+PURPOSE:  Read the threads and pixels in flight of a tuning profile
+          written by scripts/tuneCcdc.pl
 
-HISTORY:
-Date        Programmer       Reason
---------    ---------------  -------------------------------------
-1/21/2016   Song Guo         Original Development
+RETURN VALUE:
+Type = int
+Value           Description
+-----           -----------
+ERROR           Error opening or reading the file, or a value out of range
+SUCCESS         No errors encountered
 
-NOTES:
+NOTES: A profile is a "name value" pair per line; empty lines and lines
+       starting with # are skipped, as are the names other than threads
+       and read-ahead (the block size and the measured rate of the tuning,
+       for scripts/jobQueue.pl and the reader).
 ******************************************************************************/
-void quick_sort_2d_float (float arr[], float *brr[], int left, int right)
+int read_tune_profile
+(
+    const char *profile,    /* I: file name of the tuning profile           */
+    int *num_threads,       /* O: threads, unchanged if not in the file     */
+    int *read_ahead         /* O: pixels in flight, unchanged if not in it  */
+)
 {
-    int index = partition_2d_float (arr, brr, left, right);
-
-    if (left < index - 1)
+    char FUNC_NAME[] = "read_tune_profile";
+    char errmsg[3 * MAX_STR_LEN];
+    char line[MAX_STR_LEN];
+    char name[MAX_STR_LEN];
+    FILE *fd;
+    int value;
+    int line_num = 0;
+    char *c;
+
+    fd = fopen(profile, "r");
+    if (fd == NULL)
     {
-        quick_sort_2d_float (arr, brr, left, index - 1);
+        RETURN_ERROR("Opening tuning profile", FUNC_NAME, ERROR);
     }
-    if (index < right)
+
+    while (fgets(line, sizeof(line), fd) != NULL)
     {
-        quick_sort_2d_float (arr, brr, index, right);
+        line_num++;
+        for (c = line; *c == ' ' || *c == '\t'; c++)
+            ;
+        if (*c == '#' || *c == '\n' || *c == '\0')
+            continue;
+
+        if (sscanf(c, "%s", name) != 1)
+            continue;
+        if (strcmp(name, "threads") != 0 && strcmp(name, "read-ahead") != 0)
+            continue;
+        if (sscanf(c, "%*s %d", &value) != 1 ||
+            (strcmp(name, "threads") == 0 &&
+             (value < 1 || value > MAX_THREADS)) ||
+            (strcmp(name, "read-ahead") == 0 &&
+             (value < 0 || value > MAX_READ_AHEAD)))
+        {
+            fclose(fd);
+            snprintf(errmsg, sizeof(errmsg), "Invalid %s at line %d of %s",
+                     name, line_num, profile);
+            RETURN_ERROR(errmsg, FUNC_NAME, ERROR);
+        }
+        if (strcmp(name, "threads") == 0)
+            *num_threads = value;
+        else
+            *read_ahead = value;
     }
+    fclose(fd);
+
+    return (SUCCESS);
 }
 
+
 /************************************************************************
 FUNCTION: is_leap_year
 
@@ -690,7 +1079,9 @@ Date        Programmer       Reason
 1/23/2015   Song Guo         Original Development
 2/1/2016    Song Guo         Added row number 
 
-NOTES:
+NOTES: The scenes are ordered by a stable sort of their positions on the
+       row, then on yeardoy, so scenes of the same date come smaller row
+       first.
 ******************************************************************************/
 int sort_scene_based_on_year_doy_row
 (
@@ -704,6 +1095,10 @@ int sort_scene_based_on_year_doy_row
     int year, doy;          /* to keep track of year, and day within year    */
     int *yeardoy;           /* combined year day of year as one string       */
     int *row;               /* row of path/row for ordering from same swath  */
+    int *order;             /* scene positions in sorted order               */
+    int *key;               /* sort key of each position of order            */
+    char **sorted_list;     /* scene names in sorted order                   */
+    int *sorted_sdate;      /* dates in sorted order                         */
     char temp_string[8];    /* for string manipulation                       */
     char temp_string2[5];   /* for string manipulation                       */
     char temp_string3[4];   /* for string manipulation                       */
@@ -711,7 +1106,6 @@ int sort_scene_based_on_year_doy_row
     char errmsg[MAX_STR_LEN]; /* for printing error messages                 */
     char FUNC_NAME[] = "sort_scene_based_on_year_doy_row"; /* function name  */
     int len; /* length of string returned from strlen for string manipulation*/
-    char temp[MAX_STR_LEN]; /* for string manipuulation                      */
 
     /******************************************************************/
     /*                                                                */
@@ -730,6 +1124,16 @@ int sort_scene_based_on_year_doy_row
     {
         RETURN_ERROR("Allocating row memory", FUNC_NAME, ERROR);
     }
+
+    order = malloc(num_scenes * sizeof(int));
+    key = malloc(num_scenes * sizeof(int));
+    sorted_list = malloc(num_scenes * sizeof(char *));
+    sorted_sdate = malloc(num_scenes * sizeof(int));
+    if (order == NULL || key == NULL || sorted_list == NULL ||
+        sorted_sdate == NULL)
+    {
+        RETURN_ERROR("Allocating sort order memory", FUNC_NAME, ERROR);
+    }
  
     /******************************************************************/
     /*                                                                */
@@ -758,31 +1162,41 @@ int sort_scene_based_on_year_doy_row
 
     /******************************************************************/
     /*                                                                */
-    /* Sort the scene_list & sdate based on yeardoy                   */
+    /* Sort the scene_list & sdate based on yeardoy.  If two          */
+    /* identical date data exist (this is only the case for ARD       */
+    /* data), then put the smaller row number data in the front: the  */
+    /* positions are sorted on row first, and the yeardoy sort keeps  */
+    /* that order for equal dates.                                    */
     /*                                                                */
     /******************************************************************/
 
-    quick_sort(yeardoy, scene_list, sdate, 0, num_scenes - 1);
+    for (i = 0; i < num_scenes; i++)
+    {
+        order[i] = i;
+        key[i] = row[i];
+    }
+    sort_int_index(key, order, num_scenes);
+    for (i = 0; i < num_scenes; i++)
+        key[i] = yeardoy[order[i]];
+    sort_int_index(key, order, num_scenes);
 
     /******************************************************************/
     /*                                                                */
-    /* If two identical date data exist (this is only the case        */
-    /* for ARD data, then put the smaller row number data in          */
-    /* the front.                                                     */
+    /* Move the names and dates to their sorted positions.  The rows  */
+    /* of scene_list are swapped as pointers, the storage of the 2-D  */
+    /* array does not move.                                           */
     /*                                                                */
     /******************************************************************/
 
-    for (i = 0; i < num_scenes - 1; i++)
+    for (i = 0; i < num_scenes; i++)
     {
-        if (sdate[i+1] == sdate[i])
-	{
-            if (row[i] > row[i+1])
-	    {
-                strcpy(temp, scene_list[i]);
-                strcpy(scene_list[i], scene_list[i+1]);
-                strcpy(scene_list[i+1], temp);
-	    }
-	}
+        sorted_list[i] = scene_list[order[i]];
+        sorted_sdate[i] = sdate[order[i]];
+    }
+    for (i = 0; i < num_scenes; i++)
+    {
+        scene_list[i] = sorted_list[i];
+        sdate[i] = sorted_sdate[i];
     }
 
     /******************************************************************/
@@ -793,6 +1207,10 @@ int sort_scene_based_on_year_doy_row
 
     free(yeardoy);
     free(row);
+    free(order);
+    free(key);
+    free(sorted_list);
+    free(sorted_sdate);
 
     return (SUCCESS);
 
@@ -847,103 +1265,29 @@ void update_cft
 }
 
 /******************************************************************************
-MODULE:  partition_float
+MODULE:  median_variogram
 
-PURPOSE:  partition the sorted list
+PURPOSE:  simulate matlab medium function for 2d array case
 
-RETURN VALUE:
-Type = int
-Value           Description
------           -----------
-i               partitioned value   
+RETURN VALUE: int
+ERROR in allocating memory
+SUCCESS non-error encounted
 
 HISTORY:
 Date        Programmer       Reason
 --------    ---------------  -------------------------------------
-1/23/2015   Song Guo         Original Development
+5/19/2015   Song Guo         Original Development
 
-NOTES:
+NOTES: CPU_DISPATCH kernel.
 ******************************************************************************/
-int partition_float (float arr[], int left, int right)
-{
-    int i = left, j = right;
-    float tmp;
-    float pivot = arr[(left + right) / 2];
-
-    while (i <= j)
-    {
-        while (arr[i] < pivot)
-	{
-            i++;
-	}
-        while (arr[j] > pivot)
-	{
-            j--;
-	}
-        if (i <= j)
-        {
-            tmp = arr[i];
-            arr[i] = arr[j];
-            arr[j] = tmp;
-            i++;
-            j--;
-        }
-    }
-
-    return i;
-}
-
-/******************************************************************************
-MODULE:  quick_sort_float
-
-PURPOSE:  sort the scene_list based on yeardoy string
-
-RETURN VALUE: None
-
-HISTORY:
-Date        Programmer       Reason
---------    ---------------  -------------------------------------
-1/23/2015   Song Guo         Original Development
-
-NOTES:
-******************************************************************************/
-void quick_sort_float(float arr[], int left, int right)
-{
-    int index = partition_float (arr, left, right);
-
-    if (left < index - 1)
-    {
-        quick_sort_float (arr, left, index - 1);
-    }
-    if (index < right)
-    {
-        quick_sort_float (arr, index, right);
-    }
-}
-
-/******************************************************************************
-MODULE:  median_variogram
-
-PURPOSE:  simulate matlab medium function for 2d array case
-
-RETURN VALUE: int
-ERROR in allocating memory
-SUCCESS non-error encounted
-
-HISTORY:
-Date        Programmer       Reason
---------    ---------------  -------------------------------------
-5/19/2015   Song Guo         Original Development
-
-******************************************************************************/
-int median_variogram
-(
-    float **array,      /* I: input array                                    */
-    int dim1_len,       /* I: dimension 1 length in input array              */
-    int dim2_start,     /* I: dimension 2 start index                        */
-    int dim2_end,       /* I: dimension 2 end index                          */
-    float *output_array /* O: output array                                   */
-)
+CPU_DISPATCH int median_variogram
+(
+    float **array,      /* I: input array                                    */
+    int dim1_len,       /* I: dimension 1 length in input array              */
+    int dim2_start,     /* I: dimension 2 start index                        */
+    int dim2_end,       /* I: dimension 2 end index                          */
+    float *output_array /* O: output array                                   */
+)
 {
     int i, j;           /* loop indecies                                     */
     float *var;         /* pointer for allocation variable memory            */
@@ -970,9 +1314,9 @@ int median_variogram
     {
         for (j = dim2_start; j < dim2_end; j++)
         {
-            var[j] = abs(array[i][j+1] - array[i][j]);
+            var[j] = abs((int)(array[i][j+1] - array[i][j]));
         }
-        quick_sort_float(var, dim2_start, dim2_end-1);
+        sort_float(&var[dim2_start], dim2_end - dim2_start);
         if ((dim2_len-1) % 2 == 0)
 	{
             output_array[i] = (var[m-1] + var[m]) / 2.0;
@@ -1090,81 +1434,6 @@ void rmse_from_square_root_mean
     *rmse = sqrt(sum / dim2_len); 
 }
 
-/******************************************************************************
-MODULE:  partition_int
-
-PURPOSE:  partition used for the quick_sort_int routine
-
-RETURN VALUE:
-Type = int
-Value           Description
------           -----------
-i               partitioned value   
-
-HISTORY:
-Date        Programmer       Reason
---------    ---------------  -------------------------------------
-1/23/2015   Song Guo         Original Development
-
-NOTES:
-******************************************************************************/
-int partition_int (int arr[], int left, int right)
-{
-    int i = left, j = right;
-    int tmp;
-    int pivot = arr[(left + right) / 2];
-
-    while (i <= j)
-    {
-        while (arr[i] < pivot)
-	{
-            i++;
-	}
-        while (arr[j] > pivot)
-	{
-            j--;
-	}
-        if (i <= j)
-        {
-            tmp = arr[i];
-            arr[i] = arr[j];
-            arr[j] = tmp;
-            i++;
-            j--;
-        }
-    }
-
-    return i;
-}
-
-/******************************************************************************
-MODULE:  quick_sort_int
-
-PURPOSE:  sort the scene_list based on integer yeardoy 
-
-RETURN VALUE: None
-
-HISTORY:
-Date        Programmer       Reason
---------    ---------------  -------------------------------------
-1/23/2015   Song Guo         Original Development
-
-NOTES:
-******************************************************************************/
-void quick_sort_int (int arr[], int left, int right)
-{
-    int index = partition_int (arr, left, right);
-
-    if (left < index - 1)
-    {
-        quick_sort_int (arr, left, index - 1);
-    }
-    if (index < right)
-    {
-        quick_sort_int (arr, index, right);
-    }
-}
-
 /******************************************************************************
 MODULE:  partial_square_root_mean
 
@@ -1244,6 +1513,42 @@ void matlab_2d_array_norm
 }
 
 
+/******************************************************************************
+MODULE:  matlab_2d_array_norm_ids
+
+PURPOSE:  simulate matlab norm function over selected elements of 1 dimension
+          in 2d array cases only
+
+RETURN VALUE:
+Type = void
+Value           Description
+-----           -----------
+
+
+NOTES: Same as matlab_2d_array_norm applied to array[dim1_index][ids[i]],
+       i = 0 .. num_ids - 1, without gathering them first.
+******************************************************************************/
+
+void matlab_2d_array_norm_ids
+(
+    float **array,       /* I: input array                                   */
+    int dim1_index,      /* I: 1st dimension index                           */
+    const int *ids,      /* I: 2nd dimension indices of the elements         */
+    int num_ids,         /* I: number of elements                            */
+    float  *output_norm  /* O: output norm value                             */
+)
+{
+    int i;
+    float sum = 0.0;
+
+    for (i = 0; i < num_ids; i++)
+    {
+        sum += array[dim1_index][ids[i]] * array[dim1_index][ids[i]];
+    }
+    *output_norm = sqrt(sum);
+}
+
+
 /******************************************************************************
 MODULE:  matlab_2d_float_median
 
@@ -1510,7 +1815,7 @@ void matlab_unique
         clrx[k_new] = clrx[k];
         for (b = 0; b < TOTAL_IMAGE_BANDS; b++)
             clry[b][k_new] = clry[b][k];
-            k_new++;
+        k_new++;
     }
     *new_nums = k_new;
 }
@@ -1558,7 +1863,7 @@ NOTES:
 void auto_robust_fit
 (
     float **clrx,
-    float **clry,
+    const Obs_store_t *obs,
     int nums,
     int start,
     int band_index,
@@ -1601,7 +1906,7 @@ void auto_robust_fit
                 gsl_matrix_set (x, i, j, clrx[i][j-1]);
 	    }
         }
-        gsl_vector_set(y,i,clry[band_index][i+start]);
+        gsl_vector_set(y,i,OBS_Y(obs, band_index, i+start));
     }
 
     /******************************************************************/
@@ -1612,7 +1917,7 @@ void auto_robust_fit
 
     dofit(gsl_multifit_robust_bisquare, x, y, c, cov);
 
-    for (j = 0; j < c->size; j++)
+    for (j = 0; j < (int)c->size; j++)
     {
         coefs[j] = gsl_vector_get(c, j);
     }
@@ -1651,8 +1956,8 @@ NOTES:
 ******************************************************************************/
 int auto_mask
 (
-    int *clrx,
-    float **clry,
+    const Obs_store_t *obs,
+    const Harmonic_basis_t *basis,
     int start,
     int end,
     float years,
@@ -1666,11 +1971,15 @@ int auto_mask
     int year;
     float w, w2;
     int i;
+    int row;
     float **x;
     float pred_b2, pred_b5;
     int nums;
     float coefs[ROBUST_COEFFS];
     float coefs2[ROBUST_COEFFS];
+    double *cos_w2, *sin_w2;
+    int t;
+    bool in_table;
 
     nums = end - start + 1;
     /* Allocate memory */
@@ -1679,17 +1988,43 @@ int auto_mask
     {
         RETURN_ERROR("ERROR allocating x memory", FUNC_NAME, ERROR);
     }
+    cos_w2 = malloc(2 * nums * sizeof(double));
+    if (cos_w2 == NULL)
+    {
+        RETURN_ERROR("ERROR allocating cos_w2 memory", FUNC_NAME, ERROR);
+    }
+    sin_w2 = cos_w2 + nums;
 
     year = ceil(years);
     w = TWO_PI / AVE_DAYS_IN_A_YEAR;
     w2 = w / (float)year;
+    in_table = (year >= 1) && (year <= basis->max_years);
+
+    /******************************************************************/
+    /*                                                                */
+    /* Gather the annual and w2 terms from the harmonic basis table.  */
+    /* Only a year count beyond the scene set span falls back to libm.*/
+    /*                                                                */
+    /******************************************************************/
 
     for (i = 0; i < nums; i++)
     {
-        x[i][0] = cos(w * (float)clrx[i+start]);
-        x[i][1] = sin(w * (float)clrx[i+start]);
-        x[i][2] = cos(w2 * (float)clrx[i+start]);
-        x[i][3] = sin(w2 * (float)clrx[i+start]);
+        t = OBS_T(obs, i+start);
+        row = HARMONIC_ROW(basis, t);
+        if (in_table)
+        {
+            cos_w2[i] = basis->tmask_terms[year][2 * row];
+            sin_w2[i] = basis->tmask_terms[year][2 * row + 1];
+        }
+        else
+        {
+            cos_w2[i] = cos(w2 * (float)t);
+            sin_w2[i] = sin(w2 * (float)t);
+        }
+        x[i][0] = basis->fit_terms[row][0];
+        x[i][1] = basis->fit_terms[row][1];
+        x[i][2] = cos_w2[i];
+        x[i][3] = sin_w2[i];
     }
 
     /******************************************************************/
@@ -1698,7 +2033,7 @@ int auto_mask
     /*                                                                */
     /******************************************************************/
 
-    auto_robust_fit(x, clry, nums, start, 1, coefs);
+    auto_robust_fit(x, obs, nums, start, 1, coefs);
 
     /******************************************************************/
     /*                                                                */
@@ -1706,7 +2041,7 @@ int auto_mask
     /*                                                                */
     /******************************************************************/
 
-    auto_robust_fit(x, clry, nums, start, 4, coefs2);
+    auto_robust_fit(x, obs, nums, start, 4, coefs2);
 
     /******************************************************************/
     /*                                                                */
@@ -1717,16 +2052,15 @@ int auto_mask
 
     for (i = 0; i < nums; i++)
     {
-        pred_b2 = coefs[0] + coefs[1] * cos((float)clrx[i+start] * w ) + 
-                  coefs[2] * sin((float)clrx[i+start] * w ) + coefs[3] * 
-                  cos((float)clrx[i+start] * w2 ) 
-                  + coefs[4] * sin((float)clrx[i+start] * w2);
-        pred_b5 = coefs2[0] + coefs2[1] * cos((float)clrx[i+start] * w ) + 
-                  coefs2[2] * sin((float)clrx[i+start] * w ) + coefs2[3] * 
-                  cos((float)clrx[i+start] * w2 ) 
-                  + coefs2[4] * sin((float)clrx[i+start] * w2);
-        if (((clry[1][i+start]-pred_b2) > (n_t * t_b1)) || 
-            ((clry[4][i+start]-pred_b5) < -(n_t * t_b2)))
+        row = HARMONIC_ROW(basis, OBS_T(obs, i+start));
+        pred_b2 = coefs[0] + coefs[1] * basis->pred_terms[row][0] + 
+                  coefs[2] * basis->pred_terms[row][1] + coefs[3] * 
+                  cos_w2[i] + coefs[4] * sin_w2[i];
+        pred_b5 = coefs2[0] + coefs2[1] * basis->pred_terms[row][0] + 
+                  coefs2[2] * basis->pred_terms[row][1] + coefs2[3] * 
+                  cos_w2[i] + coefs2[4] * sin_w2[i];
+        if (((OBS_Y(obs, 1, i+start)-pred_b2) > (n_t * t_b1)) || 
+            ((OBS_Y(obs, 4, i+start)-pred_b5) < -(n_t * t_b2)))
 	{
             bl_ids[i] = 1;
 	}
@@ -1737,6 +2071,7 @@ int auto_mask
     }
 
     /* Free allocated memory */
+    free(cos_w2);
     if (free_2d_array ((void **) x) != SUCCESS)
     {
         RETURN_ERROR ("Freeing memory: x\n", FUNC_NAME, ERROR);
@@ -1758,11 +2093,12 @@ Date        Programmer       Reason
 3/5/2015    Song Guo         Original Development
 20160104    Song Guo         Numerous bug fixes.
 
-NOTES:
+NOTES: The kernel of df is selected once for all the observations.
 ******************************************************************************/
 int auto_ts_predict
 (
     int *clrx,
+    const Harmonic_basis_t *basis,
     float **coefs,
     int df,
     int band_index,
@@ -1774,49 +2110,219 @@ int auto_ts_predict
     char FUNC_NAME[] = "auto_ts_predict";
     int i;
     int nums = end - start + 1;
-    float w, w2, w3;
-    w = TWO_PI / AVE_DAYS_IN_A_YEAR;
-    w2 = 2.0 * w;
-    w3 = 3.0 * w;
+    const Ts_kernels_t *kern = select_ts_kernels(1, df, basis->precision);
+
+    if (kern == NULL)
+    { 
+        RETURN_ERROR("Unsupported df number", FUNC_NAME, ERROR);
+    }
 
     for (i = 0; i < nums; i++)
     { 
-      if (df ==2)
-      {
-        pred_y[i]  = coefs[band_index][0] + coefs[band_index][1] * 
-              (float)clrx[i+start];
-      }
-      else if (df == 4)
-      {
-        pred_y[i]  = coefs[band_index][0] + coefs[band_index][1] * 
-              (float)clrx[i+start] + coefs[band_index][2] * 
-              cos((float)clrx[i+start] * w ) + coefs[band_index][3] * 
-              sin((float)clrx[i+start] * w );
-      }
-      else if (df == 6)
-      {
-        pred_y[i]  = coefs[band_index][0] + coefs[band_index][1] * 
-              (float)clrx[i+start] + coefs[band_index][2] * 
-              cos((float)clrx[i+start] * w ) + coefs[band_index][3] * 
-              sin((float)clrx[i+start] * w ) + coefs[band_index][4] * 
-              cos((float)clrx[i+start] * w2 ) + coefs[band_index][5] * 
-              sin((float)clrx[i+start] * w2 );
-      }
-      else if (df == 8)
-      {
-        pred_y[i]  = coefs[band_index][0] + coefs[band_index][1] * 
-              (float)clrx[i+start] + coefs[band_index][2] * 
-              cos((float)clrx[i+start] * w ) + coefs[band_index][3] * 
-              sin((float)clrx[i+start] * w ) + coefs[band_index][4] * 
-              cos((float)clrx[i+start] * w2 ) + coefs[band_index][5] * 
-              sin((float)clrx[i+start] * w2) + coefs[band_index][6] * 
-              cos((float)clrx[i+start] * w3 ) +coefs[band_index][7] * 
-              sin((float)clrx[i+start] * w3 );
-      }
-      else
-      { 
+        pred_y[i] = kern->predict(coefs[band_index], basis, clrx[i+start]);
+    }
+
+    return (SUCCESS);
+}
+
+
+/******************************************************************************
+MODULE:  auto_ts_predict_conse
+
+PURPOSE:  Fused prediction and change magnitude kernel for the CONSE window.
+          Evaluates the time series model of all bands for nums observations,
+          stores the residuals and the squared z-score norm over the change
+          detection bands into CONSE window slots (slot, slot+1, ... modulo
+          CONSE)
+
+RETURN VALUE:
+Type = int
+ERROR unsupported df number
+SUCCESS no error encounted
+
+NOTES: kern is the TOTAL_IMAGE_BANDS instance of the df of the fit, selected
+       by the caller when the df changes.  The window is a ring buffer: callers advance its head instead of
+       shifting the arrays, and use rotate_conse_window before any code that
+       depends on the slot order.  Sums are accumulated in the same order and
+       precision as auto_ts_predict followed by the per band z-score loop,
+       so results are unchanged.  blist must be in ascending band order.
+******************************************************************************/
+int auto_ts_predict_conse
+(
+    const Obs_store_t *obs,        /* I: clear observations                  */
+    const Harmonic_basis_t *basis, /* I: harmonic terms of every date        */
+    float **coefs,                 /* I: fitted coefficients of all bands    */
+    const Ts_kernels_t *kern,      /* I: kernels of the df of the fit        */
+    int start,                     /* I: first observation to evaluate       */
+    int nums,                      /* I: number of observations to evaluate  */
+    const int *blist,              /* I: change detection band indices       */
+    int num_blist,                 /* I: number of change detection bands    */
+    const float *blist_rmse,       /* I: z-score rmse of each detection band */
+    int slot,                      /* I: window slot of the first observation*/
+    int conse,                     /* I: number of window slots (CONSE)      */
+    float *vec_mag,                /* O: squared z-score norm per slot       */
+    float **v_dif_mag              /* O: residual per band per slot          */
+)
+{
+    char FUNC_NAME[] = "auto_ts_predict_conse";
+
+    if (kern == NULL || kern->num_bands != TOTAL_IMAGE_BANDS)
+    {
         RETURN_ERROR("Unsupported df number", FUNC_NAME, ERROR);
-      }
+    }
+
+    kern->predict_conse(obs, basis, coefs, start, nums, blist, num_blist,
+                        blist_rmse, slot, conse, vec_mag, v_dif_mag);
+
+    return (SUCCESS);
+}
+
+
+/******************************************************************************
+MODULE:  rotate_conse_window
+
+PURPOSE:  Rotate the CONSE window ring buffer so that its oldest observation
+          is back in slot 0
+
+RETURN VALUE: None
+
+NOTES:
+******************************************************************************/
+void rotate_conse_window
+(
+    float *vec_mag,       /* I/O: squared z-score norm per slot          */
+    float **v_dif_mag,    /* I/O: residual per band per slot             */
+    int conse,            /* I: number of window slots                   */
+    int *head             /* I/O: slot of the oldest observation, 0 out  */
+)
+{
+    float tmp[MAX_CONSE];
+    int i_b, m;
+
+    if (*head == 0)
+        return;
+
+    for (m = 0; m < conse; m++)
+        tmp[m] = vec_mag[(*head + m) % conse];
+    for (m = 0; m < conse; m++)
+        vec_mag[m] = tmp[m];
+
+    for (i_b = 0; i_b < TOTAL_IMAGE_BANDS; i_b++)
+    {
+        for (m = 0; m < conse; m++)
+            tmp[m] = v_dif_mag[i_b][(*head + m) % conse];
+        for (m = 0; m < conse; m++)
+            v_dif_mag[i_b][m] = tmp[m];
+    }
+
+    *head = 0;
+}
+
+
+/******************************************************************************
+MODULE:  record_lazy_slot
+
+PURPOSE:  Remember the fit, date and observed values of the lazy bands for a
+          CONSE window slot
+
+RETURN VALUE: None
+
+NOTES:
+******************************************************************************/
+void record_lazy_slot
+(
+    Lazy_window_t *lazy,       /* I/O: lazy band window                      */
+    int slot,                  /* I: window slot                             */
+    const Obs_store_t *obs,    /* I: clear observations                      */
+    int index,                 /* I: observation index of the slot           */
+    const int *lazy_blist,     /* I: lazy band indices                       */
+    const Fit_range_t *fit     /* I: fit current when the slot is filled     */
+)
+{
+    int k;
+
+    lazy->fit[slot] = *fit;
+    lazy->t[slot] = OBS_T(obs, index);
+    for (k = 0; k < NUM_LAZY_BANDS; k++)
+        lazy->y[k][slot] = OBS_Y(obs, lazy_blist[k], index);
+}
+
+
+/******************************************************************************
+MODULE:  fit_lazy_bands
+
+PURPOSE:  Fit the bands that are not used for change detection when a curve
+          is recorded.  Rebuilds their CONSE window residuals with the fit
+          that was current when each slot was filled, then leaves their
+          coefficients and rmse of the current fit in fit_cft and rmse
+
+RETURN VALUE:
+Type = int
+ERROR error in fitting
+SUCCESS no error encounted
+
+NOTES: Each distinct fit is run once, so the lazy bands cost at most
+       CONSE + 1 fits per recorded curve instead of one per refit.  The
+       fits use the same observations and df as the eager path did, so the
+       recorded coefficients, rmse and magnitudes are unchanged.
+******************************************************************************/
+int fit_lazy_bands
+(
+    const Obs_store_t *obs,        /* I: clear observations                  */
+    const Harmonic_basis_t *basis, /* I: harmonic terms of every date        */
+    const int *lazy_blist,         /* I: lazy band indices                   */
+    const Lazy_window_t *lazy,     /* I: lazy band window                    */
+    int head,                      /* I: slot of the oldest observation      */
+    const Fit_range_t *cur_fit,    /* I: fit of the curve being recorded     */
+    const Ccdc_params_t *params,   /* I: CONSE and lambda of the run         */
+    float **fit_cft,               /* O: coefficients of the lazy bands      */
+    float *rmse,                   /* O: rmse of the lazy bands              */
+    float **v_dif_mag,             /* O: window residuals of the lazy bands  */
+    float **v_dif                  /* O: scratch fit residuals               */
+)
+{
+    char FUNC_NAME[] = "fit_lazy_bands";
+    const Fit_range_t *fitted = NULL; /* fit now held in fit_cft          */
+    const Fit_range_t *fit;
+    const Ts_kernels_t *kern = NULL;
+    int conse = params->conse;
+    int k, m, s;
+    int status;
+
+    for (m = 0; m <= conse; m++)
+    {
+        /**************************************************************/
+        /*                                                            */
+        /* Slots in time order, then the current fit for the record.  */
+        /*                                                            */
+        /**************************************************************/
+
+        s = (head + m) % conse;
+        fit = (m < conse) ? &lazy->fit[s] : cur_fit;
+
+        if (fitted == NULL || fit->start != fitted->start ||
+            fit->end != fitted->end || fit->df != fitted->df)
+        {
+            status = auto_ts_fit_bands(obs, basis, lazy_blist, NUM_LAZY_BANDS,
+                             fit->start, fit->end, fit->df, params->lambda,
+                             fit_cft, rmse, v_dif);
+            if (status != SUCCESS)
+            {
+                RETURN_ERROR ("Calling auto_ts_fit for lazy bands",
+                              FUNC_NAME, ERROR);
+            }
+            kern = select_ts_kernels(1, fit->df, basis->precision);
+            fitted = fit;
+        }
+
+        if (m == conse)
+            break;
+
+        for (k = 0; k < NUM_LAZY_BANDS; k++)
+        {
+            v_dif_mag[lazy_blist[k]][s] = lazy->y[k][s] -
+                kern->predict(fit_cft[lazy_blist[k]], basis, lazy->t[s]);
+        }
     }
 
     return (SUCCESS);
@@ -1840,7 +2346,8 @@ Date        Programmer       Original development
 12/16/2015   Song Guo         Fixed bug to return the 
                               correct order of coefficients
 
-NOTES:
+NOTES: With init, the coordinate descent starts from those coefficients
+       instead of 0; it converges to the same solution within thr.
 ******************************************************************************/
 
 int c_glmnet
@@ -1852,9 +2359,11 @@ int c_glmnet
     int nlam,		// number of lambda values
     double *ulam,	// value of lambda values, of dimentions (nlam)
     double parm,	// the alpha variable
+    const double *init,	// starting coefficients (ni), NULL for a cold start
 
     int *lmu,		// lmu = actual number of lamda values (solutions)
-    double cfs[nlam][ni+1]	// results = cfs[lmu][ni + 1]
+    double cfs[nlam][ni+1],	// results = cfs[lmu][ni + 1]
+    int *nlp		// number of coordinate descent passes
 )
 {
     double w[no];	// weight(no), default to a sequence of 1's
@@ -1872,6 +2381,8 @@ int c_glmnet
     int isd = 1;		// derivide from standardize in R, default is True = 1
     int intr = 1;		// derived from intercept in R, default is True = 1
     int maxit = 10000;		// default is 10000
+    double winit[ni];	// starting coefficients, original scale
+    int iwarm = (init != NULL);
 
     double a0[nlam];	//   a0(lmu) = intercept values for each solution
     double ca[nlam][nx];// ca(nx,lmu) = compressed coefficient values for each solution
@@ -1879,7 +2390,6 @@ int c_glmnet
     int nin[nlam];	//   nin(lmu) = number of compressed coefficients for each solution
     double rsq[nlam];	//   rsq(lmu) = R**2 values for each solution
     double alm[nlam];	//   alm(lmu) = lamda values corresponding to each solution
-    int nlp;		// actual number of passes over the data for all lamda values
     double b[nlam][ni]; // b(ni,lmu) = uncompressed coefficient values for each solution
     int jerr;		// error flag
 
@@ -1895,11 +2405,12 @@ int c_glmnet
 	vp[i] = 1;
 	cl[i][0] = -INFINITY;
 	cl[i][1] = INFINITY;
+	winit[i] = iwarm ? init[i] : 0.0;
     }
 
     elnet_(&ka, &parm, &no, &ni, x, y, w, jd, vp, cl, &ne, &nx,
-           &nlam, &flmin, ulam, &thr, &isd, &intr, &maxit,
-           lmu, a0, &ca[0][0], ia, nin, rsq, alm, &nlp, &jerr);
+           &nlam, &flmin, ulam, &thr, &isd, &intr, &maxit, winit, &iwarm,
+           lmu, a0, &ca[0][0], ia, nin, rsq, alm, nlp, &jerr);
 
     solns_(&ni, &nx, lmu, &ca[0][0], ia, nin, &b[0][0]);
 
@@ -1916,6 +2427,109 @@ int c_glmnet
 }
 
 
+/******************************************************************************
+MODULE:  c_glmnet_bands
+
+PURPOSE:  c_glmnet for several responses on the same predictors
+
+RETURN VALUE:
+Type = int
+0               No error
+other           glmnet error flag of the first response that failed
+
+NOTES: Every band of a fit has the same dates, so the same predictors.
+       elnetb checks and standardizes x once, and computes the inner
+       products of its columns once for all the bands, where each
+       c_glmnet call redoes both; each response then runs its own
+       coordinate descent.  The arithmetic of each response is that of
+       c_glmnet, so the coefficients are the same.  x and y are
+       standardized in place.
+******************************************************************************/
+int c_glmnet_bands
+(
+    int no,		// number of observations (no)
+    int ni,		// number of predictor variables (ni)
+    double *x,		// input matrix, x[ni][no], shared by the responses
+    int nb,		// number of responses (bands)
+    double *y,		// responses, y[nb][no]
+    int nlam,		// number of lambda values
+    double *ulam,	// value of lambda values, of dimentions (nlam)
+    double parm,	// the alpha variable
+    double init[nb][ni],   // starting coefficients of each response
+    const bool *warm,	// warm[b]: start response b from init[b]
+
+    int *lmu,		// lmu[nb] = actual number of lamda values
+    double cfs[nb][nlam][ni+1],	// results of each response
+    int *nlp		// nlp[nb] = coordinate descent passes
+)
+{
+    double w[no];	// weight(no), default to a sequence of 1's
+    double vp[ni];	// penalty factor (ni), default to a sequence of 1's
+    double cl[ni][2];	// lower and upper limits (ni, 2), default (-inf, +inf)
+    int iwarm[nb];	// 0/1 cold/warm start of each response
+
+    int ne = ni + 1;			// dfmax = ni + 1
+    int nx = min(ne * 2 + 20, ni);	// pmax = min(dfmax * 2 + 20, ni)
+
+    double flmin = 1.0;	// supplied lambda values
+    double thr = 1.0e-07;	// thresh in R, default 1.0e-07
+    int isd = 1;		// standardize in R, default is True = 1
+    int intr = 1;		// intercept in R, default is True = 1
+    int maxit = 10000;		// default is 10000
+
+    double a0[nb][nlam];	// intercept of each solution
+    double ca[nb][nlam][nx];	// compressed coefficients of each solution
+    int ia[nb][nx];		// pointers to compressed coefficients
+    int nin[nb][nlam];		// number of compressed coefficients
+    double rsq[nb][nlam];	// R**2 of each solution
+    double alm[nb][nlam];	// lamda of each solution
+    double b[nlam][ni];		// uncompressed coefficients of a response
+    int jerr;			// error flag
+
+    int i, j, k;
+
+    for (i = 0; i < no; i++) 
+    {
+	w[i] = 1;
+    }
+
+    for (i = 0; i < ni; i++) 
+    {
+	vp[i] = 1;
+	cl[i][0] = -INFINITY;
+	cl[i][1] = INFINITY;
+    }
+
+    for (k = 0; k < nb; k++)
+    {
+        iwarm[k] = (warm != NULL && warm[k]);
+    }
+
+    elnetb_(&parm, &no, &ni, x, &nb, y, w, vp, cl, &ne, &nx, &nlam,
+            &flmin, ulam, &thr, &isd, &intr, &maxit, &init[0][0], iwarm,
+            lmu, &a0[0][0], &ca[0][0][0], &ia[0][0], &nin[0][0],
+            &rsq[0][0], &alm[0][0], nlp, &jerr);
+    if (jerr != 0)
+        return jerr;
+
+    for (k = 0; k < nb; k++)
+    {
+        solns_(&ni, &nx, &lmu[k], &ca[k][0][0], ia[k], nin[k], &b[0][0]);
+
+        for (i = 0; i < lmu[k]; i++)
+        {
+            cfs[k][i][0] = a0[k][i];
+            for (j = 0; j < ni; j++)
+            {
+                cfs[k][i][j + 1] = b[i][j];
+            }
+        }
+    }
+
+    return 0;
+}
+
+
 /******************************************************************************
 MODULE:  auto_ts_fit
 
@@ -1939,52 +2553,121 @@ Date        Programmer       Reason
                              sprintf when malloc of y fails.
                              Incorporated fix to initialize coefs to 0.0.
 
-NOTES:
+NOTES: Fits a single band through auto_ts_fit_bands.
 ******************************************************************************/
 int auto_ts_fit
 (
-    int *clrx,
-    float **clry,
+    const Obs_store_t *obs,
+    const Harmonic_basis_t *basis,
     int band_index,
     int start,
     int end,
     int df,
+    double lambda,
     float **coefs,
     float *rmse,
     float **v_dif
 )
 {
     char FUNC_NAME[] = "auto_ts_fit";
+    float band_rmse[TOTAL_IMAGE_BANDS];
+    int status;
+
+    status = auto_ts_fit_bands(obs, basis, &band_index, 1, start, end, df,
+                               lambda, coefs, band_rmse, v_dif);
+    if (status != SUCCESS)
+    {
+        RETURN_ERROR("Calling auto_ts_fit_bands", FUNC_NAME, ERROR);
+    }
+    *rmse = band_rmse[band_index];
+
+    return (SUCCESS);
+}
+
+
+/******************************************************************************
+MODULE:  auto_ts_fit_bands
+
+PURPOSE:  Lasso regression fitting of several bands over the same
+          observations, with full outputs
+
+RETURN VALUE:
+Type = int
+ERROR error in allocating memories
+SUCCESS no error encounted
+
+NOTES: All the bands of a pixel share the dates and so the design matrix of
+       a fit.  It is built once; glmnet standardizes x in place, so each band
+       is solved on a copy of it.  Prediction and residuals then run in the
+       fit_resid kernel of the band count and df, over the observations with
+       the bands as the inner loop, on coefficients laid out band by band
+       (one lane per band).  Every lane does the same float/double
+       operations in the same order as auto_ts_predict and
+       matlab_2d_array_norm, so results are unchanged.  rmse is indexed by
+       band.  With neighbor warm starts in the basis, a band whose window
+       overlaps a neighbor curve starts from its coefficients, and is fit
+       cold as well, whose result is kept when the two differ.
+******************************************************************************/
+int auto_ts_fit_bands
+(
+    const Obs_store_t *obs,        /* I: clear observations                  */
+    const Harmonic_basis_t *basis, /* I: harmonic terms of every date        */
+    const int *band_list,          /* I: bands to be fit                     */
+    int num_bands,                 /* I: number of bands to be fit           */
+    int start,                     /* I: first observation of the fit        */
+    int end,                       /* I: last observation of the fit         */
+    int df,                        /* I: number of model coefficients        */
+    double lambda,                 /* I: lasso penalty                       */
+    float **coefs,                 /* O: fitted coefficients of each band    */
+    float *rmse,                   /* O: rmse of each band                   */
+    float **v_dif                  /* O: residuals of each band              */
+)
+{
+    char FUNC_NAME[] = "auto_ts_fit_bands";
     char errmsg[MAX_STR_LEN];
-    float w;
-    int i, j;
-    double **x;
-    double *y;
+    int i, j, k;
+    int nh;                     /* number of harmonic terms of the model */
+    double *h;                  /* harmonic terms of the current date */
+    double **x0;                /* design matrix shared by the bands */
+    double **x;                 /* copy standardized by glmnet */
+    double **y;                 /* [band][obs] responses */
+    int *idx;                   /* observation indices of the fit */
     int status;
-    float *yhat;
-    float v_dif_norm = 0.0;
     int nums = 0.0;
     int nlam = 1;		// number of lambda
-    double ulam[1] = {20.0, };  // lambda = 20
+    double ulam[1] = {lambda, };  // lambda, 20 by default
     double alpha = 1.0;
-    int lmu;
-    double cfs[nlam][df];
+    int lmu[num_bands];
+    double cfs[num_bands][nlam][df];
+    Lasso_warm_t *warm = basis->lasso_warm;
+    double init[num_bands][df - 1]; /* neighbor starts of the coordinate  */
+                                    /* descent                            */
+    bool use_init[TOTAL_IMAGE_BANDS] = {false};
+    int passes[num_bands];      /* coordinate descent passes of each fit */
+    int cold_lmu, cold_passes;
+    double cold_cfs[nlam][df];
+    bool same;
+    float lane_cf[LASSO_COEFFS * TOTAL_IMAGE_BANDS]; /* coefs, band lanes */
+    float lane_sum[TOTAL_IMAGE_BANDS];  /* residual sum of squares      */
+    float v_dif_norm;
+    const Ts_kernels_t *kern = select_ts_kernels(num_bands, df,
+                                                 basis->precision);
 
     nums = end - start + 1;
-    w = TWO_PI / 365.25;
 
     /* Allocate memory */
-    if (df ==2 || df ==4 || df == 6 || df == 8)
+    if (kern != NULL)
     {
+        x0 = (double **)allocate_2d_array(df - 1, nums, sizeof(double));
         x = (double **)allocate_2d_array(df - 1, nums, sizeof(double));
-        if (x == NULL)
+        if (x0 == NULL || x == NULL)
 	{
             sprintf(errmsg, "Allocating x memory for %d - 1 times %d size of double", 
                     df, nums);
             RETURN_ERROR(errmsg, FUNC_NAME, ERROR);
 	}
 
-	y = malloc(nums * sizeof(double));
+	y = (double **)allocate_2d_array(num_bands, nums, sizeof(double));
         if (y == NULL)
 	{
             sprintf(errmsg, "Allocating y memory %d %d", df, nums);
@@ -1993,156 +2676,150 @@ int auto_ts_fit
     }
     else 
     {
-        RETURN_ERROR("Unsupported df value", FUNC_NAME, ERROR);
+        sprintf(errmsg, "No kernels for %d bands and df = %d", num_bands, df);
+        RETURN_ERROR(errmsg, FUNC_NAME, ERROR);
     }
+    nh = df - 2;
 
-    yhat = (float *)malloc(nums * sizeof(float));
-    if (yhat == NULL)
+    idx = (int *)malloc(nums * sizeof(int));
+    if (idx == NULL)
     {
-        RETURN_ERROR("Allocating yhat memory", FUNC_NAME, ERROR);
+        RETURN_ERROR("Allocating idx memory", FUNC_NAME, ERROR);
     }
 
-    switch (df)
+    /******************************************************************/
+    /*                                                                */
+    /* Design matrix and responses, gathered once for all the bands.  */
+    /*                                                                */
+    /******************************************************************/
+
+    for (i = 0; i < nums; i++)
+    {
+        idx[i] = OBS_INDEX(obs, i+start);
+        x0[0][i] = (double)obs->t[idx[i]];
+        h = basis->fit_terms[HARMONIC_ROW(basis, obs->t[idx[i]])];
+        for (j = 0; j < nh; j++)
+            x0[j+1][i] = h[j];
+    }
+    for (k = 0; k < num_bands; k++)
     {
+        for (i = 0; i < nums; i++)
+            y[k][i] = (double)obs->y[band_list[k]][idx[i]];
+    }
 
-        case 2:            
-            for (i = 0; i < nums; i++)
-            {
-                x[0][i] = (double)clrx[i+start];
-		y[i] = (double)clry[band_index][i+start];
-	    }
+    /******************************************************************/
+    /*                                                                */
+    /* Lasso fit of the bands, as one batch over the shared design:   */
+    /* the checks, standardization and inner products of x are done   */
+    /* once, then each band runs its own coordinate descent.          */
+    /*                                                                */
+    /******************************************************************/
 
-            status = c_glmnet(nums, df-1, &x[0][0], y, nlam, ulam, alpha, &lmu, cfs);
-            if (status != SUCCESS) 
-            {
-                sprintf(errmsg, "Calling c_glmnet when df = %d", df);
-                RETURN_ERROR(errmsg, FUNC_NAME, ERROR);
-            }
+    for (k = 0; k < num_bands; k++)
+    {
+        use_init[k] = (warm != NULL) &&
+                      neighbor_lasso_start(warm, obs->t[idx[0]],
+                                           obs->t[idx[nums-1]],
+                                           band_list[k], df, init[k]);
+    }
+    memcpy(&x[0][0], &x0[0][0], (df - 1) * nums * sizeof(double));
+    status = c_glmnet_bands(nums, df-1, &x[0][0], num_bands, &y[0][0], nlam,
+                            ulam, alpha, init, use_init, lmu, cfs, passes);
+    if (status != SUCCESS) 
+    {
+        sprintf(errmsg, "Calling c_glmnet when df = %d", df);
+        RETURN_ERROR(errmsg, FUNC_NAME, ERROR);
+    }
 
-	    for (i = 0; i < LASSO_COEFFS; i++)
-	        coefs[band_index][i] = 0.0;
+    for (k = 0; k < num_bands; k++)
+    {
+        /**************************************************************/
+        /*                                                            */
+        /* A warm start is fit cold too, and the cold coefficients    */
+        /* kept if the float ones differ, so the curves are those of  */
+        /* cold fits.  The passes of both are counted over the warm   */
+        /* fits.  glmnet standardizes x and y in place, so both are   */
+        /* reloaded.                                                  */
+        /*                                                            */
+        /**************************************************************/
 
-            for (i = 0; i < lmu; i++) 
-            {
-	        for (j = 0; j < df; j++) 
-                {
-	            coefs[band_index][j]= cfs[i][j];
-	        }
-            }
-            break;
+        if (warm != NULL)
+            warm->stats.fits++;
+        if (use_init[k])
+        {
+            warm->stats.warm++;
+            warm->stats.warm_passes += passes[k];
+            if (passes[k] == 1)
+                warm->stats.first_pass++;
 
-       case 4:             
+            memcpy(&x[0][0], &x0[0][0], (df - 1) * nums * sizeof(double));
             for (i = 0; i < nums; i++)
-            {
-                x[0][i] = (double)clrx[i+start];
-                x[1][i] = (double)cos(w * (float)clrx[i+start]);
-                x[2][i] = (double)sin(w * (float)clrx[i+start]);
-		y[i] = (double)clry[band_index][i+start];
-	    }
-
-            status = c_glmnet(nums, df-1, &x[0][0], y, nlam, ulam, alpha, &lmu, cfs);
+                y[k][i] = (double)obs->y[band_list[k]][idx[i]];
+            status = c_glmnet(nums, df-1, &x[0][0], y[k], nlam, ulam, alpha,
+                              NULL, &cold_lmu, cold_cfs, &cold_passes);
             if (status != SUCCESS) 
             {
                 sprintf(errmsg, "Calling c_glmnet when df = %d", df);
                 RETURN_ERROR(errmsg, FUNC_NAME, ERROR);
             }
-
-	    for (i = 0; i < LASSO_COEFFS; i++)
-	        coefs[band_index][i] = 0.0;
-
-            for (i = 0; i < lmu; i++) 
+            warm->stats.cold_passes += cold_passes;
+            same = (cold_lmu == lmu[k]);
+            for (i = 0; i < lmu[k] && same; i++)
             {
-	        for (j = 0; j < df; j++) 
+                for (j = 0; j < df; j++)
                 {
-	            coefs[band_index][j]= cfs[i][j];
-	        }
+                    if ((float)cfs[k][i][j] != (float)cold_cfs[i][j])
+                        same = false;
+                }
             }
-            break;
-
-       case 6:             
-            for (i = 0; i < nums; i++)
+            if (!same)
             {
-                x[0][i] = (double)clrx[i+start];
-                x[1][i] = (double)cos(w * (float)clrx[i+start]);
-                x[2][i] = (double)sin(w * (float)clrx[i+start]);
-                x[3][i] = (double)cos(2.0 * w * (float)clrx[i+start]);
-                x[4][i] = (double)sin(2.0 * w * (float)clrx[i+start]);
-		y[i] = (double)clry[band_index][i+start];
-	    }
-
-            status = c_glmnet(nums, df-1, &x[0][0], y, nlam, ulam, alpha, &lmu, cfs);
-            if (status != SUCCESS) 
-            {
-                sprintf(errmsg, "Calling c_glmnet when df = %d", df);
-                RETURN_ERROR(errmsg, FUNC_NAME, ERROR);
+                warm->stats.mismatch++;
+                lmu[k] = cold_lmu;
+                memcpy(cfs[k], cold_cfs, sizeof(cold_cfs));
             }
+        }
 
-	    for (i = 0; i < LASSO_COEFFS; i++)
-	        coefs[band_index][i] = 0.0;
+        for (i = 0; i < LASSO_COEFFS; i++)
+            coefs[band_list[k]][i] = 0.0;
 
-            for (i = 0; i < lmu; i++) 
+        for (i = 0; i < lmu[k]; i++) 
+        {
+            for (j = 0; j < df; j++) 
             {
-	        for (j = 0; j < df; j++) 
-                {
-	            coefs[band_index][j]= cfs[i][j];
-	        }
+                coefs[band_list[k]][j]= cfs[k][i][j];
             }
-            break;
-
-       case 8:             
-            for (i = 0; i < nums; i++)
-            {
-                x[0][i] = (double)clrx[i+start];
-                x[1][i] = (double)cos(w * (float)clrx[i+start]);
-                x[2][i] = (double)sin(w * (float)clrx[i+start]);
-                x[3][i] = (double)cos(2.0 * w * (float)clrx[i+start]);
-                x[4][i] = (double)sin(2.0 * w * (float)clrx[i+start]);
-                x[5][i] = (double)cos(3.0 * w * (float)clrx[i+start]);
-                x[6][i] = (double)sin(3.0 * w * (float)clrx[i+start]);
-		y[i] = (double)clry[band_index][i+start];
-	    }
+        }
 
-            status = c_glmnet(nums, df-1, &x[0][0], y, nlam, ulam, alpha, &lmu, cfs);
-            if (status != SUCCESS) 
-            {
-                sprintf(errmsg, "Calling c_glmnet when df = %d", df);
-                RETURN_ERROR(errmsg, FUNC_NAME, ERROR);
-            }
+        for (j = 0; j < df; j++)
+            lane_cf[j * num_bands + k] = coefs[band_list[k]][j];
+    }
 
-            for (i = 0; i < LASSO_COEFFS; i++)
-                coefs[band_index][i] = 0.0;
+    /******************************************************************/
+    /*                                                                */
+    /* Predict lasso model results and residuals of all the bands.    */
+    /*                                                                */
+    /******************************************************************/
 
-	    for (i = 0; i < lmu; i++)
-            {
-                for (j = 0; j < df; j++)
-                {
-	            coefs[band_index][j]= cfs[i][j];
-	        }
-            }
-            break;
-    }
+    kern->fit_resid(obs, basis, band_list, idx, nums, lane_cf, v_dif,
+                    lane_sum);
 
-    /* predict lasso model results */
-    if (df == 2 || df == 4 || df == 6 || df == 8)
+    for (k = 0; k < num_bands; k++)
     {
-        auto_ts_predict(clrx, coefs, df, band_index, start, end, yhat);
-        for (i = 0; i < nums; i++)
-        {
-            v_dif[band_index][i] = clry[band_index][i+start] - yhat[i];
-        }
-        matlab_2d_array_norm(v_dif, band_index, nums, &v_dif_norm);
-        *rmse = v_dif_norm / sqrt((float)(nums - df));
+        v_dif_norm = sqrt(lane_sum[k]);
+        rmse[band_list[k]] = v_dif_norm / sqrt((float)(nums - df));
     }
 
     /* Free allocated memory */
-    free(yhat);
-    if (df == 2 || df == 4 || df == 6 || df == 8)
+    free(idx);
+    if (free_2d_array ((void **) x0) != SUCCESS ||
+        free_2d_array ((void **) x) != SUCCESS)
     {
-        if (free_2d_array ((void **) x) != SUCCESS)
-	{
-            RETURN_ERROR ("Freeing memory: x\n", FUNC_NAME, ERROR);
-	}
-	free(y);
+        RETURN_ERROR ("Freeing memory: x\n", FUNC_NAME, ERROR);
+    }
+    if (free_2d_array ((void **) y) != SUCCESS)
+    {
+        RETURN_ERROR ("Freeing memory: y\n", FUNC_NAME, ERROR);
     }
 
     return (SUCCESS);
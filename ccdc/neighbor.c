@@ -0,0 +1,64 @@
+#include <stdlib.h>
+#include <stdbool.h>
+
+#include "neighbor.h"
+
+
+/******************************************************************************
+MODULE:  neighbor_lasso_start
+
+PURPOSE:  Pick the starting coefficients of a lasso fit from the neighbor
+          curve that overlaps its window most
+
+RETURN VALUE:
+Type = bool
+Value           Description
+-----           -----------
+true            init holds the coefficients of a neighbor curve
+false           no neighbor curve overlaps the window, start cold
+
+NOTES: Curve records keep the intercept in coefs[band][0] and the slope and
+       harmonic terms after it, in the order of the glmnet predictors, so
+       the first df - 1 terms after the intercept are the start.  Terms the
+       neighbor model did not fit are 0 in its record.
+******************************************************************************/
+bool neighbor_lasso_start
+(
+    const Lasso_warm_t *warm, /* I: neighbor curves                         */
+    int t_first,              /* I: first date of the fit window            */
+    int t_last,               /* I: last date of the fit window             */
+    int band,                 /* I: band of the fit                         */
+    int df,                   /* I: number of coefficients of the fit       */
+    double *init              /* O: [df - 1] starting coefficients, without */
+                              /*    the intercept                           */
+)
+{
+    const Output_t *best = NULL;
+    const Output_t *rec;
+    int best_overlap = 0;
+    int overlap;
+    int n, i, j;
+
+    for (n = 0; n < NUM_NEIGHBORS; n++)
+    {
+        for (i = 0; i < warm->num_recs[n]; i++)
+        {
+            rec = &warm->recs[n][i];
+            overlap = ((rec->t_end < t_last) ? rec->t_end : t_last) -
+                      ((rec->t_start > t_first) ? rec->t_start : t_first);
+            if (overlap > best_overlap)
+            {
+                best_overlap = overlap;
+                best = rec;
+            }
+        }
+    }
+
+    if (best == NULL)
+        return false;
+
+    for (j = 1; j < df; j++)
+        init[j - 1] = (double)best->coefs[band][j];
+
+    return true;
+}
@@ -0,0 +1,49 @@
+#ifndef NEIGHBOR_H
+#define NEIGHBOR_H
+
+
+#include <stdbool.h>
+
+#include "output.h"
+
+/* Warm starts of the lasso fits of a pixel from its finished neighbors   */
+/* in block mode.  Adjacent pixels usually share land cover and break     */
+/* dates, so the coefficients of the neighbor curve that overlaps a fit   */
+/* window most are a close start for the coordinate descent of glmnet.    */
+/* It converges to the lasso solution only within its threshold, and    */
+/* from another start lands elsewhere inside it, so each warm fit is also */
+/* fit cold and the cold result kept when they differ: the run is         */
+/* identical to cold.  The counters compare the passes of the two starts  */
+/* over the same fits.                                                    */
+typedef struct
+{
+    int fits;             /* lasso fits of the pixel                        */
+    int warm;             /* fits started from a neighbor curve             */
+    int first_pass;       /* warm fits already converged in their first pass*/
+    long warm_passes;     /* coordinate descent passes of the warm fits     */
+    long cold_passes;     /* passes of the same fits started cold           */
+    int mismatch;         /* warm fits that differ from cold, which keep    */
+                          /* the cold result                                */
+} Neighbor_stats_t;
+
+#define NUM_NEIGHBORS 2   /* left and upper neighbor of a block pixel       */
+
+typedef struct Lasso_warm_s
+{
+    const Output_t *recs[NUM_NEIGHBORS]; /* curves of each neighbor         */
+    int num_recs[NUM_NEIGHBORS];         /* their number, 0 if none         */
+    Neighbor_stats_t stats;/* counters of the pixel                         */
+} Lasso_warm_t;
+
+bool neighbor_lasso_start
+(
+    const Lasso_warm_t *warm, /* I: neighbor curves                         */
+    int t_first,              /* I: first date of the fit window            */
+    int t_last,               /* I: last date of the fit window             */
+    int band,                 /* I: band of the fit                         */
+    int df,                   /* I: number of coefficients of the fit       */
+    double *init              /* O: [df - 1] starting coefficients, without */
+                              /*    the intercept                           */
+);
+
+#endif /* NEIGHBOR_H */
@@ -0,0 +1,221 @@
+#define _GNU_SOURCE
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+#include <sched.h>
+#include <pthread.h>
+#include <unistd.h>
+
+#include "const.h"
+#include "utilities.h"
+#include "numa.h"
+
+
+/* Numbers of a sysfs list such as "0-3,8-11", appended to *list;         */
+/* FAILURE if the file cannot be read or *list grown, which keeps the     */
+/* numbers appended before.                                               */
+static int read_list
+(
+    const char *path,
+    int **list,
+    int *num
+)
+{
+    char line[4 * MAX_STR_LEN];
+    char *c;
+    char *end;
+    long first, last, i;
+    int *grown;
+    FILE *fp;
+
+    fp = fopen(path, "r");
+    if (fp == NULL)
+        return FAILURE;
+    if (fgets(line, sizeof(line), fp) == NULL)
+        line[0] = '\0';
+    fclose(fp);
+
+    c = line;
+    while (*c >= '0' && *c <= '9')
+    {
+        first = strtol(c, &end, 10);
+        last = first;
+        if (*end == '-')
+            last = strtol(end + 1, &end, 10);
+        grown = realloc(*list, (*num + last - first + 1) * sizeof(int));
+        if (grown == NULL)
+            return FAILURE;
+        *list = grown;
+        for (i = first; i <= last; i++)
+            (*list)[(*num)++] = (int)i;
+        c = (*end == ',') ? end + 1 : end;
+    }
+
+    return SUCCESS;
+}
+
+
+/******************************************************************************
+MODULE:  numa_open
+
+PURPOSE:  Read the NUMA nodes of the machine and their CPUs
+
+RETURN VALUE:
+Type = int
+Value           Description
+-----           -----------
+FAILURE         Error in allocating memory
+SUCCESS         No errors encountered
+
+NOTES: Nodes without CPUs (memory only) are left out.  Without the online
+       list of sysfs the machine is taken as one node of all the CPUs.
+******************************************************************************/
+int numa_open
+(
+    const char *sysfs,      /* I: node directory, NUMA_SYSFS                */
+    Numa_t *numa            /* O: nodes and their CPUs                      */
+)
+{
+    char FUNC_NAME[] = "numa_open";
+    char path[MAX_STR_LEN];
+    int *nodes = NULL;
+    int num_nodes = 0;
+    int i;
+
+    memset(numa, 0, sizeof(Numa_t));
+
+    snprintf(path, sizeof(path), "%s/online", sysfs);
+    if (read_list(path, &nodes, &num_nodes) != SUCCESS || num_nodes == 0)
+    {
+        free(nodes);
+        nodes = malloc(sizeof(int));
+        if (nodes == NULL)
+            RETURN_ERROR ("Allocating NUMA memory", FUNC_NAME, FAILURE);
+        nodes[0] = -1;
+        num_nodes = 1;
+    }
+
+    numa->num_cpus = calloc(num_nodes, sizeof(int));
+    numa->cpus = calloc(num_nodes, sizeof(int *));
+    if (numa->num_cpus == NULL || numa->cpus == NULL)
+    {
+        free(nodes);
+        RETURN_ERROR ("Allocating NUMA memory", FUNC_NAME, FAILURE);
+    }
+
+    for (i = 0; i < num_nodes; i++)
+    {
+        numa->cpus[numa->num_nodes] = NULL;
+        numa->num_cpus[numa->num_nodes] = 0;
+        snprintf(path, sizeof(path), "%s/node%d/cpulist", sysfs, nodes[i]);
+        if (nodes[i] < 0 || read_list(path, &numa->cpus[numa->num_nodes],
+                                      &numa->num_cpus[numa->num_nodes])
+                            != SUCCESS)
+        {
+            /* one node of all the CPUs, not pinned                      */
+            numa->num_cpus[numa->num_nodes] = 0;
+        }
+        if (numa->num_cpus[numa->num_nodes] > 0 || num_nodes == 1)
+            numa->num_nodes++;
+        else
+        {
+            free(numa->cpus[numa->num_nodes]);
+            numa->cpus[numa->num_nodes] = NULL;
+        }
+    }
+    free(nodes);
+
+    if (numa->num_nodes == 0)
+    {
+        /* no node with CPUs listed: one node, not pinned                 */
+        numa->num_nodes = 1;
+        numa->num_cpus[0] = 0;
+    }
+
+    return (SUCCESS);
+}
+
+
+/******************************************************************************
+MODULE:  numa_worker_node
+
+PURPOSE:  Node a worker of a pool runs on
+
+RETURN VALUE:
+Type = int
+Value           Description
+-----           -----------
+node            Index of the node in numa
+
+NOTES: The workers are split in consecutive runs, one per node, so the
+       workers of a node are neighbors in the order of the pool.  Without
+       workers, node 0.
+******************************************************************************/
+int numa_worker_node
+(
+    const Numa_t *numa,     /* I: nodes                                     */
+    int worker,             /* I: worker number                             */
+    int num_workers         /* I: number of workers                         */
+)
+{
+    if (num_workers < 1)
+        return 0;
+
+    return (int)((long)worker * numa->num_nodes / num_workers);
+}
+
+
+/******************************************************************************
+MODULE:  numa_pin
+
+PURPOSE:  Run the calling thread on the CPUs of a node
+
+RETURN VALUE:
+Type = int
+Value           Description
+-----           -----------
+FAILURE         The affinity could not be set
+SUCCESS         Pinned, or a machine of one node, where nothing is done
+
+NOTES: The thread may run on any CPU of its node, the scheduler balancing
+       the workers of the node among them.  Memory it touches first is
+       then allocated on the node, under the default local policy.
+******************************************************************************/
+int numa_pin
+(
+    const Numa_t *numa,     /* I: nodes                                     */
+    int node                /* I: node to run the calling thread on         */
+)
+{
+    cpu_set_t set;
+    int i;
+
+    if (numa->num_nodes < 2 || numa->num_cpus[node] == 0)
+        return (SUCCESS);
+
+    CPU_ZERO(&set);
+    for (i = 0; i < numa->num_cpus[node]; i++)
+    {
+        if (numa->cpus[node][i] < CPU_SETSIZE)
+            CPU_SET(numa->cpus[node][i], &set);
+    }
+    if (pthread_setaffinity_np(pthread_self(), sizeof(set), &set) != 0)
+        return (FAILURE);
+
+    return (SUCCESS);
+}
+
+
+void numa_free
+(
+    Numa_t *numa            /* I/O: nodes                                   */
+)
+{
+    int i;
+
+    for (i = 0; i < numa->num_nodes; i++)
+        free(numa->cpus[i]);
+    free(numa->cpus);
+    free(numa->num_cpus);
+    memset(numa, 0, sizeof(Numa_t));
+}
@@ -0,0 +1,41 @@
+#ifndef NUMA_H
+#define NUMA_H
+
+
+#define NUMA_SYSFS "/sys/devices/system/node"
+
+/* NUMA nodes of the machine and the CPUs of each, from sysfs.  A machine */
+/* without the node directory, or a kernel without NUMA, is one node of   */
+/* all the CPUs.                                                          */
+typedef struct
+{
+    int num_nodes;          /* online nodes with CPUs                       */
+    int *num_cpus;          /* [node] CPUs of the node, 0 if not pinned     */
+    int **cpus;             /* [node][i] their numbers                      */
+} Numa_t;
+
+int numa_open
+(
+    const char *sysfs,      /* I: node directory, NUMA_SYSFS                */
+    Numa_t *numa            /* O: nodes and their CPUs                      */
+);
+
+int numa_worker_node
+(
+    const Numa_t *numa,     /* I: nodes                                     */
+    int worker,             /* I: worker number                             */
+    int num_workers         /* I: number of workers                         */
+);
+
+int numa_pin
+(
+    const Numa_t *numa,     /* I: nodes                                     */
+    int node                /* I: node to run the calling thread on         */
+);
+
+void numa_free
+(
+    Numa_t *numa            /* I/O: nodes                                   */
+);
+
+#endif /* NUMA_H */
@@ -0,0 +1,281 @@
+#include <stdlib.h>
+#include <string.h>
+
+#include "const.h"
+#include "utilities.h"
+#include "obs_store.h"
+#include "defines.h"
+
+
+/******************************************************************************
+MODULE:  obs_store_alloc
+
+PURPOSE:  Allocate the valid mask and views of an observation store over
+          existing date and value arrays
+
+RETURN VALUE:
+Type = int
+ERROR error in allocating memories
+SUCCESS no error encounted
+
+NOTES: obs_store_extend appends to the live view after each removal it
+       follows, so the view holds twice the capacity before it has to be
+       re-packed.
+******************************************************************************/
+int obs_store_alloc
+(
+    int *t,                 /* I: date array of the observations            */
+    float **y,              /* I: [band][observation] value array           */
+    int capacity,           /* I: number of observations t and y can hold   */
+    Obs_store_t *obs        /* O: observation store                         */
+)
+{
+    char FUNC_NAME[] = "obs_store_alloc";
+
+    obs->t = t;
+    obs->y = y;
+    obs->capacity = capacity;
+    obs->view_size = 2 * capacity + 1;
+
+    obs->valid = malloc(capacity * sizeof(unsigned char));
+    obs->view = malloc(obs->view_size * sizeof(int));
+    obs->stale = malloc(capacity * sizeof(int));
+    if (obs->valid == NULL || obs->view == NULL || obs->stale == NULL)
+    {
+        obs_store_free(obs);
+        RETURN_ERROR ("Allocating observation store memory", FUNC_NAME,
+                      ERROR);
+    }
+
+    obs_store_reset(obs, 0);
+
+    return (SUCCESS);
+}
+
+
+/******************************************************************************
+MODULE:  obs_store_reset
+
+PURPOSE:  Make the first len observations live, position p being
+          observation p
+
+RETURN VALUE: None
+
+NOTES: Call after the date and value arrays have been (re)loaded.
+******************************************************************************/
+void obs_store_reset
+(
+    Obs_store_t *obs,       /* I/O: observation store                       */
+    int len                 /* I: number of live observations               */
+)
+{
+    int k;
+
+    for (k = 0; k < obs->capacity; k++)
+    {
+        obs->valid[k] = 1;
+        obs->stale[k] = k;
+    }
+    for (k = 0; k < obs->view_size; k++)
+        obs->view[k] = k;
+    obs->len = len;
+    obs->gap_pos = 0;
+    obs->gap_len = 0;
+}
+
+
+/******************************************************************************
+MODULE:  move_gap
+
+PURPOSE:  Move the gap of the live view in front of position pos
+
+RETURN VALUE: None
+
+NOTES: Only the view entries between the old and new gap positions move.
+******************************************************************************/
+static void move_gap
+(
+    Obs_store_t *obs,       /* I/O: observation store                       */
+    int pos                 /* I: new gap position                          */
+)
+{
+    if (obs->gap_len == 0)
+    {
+        obs->gap_pos = pos;
+    }
+    else if (pos < obs->gap_pos)
+    {
+        memmove(&obs->view[pos + obs->gap_len], &obs->view[pos],
+                (obs->gap_pos - pos) * sizeof(int));
+        obs->gap_pos = pos;
+    }
+    else if (pos > obs->gap_pos)
+    {
+        memmove(&obs->view[obs->gap_pos],
+                &obs->view[obs->gap_pos + obs->gap_len],
+                (pos - obs->gap_pos) * sizeof(int));
+        obs->gap_pos = pos;
+    }
+}
+
+
+/******************************************************************************
+MODULE:  drop_position
+
+PURPOSE:  Drop a live position into the gap and mark its observation removed
+
+RETURN VALUE: None
+******************************************************************************/
+static void drop_position
+(
+    Obs_store_t *obs,       /* I/O: observation store                       */
+    int pos                 /* I: live position of the observation          */
+)
+{
+    move_gap(obs, pos);
+    obs->valid[obs->view[pos + obs->gap_len]] = 0;
+    obs->gap_len++;
+    obs->len--;
+}
+
+
+/******************************************************************************
+MODULE:  obs_store_remove
+
+PURPOSE:  Remove the observation at a live position, the live positions after
+          it move down by one
+
+RETURN VALUE: None
+
+NOTES: Same result as shifting the arrays down over [pos, len - 1): the
+       former last position keeps its observation, now past the end.
+       Removals at the monitoring position, which only moves forward, are
+       O(1) apart from the distance the gap travels.
+******************************************************************************/
+void obs_store_remove
+(
+    Obs_store_t *obs,       /* I/O: observation store                       */
+    int pos                 /* I: live position of the observation          */
+)
+{
+    obs->stale[obs->len - 1] = OBS_INDEX(obs, obs->len - 1);
+    drop_position(obs, pos);
+}
+
+
+/******************************************************************************
+MODULE:  obs_store_compact
+
+PURPOSE:  Remove the flagged observations of a run of positions at once
+
+RETURN VALUE: None
+
+NOTES: Same result as compacting the arrays in place: the positions from the
+       new end up to the old one keep their former observations.  Flags past
+       the live positions are ignored.  Removal runs from the last flag down,
+       so the gap only travels over the run.
+******************************************************************************/
+void obs_store_compact
+(
+    Obs_store_t *obs,       /* I/O: observation store                       */
+    int first,              /* I: position of flags[0]                      */
+    int num,                /* I: number of flags                           */
+    const int *flags        /* I: 1 for positions to be removed             */
+)
+{
+    int k;
+    int count = 0;
+
+    for (k = 0; k < num && first + k < obs->len; k++)
+    {
+        if (flags[k] == 1)
+            count++;
+    }
+    for (k = obs->len - count; k < obs->len; k++)
+        obs->stale[k] = OBS_INDEX(obs, k);
+
+    for (k = min(num, obs->len - first) - 1; k >= 0; k--)
+    {
+        if (flags[k] == 1)
+            drop_position(obs, first + k);
+    }
+}
+
+
+/******************************************************************************
+MODULE:  obs_store_truncate
+
+PURPOSE:  Shorten the live positions without removing any observation
+
+RETURN VALUE: None
+******************************************************************************/
+void obs_store_truncate
+(
+    Obs_store_t *obs,       /* I/O: observation store                       */
+    int len                 /* I: new number of live positions             */
+)
+{
+    int k;
+
+    for (k = len; k < obs->len; k++)
+        obs->stale[k] = OBS_INDEX(obs, k);
+    obs->len = len;
+}
+
+
+/******************************************************************************
+MODULE:  obs_store_extend
+
+PURPOSE:  Make the position right after the live ones live again, with the
+          observation it still holds
+
+RETURN VALUE: None
+
+NOTES: Following obs_store_remove, this reproduces the continuous monitoring
+       noise removal, which shifts the arrays without shortening the series
+       so that the last observation is seen twice.  When the view is full,
+       the dead entries after the gap are dropped first.
+******************************************************************************/
+void obs_store_extend
+(
+    Obs_store_t *obs        /* I/O: observation store                       */
+)
+{
+    int last = OBS_INDEX(obs, obs->len);
+
+    if (obs->len < obs->gap_pos)
+    {
+        obs->view[obs->len] = last;
+    }
+    else
+    {
+        if (obs->len + obs->gap_len >= obs->view_size)
+        {
+            move_gap(obs, obs->len);
+            obs->gap_len = 0;
+        }
+        obs->view[obs->len + obs->gap_len] = last;
+    }
+    obs->len++;
+}
+
+
+/******************************************************************************
+MODULE:  obs_store_free
+
+PURPOSE:  Release the memory of an observation store
+
+RETURN VALUE: None
+******************************************************************************/
+void obs_store_free
+(
+    Obs_store_t *obs        /* I/O: observation store                       */
+)
+{
+    free(obs->valid);
+    obs->valid = NULL;
+    free(obs->view);
+    obs->view = NULL;
+    free(obs->stale);
+    obs->stale = NULL;
+}
@@ -0,0 +1,80 @@
+#ifndef OBS_STORE_H
+#define OBS_STORE_H
+
+
+/* Clear observation store of a pixel.  The dates and values stay where   */
+/* they were loaded; removing an observation only marks it in the valid   */
+/* mask (a tombstone) and drops it from the live view, which maps the     */
+/* positions used by the algorithm (i, i_start, end, ...) to observation  */
+/* indices.  The live view keeps a gap at the last removal position, so a */
+/* removal at or next to the previous one is O(1) and scattered removals  */
+/* only move the int entries between them, never the band values.         */
+/*                                                                        */
+/* Positions at or after len keep the observation that the former array   */
+/* shifting left there (stale), as a few reads past the end rely on it.   */
+typedef struct
+{
+    int *t;               /* dates of all observations (not owned)          */
+    float **y;            /* [band][observation] values (not owned)         */
+    int capacity;         /* number of observations t and y can hold        */
+    unsigned char *valid; /* 1 for live observations, 0 once removed        */
+    int len;              /* number of live positions                       */
+    int *view;            /* live view, position -> observation index       */
+    int view_size;        /* allocated length of view                       */
+    int gap_pos;          /* position in front of which the gap sits        */
+    int gap_len;          /* number of view entries inside the gap          */
+    int *stale;           /* position >= len -> observation index           */
+} Obs_store_t;
+
+/* Observation index, date and value of band b at position p.             */
+#define OBS_INDEX(s, p) \
+            ((p) >= (s)->len ? (s)->stale[p] : \
+             (s)->view[(p) < (s)->gap_pos ? (p) : (p) + (s)->gap_len])
+#define OBS_T(s, p) ((s)->t[OBS_INDEX(s, p)])
+#define OBS_Y(s, b, p) ((s)->y[b][OBS_INDEX(s, p)])
+
+int obs_store_alloc
+(
+    int *t,                 /* I: date array of the observations            */
+    float **y,              /* I: [band][observation] value array           */
+    int capacity,           /* I: number of observations t and y can hold   */
+    Obs_store_t *obs        /* O: observation store                         */
+);
+
+void obs_store_reset
+(
+    Obs_store_t *obs,       /* I/O: observation store                       */
+    int len                 /* I: number of live observations               */
+);
+
+void obs_store_remove
+(
+    Obs_store_t *obs,       /* I/O: observation store                       */
+    int pos                 /* I: live position of the observation          */
+);
+
+void obs_store_compact
+(
+    Obs_store_t *obs,       /* I/O: observation store                       */
+    int first,              /* I: position of flags[0]                      */
+    int num,                /* I: number of flags                           */
+    const int *flags        /* I: 1 for positions to be removed             */
+);
+
+void obs_store_truncate
+(
+    Obs_store_t *obs,       /* I/O: observation store                       */
+    int len                 /* I: new number of live positions             */
+);
+
+void obs_store_extend
+(
+    Obs_store_t *obs        /* I/O: observation store                       */
+);
+
+void obs_store_free
+(
+    Obs_store_t *obs        /* I/O: observation store                       */
+);
+
+#endif /* OBS_STORE_H */
@@ -0,0 +1,408 @@
+#include <stdlib.h>
+#include <string.h>
+
+#include "const.h"
+#include "utilities.h"
+#include "out_buffer.h"
+
+
+/******************************************************************************
+MODULE:  out_buffer_init
+
+PURPOSE:  Set up an empty output buffer
+
+RETURN VALUE:
+Type = None
+******************************************************************************/
+void out_buffer_init
+(
+    Out_buffer_t *ob        /* O: empty output buffer                       */
+)
+{
+    ob->streams = NULL;
+    ob->num_streams = 0;
+    ob->max_streams = 0;
+}
+
+
+/******************************************************************************
+MODULE:  out_buffer_open
+
+PURPOSE:  Get the memory stream of a destination file, opening it on first
+          use
+
+RETURN VALUE:
+Type = FILE *
+Value           Description
+-----           -----------
+NULL            Error in allocating memories
+stream          Stream to fprintf or fwrite the output to
+
+NOTES: The stream stays open until out_buffer_write, so a pixel can open
+       the same destination once per parameter set without closing it.
+******************************************************************************/
+FILE *out_buffer_open
+(
+    Out_buffer_t *ob,       /* I/O: output buffer of the pixel              */
+    const char *path        /* I: destination file, NULL for stdout         */
+)
+{
+    char FUNC_NAME[] = "out_buffer_open";
+    Out_stream_t **streams;
+    Out_stream_t *s;
+    int i;
+
+    if (path == NULL)
+        path = "";
+
+    for (i = 0; i < ob->num_streams; i++)
+    {
+        if (strcmp(ob->streams[i]->path, path) == 0)
+            return ob->streams[i]->fp;
+    }
+
+    if (ob->num_streams == ob->max_streams)
+    {
+        streams = realloc(ob->streams, (2 * ob->max_streams + 1) * 
+                          sizeof(Out_stream_t *));
+        if (streams == NULL)
+        {
+            ERROR_MESSAGE ("Allocating output buffer memory", FUNC_NAME);
+            return NULL;
+        }
+        for (i = ob->max_streams; i < 2 * ob->max_streams + 1; i++)
+            streams[i] = NULL;
+        ob->streams = streams;
+        ob->max_streams = 2 * ob->max_streams + 1;
+    }
+
+    /* Streams emptied by out_buffer_write are reused.                    */
+    if (ob->streams[ob->num_streams] == NULL)
+    {
+        ob->streams[ob->num_streams] = malloc(sizeof(Out_stream_t));
+        if (ob->streams[ob->num_streams] == NULL)
+        {
+            ERROR_MESSAGE ("Allocating output buffer memory", FUNC_NAME);
+            return NULL;
+        }
+    }
+
+    s = ob->streams[ob->num_streams];
+    snprintf(s->path, sizeof(s->path), "%s", path);
+    s->data = NULL;
+    s->len = 0;
+    s->fp = open_memstream(&s->data, &s->len);
+    if (s->fp == NULL)
+    {
+        ERROR_MESSAGE ("Opening output memory stream", FUNC_NAME);
+        return NULL;
+    }
+    ob->num_streams++;
+
+    return s->fp;
+}
+
+
+/******************************************************************************
+MODULE:  out_files_get
+
+PURPOSE:  Get the open file of a destination, opening it for append on
+          first use
+
+RETURN VALUE:
+Type = FILE *
+Value           Description
+-----           -----------
+NULL            Error in allocating memories or opening the file
+fp              File to write the destination's output to
+******************************************************************************/
+static FILE *out_files_get
+(
+    Out_files_t *of,        /* I/O: destination files of the run            */
+    const char *path        /* I: destination file                          */
+)
+{
+    char FUNC_NAME[] = "out_files_get";
+    char errmsg[MAX_STR_LEN + 16];
+    Out_file_t *files;
+    Out_file_t *f;
+    int i;
+
+    for (i = 0; i < of->num_files; i++)
+    {
+        if (strcmp(of->files[i].path, path) == 0)
+            return of->files[i].fp;
+    }
+
+    if (of->num_files == of->max_files)
+    {
+        files = realloc(of->files, (2 * of->max_files + 4) * 
+                        sizeof(Out_file_t));
+        if (files == NULL)
+        {
+            ERROR_MESSAGE ("Allocating output file memory", FUNC_NAME);
+            return NULL;
+        }
+        of->files = files;
+        of->max_files = 2 * of->max_files + 4;
+    }
+
+    f = &of->files[of->num_files];
+    f->fp = fopen(path, "ab");
+    if (f->fp == NULL)
+    {
+        snprintf(errmsg, sizeof(errmsg), "Opening %s", path);
+        ERROR_MESSAGE (errmsg, FUNC_NAME);
+        return NULL;
+    }
+    snprintf(f->path, sizeof(f->path), "%s", path);
+    of->num_files++;
+
+    return f->fp;
+}
+
+
+/******************************************************************************
+MODULE:  out_buffer_write
+
+PURPOSE:  Append the buffered output to the destination files and empty
+          the buffer
+
+RETURN VALUE:
+Type = int
+Value           Description
+-----           -----------
+FAILURE         Error in writing a destination file
+SUCCESS         No errors encountered
+
+NOTES: Destination files are opened for append, so they collect the
+       pixels in the order their buffers are written.  What is written is
+       only in the files once out_files_flush or out_files_close returns.
+******************************************************************************/
+int out_buffer_write
+(
+    Out_buffer_t *ob,       /* I/O: output buffer, emptied                  */
+    Out_files_t *of         /* I/O: destination files of the run            */
+)
+{
+    char FUNC_NAME[] = "out_buffer_write";
+    char errmsg[MAX_STR_LEN + 16];
+    Out_stream_t *s;
+    FILE *fp;
+    int status = SUCCESS;
+    int i;
+
+    for (i = 0; i < ob->num_streams; i++)
+    {
+        s = ob->streams[i];
+        fclose(s->fp);
+        s->fp = NULL;
+        if (s->len == 0)
+        {
+            free(s->data);
+            continue;
+        }
+
+        if (s->path[0] == '\0')
+            fp = stdout;
+        else
+            fp = out_files_get(of, s->path);
+        if (fp == NULL)
+            status = FAILURE;
+        else if (fwrite(s->data, 1, s->len, fp) != s->len)
+        {
+            snprintf(errmsg, sizeof(errmsg), "Writing %s", s->path);
+            ERROR_MESSAGE (errmsg, FUNC_NAME);
+            status = FAILURE;
+        }
+        free(s->data);
+    }
+    ob->num_streams = 0;
+
+    return (status);
+}
+
+
+/******************************************************************************
+MODULE:  out_buffer_take
+
+PURPOSE:  Hand the buffered output of one destination to the caller instead
+          of writing it, and empty the buffer
+
+RETURN VALUE:
+Type = int
+Value           Description
+-----           -----------
+FAILURE         Error in closing a memory stream
+SUCCESS         No errors encountered
+
+NOTES: For runs whose output is kept in memory (ccdc_run_arrays): the
+       other destinations are dropped.  *data is NULL, and *len 0, when
+       nothing went to path; the caller frees *data.
+******************************************************************************/
+int out_buffer_take
+(
+    Out_buffer_t *ob,       /* I/O: output buffer, emptied                  */
+    const char *path,       /* I: destination to take                       */
+    char **data,            /* O: its contents                              */
+    size_t *len             /* O: their size in bytes                       */
+)
+{
+    char FUNC_NAME[] = "out_buffer_take";
+    Out_stream_t *s;
+    int status = SUCCESS;
+    int i;
+
+    *data = NULL;
+    *len = 0;
+    for (i = 0; i < ob->num_streams; i++)
+    {
+        s = ob->streams[i];
+        if (fclose(s->fp) != 0)
+            status = FAILURE;
+        s->fp = NULL;
+        if (*data == NULL && strcmp(s->path, path) == 0)
+        {
+            *data = s->data;
+            *len = s->len;
+        }
+        else
+            free(s->data);
+    }
+    ob->num_streams = 0;
+
+    if (status != SUCCESS)
+    {
+        free(*data);
+        *data = NULL;
+        *len = 0;
+        RETURN_ERROR ("Closing output memory stream", FUNC_NAME, FAILURE);
+    }
+
+    return (SUCCESS);
+}
+
+
+/******************************************************************************
+MODULE:  out_buffer_free
+
+PURPOSE:  Free an output buffer, dropping what was not written
+
+RETURN VALUE:
+Type = None
+******************************************************************************/
+void out_buffer_free
+(
+    Out_buffer_t *ob        /* I/O: output buffer                           */
+)
+{
+    int i;
+
+    for (i = 0; i < ob->num_streams; i++)
+    {
+        fclose(ob->streams[i]->fp);
+        free(ob->streams[i]->data);
+    }
+    for (i = 0; i < ob->max_streams; i++)
+        free(ob->streams[i]);
+    free(ob->streams);
+    out_buffer_init(ob);
+}
+
+
+/******************************************************************************
+MODULE:  out_files_init
+
+PURPOSE:  Set up the destination files of a run, none open yet
+
+RETURN VALUE:
+Type = None
+******************************************************************************/
+void out_files_init
+(
+    Out_files_t *of         /* O: no destination file open                  */
+)
+{
+    of->files = NULL;
+    of->num_files = 0;
+    of->max_files = 0;
+}
+
+
+/******************************************************************************
+MODULE:  out_files_flush
+
+PURPOSE:  Flush what was written to the destination files of a run
+
+RETURN VALUE:
+Type = int
+Value           Description
+-----           -----------
+FAILURE         Error in writing a destination file
+SUCCESS         No errors encountered
+
+NOTES: Called before the sizes of the files are read, as a checkpoint
+       does.
+******************************************************************************/
+int out_files_flush
+(
+    Out_files_t *of         /* I/O: destination files of the run            */
+)
+{
+    char FUNC_NAME[] = "out_files_flush";
+    char errmsg[MAX_STR_LEN + 16];
+    int status = SUCCESS;
+    int i;
+
+    for (i = 0; i < of->num_files; i++)
+    {
+        if (fflush(of->files[i].fp) != 0)
+        {
+            snprintf(errmsg, sizeof(errmsg), "Writing %s", of->files[i].path);
+            ERROR_MESSAGE (errmsg, FUNC_NAME);
+            status = FAILURE;
+        }
+    }
+
+    return (status);
+}
+
+
+/******************************************************************************
+MODULE:  out_files_close
+
+PURPOSE:  Close the destination files of a run
+
+RETURN VALUE:
+Type = int
+Value           Description
+-----           -----------
+FAILURE         Error in writing a destination file
+SUCCESS         No errors encountered
+
+NOTES: The files are closed and freed even if one of them fails.
+******************************************************************************/
+int out_files_close
+(
+    Out_files_t *of         /* I/O: destination files, closed and freed     */
+)
+{
+    char FUNC_NAME[] = "out_files_close";
+    char errmsg[MAX_STR_LEN + 16];
+    int status = SUCCESS;
+    int i;
+
+    for (i = 0; i < of->num_files; i++)
+    {
+        if (fclose(of->files[i].fp) != 0)
+        {
+            snprintf(errmsg, sizeof(errmsg), "Writing %s", of->files[i].path);
+            ERROR_MESSAGE (errmsg, FUNC_NAME);
+            status = FAILURE;
+        }
+    }
+    free(of->files);
+    out_files_init(of);
+
+    return (status);
+}
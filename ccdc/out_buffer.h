@@ -0,0 +1,94 @@
+#ifndef OUT_BUFFER_H
+#define OUT_BUFFER_H
+
+
+#include <stdio.h>
+
+#include "const.h"
+
+
+/* Output of a pixel held in memory until it can be written.  The records */
+/* and counters a pixel writes go to one memory stream per destination   */
+/* file; out_buffer_write appends each stream to its file, or to stdout.  */
+/* With several threads the pixels of a block finish in any order, and   */
+/* writing their buffers in block order keeps the files byte-identical   */
+/* to a run on one thread.                                                */
+typedef struct
+{
+    char path[MAX_STR_LEN]; /* destination file, "" for stdout              */
+    FILE *fp;               /* memory stream of the text or records         */
+    char *data;             /* its contents, once closed                    */
+    size_t len;             /* their size in bytes                          */
+} Out_stream_t;
+
+typedef struct
+{
+    Out_stream_t **streams; /* one per destination, in first use order;     */
+                            /* they do not move, the memory streams keep    */
+                            /* the addresses of data and len                */
+    int num_streams;        /* number of them                               */
+    int max_streams;        /* allocated length of streams                  */
+} Out_buffer_t;
+
+/* Destination files of a run.  Each is opened for append the first time  */
+/* a pixel writes it and stays open until out_files_close, so writing a   */
+/* pixel does not reopen and close every file it writes.                  */
+typedef struct
+{
+    char path[MAX_STR_LEN]; /* destination file                             */
+    FILE *fp;               /* open for append                              */
+} Out_file_t;
+
+typedef struct
+{
+    Out_file_t *files;      /* in first write order                         */
+    int num_files;          /* number of them                               */
+    int max_files;          /* allocated length of files                    */
+} Out_files_t;
+
+void out_buffer_init
+(
+    Out_buffer_t *ob        /* O: empty output buffer                       */
+);
+
+FILE *out_buffer_open
+(
+    Out_buffer_t *ob,       /* I/O: output buffer of the pixel              */
+    const char *path        /* I: destination file, NULL for stdout         */
+);
+
+int out_buffer_write
+(
+    Out_buffer_t *ob,       /* I/O: output buffer, emptied                  */
+    Out_files_t *of         /* I/O: destination files of the run            */
+);
+
+int out_buffer_take
+(
+    Out_buffer_t *ob,       /* I/O: output buffer, emptied                  */
+    const char *path,       /* I: destination to take                       */
+    char **data,            /* O: its contents                              */
+    size_t *len             /* O: their size in bytes                       */
+);
+
+void out_buffer_free
+(
+    Out_buffer_t *ob        /* I/O: output buffer                           */
+);
+
+void out_files_init
+(
+    Out_files_t *of         /* O: no destination file open                  */
+);
+
+int out_files_flush
+(
+    Out_files_t *of         /* I/O: destination files of the run            */
+);
+
+int out_files_close
+(
+    Out_files_t *of         /* I/O: destination files, closed and freed     */
+);
+
+#endif /* OUT_BUFFER_H */
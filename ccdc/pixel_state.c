@@ -0,0 +1,281 @@
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+#include <unistd.h>
+
+#include "const.h"
+#include "defines.h"
+#include "utilities.h"
+#include "pixel_state.h"
+
+
+/******************************************************************************
+MODULE:  state_open
+
+PURPOSE:  Open the state files of a block run: with update the state of
+          the previous run of the block, and the new state
+
+RETURN VALUE:
+Type = int
+Value           Description
+-----           -----------
+FAILURE         Error in opening the files, or the state is of another run
+SUCCESS         No errors encountered
+
+NOTES: The state file of a block is state_<row>_<col>.bin in the state
+       directory.  It starts with two lines, "ccdc state" and the key,
+       which is compared on update so that a state is not applied to
+       another block or input, followed by a record per pixel in block
+       order.  Without a previous state, an update reads every scene.
+******************************************************************************/
+int state_open
+(
+    const char *state_dir,  /* I: directory of the state files              */
+    int row,                /* I: first pixel of the block                  */
+    int col,
+    const char *key,        /* I: block and input of the run                */
+    bool update,            /* I: read the previous state                   */
+    State_file_t *sf        /* O: state files of the run                    */
+)
+{
+    char FUNC_NAME[] = "state_open";
+    char line[2 * MAX_STR_LEN];
+    char msg_str[3 * MAX_STR_LEN];
+    char tmp_path[MAX_STR_LEN + 8];
+    char *old_key;
+    int len;
+
+    len = snprintf(sf->path, sizeof(sf->path), "%s/state_%d_%d.bin",
+                   state_dir, row, col);
+    if (len < 0 || len >= (int)sizeof(sf->path))
+        RETURN_ERROR ("State file name too long", FUNC_NAME, FAILURE);
+    snprintf(sf->key, sizeof(sf->key), "%s", key);
+    sf->in = NULL;
+    sf->out = NULL;
+
+    if (update)
+    {
+        sf->in = fopen(sf->path, "rb");
+        if (sf->in == NULL)
+        {
+            snprintf(msg_str, sizeof(msg_str), "No %s, reading every scene",
+                     sf->path);
+            WARNING_MESSAGE (msg_str, FUNC_NAME);
+        }
+    }
+    if (sf->in != NULL)
+    {
+        if (fgets(line, sizeof(line), sf->in) == NULL ||
+            strcmp(line, "ccdc state\n") != 0 ||
+            fgets(line, sizeof(line), sf->in) == NULL ||
+            strncmp(line, "key ", 4) != 0)
+        {
+            fclose(sf->in);
+            snprintf(msg_str, sizeof(msg_str), "Reading %s", sf->path);
+            RETURN_ERROR (msg_str, FUNC_NAME, FAILURE);
+        }
+        old_key = line + 4;
+        old_key[strcspn(old_key, "\n")] = '\0';
+        if (strcmp(old_key, sf->key) != 0)
+        {
+            fclose(sf->in);
+            len = snprintf(msg_str, sizeof(msg_str), "%s is of another "
+                           "run: %s", sf->path, old_key);
+            if (len < 0 || len >= (int)sizeof(msg_str))
+                snprintf(msg_str, sizeof(msg_str), "%s is of another run",
+                         sf->path);
+            RETURN_ERROR (msg_str, FUNC_NAME, FAILURE);
+        }
+    }
+
+    snprintf(tmp_path, sizeof(tmp_path), "%s.tmp", sf->path);
+    sf->out = fopen(tmp_path, "wb");
+    if (sf->out == NULL)
+    {
+        if (sf->in != NULL)
+            fclose(sf->in);
+        snprintf(msg_str, sizeof(msg_str), "Opening %s", tmp_path);
+        RETURN_ERROR (msg_str, FUNC_NAME, FAILURE);
+    }
+    fprintf(sf->out, "ccdc state\n");
+    fprintf(sf->out, "key %s\n", sf->key);
+
+    return (SUCCESS);
+}
+
+
+/******************************************************************************
+MODULE:  state_read
+
+PURPOSE:  Read the previous state of the next pixel of the block
+
+RETURN VALUE:
+Type = int
+Value           Description
+-----           -----------
+FAILURE         Error in reading the state, or it does not fit the run
+SUCCESS         No errors encountered
+
+NOTES: The scene list of the run has to start with the scenes the state
+       was read from: scenes are only ever added after them, as the list
+       is sorted by date and new acquisitions are the latest.
+******************************************************************************/
+int state_read
+(
+    State_file_t *sf,       /* I/O: state files                             */
+    int row,                /* I: pixel expected next                       */
+    int col,
+    char **scene_list,      /* I: sorted scene list of the run              */
+    int num_scenes,         /* I: its length                                */
+    Pixel_state_t *ps,      /* O: state of the pixel                        */
+    int *sdate,             /* O: dates of its valid observations           */
+    unsigned char *fmask,   /* O: their cfmask                              */
+    int **buf               /* O: their band values                         */
+)
+{
+    char FUNC_NAME[] = "state_read";
+    char msg_str[3 * MAX_STR_LEN];
+    size_t n;
+    int k;
+
+    if (fread(ps, sizeof(Pixel_state_t), 1, sf->in) != 1)
+    {
+        snprintf(msg_str, sizeof(msg_str), "%s ends before pixel %d %d",
+                 sf->path, row, col);
+        RETURN_ERROR (msg_str, FUNC_NAME, FAILURE);
+    }
+    if (ps->row != row || ps->col != col)
+    {
+        snprintf(msg_str, sizeof(msg_str), "%s has pixel %d %d instead of "
+                 "%d %d", sf->path, ps->row, ps->col, row, col);
+        RETURN_ERROR (msg_str, FUNC_NAME, FAILURE);
+    }
+    if (ps->num_read < 0 || ps->num_read > num_scenes ||
+        ps->num_valid < 0 || ps->num_valid > ps->num_read ||
+        (ps->num_read > 0 &&
+         strcmp(scene_list[ps->num_read - 1], ps->last_scene) != 0))
+    {
+        snprintf(msg_str, sizeof(msg_str), "The scene list does not start "
+                 "with the %d scenes of %s", ps->num_read, sf->path);
+        RETURN_ERROR (msg_str, FUNC_NAME, FAILURE);
+    }
+
+    n = ps->num_valid;
+    if (fread(sdate, sizeof(int), n, sf->in) != n ||
+        fread(fmask, sizeof(unsigned char), n, sf->in) != n)
+    {
+        snprintf(msg_str, sizeof(msg_str), "Reading %s", sf->path);
+        RETURN_ERROR (msg_str, FUNC_NAME, FAILURE);
+    }
+    for (k = 0; k < TOTAL_IMAGE_BANDS; k++)
+    {
+        if (fread(buf[k], sizeof(int), n, sf->in) != n)
+        {
+            snprintf(msg_str, sizeof(msg_str), "Reading %s", sf->path);
+            RETURN_ERROR (msg_str, FUNC_NAME, FAILURE);
+        }
+    }
+
+    return (SUCCESS);
+}
+
+
+/******************************************************************************
+MODULE:  state_write
+
+PURPOSE:  Append the state of a pixel to the new state of the block
+
+RETURN VALUE:
+Type = int
+Value           Description
+-----           -----------
+FAILURE         Error in writing the state
+SUCCESS         No errors encountered
+******************************************************************************/
+int state_write
+(
+    State_file_t *sf,       /* I/O: state files                             */
+    const Pixel_state_t *ps,/* I: state of the pixel                        */
+    const int *sdate,       /* I: dates of its valid observations           */
+    const unsigned char *fmask, /* I: their cfmask                          */
+    int **buf               /* I: their band values                         */
+)
+{
+    char FUNC_NAME[] = "state_write";
+    size_t n = ps->num_valid;
+    int k;
+
+    if (fwrite(ps, sizeof(Pixel_state_t), 1, sf->out) != 1 ||
+        fwrite(sdate, sizeof(int), n, sf->out) != n ||
+        fwrite(fmask, sizeof(unsigned char), n, sf->out) != n)
+    {
+        RETURN_ERROR ("Writing the state file", FUNC_NAME, FAILURE);
+    }
+    for (k = 0; k < TOTAL_IMAGE_BANDS; k++)
+    {
+        if (fwrite(buf[k], sizeof(int), n, sf->out) != n)
+        {
+            RETURN_ERROR ("Writing the state file", FUNC_NAME, FAILURE);
+        }
+    }
+
+    return (SUCCESS);
+}
+
+
+/******************************************************************************
+MODULE:  state_close
+
+PURPOSE:  Close the state files, and with commit replace the state of the
+          block by the new one
+
+RETURN VALUE:
+Type = int
+Value           Description
+-----           -----------
+FAILURE         Error in writing or renaming the new state
+SUCCESS         No errors encountered
+
+NOTES: The new state is flushed to disk before it is renamed over the
+       old one, so the state file is always a whole one.  Without commit
+       (a failed run) the new state is removed and the old one kept.
+******************************************************************************/
+int state_close
+(
+    State_file_t *sf,       /* I/O: state files                             */
+    bool commit             /* I: replace the previous state by the new one */
+)
+{
+    char FUNC_NAME[] = "state_close";
+    char tmp_path[MAX_STR_LEN + 8];
+    int status = SUCCESS;
+
+    if (sf->in != NULL)
+        fclose(sf->in);
+    sf->in = NULL;
+    if (sf->out == NULL)
+        return (SUCCESS);
+
+    snprintf(tmp_path, sizeof(tmp_path), "%s.tmp", sf->path);
+    if (commit && (fflush(sf->out) != 0 || fsync(fileno(sf->out)) != 0))
+        status = FAILURE;
+    if (fclose(sf->out) != 0)
+        status = FAILURE;
+    sf->out = NULL;
+    if (!commit || status != SUCCESS)
+    {
+        unlink(tmp_path);
+        if (commit)
+        {
+            RETURN_ERROR ("Writing the state file", FUNC_NAME, FAILURE);
+        }
+        return (SUCCESS);
+    }
+
+    if (rename(tmp_path, sf->path) != 0)
+    {
+        RETURN_ERROR ("Renaming the state file", FUNC_NAME, FAILURE);
+    }
+
+    return (SUCCESS);
+}
@@ -0,0 +1,82 @@
+#ifndef PIXEL_STATE_H
+#define PIXEL_STATE_H
+
+
+#include <stdio.h>
+#include <stdbool.h>
+
+#include "const.h"
+
+
+/* What read_pixel has made of the scenes of a pixel read so far: the     */
+/* scene list read up to, the swath overlap filter of the last scene,     */
+/* the cfmask counts, and the valid observations.  Kept per pixel in the  */
+/* state file of a block, a later run of the block with --update restores */
+/* it and reads only the scenes the list gained since, which leaves the   */
+/* pixel as a run over the whole list does: the change detection is then */
+/* run over the whole series again, so its results are the same too.     */
+typedef struct
+{
+    int row, col;                    /* position of the pixel              */
+    int num_read;                    /* scenes of the sorted list read     */
+    char last_scene[MAX_STR_LEN];    /* the last of them                   */
+    int prev_wrs_path;               /* path, row, date and cfmask of the  */
+    int prev_wrs_row;                /* last scene, for the swath overlap  */
+    int prev_year;                   /* filter of the next one             */
+    int prev_jday;
+    unsigned char prev_fmask;
+    int swath_overlap_count;         /* overlap pixels removed             */
+    int clr_sum, water_sum, shadow_sum, sn_sum, cloud_sum, fill_sum,
+        all_sum;                     /* cfmask counts                      */
+    int num_valid;                   /* valid observations                 */
+} Pixel_state_t;
+
+/* The state files of a block run: the one of the previous run, read with */
+/* --update, and the one written, renamed over it once the block is done. */
+typedef struct
+{
+    char path[MAX_STR_LEN];          /* state file of the block            */
+    char key[MAX_STR_LEN];           /* block and input of the run         */
+    FILE *in;                        /* previous state, NULL if none       */
+    FILE *out;                       /* new state, to path.tmp             */
+} State_file_t;
+
+int state_open
+(
+    const char *state_dir,  /* I: directory of the state files              */
+    int row,                /* I: first pixel of the block                  */
+    int col,
+    const char *key,        /* I: block and input of the run                */
+    bool update,            /* I: read the previous state                   */
+    State_file_t *sf        /* O: state files of the run                    */
+);
+
+int state_read
+(
+    State_file_t *sf,       /* I/O: state files                             */
+    int row,                /* I: pixel expected next                       */
+    int col,
+    char **scene_list,      /* I: sorted scene list of the run              */
+    int num_scenes,         /* I: its length                                */
+    Pixel_state_t *ps,      /* O: state of the pixel                        */
+    int *sdate,             /* O: dates of its valid observations           */
+    unsigned char *fmask,   /* O: their cfmask                              */
+    int **buf               /* O: their band values                         */
+);
+
+int state_write
+(
+    State_file_t *sf,       /* I/O: state files                             */
+    const Pixel_state_t *ps,/* I: state of the pixel                        */
+    const int *sdate,       /* I: dates of its valid observations           */
+    const unsigned char *fmask, /* I: their cfmask                          */
+    int **buf               /* I: their band values                         */
+);
+
+int state_close
+(
+    State_file_t *sf,       /* I/O: state files                             */
+    bool commit             /* I: replace the previous state by the new one */
+);
+
+#endif /* PIXEL_STATE_H */
@@ -0,0 +1,429 @@
+#include <stdlib.h>
+
+#include "const.h"
+#include "utilities.h"
+#include "pool.h"
+
+
+/* Pop the oldest task of the owner's deque.                              */
+static bool deque_take
+(
+    Pool_deque_t *d,
+    int capacity,
+    int *task
+)
+{
+    bool found = false;
+
+    pthread_mutex_lock(&d->lock);
+    if (d->count > 0)
+    {
+        *task = d->tasks[d->head];
+        d->head = (d->head + 1) % capacity;
+        d->count--;
+        found = true;
+    }
+    pthread_mutex_unlock(&d->lock);
+
+    return found;
+}
+
+
+/* Pop the newest task of another worker's deque, remote if that worker  */
+/* is on another node.                                                    */
+static bool deque_steal
+(
+    Pool_deque_t *d,
+    int capacity,
+    bool remote,
+    int *task
+)
+{
+    bool found = false;
+
+    pthread_mutex_lock(&d->lock);
+    if (d->count > 0)
+    {
+        d->count--;
+        *task = d->tasks[(d->head + d->count) % capacity];
+        d->steals++;
+        if (remote)
+            d->remote_steals++;
+        found = true;
+    }
+    pthread_mutex_unlock(&d->lock);
+
+    return found;
+}
+
+
+/******************************************************************************
+MODULE:  pool_worker
+
+PURPOSE:  Worker thread: run the tasks of its own deque, then steal from
+          the others, and sleep while there is nothing to run
+
+RETURN VALUE:
+Type = void *
+Value           Description
+-----           -----------
+NULL            The pool stopped
+
+NOTES: With nodes, the worker is pinned to its node before its init, and
+       steals from the workers of its node before the others, whose
+       tasks' memory is on another node.
+******************************************************************************/
+static void *pool_worker
+(
+    void *arg               /* I: pool                                      */
+)
+{
+    char FUNC_NAME[] = "pool_worker";
+    Pool_t *pool = arg;
+    int worker;
+    int node;
+    int victim;
+    int task;
+    int status = SUCCESS;
+    int i, pass;
+    bool found;
+
+    pthread_mutex_lock(&pool->lock);
+    worker = pool->started++;
+    pthread_mutex_unlock(&pool->lock);
+    node = pool->worker_node[worker];
+
+    if (pool->numa != NULL && numa_pin(pool->numa, node) != SUCCESS)
+        WARNING_MESSAGE ("Pinning a worker to its node", FUNC_NAME);
+    if (pool->init != NULL)
+        status = pool->init(pool->arg, worker, node);
+    pthread_mutex_lock(&pool->lock);
+    pool->num_ready++;
+    if (status != SUCCESS)
+        pool->init_status = FAILURE;
+    pthread_cond_broadcast(&pool->ready);
+    pthread_mutex_unlock(&pool->lock);
+
+    while (1)
+    {
+        found = deque_take(&pool->deques[worker], pool->capacity, &task);
+        for (pass = 0; !found && pass < 2; pass++)
+        {
+            /* Pass 0 steals on the node of the worker, pass 1 off it.    */
+            for (i = 1; !found && i < pool->num_workers; i++)
+            {
+                victim = (worker + i) % pool->num_workers;
+                if ((pool->worker_node[victim] != node) != (pass == 1))
+                    continue;
+                found = deque_steal(&pool->deques[victim], pool->capacity,
+                                    pass == 1, &task);
+            }
+        }
+
+        pthread_mutex_lock(&pool->lock);
+        if (!found)
+        {
+            /* A task submitted after the scan above is counted in        */
+            /* pending, so the scan is retried instead of sleeping.       */
+            while (pool->pending == 0 && !pool->stop)
+                pthread_cond_wait(&pool->queued, &pool->lock);
+            if (pool->pending == 0 && pool->stop)
+            {
+                pthread_mutex_unlock(&pool->lock);
+                break;
+            }
+            pthread_mutex_unlock(&pool->lock);
+            continue;
+        }
+        pool->pending--;
+        pthread_mutex_unlock(&pool->lock);
+
+        status = pool->run(pool->arg, worker, task);
+
+        pthread_mutex_lock(&pool->lock);
+        pool->status[task % pool->capacity] = status;
+        pool->done[task % pool->capacity] = true;
+        pthread_cond_broadcast(&pool->finished);
+        pthread_mutex_unlock(&pool->lock);
+    }
+
+    /* The log buffer of the thread is written by its destructor.         */
+    return NULL;
+}
+
+
+/* Stop the first num_threads workers of a pool once the queued tasks are */
+/* run, and join them.                                                    */
+static void pool_join
+(
+    Pool_t *pool,
+    int num_threads
+)
+{
+    int i;
+
+    pthread_mutex_lock(&pool->lock);
+    pool->stop = true;
+    pthread_cond_broadcast(&pool->queued);
+    pthread_mutex_unlock(&pool->lock);
+
+    /* Every worker can still steal from any deque until it exits.       */
+    for (i = 0; i < num_threads; i++)
+        pthread_join(pool->threads[i], NULL);
+}
+
+
+/* Free the memory of a pool, its locks destroyed if they were made.      */
+static void pool_free
+(
+    Pool_t *pool,
+    bool locks
+)
+{
+    int i;
+
+    for (i = 0; pool->deques != NULL && i < pool->num_workers; i++)
+    {
+        if (locks)
+            pthread_mutex_destroy(&pool->deques[i].lock);
+        free(pool->deques[i].tasks);
+    }
+    if (locks)
+    {
+        pthread_mutex_destroy(&pool->lock);
+        pthread_cond_destroy(&pool->queued);
+        pthread_cond_destroy(&pool->finished);
+        pthread_cond_destroy(&pool->ready);
+    }
+    free(pool->threads);
+    free(pool->deques);
+    free(pool->worker_node);
+    free(pool->done);
+    free(pool->status);
+}
+
+
+/******************************************************************************
+MODULE:  pool_create
+
+PURPOSE:  Start the worker threads of a pool
+
+RETURN VALUE:
+Type = int
+Value           Description
+-----           -----------
+FAILURE         Error in allocating memories or starting the threads
+SUCCESS         No errors encountered
+
+NOTES: Each worker has a deque; pool_submit deals the tasks to them in
+       turn, and a worker that runs out steals from the others, so a few
+       expensive pixels do not hold up the cheap ones queued behind them.
+       With numa the workers are split among the nodes, see
+       numa_worker_node.  The pool returns once every worker is through
+       its init.  On failure the workers started are stopped and joined,
+       and the pool is freed.
+******************************************************************************/
+int pool_create
+(
+    int num_workers,        /* I: number of worker threads                  */
+    int capacity,           /* I: most tasks in flight                      */
+    Pool_task_fn_t run,     /* I: task function                             */
+    Pool_init_fn_t init,    /* I: worker start function, NULL if none       */
+    void *arg,              /* I: first argument of both                    */
+    const Numa_t *numa,     /* I: nodes to pin the workers to, NULL if not  */
+    Pool_t *pool            /* O: running pool                              */
+)
+{
+    char FUNC_NAME[] = "pool_create";
+    int i;
+
+    pool->num_workers = num_workers;
+    pool->capacity = capacity;
+    pool->run = run;
+    pool->init = init;
+    pool->arg = arg;
+    pool->numa = numa;
+    pool->next_deque = 0;
+    pool->started = 0;
+    pool->num_ready = 0;
+    pool->init_status = SUCCESS;
+    pool->pending = 0;
+    pool->stop = false;
+
+    pool->threads = malloc(num_workers * sizeof(pthread_t));
+    pool->deques = calloc(num_workers, sizeof(Pool_deque_t));
+    pool->worker_node = calloc(num_workers, sizeof(int));
+    pool->done = calloc(capacity, sizeof(bool));
+    pool->status = calloc(capacity, sizeof(int));
+    for (i = 0; pool->deques != NULL && i < num_workers; i++)
+    {
+        pool->deques[i].tasks = malloc(capacity * sizeof(int));
+        if (pool->deques[i].tasks == NULL)
+            break;
+    }
+    if (pool->threads == NULL || pool->deques == NULL ||
+        pool->worker_node == NULL || pool->done == NULL ||
+        pool->status == NULL || i < num_workers)
+    {
+        pool_free(pool, false);
+        RETURN_ERROR ("Allocating pool memory", FUNC_NAME, FAILURE);
+    }
+    for (i = 0; numa != NULL && i < num_workers; i++)
+        pool->worker_node[i] = numa_worker_node(numa, i, num_workers);
+    for (i = 0; i < num_workers; i++)
+        pthread_mutex_init(&pool->deques[i].lock, NULL);
+    pthread_mutex_init(&pool->lock, NULL);
+    pthread_cond_init(&pool->queued, NULL);
+    pthread_cond_init(&pool->finished, NULL);
+    pthread_cond_init(&pool->ready, NULL);
+
+    for (i = 0; i < num_workers; i++)
+    {
+        if (pthread_create(&pool->threads[i], NULL, pool_worker, pool) != 0)
+            break;
+    }
+
+    pthread_mutex_lock(&pool->lock);
+    while (pool->num_ready < i)
+        pthread_cond_wait(&pool->ready, &pool->lock);
+    pthread_mutex_unlock(&pool->lock);
+    if (i < num_workers)
+    {
+        pool_join(pool, i);
+        pool_free(pool, true);
+        RETURN_ERROR ("Starting pool threads", FUNC_NAME, FAILURE);
+    }
+    if (pool->init_status != SUCCESS)
+    {
+        pool_join(pool, num_workers);
+        pool_free(pool, true);
+        RETURN_ERROR ("Starting pool workers", FUNC_NAME, FAILURE);
+    }
+
+    return (SUCCESS);
+}
+
+
+/******************************************************************************
+MODULE:  pool_submit
+
+PURPOSE:  Queue a task on the next worker's deque
+
+RETURN VALUE:
+Type = None
+
+NOTES: The caller keeps at most capacity tasks in flight, by waiting for
+       task n before submitting task n + capacity, so a deque never holds
+       more than capacity tasks and task % capacity names one task.
+******************************************************************************/
+void pool_submit
+(
+    Pool_t *pool,           /* I/O: pool                                    */
+    int task                /* I: task number                               */
+)
+{
+    int worker = pool->next_deque;
+
+    pool->next_deque = (pool->next_deque + 1) % pool->num_workers;
+    pool_submit_to(pool, task, worker);
+}
+
+
+/******************************************************************************
+MODULE:  pool_submit_to
+
+PURPOSE:  Queue a task on the deque of a given worker, the one on whose
+          node its memory is
+
+RETURN VALUE:
+Type = None
+
+NOTES: As for pool_submit, at most capacity tasks are in flight.
+******************************************************************************/
+void pool_submit_to
+(
+    Pool_t *pool,           /* I/O: pool                                    */
+    int task,               /* I: task number                               */
+    int worker              /* I: worker whose deque it is queued on        */
+)
+{
+    Pool_deque_t *d = &pool->deques[worker];
+
+    pthread_mutex_lock(&d->lock);
+    d->tasks[(d->head + d->count) % pool->capacity] = task;
+    d->count++;
+    pthread_mutex_unlock(&d->lock);
+
+    pthread_mutex_lock(&pool->lock);
+    pool->pending++;
+    pthread_cond_signal(&pool->queued);
+    pthread_mutex_unlock(&pool->lock);
+}
+
+
+/******************************************************************************
+MODULE:  pool_wait
+
+PURPOSE:  Wait for a submitted task to finish
+
+RETURN VALUE:
+Type = int
+Value           Description
+-----           -----------
+status          Return value of the task function
+******************************************************************************/
+int pool_wait
+(
+    Pool_t *pool,           /* I/O: pool                                    */
+    int task                /* I: task number                               */
+)
+{
+    int status;
+
+    pthread_mutex_lock(&pool->lock);
+    while (!pool->done[task % pool->capacity])
+        pthread_cond_wait(&pool->finished, &pool->lock);
+    pool->done[task % pool->capacity] = false;
+    status = pool->status[task % pool->capacity];
+    pthread_mutex_unlock(&pool->lock);
+
+    return status;
+}
+
+
+/******************************************************************************
+MODULE:  pool_destroy
+
+PURPOSE:  Let the workers finish the queued tasks, join them and free the
+          pool
+
+RETURN VALUE:
+Type = long
+Value           Description
+-----           -----------
+steals          Number of tasks run by a worker other than the one they
+                were submitted to
+******************************************************************************/
+long pool_destroy
+(
+    Pool_t *pool,           /* I/O: pool, its workers joined                */
+    long *remote_steals     /* O: steals across nodes, NULL if not wanted   */
+)
+{
+    long steals = 0;
+    long remote = 0;
+    int i;
+
+    pool_join(pool, pool->num_workers);
+    for (i = 0; i < pool->num_workers; i++)
+    {
+        steals += pool->deques[i].steals;
+        remote += pool->deques[i].remote_steals;
+    }
+    pool_free(pool, true);
+
+    if (remote_steals != NULL)
+        *remote_steals = remote;
+
+    return steals;
+}
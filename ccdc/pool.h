@@ -0,0 +1,99 @@
+#ifndef POOL_H
+#define POOL_H
+
+
+#include <stdbool.h>
+#include <pthread.h>
+
+#include "numa.h"
+
+
+/* Tasks a worker is handed per thread of the pool, the window of pixels  */
+/* read ahead of the output.                                              */
+#define POOL_TASKS_PER_THREAD 4
+
+/* Runs task on worker; returns SUCCESS or FAILURE.                      */
+typedef int (*Pool_task_fn_t)(void *arg, int worker, int task);
+
+/* Run by each worker when it starts, on its node, before any task, to    */
+/* allocate and touch its memory there; returns SUCCESS or FAILURE.       */
+typedef int (*Pool_init_fn_t)(void *arg, int worker, int node);
+
+/* Tasks of one worker.  The owner takes the oldest task first, so the    */
+/* tasks finish close to submission order, and idle workers steal the     */
+/* newest from the other end.                                             */
+typedef struct
+{
+    pthread_mutex_t lock;
+    int *tasks;             /* ring of task numbers                         */
+    int head;               /* slot of the oldest task                      */
+    int count;              /* number of tasks queued                       */
+    long steals;            /* tasks taken from this deque by other workers */
+    long remote_steals;     /* of them, by workers of another node          */
+} Pool_deque_t;
+
+/* Thread pool over a window of capacity tasks in flight: the caller      */
+/* submits task numbers in order and waits for each one by number before  */
+/* submitting capacity tasks past it.                                     */
+typedef struct
+{
+    int num_workers;        /* number of worker threads                     */
+    int capacity;           /* most tasks submitted and not yet waited for  */
+    Pool_task_fn_t run;     /* task function                                */
+    void *arg;              /* its first argument                           */
+    Pool_init_fn_t init;    /* worker start function, NULL if none          */
+    const Numa_t *numa;     /* nodes the workers are pinned to, NULL if not */
+    int *worker_node;       /* [worker] its node, 0 without numa            */
+    pthread_t *threads;     /* worker threads                               */
+    Pool_deque_t *deques;   /* [worker] queued tasks                        */
+    int next_deque;         /* deque the next task is submitted to          */
+    pthread_mutex_t lock;   /* guards the fields below                      */
+    int started;            /* workers started, the next worker number      */
+    int num_ready;          /* workers through init                         */
+    int init_status;        /* FAILURE if an init failed                    */
+    pthread_cond_t ready;   /* a worker is through init                     */
+    pthread_cond_t queued;  /* a task was submitted, or the pool stops      */
+    pthread_cond_t finished;/* a task finished                              */
+    int pending;            /* tasks submitted and not yet taken            */
+    bool *done;             /* [task % capacity] task finished              */
+    int *status;            /* [task % capacity] its return value           */
+    bool stop;              /* workers exit once the deques are empty       */
+} Pool_t;
+
+int pool_create
+(
+    int num_workers,        /* I: number of worker threads                  */
+    int capacity,           /* I: most tasks in flight                      */
+    Pool_task_fn_t run,     /* I: task function                             */
+    Pool_init_fn_t init,    /* I: worker start function, NULL if none       */
+    void *arg,              /* I: first argument of both                    */
+    const Numa_t *numa,     /* I: nodes to pin the workers to, NULL if not  */
+    Pool_t *pool            /* O: running pool                              */
+);
+
+void pool_submit
+(
+    Pool_t *pool,           /* I/O: pool                                    */
+    int task                /* I: task number                               */
+);
+
+void pool_submit_to
+(
+    Pool_t *pool,           /* I/O: pool                                    */
+    int task,               /* I: task number                               */
+    int worker              /* I: worker whose deque it is queued on        */
+);
+
+int pool_wait
+(
+    Pool_t *pool,           /* I/O: pool                                    */
+    int task                /* I: task number                               */
+);
+
+long pool_destroy
+(
+    Pool_t *pool,           /* I/O: pool, its workers joined                */
+    long *remote_steals     /* O: steals across nodes, NULL if not wanted   */
+);
+
+#endif /* POOL_H */
@@ -0,0 +1,333 @@
+/* Python bindings of the CCDC core.  ccdc.run_block hands a block of pixels
+   held in NumPy arrays (or anything with the buffer protocol) to
+   ccdc_run_arrays where they are, without a copy and with the interpreter
+   lock released, and returns the curve records as a structured array of
+   ccdc.OUTPUT_DTYPE, the layout of Output_t and of output.bin.  Build with
+   "make python" in the ccdc directory. */
+
+#define PY_SSIZE_T_CLEAN
+#include <Python.h>
+#include <stddef.h>
+
+#include "const.h"
+#include "utilities.h"
+#include "output.h"
+#include "ccdc.h"
+
+
+static PyObject *output_dtype;      /* numpy dtype of Output_t               */
+static PyObject *numpy_frombuffer;  /* numpy.frombuffer                      */
+
+
+/******************************************************************************
+MODULE:  get_array
+
+PURPOSE:  Get the buffer of an array argument, of an item type and of the
+          dimensions of a pixel or of a block
+
+RETURN VALUE:
+Type = int
+Value           Description
+-----           -----------
+-1              Not such an array, a Python exception set
+0               The buffer, to be released by the caller
+
+NOTES: The type is the struct code of the item, in native byte order, as
+       NumPy exports int32 ("i"), int16 ("h") and uint8 ("B") arrays.
+******************************************************************************/
+static int get_array
+(
+    PyObject *obj,          /* I: argument                                  */
+    const char *name,       /* I: its name, for the messages                */
+    char code,              /* I: struct code of the items                  */
+    int pixel_ndim,         /* I: dimensions of a pixel                     */
+    int block_ndim,         /* I: dimensions of a block                     */
+    Py_buffer *view         /* O: buffer of the argument                    */
+)
+{
+    const char *format;
+
+    if (PyObject_GetBuffer(obj, view, PyBUF_RECORDS_RO) != 0)
+        return -1;
+
+    format = (view->format != NULL) ? view->format : "B";
+    if (*format == '@' || *format == '=')
+        format++;
+    if (format[0] != code || format[1] != '\0')
+    {
+        PyErr_Format(PyExc_TypeError, "%s must be an array of %s items "
+                     "in native byte order, not \"%s\"", name,
+                     (code == 'i') ? "int32" :
+                     (code == 'h') ? "int16" : "uint8", view->format);
+        PyBuffer_Release(view);
+        return -1;
+    }
+    if (view->ndim != pixel_ndim && view->ndim != block_ndim)
+    {
+        PyErr_Format(PyExc_ValueError, "%s must have %d dimensions, or %d "
+                     "for a block", name, pixel_ndim, block_ndim);
+        PyBuffer_Release(view);
+        return -1;
+    }
+
+    return 0;
+}
+
+
+PyDoc_STRVAR(run_block_doc,
+"run_block(dates, bands, qa, *, threads=1, row=0, col=0, t_cg, t_max_cg,\n"
+"          conse, lambda_, n_times, min_num_c)\n"
+"--\n"
+"\n"
+"Run the change detection of a pixel, or of a block of pixels, over the\n"
+"same dates.\n"
+"\n"
+"dates   int32 julian dates (days since year 0000) of the n scenes,\n"
+"        ascending, shape (n,)\n"
+"bands   int16 values of the 7 bands (sr 1, 2, 3, 4, 5, 7 and toa 6 in\n"
+"        Kelvin, as in the files), shape (7, n), or (rows, cols, 7, n)\n"
+"qa      uint8 cfmask of the scenes, shape (n,), or (rows, cols, n);\n"
+"        scenes of fill (255) are left out\n"
+"\n"
+"The arrays are read in place, any strides.  The pixels run with the GIL\n"
+"released, on as many native threads as threads says, 1 to 256 as for\n"
+"ccdc --threads.  row and col are the position of the first pixel, in\n"
+"the pos field of its records.  The thresholds default to those of\n"
+"ccdc.  Returns the curve records, in row then col order, as a structured\n"
+"array of OUTPUT_DTYPE: the records ccdc writes to output.bin.");
+
+static PyObject *run_block
+(
+    PyObject *self,
+    PyObject *args,
+    PyObject *kwargs
+)
+{
+    static char *keywords[] = {"dates", "bands", "qa", "threads", "row",
+                               "col", "t_cg", "t_max_cg", "conse",
+                               "lambda_", "n_times", "min_num_c", NULL};
+    PyObject *dates_obj, *bands_obj, *qa_obj;
+    Py_buffer dates, bands, qa;
+    Ccdc_arrays_t arrays;
+    Ccdc_params_t params;
+    int num_threads = 1;
+    int row = 0, col = 0;
+    bool block;
+    Output_t *recs;
+    int num_recs;
+    int status;
+    int i;
+    PyObject *data;
+    PyObject *result;
+
+    (void)self;
+    default_ccdc_params(&params);
+    if (!PyArg_ParseTupleAndKeywords(args, kwargs, "OOO|$iiiddidii",
+                                     keywords, &dates_obj, &bands_obj,
+                                     &qa_obj, &num_threads, &row, &col,
+                                     &params.t_cg, &params.t_max_cg,
+                                     &params.conse, &params.lambda,
+                                     &params.n_times, &params.min_num_c))
+        return NULL;
+
+    if (get_array(dates_obj, "dates", 'i', 1, 1, &dates) != 0)
+        return NULL;
+    if (get_array(bands_obj, "bands", 'h', 2, 4, &bands) != 0)
+    {
+        PyBuffer_Release(&dates);
+        return NULL;
+    }
+    if (get_array(qa_obj, "qa", 'B', 1, 3, &qa) != 0)
+    {
+        PyBuffer_Release(&dates);
+        PyBuffer_Release(&bands);
+        return NULL;
+    }
+
+    /******************************************************************/
+    /*                                                                */
+    /* The shapes: the scenes of the dates, the bands, and a block of */
+    /* the same rows and cols in bands and qa.  A pixel is a block of */
+    /* one, its row and col strides 0.                                */
+    /*                                                                */
+    /******************************************************************/
+
+    block = (bands.ndim == 4);
+    arrays.num_scenes = dates.shape[0];
+    if ((qa.ndim == 3) != block ||
+        bands.shape[bands.ndim - 2] != TOTAL_IMAGE_BANDS ||
+        bands.shape[bands.ndim - 1] != dates.shape[0] ||
+        qa.shape[qa.ndim - 1] != dates.shape[0] ||
+        (block && (bands.shape[0] != qa.shape[0] ||
+                   bands.shape[1] != qa.shape[1])) ||
+        dates.shape[0] > INT_MAX)
+    {
+        PyErr_Format(PyExc_ValueError, "shapes of dates, bands and qa must "
+                     "be (n,), (7, n) and (n,), or (n,), (rows, cols, 7, n) "
+                     "and (rows, cols, n)");
+        status = FAILURE;
+    }
+    else
+    {
+        arrays.rows = block ? bands.shape[0] : 1;
+        arrays.cols = block ? bands.shape[1] : 1;
+        arrays.row = row;
+        arrays.col = col;
+        arrays.sdate = dates.buf;
+        arrays.sdate_stride = dates.strides[0];
+        arrays.bands = bands.buf;
+        arrays.qa = qa.buf;
+        for (i = 0; i < 2; i++)
+        {
+            arrays.band_strides[i] = block ? bands.strides[i] : 0;
+            arrays.qa_strides[i] = block ? qa.strides[i] : 0;
+        }
+        arrays.band_strides[2] = bands.strides[bands.ndim - 2];
+        arrays.band_strides[3] = bands.strides[bands.ndim - 1];
+        arrays.qa_strides[2] = qa.strides[qa.ndim - 1];
+
+        Py_BEGIN_ALLOW_THREADS
+        status = ccdc_run_arrays(&arrays, &params, num_threads, &recs,
+                                 &num_recs);
+        Py_END_ALLOW_THREADS
+        if (status != SUCCESS)
+            PyErr_SetString(PyExc_RuntimeError, "ccdc_run_arrays failed, "
+                            "the reason is logged to stderr");
+    }
+
+    PyBuffer_Release(&dates);
+    PyBuffer_Release(&bands);
+    PyBuffer_Release(&qa);
+    if (status != SUCCESS)
+        return NULL;
+
+    data = PyByteArray_FromStringAndSize((const char *)recs,
+                                         (Py_ssize_t)num_recs *
+                                         sizeof(Output_t));
+    free(recs);
+    if (data == NULL)
+        return NULL;
+    result = PyObject_CallFunctionObjArgs(numpy_frombuffer, data,
+                                          output_dtype, NULL);
+    Py_DECREF(data);
+
+    return result;
+}
+
+
+/******************************************************************************
+MODULE:  make_output_dtype
+
+PURPOSE:  Build the numpy dtype of Output_t
+
+RETURN VALUE:
+Type = PyObject *
+Value           Description
+-----           -----------
+NULL            Error, a Python exception set
+dtype           The dtype, its fields at the offsets of the struct
+
+NOTES: The offsets and the size come from the compiler, so the dtype
+       matches the records whatever the padding of the struct.
+******************************************************************************/
+static PyObject *make_output_dtype
+(
+    PyObject *numpy         /* I: numpy module                              */
+)
+{
+    PyObject *pos;
+    PyObject *spec;
+    PyObject *dtype;
+
+    pos = PyObject_CallMethod(numpy, "dtype", "({s:[ss],s:[ss],s:[nn],s:n})",
+                              "names", "row", "col",
+                              "formats", "i4", "i4",
+                              "offsets", (Py_ssize_t)offsetof(Position_t, row),
+                              (Py_ssize_t)offsetof(Position_t, col),
+                              "itemsize", (Py_ssize_t)sizeof(Position_t));
+    if (pos == NULL)
+        return NULL;
+
+    spec = Py_BuildValue("{s:[ssssssssss],"
+                         "s:[sss(s(ii))(s(i))Osss(s(i))],"
+                         "s:[nnnnnnnnnn],s:n}",
+                         "names", "t_start", "t_end", "t_break", "coefs",
+                         "rmse", "pos", "change_prob", "num_obs",
+                         "category", "magnitude",
+                         "formats", "i4", "i4", "i4",
+                         "f4", NUM_BANDS, NUM_COEFFS, "f4", NUM_BANDS, pos,
+                         "f4", "i4", "i4", "f4", NUM_BANDS,
+                         "offsets",
+                         (Py_ssize_t)offsetof(Output_t, t_start),
+                         (Py_ssize_t)offsetof(Output_t, t_end),
+                         (Py_ssize_t)offsetof(Output_t, t_break),
+                         (Py_ssize_t)offsetof(Output_t, coefs),
+                         (Py_ssize_t)offsetof(Output_t, rmse),
+                         (Py_ssize_t)offsetof(Output_t, pos),
+                         (Py_ssize_t)offsetof(Output_t, change_prob),
+                         (Py_ssize_t)offsetof(Output_t, num_obs),
+                         (Py_ssize_t)offsetof(Output_t, category),
+                         (Py_ssize_t)offsetof(Output_t, magnitude),
+                         "itemsize", (Py_ssize_t)sizeof(Output_t));
+    Py_DECREF(pos);
+    if (spec == NULL)
+        return NULL;
+    dtype = PyObject_CallMethod(numpy, "dtype", "(O)", spec);
+    Py_DECREF(spec);
+
+    return dtype;
+}
+
+
+static PyMethodDef ccdc_methods[] =
+{
+    {"run_block", (PyCFunction)(void (*)(void))run_block,
+     METH_VARARGS | METH_KEYWORDS, run_block_doc},
+    {NULL, NULL, 0, NULL}
+};
+
+static struct PyModuleDef ccdc_module =
+{
+    PyModuleDef_HEAD_INIT, "ccdc",
+    "Continuous Change Detection and Classification of a block of pixels "
+    "in arrays.", -1, ccdc_methods, NULL, NULL, NULL, NULL
+};
+
+
+PyMODINIT_FUNC PyInit_ccdc (void)
+{
+    PyObject *module;
+    PyObject *numpy;
+
+    /* The core logs its warnings and errors to stderr, away from the     */
+    /* output of the interpreter.                                         */
+    if (log_open(NULL, stderr, LOG_LEVEL_WARN) != SUCCESS)
+    {
+        PyErr_SetString(PyExc_ImportError, "Opening the ccdc log");
+        return NULL;
+    }
+
+    numpy = PyImport_ImportModule("numpy");
+    if (numpy == NULL)
+        return NULL;
+    numpy_frombuffer = PyObject_GetAttrString(numpy, "frombuffer");
+    output_dtype = make_output_dtype(numpy);
+    Py_DECREF(numpy);
+    if (numpy_frombuffer == NULL || output_dtype == NULL)
+        return NULL;
+
+    module = PyModule_Create(&ccdc_module);
+    if (module == NULL)
+        return NULL;
+    Py_INCREF(output_dtype);
+    if (PyModule_AddObject(module, "OUTPUT_DTYPE", output_dtype) != 0 ||
+        PyModule_AddIntConstant(module, "NUM_BANDS", NUM_BANDS) != 0 ||
+        PyModule_AddIntConstant(module, "NUM_COEFFS", NUM_COEFFS) != 0)
+    {
+        Py_DECREF(output_dtype);
+        Py_DECREF(module);
+        return NULL;
+    }
+
+    return module;
+}
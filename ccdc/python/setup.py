@@ -0,0 +1,39 @@
+# Builds the ccdc Python module (ccdcmodule.c) over the CCDC core: the C
+# sources of the ccdc directory, compiled with CCDC_LIBRARY so that main is
+# left out and with the flags of "make release", and glmnet5.o, which
+# "make python" compiles position independent first.  Run through
+# "make python", which passes GSL_SCI_INC and GSL_SCI_LIB.
+
+import glob
+import os
+
+from setuptools import Extension, setup
+
+here = os.path.dirname(os.path.abspath(__file__))
+src = os.path.dirname(here)
+gsl_inc = os.environ.get("GSL_SCI_INC", "/usr/include/gsl")
+gsl_lib = os.environ.get("GSL_SCI_LIB", "/usr/lib")
+
+core = sorted(glob.glob(os.path.join(src, "*.c")))
+
+setup(
+    name="ccdc",
+    version="5.1",
+    description="Continuous Change Detection and Classification of a block "
+                "of pixels in NumPy arrays",
+    ext_modules=[
+        Extension(
+            "ccdc",
+            sources=[os.path.join(here, "ccdcmodule.c")] + core,
+            include_dirs=[src, gsl_inc],
+            define_macros=[("CCDC_LIBRARY", None),
+                           ("CCDC_LOG_FLOOR", "LOG_LEVEL_DEBUG")],
+            extra_compile_args=["-O2", "-ffp-contract=off"],
+            extra_objects=[os.path.join(here, "glmnet5.o")],
+            library_dirs=[gsl_lib],
+            libraries=["z", "pthread", "rt", "gsl", "gslcblas", "gfortran",
+                       "m"],
+        )
+    ],
+    install_requires=["numpy"],
+)
@@ -0,0 +1,123 @@
+#!/usr/bin/perl
+
+# ######################################################################
+#
+# Name: calibrateCost.pl
+#
+# Description:
+# Fits the per pixel cost model of scheduleCost.pl on the cost records
+# of ccdc runs with --record-cost.  Each line of their cost.txt is
+#
+#   row col path valid clr water snow all usec
+#
+# with path the branch the cfmask counts send the pixel down (full,
+# snow or fmask_fail) and usec the time of its change detection.  For
+# each path the time is fitted by least squares as
+#
+#   usec = a + b * n + c * n * n
+#
+# where n is the number of observations the path works on: the clear
+# (and water) ones for full, clear and snow for snow, all the valid ones
+# for fmask_fail.  The model is printed as one line per path,
+#
+#   path a b c records
+#
+# A path with fewer than 3 timed records, or whose records all have
+# the same n, is fitted as usec = b * n.  Records of --cost-only runs
+# (usec 0) are skipped.
+#
+# Usage:
+#   calibrateCost.pl <cost file> [<cost file> ...] > model.txt
+#
+# ######################################################################
+
+use strict;
+use warnings;
+
+die "usage: $0 <cost file> [<cost file> ...]\n" if (@ARGV < 1);
+
+# Observations a path works on, from the fields of a cost record
+sub path_obs
+{
+    my ($path, $valid, $clr, $snow) = @_;
+
+    return $clr if ($path eq "full");
+    return $clr + $snow if ($path eq "snow");
+    return $valid;
+}
+
+# Normal equations of each path: sums of n^k (k = 0..4) and of n^k usec
+my %sums;
+for my $file (@ARGV)
+{
+    open(my $fh, "<", $file) or die "cannot open $file\n";
+    while (my $line = <$fh>)
+    {
+        my @v = split(' ', $line);
+        next if (@v != 9 || $v[8] <= 0);
+        my $n = path_obs($v[2], $v[3], $v[4], $v[6]);
+        my $s = $sums{$v[2]} //= {nk => [0, 0, 0, 0, 0], nt => [0, 0, 0]};
+        for my $k (0 .. 4)
+        {
+            $s->{nk}[$k] += $n ** $k;
+        }
+        for my $k (0 .. 2)
+        {
+            $s->{nt}[$k] += $n ** $k * $v[8];
+        }
+    }
+    close($fh);
+}
+
+# Solve the 3 x 3 system m x = r by Gaussian elimination with partial
+# pivoting; undef if it is singular
+sub solve3
+{
+    my ($m, $r) = @_;
+    my @a = map { [@{$m->[$_]}, $r->[$_]] } (0 .. 2);
+
+    for my $i (0 .. 2)
+    {
+        my $p = $i;
+        for my $j ($i + 1 .. 2)
+        {
+            $p = $j if (abs($a[$j][$i]) > abs($a[$p][$i]));
+        }
+        return undef if (abs($a[$p][$i]) < 1e-12 * (abs($a[0][0]) + 1));
+        @a[$i, $p] = @a[$p, $i];
+        for my $j ($i + 1 .. 2)
+        {
+            my $f = $a[$j][$i] / $a[$i][$i];
+            $a[$j][$_] -= $f * $a[$i][$_] for ($i .. 3);
+        }
+    }
+
+    my @x;
+    for my $i (reverse(0 .. 2))
+    {
+        my $v = $a[$i][3];
+        $v -= $a[$i][$_] * $x[$_] for ($i + 1 .. 2);
+        $x[$i] = $v / $a[$i][$i];
+    }
+
+    return \@x;
+}
+
+for my $path (sort(keys(%sums)))
+{
+    my $nk = $sums{$path}{nk};
+    my $nt = $sums{$path}{nt};
+    my $x;
+
+    if ($nk->[0] >= 3)
+    {
+        $x = solve3([[$nk->[0], $nk->[1], $nk->[2]],
+                     [$nk->[1], $nk->[2], $nk->[3]],
+                     [$nk->[2], $nk->[3], $nk->[4]]], $nt);
+    }
+    if (!defined($x))
+    {
+        $x = [0, ($nk->[2] > 0) ? $nt->[1] / $nk->[2] : 0, 0];
+    }
+    printf("%s %g %g %g %d\n", $path, @$x, $nk->[0]);
+}
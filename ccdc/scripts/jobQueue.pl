@@ -0,0 +1,323 @@
+#!/usr/bin/perl
+
+# ######################################################################
+#
+# Name: jobQueue.pl
+#
+# Description:
+# Job queue of the pixel blocks of a tile, in a directory of a shared
+# filesystem, so that any number of ccdc workers on any number of nodes
+# run the tile together.  Every change of state of a job is a rename,
+# which is atomic, so no two workers ever hold the same job:
+#
+#   todo/<job>            job waiting, "row col rows cols attempts"
+#   leased/<job>@<worker> job run by a worker; the file is touched every
+#                         lease / 3 seconds while it runs (heartbeat)
+#   work/<job>@<worker>/  out-path of that run
+#   done/<job>/           output of the job, committed by renaming the
+#                         out-path of a successful run
+#   failed/<job>          job that failed max-attempts times
+#
+# A lease not touched for lease seconds belongs to a dead or stuck
+# worker: the next idle worker puts the job back in todo, counting an
+# attempt.  A worker that finds its own lease gone stops its run.  If
+# two runs of a job both finish, the first to commit wins and the other
+# is discarded; both wrote the same output.
+#
+# Usage:
+#   jobQueue.pl init <queue> <lines> <samples> <block rows> <block cols>
+#               [<first index>]
+#       Create the queue of the blocks of a lines x samples tile.  The
+#       first index is 0 for tifs input and 1 for bip input (default 0).
+#   jobQueue.pl worker <queue> [--lease=<seconds>] [--max-attempts=<n>]
+#               -- <ccdc command and args>
+#       Run jobs until none is left, appending --row, --col,
+#       --block-rows, --block-cols and --out-path to the command.  Start
+#       one per node or core, for example under SLURM:
+#           srun jobQueue.pl worker /shared/q -- ccdc --in-path=...
+#   jobQueue.pl status <queue>
+#       Print the number of jobs in each state, and the failed ones.
+#   jobQueue.pl merge <queue> <out dir>
+#       Append the files of the done jobs, in row then col order of the
+#       blocks, to the files of the same name in out dir.
+#
+# ######################################################################
+
+use strict;
+use warnings;
+use Getopt::Long qw(GetOptionsFromArray);
+use POSIX qw(:sys_wait_h);
+use Sys::Hostname;
+use File::Path qw(make_path remove_tree);
+
+my @states = ("todo", "leased", "work", "done", "failed");
+
+sub usage
+{
+    die "usage: $0 init <queue> <lines> <samples> <block rows> <block cols> "
+        . "[<first index>]\n"
+        . "       $0 worker <queue> [--lease=<seconds>] [--max-attempts=<n>]"
+        . " -- <ccdc command>\n"
+        . "       $0 status <queue>\n"
+        . "       $0 merge <queue> <out dir>\n";
+}
+
+# Entries of a state directory, without the temporary (dot) files
+sub entries
+{
+    my ($dir) = @_;
+
+    opendir(my $dh, $dir) or die "cannot open $dir\n";
+    my @e = sort(grep { !/^\./ } readdir($dh));
+    closedir($dh);
+
+    return @e;
+}
+
+sub read_job
+{
+    my ($file) = @_;
+
+    open(my $fh, "<", $file) or return undef;
+    my @v = split(' ', <$fh> // "");
+    close($fh);
+
+    return (@v == 5) ? \@v : undef;
+}
+
+# Write a job file through a temporary file, so it is never seen partly
+# written
+sub write_job
+{
+    my ($file, $job) = @_;
+    my $tmp = "$file.$$.tmp";
+    $tmp =~ s{([^/]+)$}{.$1};
+
+    open(my $fh, ">", $tmp) or die "cannot write $tmp\n";
+    print $fh join(" ", @$job), "\n";
+    close($fh) or die "cannot write $tmp\n";
+    rename($tmp, $file) or die "cannot rename $tmp\n";
+}
+
+sub init
+{
+    my ($queue, $lines, $samples, $rows, $cols, $first) = @_;
+    my $num_jobs = 0;
+
+    usage() if (!defined($cols));
+    $first = 0 if (!defined($first));
+    die "block rows and cols must be > 0\n" if ($rows < 1 || $cols < 1);
+    make_path(map { "$queue/$_" } @states);
+
+    for (my $row = $first; $row < $lines + $first; $row += $rows)
+    {
+        for (my $col = $first; $col < $samples + $first; $col += $cols)
+        {
+            my $r = ($row + $rows > $lines + $first) ?
+                    $lines + $first - $row : $rows;
+            my $c = ($col + $cols > $samples + $first) ?
+                    $samples + $first - $col : $cols;
+            write_job(sprintf("%s/todo/%06d_%06d", $queue, $row, $col),
+                      [$row, $col, $r, $c, 0]);
+            $num_jobs++;
+        }
+    }
+    print "$num_jobs jobs\n";
+}
+
+# Put the jobs of the leases older than $lease seconds back in todo, or
+# in failed after $max attempts; the number put back
+sub reap
+{
+    my ($queue, $lease, $max) = @_;
+    my $reaped = 0;
+
+    for my $f (entries("$queue/leased"))
+    {
+        my $mtime = (stat("$queue/leased/$f"))[9];
+        next if (!defined($mtime) || time() - $mtime <= $lease);
+
+        # Out of leased first, so only one worker reaps it
+        my ($name) = split(/@/, $f);
+        my $tmp = "$queue/todo/.reap.$f";
+        next if (!rename("$queue/leased/$f", $tmp));
+        my $job = read_job($tmp) // die "bad job file $tmp\n";
+        $job->[4]++;
+        write_job($tmp, $job);
+        my $state = ($job->[4] >= $max) ? "failed" : "todo";
+        rename($tmp, "$queue/$state/$name") or die "cannot rename $tmp\n";
+        remove_tree("$queue/work/$f");
+        print STDERR "reaped $name of $f, attempt $job->[4]\n";
+        $reaped++;
+    }
+
+    return $reaped;
+}
+
+# Lease a job: its name and lease file, or nothing once the queue is
+# empty
+sub claim
+{
+    my ($queue, $id, $lease, $max) = @_;
+
+    while (1)
+    {
+        for my $name (entries("$queue/todo"))
+        {
+            my $leased = "$queue/leased/$name\@$id";
+            next if (!rename("$queue/todo/$name", $leased));
+            if (-e "$queue/done/$name")
+            {
+                unlink($leased);
+                next;
+            }
+            utime(undef, undef, $leased);
+            return ($name, $leased);
+        }
+        next if (reap($queue, $lease, $max) > 0);
+        return () if (entries("$queue/leased") == 0);
+
+        # Others still run jobs, which come back if they fail
+        sleep(($lease > 3) ? int($lease / 3) : 1);
+    }
+}
+
+sub worker
+{
+    my ($queue, @args) = @_;
+    my $lease = 600;
+    my $max = 3;
+    my $id = hostname() . ".$$";
+
+    usage() if (!defined($queue));
+    GetOptionsFromArray(\@args, "lease=i" => \$lease,
+                        "max-attempts=i" => \$max) or usage();
+    usage() if (@args == 0);
+    die "lease must be > 0\n" if ($lease < 1);
+
+    while (my ($name, $leased) = claim($queue, $id, $lease, $max))
+    {
+        my $job = read_job($leased) // die "bad job file $leased\n";
+        my $work = "$queue/work/$name\@$id";
+        remove_tree($work);
+        make_path($work);
+
+        my $pid = fork();
+        die "cannot fork\n" if (!defined($pid));
+        if ($pid == 0)
+        {
+            exec(@args, "--row=$job->[0]", "--col=$job->[1]",
+                 "--block-rows=$job->[2]", "--block-cols=$job->[3]",
+                 "--out-path=$work") or die "cannot run $args[0]\n";
+        }
+
+        # Heartbeat until the run ends, or stop it if the lease is lost
+        my $beat = time();
+        my $lost = 0;
+        while (waitpid($pid, WNOHANG) == 0)
+        {
+            if (!-e $leased)
+            {
+                kill("TERM", $pid);
+                waitpid($pid, 0);
+                $lost = 1;
+                last;
+            }
+            if (time() - $beat >= $lease / 3)
+            {
+                utime(undef, undef, $leased);
+                $beat = time();
+            }
+            sleep(1);
+        }
+        my $status = $?;
+
+        if ($lost)
+        {
+            print STDERR "$id lost the lease of $name\n";
+            remove_tree($work);
+        }
+        elsif ($status == 0)
+        {
+            # Commit; a run of the job that committed first wins
+            if (!rename($work, "$queue/done/$name"))
+            {
+                remove_tree($work);
+            }
+            unlink($leased);
+        }
+        else
+        {
+            $job->[4]++;
+            print STDERR "$id failed $name, status $status, attempt "
+                         . "$job->[4]\n";
+            remove_tree($work);
+            write_job($leased, $job);
+            my $state = ($job->[4] >= $max) ? "failed" : "todo";
+            rename($leased, "$queue/$state/$name");
+        }
+    }
+}
+
+sub status
+{
+    my ($queue) = @_;
+
+    usage() if (!defined($queue));
+    for my $state ("todo", "leased", "done", "failed")
+    {
+        printf("%-7s %d\n", $state, scalar(entries("$queue/$state")));
+    }
+    for my $name (entries("$queue/failed"))
+    {
+        print "failed $name\n";
+    }
+}
+
+sub merge
+{
+    my ($queue, $out) = @_;
+
+    usage() if (!defined($out));
+    make_path($out);
+    for my $name (entries("$queue/done"))
+    {
+        for my $file (entries("$queue/done/$name"))
+        {
+            open(my $in, "<:raw", "$queue/done/$name/$file")
+                or die "cannot open $queue/done/$name/$file\n";
+            open(my $fh, ">>:raw", "$out/$file")
+                or die "cannot open $out/$file\n";
+            local $/ = \65536;
+            while (my $buf = <$in>)
+            {
+                print $fh $buf;
+            }
+            close($in);
+            close($fh) or die "cannot write $out/$file\n";
+        }
+    }
+}
+
+my $cmd = shift(@ARGV) // usage();
+if ($cmd eq "init")
+{
+    init(@ARGV);
+}
+elsif ($cmd eq "worker")
+{
+    my $queue = shift(@ARGV);
+    worker($queue, @ARGV);
+}
+elsif ($cmd eq "status")
+{
+    status(@ARGV);
+}
+elsif ($cmd eq "merge")
+{
+    merge(@ARGV);
+}
+else
+{
+    usage();
+}
@@ -0,0 +1,126 @@
+#!/usr/bin/perl
+
+# ######################################################################
+#
+# Name: scheduleCost.pl
+#
+# Description:
+# Splits the pixels of a tile into jobs of about the same predicted
+# run time, instead of the same number of pixels.  The cost records of
+# the pixels come from a ccdc --cost-only pass (reading only, no change
+# detection), one line per pixel in cost.txt:
+#
+#   row col path valid clr water snow all usec
+#
+# and the model from calibrateCost.pl, one "path a b c records" line
+# per path.  The predicted cost of a pixel is a + b * n + c * n * n,
+# with n the observations its path works on (see calibrateCost.pl).
+# Without a model file every path costs n.
+#
+# The pixels are dealt heaviest first, each to the job with the least
+# predicted cost so far (longest processing time first), so the jobs
+# end at about the same time and the slowest pixels of a tile do not
+# all land in its last job.  The output is one line per pixel,
+#
+#   job row col cost
+#
+# in the order the jobs should run them, heaviest first; the predicted
+# total of each job is printed to stderr.  For example, job 3 runs
+#
+#   awk '$1 == 3 {print $2, $3}' jobs.txt |
+#       while read r c; do ccdc --row=$r --col=$c ...; done
+#
+# Usage:
+#   scheduleCost.pl <cost file> <jobs> [<model file>]
+#
+# ######################################################################
+
+use strict;
+use warnings;
+
+die "usage: $0 <cost file> <jobs> [<model file>]\n" if (@ARGV < 2);
+my ($file, $jobs, $model_file) = @ARGV;
+die "jobs must be > 0\n" if ($jobs < 1);
+
+# Observations a path works on, as in calibrateCost.pl
+sub path_obs
+{
+    my ($path, $valid, $clr, $snow) = @_;
+
+    return $clr if ($path eq "full");
+    return $clr + $snow if ($path eq "snow");
+    return $valid;
+}
+
+my %model;
+if (defined($model_file))
+{
+    open(my $fh, "<", $model_file) or die "cannot open $model_file\n";
+    while (my $line = <$fh>)
+    {
+        my @v = split(' ', $line);
+        next if (@v != 5);
+        $model{$v[0]} = [@v[1 .. 3]];
+    }
+    close($fh);
+}
+
+my @pixels;
+open(my $fh, "<", $file) or die "cannot open $file\n";
+while (my $line = <$fh>)
+{
+    my @v = split(' ', $line);
+    next if (@v != 9);
+    my $n = path_obs($v[2], $v[3], $v[4], $v[6]);
+    my ($a, $b, $c) = @{$model{$v[2]} // [0, 1, 0]};
+    my $cost = $a + $b * $n + $c * $n * $n;
+    $cost = 0 if ($cost < 0);
+    push(@pixels, {row => $v[0], col => $v[1], cost => $cost});
+}
+close($fh);
+
+@pixels = sort { $b->{cost} <=> $a->{cost} || $a->{row} <=> $b->{row}
+                 || $a->{col} <=> $b->{col} } @pixels;
+
+# Jobs in a binary min-heap on their predicted cost, ties to the lowest
+# job number
+my @load = (0) x $jobs;
+my @heap = (0 .. $jobs - 1);
+
+sub lighter
+{
+    my ($i, $j) = @_;
+
+    return ($load[$i] < $load[$j] || ($load[$i] == $load[$j] && $i < $j));
+}
+
+sub sift_down
+{
+    my $k = 0;
+
+    while (1)
+    {
+        my $m = $k;
+        for my $child (2 * $k + 1, 2 * $k + 2)
+        {
+            $m = $child if ($child < $jobs && lighter($heap[$child], $heap[$m]));
+        }
+        last if ($m == $k);
+        @heap[$k, $m] = @heap[$m, $k];
+        $k = $m;
+    }
+}
+
+for my $p (@pixels)
+{
+    my $job = $heap[0];
+
+    printf("%d %d %d %g\n", $job, $p->{row}, $p->{col}, $p->{cost});
+    $load[$job] += $p->{cost};
+    sift_down();
+}
+
+for my $job (0 .. $jobs - 1)
+{
+    printf(STDERR "job %d predicted %g\n", $job, $load[$job]);
+}
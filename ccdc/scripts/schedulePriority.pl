@@ -0,0 +1,86 @@
+#!/usr/bin/perl
+
+# ######################################################################
+#
+# Name: schedulePriority.pl
+#
+# Description:
+# Orders the full resolution pixels of a tile from the results of a
+# ccdc screening pass (--screen-cell=<n>).  Each line of the
+# priority.txt file written by the screening runs is
+#
+#   row col cell breaks
+#
+# for the cell x cell block whose upper left pixel is row, col.  The
+# pixels of the cells with the most breaks come first, cells with the
+# same number of breaks in row then col order, and the pixels no cell
+# covered come last, in row then col order.  Every pixel of the tile is
+# listed exactly once, so running ccdc on all of them in this order
+# gives the same output as any other order; only the areas of change
+# are processed earlier.
+#
+# Usage:
+#   schedulePriority.pl <priority file> <lines> <samples> [<first index>]
+#
+# The first index is 0 for tifs input and 1 for bip input (default 0).
+# The output is one "row col" line per pixel, for example to feed
+#
+#   while read r c; do ccdc --row=$r --col=$c ...; done
+#
+# ######################################################################
+
+use strict;
+use warnings;
+
+die "usage: $0 <priority file> <lines> <samples> [<first index>]\n"
+    if (@ARGV < 3);
+my ($file, $lines, $samples, $first) = @ARGV;
+$first = 0 if (!defined($first));
+
+my @cells;
+open(my $fh, "<", $file) or die "cannot open $file\n";
+while (my $line = <$fh>)
+{
+    my @v = split(' ', $line);
+    next if (@v != 4);
+    push(@cells, {row => $v[0], col => $v[1], cell => $v[2],
+                  breaks => $v[3]});
+}
+close($fh);
+
+@cells = sort { $b->{breaks} <=> $a->{breaks} || $a->{row} <=> $b->{row}
+                || $a->{col} <=> $b->{col} } @cells;
+
+# Pixels already listed, one bit per pixel
+my $done = "";
+
+sub emit
+{
+    my ($row, $col) = @_;
+    my $n = ($row - $first) * $samples + ($col - $first);
+
+    return if (vec($done, $n, 1));
+    vec($done, $n, 1) = 1;
+    print "$row $col\n";
+}
+
+for my $c (@cells)
+{
+    for my $row ($c->{row} .. $c->{row} + $c->{cell} - 1)
+    {
+        next if ($row < $first || $row >= $lines + $first);
+        for my $col ($c->{col} .. $c->{col} + $c->{cell} - 1)
+        {
+            next if ($col < $first || $col >= $samples + $first);
+            emit($row, $col);
+        }
+    }
+}
+
+for my $row ($first .. $lines + $first - 1)
+{
+    for my $col ($first .. $samples + $first - 1)
+    {
+        emit($row, $col);
+    }
+}
@@ -0,0 +1,199 @@
+#!/usr/bin/perl
+
+# ######################################################################
+#
+# Name: tuneCcdc.pl
+#
+# Description:
+# Picks the thread count, read-ahead (the pixels in flight, which is
+# the depth of the reads queued ahead of the change detection) and block
+# size of ccdc for the node it runs on, the storage of the tile and its
+# number of scenes, by timing short block runs on a sample of the tile.
+# The sweep is one knob at a time, each at the best value of the ones
+# before:
+#
+#   threads     at the default read-ahead and the first block size
+#   read-ahead  at the best threads
+#   block size  at the best threads and read-ahead, the blocks all of
+#               about --pixels pixels
+#
+# Every run reads another area of the tile, down from --row, --col, so
+# that it is not timed on the pages the one before left in the cache;
+# after the last line it starts again from --row, with a warning.
+# The rate of each run, in pixels per second, is printed to stderr,
+# and the best values written to the profile as "name value" lines:
+#
+#   threads <n>
+#   read-ahead <n>
+#   block-rows <n>
+#   block-cols <n>
+#   pixels-per-sec <rate>
+#
+# By default the profile is tune_<host name>.txt in the in-path of the
+# command, where ccdc runs on that node read it for --threads and
+# --read-ahead when they are not given (see --tune-profile).  The block
+# size is for the jobs, for example
+#
+#   jobQueue.pl init <queue> <lines> <samples> <block-rows> <block-cols>
+#
+# Usage:
+#   tuneCcdc.pl --lines=<n> --samples=<n> [--first=<index>] [--row=<n>]
+#               [--col=<n>] [--pixels=<n>] [--threads=<list>]
+#               [--read-ahead=<list>] [--blocks=<list>] [--repeat=<n>]
+#               [--out=<profile>]
+#               -- <ccdc command and args>
+#       The lists are comma separated, blocks as <rows>x<cols>.  The
+#       command gets --row, --col, --block-rows, --block-cols,
+#       --threads, --read-ahead and --out-path appended; give it
+#       --in-path and --data-type.  The first index is 0 for tifs input
+#       and 1 for bip input (default 0), and --row and --col default to
+#       it.
+#
+# ######################################################################
+
+use strict;
+use warnings;
+use Getopt::Long;
+use Sys::Hostname;
+use File::Temp qw(tempdir);
+use File::Path qw(remove_tree);
+use POSIX qw(floor);
+use Time::HiRes qw(time);
+
+sub usage
+{
+    die "usage: $0 --lines=<n> --samples=<n> [--first=<index>] [--row=<n>] "
+        . "[--col=<n>] [--pixels=<n>] [--threads=<list>] "
+        . "[--read-ahead=<list>] [--blocks=<list>] [--repeat=<n>] "
+        . "[--out=<profile>] "
+        . "-- <ccdc command>\n";
+}
+
+my $cores = `getconf _NPROCESSORS_ONLN 2>/dev/null` || 1;
+chomp($cores);
+my @threads = grep { $_ <= $cores } (1, 2, 4, 8, 16, 32, 64);
+push(@threads, $cores) if ($threads[-1] != $cores);
+
+my ($lines, $samples, $row, $col);
+my $first = 0;
+my $pixels = 64;
+my $thread_list = join(",", @threads);
+my $ahead_list = "0,1,4,16,64";
+my $block_list;
+my $repeat = 1;
+my $out;
+GetOptions("lines=i" => \$lines, "samples=i" => \$samples,
+           "first=i" => \$first, "row=i" => \$row, "col=i" => \$col,
+           "pixels=i" => \$pixels,
+           "threads=s" => \$thread_list, "read-ahead=s" => \$ahead_list,
+           "blocks=s" => \$block_list, "repeat=i" => \$repeat,
+           "out=s" => \$out) or usage();
+my @cmd = @ARGV;
+usage() if (!defined($lines) || !defined($samples) || @cmd == 0);
+$row //= $first;
+$col //= $first;
+die "pixels and repeat must be > 0\n" if ($pixels < 1 || $repeat < 1);
+
+# Blocks of about $pixels pixels, from one line to as square as it gets
+if (!defined($block_list))
+{
+    my @b;
+    for (my $r = 1; $r * $r <= $pixels; $r *= 2)
+    {
+        push(@b, sprintf("%dx%d", $r, floor($pixels / $r)));
+    }
+    $block_list = join(",", @b);
+}
+my @blocks = map { [split(/x/)] } split(/,/, $block_list);
+for my $block (@blocks)
+{
+    my ($r, $c) = @$block;
+
+    die "bad block in $block_list\n" if (@$block != 2 || $r < 1 || $c < 1);
+    die "block ${r}x$c does not fit in the tile at $row, $col\n"
+        if ($row + $r > $lines + $first || $col + $c > $samples + $first);
+}
+
+if (!defined($out))
+{
+    my ($in) = map { /^--in-path=(.*)$/ ? $1 : () } @cmd;
+    $out = ($in // ".") . "/tune_" . hostname() . ".txt";
+}
+
+my $work = tempdir("tuneCcdc.XXXXXX", TMPDIR => 1, CLEANUP => 1);
+my $next_row = $row;
+my $runs = 0;
+
+# Time a block run at the next area of the tile; its pixels per second
+sub run
+{
+    my ($t, $ra, $block) = @_;
+    my ($r, $c) = @$block;
+
+    if ($next_row + $r > $lines + $first)
+    {
+        print STDERR "out of fresh lines, timing cached pixels again\n";
+        $next_row = $row;
+    }
+    my $dir = "$work/run" . $runs++;
+    mkdir($dir) or die "cannot create $dir\n";
+
+    my $start = time();
+    my $status = system(@cmd, "--row=$next_row", "--col=$col",
+                        "--block-rows=$r", "--block-cols=$c",
+                        "--threads=$t", "--read-ahead=$ra",
+                        "--out-path=$dir");
+    my $sec = time() - $start;
+    die "$cmd[0] failed, status $status\n" if ($status != 0);
+    $next_row += $r;
+    remove_tree($dir);
+
+    return $r * $c / (($sec > 0) ? $sec : 1e-6);
+}
+
+# Median rate of $repeat runs of a setting, printed
+sub rate
+{
+    my ($t, $ra, $block) = @_;
+    my @rates = sort { $a <=> $b } map { run($t, $ra, $block) }
+                (1 .. $repeat);
+    my $rate = $rates[floor($#rates / 2)];
+
+    printf(STDERR "threads %d read-ahead %d block %dx%d: %.2f pixels/sec\n",
+           $t, $ra, @$block, $rate);
+
+    return $rate;
+}
+
+# The value of a list with the best rate, the rest of the setting fixed
+sub best
+{
+    my ($values, $setting) = @_;
+    my ($best, $best_rate);
+
+    for my $v (@$values)
+    {
+        my $rate = rate($setting->($v));
+        ($best, $best_rate) = ($v, $rate)
+            if (!defined($best_rate) || $rate > $best_rate);
+    }
+
+    return ($best, $best_rate);
+}
+
+my ($t) = best([split(/,/, $thread_list)],
+               sub { ($_[0], 0, $blocks[0]) });
+my ($ra) = best([split(/,/, $ahead_list)],
+                sub { ($t, $_[0], $blocks[0]) });
+my ($block, $rate) = best(\@blocks, sub { ($t, $ra, $_[0]) });
+
+open(my $fh, ">", $out) or die "cannot write $out\n";
+printf($fh "# ccdc tuning profile of %s, %s\n", hostname(),
+       scalar(localtime()));
+print $fh "threads $t\n";
+print $fh "read-ahead $ra\n";
+print $fh "block-rows $block->[0]\n";
+print $fh "block-cols $block->[1]\n";
+printf($fh "pixels-per-sec %.2f\n", $rate);
+close($fh) or die "cannot write $out\n";
+print STDERR "wrote $out\n";
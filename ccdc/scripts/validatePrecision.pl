@@ -0,0 +1,132 @@
+#!/usr/bin/perl
+
+# ######################################################################
+#
+# Name: validatePrecision.pl
+#
+# Description:
+# Validation of the single precision mode of ccdc.  Runs ccdc on each
+# pixel of a corpus with --precision=double and --precision=single and
+# compares the two output.bin files, reporting per pixel the curves
+# whose number, start, end or break dates differ, and the largest
+# coefficient and rmse differences.  A summary over the corpus ends the
+# report.
+#
+# Usage:
+#   validatePrecision.pl <ccdc executable> <pixel file> [<pixel file>...]
+#
+# Each pixel file is the text input of one pixel as read with
+# --in-path=stdin.  Pixel n of the list is run as --row=n so that its
+# curves can be told apart in output.bin.  Extra ccdc options can be
+# given in the CCDC_OPTS environment variable.
+#
+# ######################################################################
+
+use strict;
+use warnings;
+use File::Temp qw(tempdir);
+
+# Output_t as written by ccdc: t_start, t_end, t_break, coefs[7][8],
+# rmse[7], pos.row, pos.col, change_prob, num_obs, category, magnitude[7]
+my $NUM_BANDS  = 7;
+my $NUM_COEFFS = 8;
+my $REC_FORMAT = "l3 f56 f7 l2 f l2 f7";
+my $REC_SIZE   = 312;
+
+die "usage: $0 <ccdc executable> <pixel file> [<pixel file>...]\n"
+    if (@ARGV < 2);
+my ($ccdc, @pixels) = @ARGV;
+my $opts = defined($ENV{CCDC_OPTS}) ? $ENV{CCDC_OPTS} : "";
+
+my %dir = (double => tempdir(CLEANUP => 1), single => tempdir(CLEANUP => 1));
+
+for my $n (0 .. $#pixels)
+{
+    for my $precision ("double", "single")
+    {
+        my $cmd = "$ccdc --row=$n --col=0 --in-path=stdin"
+                . " --out-path=$dir{$precision} --precision=$precision"
+                . " $opts < $pixels[$n] > /dev/null";
+        system($cmd) == 0
+            or die "ccdc failed on $pixels[$n] ($precision)\n";
+    }
+}
+
+# Curves of each pixel, in output order
+sub read_curves
+{
+    my ($file) = @_;
+    my %curves;
+    my $buf;
+
+    open(my $fh, "<", $file) or die "cannot open $file\n";
+    binmode($fh);
+    while (read($fh, $buf, $REC_SIZE) == $REC_SIZE)
+    {
+        my @v = unpack($REC_FORMAT, $buf);
+        my %c;
+        @c{qw(t_start t_end t_break)} = @v[0 .. 2];
+        $c{coefs} = [@v[3 .. 58]];
+        $c{rmse} = [@v[59 .. 65]];
+        $c{row} = $v[66];
+        push(@{$curves{$c{row}}}, \%c);
+    }
+    close($fh);
+
+    return \%curves;
+}
+
+my $dbl = read_curves("$dir{double}/output.bin");
+my $sgl = read_curves("$dir{single}/output.bin");
+
+my ($num_curves, $num_count_diff, $num_date_diff) = (0, 0, 0);
+my ($max_break_diff, $max_coef_diff, $max_rmse_diff) = (0, 0, 0);
+
+for my $n (0 .. $#pixels)
+{
+    my @d = @{$dbl->{$n} || []};
+    my @s = @{$sgl->{$n} || []};
+
+    if (@d != @s)
+    {
+        printf("%s: %d curves in double, %d in single\n",
+               $pixels[$n], scalar(@d), scalar(@s));
+        $num_count_diff++;
+    }
+
+    for my $k (0 .. (@d < @s ? $#d : $#s))
+    {
+        my ($cd, $cs) = ($d[$k], $s[$k]);
+        $num_curves++;
+
+        if ($cd->{t_start} != $cs->{t_start} || $cd->{t_end} != $cs->{t_end}
+            || $cd->{t_break} != $cs->{t_break})
+        {
+            printf("%s: curve %d dates %d %d %d (double) %d %d %d (single)\n",
+                   $pixels[$n], $k, $cd->{t_start}, $cd->{t_end},
+                   $cd->{t_break}, $cs->{t_start}, $cs->{t_end},
+                   $cs->{t_break});
+            $num_date_diff++;
+            my $diff = abs($cd->{t_break} - $cs->{t_break});
+            $max_break_diff = $diff if ($diff > $max_break_diff);
+        }
+
+        for my $i (0 .. $NUM_BANDS * $NUM_COEFFS - 1)
+        {
+            my $diff = abs($cd->{coefs}[$i] - $cs->{coefs}[$i]);
+            $max_coef_diff = $diff if ($diff > $max_coef_diff);
+        }
+        for my $i (0 .. $NUM_BANDS - 1)
+        {
+            my $diff = abs($cd->{rmse}[$i] - $cs->{rmse}[$i]);
+            $max_rmse_diff = $diff if ($diff > $max_rmse_diff);
+        }
+    }
+}
+
+printf("pixels %d, curves compared %d\n", scalar(@pixels), $num_curves);
+printf("pixels with a different number of curves %d\n", $num_count_diff);
+printf("curves with different dates %d, largest break date difference %d"
+       . " days\n", $num_date_diff, $max_break_diff);
+printf("largest coefficient difference %g, largest rmse difference %g\n",
+       $max_coef_diff, $max_rmse_diff);
@@ -0,0 +1,130 @@
+#!/usr/bin/perl
+
+# ######################################################################
+#
+# Name: validateSweep.pl
+#
+# Description:
+# Validation of the --sweep-file mode of ccdc.  Runs ccdc on each pixel
+# of a corpus with every parameter set of a sweep in one run, then with
+# each set alone, and checks that every run succeeds and that set n of
+# the sweep writes the same records as the set run on its own (a sweep
+# of one set writes output.bin, like a run without --sweep-file).
+# A summary over the corpus ends the report; the exit status is 1 if
+# any run failed or any output differs.
+#
+# Usage:
+#   validateSweep.pl <ccdc executable> <pixel file> [<pixel file>...]
+#
+# Each pixel file is the text input of one pixel as read with
+# --in-path=stdin.  The sweep is read from the file named by the
+# SWEEP_FILE environment variable, or is the built-in one below.  Extra
+# ccdc options can be given in the CCDC_OPTS environment variable.
+#
+# ######################################################################
+
+use strict;
+use warnings;
+use File::Compare qw(compare);
+use File::Temp qw(tempdir);
+
+# t_cg t_max_cg conse lambda n_times min_num_c.  The defaults, then sets
+# at the edges of what read_sweep_file accepts: conse 8 with min_num_c 6
+# ends some series on a window of one repeated date, and conse below the
+# largest of the sweep runs on window buffers wider than it.  A lambda
+# near 0 is left out: glmnet need not converge without the penalty.
+my @BUILTIN_SETS = (
+    "15.0863 35.8882 6 20 3 4",
+    "11.0705 35.8882 8 20 3 4",
+    "15.0863 35.8882 8 20 3 6",
+    "15.0863 35.8882 12 20 3 6",
+    "15.0863 35.8882 12 20 3 4",
+    "15.0863 35.8882 4 1 1 4",
+);
+
+die "usage: $0 <ccdc executable> <pixel file> [<pixel file>...]\n"
+    if (@ARGV < 2);
+my ($ccdc, @pixels) = @ARGV;
+my $opts = defined($ENV{CCDC_OPTS}) ? $ENV{CCDC_OPTS} : "";
+
+my @sets;
+if (defined($ENV{SWEEP_FILE}))
+{
+    open(my $fh, "<", $ENV{SWEEP_FILE})
+        or die "cannot open $ENV{SWEEP_FILE}\n";
+    @sets = grep { !/^\s*(#|$)/ } <$fh>;
+    close($fh);
+    chomp(@sets);
+}
+else
+{
+    @sets = @BUILTIN_SETS;
+}
+die "no parameter set\n" if (@sets == 0);
+
+my $tmp = tempdir(CLEANUP => 1);
+
+# Runs ccdc on a pixel with the given sets, returns the output directory
+# or undef if ccdc failed
+sub run_sets
+{
+    my ($pixel, $name, @run_sets) = @_;
+    my $dir = "$tmp/$name";
+    my $sweep = "$tmp/$name.txt";
+
+    mkdir($dir) or die "cannot create $dir\n";
+    open(my $fh, ">", $sweep) or die "cannot create $sweep\n";
+    print $fh map { "$_\n" } @run_sets;
+    close($fh);
+
+    my $cmd = "$ccdc --row=0 --col=0 --in-path=stdin --out-path=$dir"
+            . " --sweep-file=$sweep $opts < $pixel > /dev/null 2>&1";
+
+    return (system($cmd) == 0) ? $dir : undef;
+}
+
+my ($num_runs, $num_failed, $num_diff) = (0, 0, 0);
+
+for my $n (0 .. $#pixels)
+{
+    my $all = run_sets($pixels[$n], "p${n}_all", @sets);
+    $num_runs++;
+    if (!defined($all))
+    {
+        printf("%s: ccdc failed on the whole sweep\n", $pixels[$n]);
+        $num_failed++;
+    }
+
+    for my $k (0 .. $#sets)
+    {
+        my $one = run_sets($pixels[$n], "p${n}_$k", $sets[$k]);
+        $num_runs++;
+        if (!defined($one))
+        {
+            printf("%s: ccdc failed on set %d (%s)\n", $pixels[$n], $k,
+                   $sets[$k]);
+            $num_failed++;
+            next;
+        }
+        next if (!defined($all));
+
+        # No curve writes no file; both runs must agree on that too
+        my $a = (@sets > 1) ? "$all/output_$k.bin" : "$all/output.bin";
+        my $b = "$one/output.bin";
+        my $same = (-e $a || -e $b) ? (-e $a && -e $b && compare($a, $b) == 0)
+                                    : 1;
+        if (!$same)
+        {
+            printf("%s: set %d (%s) differs from its own run\n",
+                   $pixels[$n], $k, $sets[$k]);
+            $num_diff++;
+        }
+    }
+}
+
+printf("pixels %d, sets %d, runs %d\n", scalar(@pixels), scalar(@sets),
+       $num_runs);
+printf("failed runs %d, sets differing from their own run %d\n",
+       $num_failed, $num_diff);
+
+exit(($num_failed == 0 && $num_diff == 0) ? 0 : 1);
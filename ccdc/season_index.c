@@ -0,0 +1,293 @@
+#include <stdlib.h>
+#include <stdbool.h>
+#include <math.h>
+
+#include "const.h"
+#include "utilities.h"
+#include "season_index.h"
+#include "defines.h"
+
+
+/******************************************************************************
+MODULE:  season_dist
+
+PURPOSE:  Distance in days between the day of year of two dates
+
+RETURN VALUE:
+Type = float
+Value           Description
+-----           -----------
+dist            days to the closest date with the same day of year
+
+NOTES: Same expression as the d_yr used for the temporary RMSE.  For integer
+       dates the result is exact, a multiple of a quarter day.
+******************************************************************************/
+static float season_dist
+(
+    int date,               /* I: date of the observation                   */
+    int ref_date            /* I: date to be compared with                  */
+)
+{
+    int d_rt = date - ref_date;
+
+    return fabs(round((float)d_rt / NUM_YEARS) * NUM_YEARS - (float)d_rt);
+}
+
+
+/******************************************************************************
+MODULE:  compare_entry
+
+PURPOSE:  qsort order of the index entries: day of year, then fit index
+
+RETURN VALUE:
+Type = int
+Value           Description
+-----           -----------
+-1, 0, 1        a before, equal to or after b
+******************************************************************************/
+static int compare_entry
+(
+    const void *a,
+    const void *b
+)
+{
+    const Season_entry_t *ea = a;
+    const Season_entry_t *eb = b;
+
+    if (ea->phase != eb->phase)
+        return (ea->phase < eb->phase) ? -1 : 1;
+    return (ea->m > eb->m) - (ea->m < eb->m);
+}
+
+
+/******************************************************************************
+MODULE:  season_index_alloc
+
+PURPOSE:  Allocate a season index for up to capacity fit observations
+
+RETURN VALUE:
+Type = int
+ERROR error in allocating memories
+SUCCESS no error encounted
+******************************************************************************/
+int season_index_alloc
+(
+    int capacity,           /* I: largest number of fit observations        */
+    Season_index_t *index   /* O: season index                              */
+)
+{
+    char FUNC_NAME[] = "season_index_alloc";
+
+    index->capacity = capacity;
+    index->num = 0;
+    index->date = malloc(capacity * sizeof(int));
+    index->entry = malloc(capacity * sizeof(Season_entry_t));
+    index->cand = malloc(capacity * sizeof(int));
+    index->cand_dist = malloc(capacity * sizeof(float));
+    if (index->date == NULL || index->entry == NULL || index->cand == NULL ||
+        index->cand_dist == NULL)
+    {
+        season_index_free(index);
+        RETURN_ERROR ("Allocating season index memory", FUNC_NAME, ERROR);
+    }
+
+    return (SUCCESS);
+}
+
+
+/******************************************************************************
+MODULE:  season_index_build
+
+PURPOSE:  Index the observations of a new fit by day of year
+
+RETURN VALUE: None
+
+NOTES: The fit index m of an observation is its position in ids, which is
+       also its index in the residuals (rec_v_dif) of the fit.
+******************************************************************************/
+void season_index_build
+(
+    Season_index_t *index,  /* I/O: season index                            */
+    const Obs_store_t *obs, /* I: clear observations                        */
+    const int *ids,         /* I: positions of the fit observations         */
+    int num                 /* I: number of fit observations                */
+)
+{
+    int m;
+
+    index->num = num;
+    for (m = 0; m < num; m++)
+    {
+        index->date[m] = OBS_T(obs, ids[m]);
+        index->entry[m].phase = fmod((double)index->date[m], NUM_YEARS);
+        index->entry[m].m = m;
+    }
+
+    qsort(index->entry, num, sizeof(Season_entry_t), compare_entry);
+}
+
+
+/******************************************************************************
+MODULE:  season_index_closest
+
+PURPOSE:  Select the n fit observations closest in day of year to a date
+
+RETURN VALUE:
+Type = int
+Value           Description
+-----           -----------
+n_sel           number of selected observations, min(n, indexed number)
+
+NOTES: The day of year of ref_date splits the year circle; the entries after
+       it (up to half a year ahead) and before it (less than half a year
+       back) are two runs of increasing distance, which are merged until n
+       candidates and all the ties of the last one are found.  The
+       candidates are then ordered by distance and fit index, as a stable
+       sort of all the distances would order them.
+******************************************************************************/
+int season_index_closest
+(
+    Season_index_t *index,  /* I/O: season index (candidate scratch)        */
+    int ref_date,           /* I: date to be compared with                  */
+    int n,                  /* I: number of observations wanted             */
+    int *sel                /* O: fit indices, closest in season first      */
+)
+{
+    int num = index->num;
+    int lo, hi, mid;
+    int right, left;        /* next entry of the forward and backward run   */
+    int n_right, n_left;    /* entries taken from each run                  */
+    int n_cand = 0;
+    int k, j;
+    int cm;
+    float cd;
+    float d_right, d_left;
+    double q;               /* day of year of ref_date                      */
+    double f;               /* forward offset of an entry from q            */
+    bool use_right, use_left;
+
+    if (num <= 0)
+        return 0;
+    n = min(n, num);
+
+    /******************************************************************/
+    /*                                                                */
+    /* First entry on or after the day of year of ref_date.           */
+    /*                                                                */
+    /******************************************************************/
+
+    q = fmod((double)ref_date, NUM_YEARS);
+    lo = 0;
+    hi = num;
+    while (lo < hi)
+    {
+        mid = (lo + hi) / 2;
+        if (index->entry[mid].phase < q)
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+    right = lo % num;
+    left = (lo + num - 1) % num;
+    n_right = 0;
+    n_left = 0;
+
+    while (n_right + n_left < num)
+    {
+        f = index->entry[right].phase - q;
+        if (f < 0.0)
+            f += NUM_YEARS;
+        use_right = (n_right < num && f <= NUM_YEARS / 2.0);
+        f = index->entry[left].phase - q;
+        if (f < 0.0)
+            f += NUM_YEARS;
+        use_left = (n_left < num && f > NUM_YEARS / 2.0);
+        if (!use_right && !use_left)
+            break;
+
+        d_right = use_right ?
+            season_dist(index->date[index->entry[right].m], ref_date) : 0.0;
+        d_left = use_left ?
+            season_dist(index->date[index->entry[left].m], ref_date) : 0.0;
+        if (use_right && use_left)
+        {
+            if (d_left < d_right)
+                use_right = false;
+            else
+                use_left = false;
+        }
+        cd = use_right ? d_right : d_left;
+
+        /**************************************************************/
+        /*                                                            */
+        /* Stop once n are found and the next one is farther.         */
+        /*                                                            */
+        /**************************************************************/
+
+        if (n_cand >= n && cd > index->cand_dist[n_cand - 1])
+            break;
+
+        if (use_right)
+        {
+            index->cand[n_cand] = index->entry[right].m;
+            right = (right + 1) % num;
+            n_right++;
+        }
+        else
+        {
+            index->cand[n_cand] = index->entry[left].m;
+            left = (left + num - 1) % num;
+            n_left++;
+        }
+        index->cand_dist[n_cand] = cd;
+        n_cand++;
+    }
+
+    /******************************************************************/
+    /*                                                                */
+    /* Order the (few) candidates by distance, then fit index.        */
+    /*                                                                */
+    /******************************************************************/
+
+    for (k = 1; k < n_cand; k++)
+    {
+        cm = index->cand[k];
+        cd = index->cand_dist[k];
+        for (j = k - 1; j >= 0 && (index->cand_dist[j] > cd ||
+             (index->cand_dist[j] == cd && index->cand[j] > cm)); j--)
+        {
+            index->cand[j + 1] = index->cand[j];
+            index->cand_dist[j + 1] = index->cand_dist[j];
+        }
+        index->cand[j + 1] = cm;
+        index->cand_dist[j + 1] = cd;
+    }
+
+    for (k = 0; k < n; k++)
+        sel[k] = index->cand[k];
+
+    return n;
+}
+
+
+/******************************************************************************
+MODULE:  season_index_free
+
+PURPOSE:  Release the memory of a season index
+
+RETURN VALUE: None
+******************************************************************************/
+void season_index_free
+(
+    Season_index_t *index   /* I/O: season index                            */
+)
+{
+    free(index->date);
+    index->date = NULL;
+    free(index->entry);
+    index->entry = NULL;
+    free(index->cand);
+    index->cand = NULL;
+    free(index->cand_dist);
+    index->cand_dist = NULL;
+}
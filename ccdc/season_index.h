@@ -0,0 +1,55 @@
+#ifndef SEASON_INDEX_H
+#define SEASON_INDEX_H
+
+
+#include "obs_store.h"
+
+/* Day-of-year index of the observations of the current fit, used to pick */
+/* the residuals closest in season to the monitored observation for the   */
+/* temporary RMSE.  It is built when the fit changes; each monitoring     */
+/* step then binary searches the reference day of year and walks outward  */
+/* on the year circle, instead of sorting every residual of every band.   */
+typedef struct
+{
+    double phase;         /* day of year of the date, [0, NUM_YEARS)        */
+    int m;                /* fit index of the observation                   */
+} Season_entry_t;
+
+typedef struct
+{
+    int capacity;         /* number of observations the index can hold      */
+    int num;              /* number of indexed observations                 */
+    int *date;            /* [m] date of the m-th fit observation           */
+    Season_entry_t *entry;/* fit observations sorted by day of year         */
+    int *cand;            /* candidate fit indices of a query               */
+    float *cand_dist;     /* seasonal distance of each candidate            */
+} Season_index_t;
+
+int season_index_alloc
+(
+    int capacity,           /* I: largest number of fit observations        */
+    Season_index_t *index   /* O: season index                              */
+);
+
+void season_index_build
+(
+    Season_index_t *index,  /* I/O: season index                            */
+    const Obs_store_t *obs, /* I: clear observations                        */
+    const int *ids,         /* I: positions of the fit observations         */
+    int num                 /* I: number of fit observations                */
+);
+
+int season_index_closest
+(
+    Season_index_t *index,  /* I/O: season index (candidate scratch)        */
+    int ref_date,           /* I: date to be compared with                  */
+    int n,                  /* I: number of observations wanted             */
+    int *sel                /* O: fit indices, closest in season first      */
+);
+
+void season_index_free
+(
+    Season_index_t *index   /* I/O: season index                            */
+);
+
+#endif /* SEASON_INDEX_H */
@@ -0,0 +1,462 @@
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+
+#include "sort.h"
+
+
+#define SORT_SWAP(type, x, y) do { type t_ = (x); (x) = (y); (y) = t_; } while (0)
+
+/* Introsort of the values of one type.  Only < is used, so NaNs (never   */
+/* less than anything) end up wherever the partitions leave them, as with */
+/* the quicksorts this replaces.                                          */
+#define DEFINE_INTROSORT(name, type) \
+static void name##_insertion(type *a, int n) \
+{ \
+    int i, j; \
+    type v; \
+    for (i = 1; i < n; i++) \
+    { \
+        v = a[i]; \
+        for (j = i; j > 0 && v < a[j - 1]; j--) \
+            a[j] = a[j - 1]; \
+        a[j] = v; \
+    } \
+} \
+static void name##_sift(type *a, int root, int n) \
+{ \
+    int child; \
+    type v = a[root]; \
+    while ((child = 2 * root + 1) < n) \
+    { \
+        if (child + 1 < n && a[child] < a[child + 1]) \
+            child++; \
+        if (!(v < a[child])) \
+            break; \
+        a[root] = a[child]; \
+        root = child; \
+    } \
+    a[root] = v; \
+} \
+static void name##_heapsort(type *a, int n) \
+{ \
+    int i; \
+    for (i = n / 2 - 1; i >= 0; i--) \
+        name##_sift(a, i, n); \
+    for (i = n - 1; i > 0; i--) \
+    { \
+        SORT_SWAP(type, a[0], a[i]); \
+        name##_sift(a, 0, i); \
+    } \
+} \
+static void name(type *a, int n, int depth) \
+{ \
+    int i, j, mid; \
+    type pivot; \
+    while (n > SORT_INSERTION_MAX) \
+    { \
+        if (depth-- == 0) \
+        { \
+            name##_heapsort(a, n); \
+            return; \
+        } \
+        mid = (n - 1) / 2; \
+        if (a[mid] < a[0]) \
+            SORT_SWAP(type, a[0], a[mid]); \
+        if (a[n - 1] < a[mid]) \
+        { \
+            SORT_SWAP(type, a[mid], a[n - 1]); \
+            if (a[mid] < a[0]) \
+                SORT_SWAP(type, a[0], a[mid]); \
+        } \
+        pivot = a[mid]; \
+        i = -1; \
+        j = n; \
+        for (;;) \
+        { \
+            do i++; while (a[i] < pivot); \
+            do j--; while (pivot < a[j]); \
+            if (i >= j) \
+                break; \
+            SORT_SWAP(type, a[i], a[j]); \
+        } \
+        /* [0, j] and [j + 1, n), recurse into the smaller one */ \
+        if (j + 1 < n - j - 1) \
+        { \
+            name(a, j + 1, depth); \
+            a += j + 1; \
+            n -= j + 1; \
+        } \
+        else \
+        { \
+            name(a + j + 1, n - j - 1, depth); \
+            n = j + 1; \
+        } \
+    } \
+    name##_insertion(a, n); \
+}
+
+/* Whether the values are already in order, checked before the radix     */
+/* sort, which does not gain from presorted input the way introsort does. */
+#define DEFINE_IS_SORTED(name, type) \
+static int name(const type *a, int n) \
+{ \
+    int i; \
+    for (i = 1; i < n; i++) \
+    { \
+        if (a[i] < a[i - 1]) \
+            return 0; \
+    } \
+    return 1; \
+}
+
+/* Stable insertion sort of keys with a payload, for short arrays.        */
+#define DEFINE_INSERTION_INDEX(name, type) \
+static void name(type *key, int *index, int n) \
+{ \
+    int i, j, w; \
+    type v; \
+    for (i = 1; i < n; i++) \
+    { \
+        v = key[i]; \
+        w = index[i]; \
+        for (j = i; j > 0 && v < key[j - 1]; j--) \
+        { \
+            key[j] = key[j - 1]; \
+            index[j] = index[j - 1]; \
+        } \
+        key[j] = v; \
+        index[j] = w; \
+    } \
+}
+
+/* LSD radix sort of unsigned keys, a byte per pass, with an optional     */
+/* payload (index may be NULL).  Bytes where every key has the same value */
+/* are skipped.  Sorted keys end up in key, tmp_key is scratch.           */
+#define DEFINE_RADIX(name, utype) \
+static void name(utype *key, int *index, utype *tmp_key, int *tmp_index, \
+                 int n) \
+{ \
+    int count[sizeof(utype)][256]; \
+    utype *src = key, *dst = tmp_key; \
+    int *src_i = index, *dst_i = tmp_index; \
+    utype *swap_k; \
+    int *swap_i; \
+    int d, i, b, c, sum; \
+    memset(count, 0, sizeof(count)); \
+    for (i = 0; i < n; i++) \
+    { \
+        for (d = 0; d < (int)sizeof(utype); d++) \
+            count[d][(key[i] >> (8 * d)) & 0xff]++; \
+    } \
+    for (d = 0; d < (int)sizeof(utype); d++) \
+    { \
+        if (count[d][(key[0] >> (8 * d)) & 0xff] == n) \
+            continue; \
+        sum = 0; \
+        for (b = 0; b < 256; b++) \
+        { \
+            c = count[d][b]; \
+            count[d][b] = sum; \
+            sum += c; \
+        } \
+        for (i = 0; i < n; i++) \
+        { \
+            c = count[d][(src[i] >> (8 * d)) & 0xff]++; \
+            dst[c] = src[i]; \
+            if (index != NULL) \
+                dst_i[c] = src_i[i]; \
+        } \
+        swap_k = src; src = dst; dst = swap_k; \
+        swap_i = src_i; src_i = dst_i; dst_i = swap_i; \
+    } \
+    if (src != key) \
+    { \
+        memcpy(key, src, n * sizeof(utype)); \
+        if (index != NULL) \
+            memcpy(index, src_i, n * sizeof(int)); \
+    } \
+}
+
+DEFINE_INTROSORT(introsort_int, int)
+DEFINE_INTROSORT(introsort_float, float)
+DEFINE_INTROSORT(introsort_double, double)
+DEFINE_IS_SORTED(is_sorted_int, int)
+DEFINE_IS_SORTED(is_sorted_float, float)
+DEFINE_IS_SORTED(is_sorted_double, double)
+DEFINE_INSERTION_INDEX(insertion_int_index, int)
+DEFINE_INSERTION_INDEX(insertion_double_index, double)
+DEFINE_RADIX(radix_u32, uint32_t)
+DEFINE_RADIX(radix_u64, uint64_t)
+
+
+/******************************************************************************
+MODULE:  sort_depth
+
+PURPOSE:  Partition depth after which introsort switches to heapsort
+
+RETURN VALUE:
+Type = int
+Value           Description
+-----           -----------
+depth           2 floor(log2(n))
+******************************************************************************/
+static int sort_depth
+(
+    int n                   /* I: number of values                          */
+)
+{
+    int depth = 0;
+
+    while (n > 1)
+    {
+        n >>= 1;
+        depth += 2;
+    }
+
+    return depth;
+}
+
+
+/* Order preserving maps of the values to unsigned keys and back: the     */
+/* sign bit of ints is flipped; for IEEE floats the sign bit is flipped   */
+/* for positive values and all bits for negative ones.                    */
+static uint32_t int_key(int v)
+{
+    return (uint32_t)v ^ 0x80000000u;
+}
+
+static int key_int(uint32_t k)
+{
+    return (int)(k ^ 0x80000000u);
+}
+
+static uint32_t float_key(float v)
+{
+    uint32_t u;
+
+    memcpy(&u, &v, sizeof(u));
+    return (u & 0x80000000u) ? ~u : (u | 0x80000000u);
+}
+
+static float key_float(uint32_t k)
+{
+    float v;
+
+    k = (k & 0x80000000u) ? (k & 0x7fffffffu) : ~k;
+    memcpy(&v, &k, sizeof(v));
+    return v;
+}
+
+static uint64_t double_key(double v)
+{
+    uint64_t u;
+
+    memcpy(&u, &v, sizeof(u));
+    return (u >> 63) ? ~u : (u | ((uint64_t)1 << 63));
+}
+
+static double key_double(uint64_t k)
+{
+    double v;
+
+    k = (k >> 63) ? (k & ~((uint64_t)1 << 63)) : ~k;
+    memcpy(&v, &k, sizeof(v));
+    return v;
+}
+
+
+/******************************************************************************
+MODULE:  sort_int
+
+PURPOSE:  Sort ints ascending
+
+RETURN VALUE: None
+******************************************************************************/
+void sort_int
+(
+    int *arr,               /* I/O: values, sorted ascending                */
+    int n                   /* I: number of values                          */
+)
+{
+    uint32_t *key;
+    int i;
+
+    if (n > SORT_RADIX_MIN && is_sorted_int(arr, n))
+        return;
+    if (n > SORT_RADIX_MIN && (key = malloc(2 * n * sizeof(uint32_t))) != NULL)
+    {
+        for (i = 0; i < n; i++)
+            key[i] = int_key(arr[i]);
+        radix_u32(key, NULL, key + n, NULL, n);
+        for (i = 0; i < n; i++)
+            arr[i] = key_int(key[i]);
+        free(key);
+        return;
+    }
+
+    introsort_int(arr, n, sort_depth(n));
+}
+
+
+/******************************************************************************
+MODULE:  sort_float
+
+PURPOSE:  Sort floats ascending
+
+RETURN VALUE: None
+
+NOTES: The radix keys order -0.0 before 0.0, introsort leaves them as they
+       come; both are equal under <.
+******************************************************************************/
+void sort_float
+(
+    float *arr,             /* I/O: values, sorted ascending                */
+    int n                   /* I: number of values                          */
+)
+{
+    uint32_t *key;
+    int i;
+
+    if (n > SORT_RADIX_MIN && is_sorted_float(arr, n))
+        return;
+    if (n > SORT_RADIX_MIN && (key = malloc(2 * n * sizeof(uint32_t))) != NULL)
+    {
+        for (i = 0; i < n; i++)
+            key[i] = float_key(arr[i]);
+        radix_u32(key, NULL, key + n, NULL, n);
+        for (i = 0; i < n; i++)
+            arr[i] = key_float(key[i]);
+        free(key);
+        return;
+    }
+
+    introsort_float(arr, n, sort_depth(n));
+}
+
+
+/******************************************************************************
+MODULE:  sort_double
+
+PURPOSE:  Sort doubles ascending
+
+RETURN VALUE: None
+******************************************************************************/
+void sort_double
+(
+    double *arr,            /* I/O: values, sorted ascending                */
+    int n                   /* I: number of values                          */
+)
+{
+    uint64_t *key;
+    int i;
+
+    if (n > SORT_RADIX_MIN && is_sorted_double(arr, n))
+        return;
+    if (n > SORT_RADIX_MIN && (key = malloc(2 * n * sizeof(uint64_t))) != NULL)
+    {
+        for (i = 0; i < n; i++)
+            key[i] = double_key(arr[i]);
+        radix_u64(key, NULL, key + n, NULL, n);
+        for (i = 0; i < n; i++)
+            arr[i] = key_double(key[i]);
+        free(key);
+        return;
+    }
+
+    introsort_double(arr, n, sort_depth(n));
+}
+
+
+/******************************************************************************
+MODULE:  sort_int_index
+
+PURPOSE:  Stable sort of int keys, permuting a payload with them
+
+RETURN VALUE: None
+
+NOTES: Without memory for the radix buffers the insertion sort is used
+       whatever n is.
+******************************************************************************/
+void sort_int_index
+(
+    int *key,               /* I/O: keys, sorted ascending                  */
+    int *index,             /* I/O: payload, permuted with the keys         */
+    int n                   /* I: number of keys                            */
+)
+{
+    uint32_t *ukey = NULL;
+    int *tmp_index = NULL;
+    int i;
+
+    if (is_sorted_int(key, n))
+        return;
+    if (n > SORT_RADIX_MIN)
+    {
+        ukey = malloc(2 * n * sizeof(uint32_t));
+        tmp_index = malloc(n * sizeof(int));
+    }
+    if (ukey == NULL || tmp_index == NULL)
+    {
+        free(ukey);
+        free(tmp_index);
+        insertion_int_index(key, index, n);
+        return;
+    }
+
+    for (i = 0; i < n; i++)
+        ukey[i] = int_key(key[i]);
+    radix_u32(ukey, index, ukey + n, tmp_index, n);
+    for (i = 0; i < n; i++)
+        key[i] = key_int(ukey[i]);
+
+    free(ukey);
+    free(tmp_index);
+}
+
+
+/******************************************************************************
+MODULE:  sort_double_index
+
+PURPOSE:  Stable sort of double keys, permuting a payload with them
+
+RETURN VALUE: None
+
+NOTES: Without memory for the radix buffers the insertion sort is used
+       whatever n is.
+******************************************************************************/
+void sort_double_index
+(
+    double *key,            /* I/O: keys, sorted ascending                  */
+    int *index,             /* I/O: payload, permuted with the keys         */
+    int n                   /* I: number of keys                            */
+)
+{
+    uint64_t *ukey = NULL;
+    int *tmp_index = NULL;
+    int i;
+
+    if (is_sorted_double(key, n))
+        return;
+    if (n > SORT_RADIX_MIN)
+    {
+        ukey = malloc(2 * n * sizeof(uint64_t));
+        tmp_index = malloc(n * sizeof(int));
+    }
+    if (ukey == NULL || tmp_index == NULL)
+    {
+        free(ukey);
+        free(tmp_index);
+        insertion_double_index(key, index, n);
+        return;
+    }
+
+    for (i = 0; i < n; i++)
+        ukey[i] = double_key(key[i]);
+    radix_u64(ukey, index, ukey + n, tmp_index, n);
+    for (i = 0; i < n; i++)
+        key[i] = key_double(ukey[i]);
+
+    free(ukey);
+    free(tmp_index);
+}
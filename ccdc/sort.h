@@ -0,0 +1,51 @@
+#ifndef SORT_H
+#define SORT_H
+
+
+/* Sorting routines shared by ccdc and classification.  Arrays of more    */
+/* than SORT_RADIX_MIN elements are LSD radix sorted on order preserving  */
+/* unsigned keys, one pass per byte, skipping the bytes every key shares  */
+/* (dates, for example, differ only in their low bytes).  Smaller arrays, */
+/* or any array when the radix buffers cannot be allocated, go through an */
+/* introsort: median of three quicksort that switches to heapsort past    */
+/* 2 log2(n) levels and to insertion sort below SORT_INSERTION_MAX        */
+/* elements, so (nearly) sorted or adversarial input is O(n log n) with a */
+/* bounded stack.  The index sorts, which permute a payload with the      */
+/* keys, are stable: radix as above, insertion sort below SORT_RADIX_MIN. */
+/* Input already in order is returned after one pass.                     */
+#define SORT_INSERTION_MAX 16
+#define SORT_RADIX_MIN 256
+
+void sort_int
+(
+    int *arr,               /* I/O: values, sorted ascending                */
+    int n                   /* I: number of values                          */
+);
+
+void sort_float
+(
+    float *arr,             /* I/O: values, sorted ascending                */
+    int n                   /* I: number of values                          */
+);
+
+void sort_double
+(
+    double *arr,            /* I/O: values, sorted ascending                */
+    int n                   /* I: number of values                          */
+);
+
+void sort_int_index
+(
+    int *key,               /* I/O: keys, sorted ascending                  */
+    int *index,             /* I/O: payload, permuted with the keys         */
+    int n                   /* I: number of keys                            */
+);
+
+void sort_double_index
+(
+    double *key,            /* I/O: keys, sorted ascending                  */
+    int *index,             /* I/O: payload, permuted with the keys         */
+    int n                   /* I: number of keys                            */
+);
+
+#endif /* SORT_H */
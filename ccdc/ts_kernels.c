@@ -0,0 +1,396 @@
+#include <stdlib.h>
+#include <math.h>
+#include <float.h>
+
+#include "const.h"
+#include "utilities.h"
+#include "ts_kernels.h"
+#include "cpu_dispatch.h"
+#include "defines.h"
+
+
+/* The kernel bodies are written once with the band count and df as      */
+/* arguments and always inlined into the instances, which pass them as    */
+/* constants, so the band and coefficient loops have fixed trip counts.   */
+/* KERNEL_UNROLL asks for the fixed-size loop that follows to be fully    */
+/* unrolled, which -O2 alone does not do once the body has a few          */
+/* statements.                                                            */
+#if defined(__GNUC__)
+#define KERNEL_INLINE static inline __attribute__((always_inline))
+#else
+#define KERNEL_INLINE static inline
+#endif
+#if defined(__clang__) || (defined(__GNUC__) && __GNUC__ >= 8)
+#define KERNEL_UNROLL _Pragma("GCC unroll 16")
+#else
+#define KERNEL_UNROLL
+#endif
+
+/* Configurations compiled in, as (band count, df).  Band counts: 1 for   */
+/* single band fits, NUM_LAZY_BANDS (2), NUM_LASSO_BANDS (5) and          */
+/* TOTAL_IMAGE_BANDS (7) of Landsat.  Another sensor adds its band counts */
+/* here with the four df of the models.                                   */
+#define TS_KERNEL_DFS(X, nb) X(nb, 2) X(nb, 4) X(nb, 6) X(nb, 8)
+#define TS_KERNEL_CONFIGS(X) \
+            TS_KERNEL_DFS(X, 1) \
+            TS_KERNEL_DFS(X, 2) \
+            TS_KERNEL_DFS(X, 5) \
+            TS_KERNEL_DFS(X, 7)
+
+
+/******************************************************************************
+MODULE:  eval_double
+
+PURPOSE:  Model value of one band at one date, accumulated in double
+
+RETURN VALUE:
+Type = float
+Value           Description
+-----           -----------
+pred_y          predicted value
+
+NOTES: Coefficient j of the band is c[j * stride].
+******************************************************************************/
+KERNEL_INLINE float eval_double
+(
+    int df,                 /* I: number of coefficients (constant)         */
+    const float *c,         /* I: coefficients of the band                  */
+    int stride,             /* I: distance between its coefficients         */
+    float t,                /* I: date                                      */
+    const double *h         /* I: harmonic terms of the date                */
+)
+{
+    int j;
+    double pred;
+
+    pred = c[0] + c[stride] * t;
+    KERNEL_UNROLL
+    for (j = 2; j < df; j++)
+        pred += c[j * stride] * h[j - 2];
+
+    return (float)pred;
+}
+
+
+/******************************************************************************
+MODULE:  eval_single
+
+PURPOSE:  Model value of one band at one date, accumulated in float, with
+          the magnitude that bounds its rounding error
+
+RETURN VALUE:
+Type = float
+Value           Description
+-----           -----------
+pred_y          predicted value
+
+NOTES: The trend part c0 + c1 * t is float in both precisions.  The error of
+       the rest against eval_double is within FLT_EPSILON * df * mag.
+******************************************************************************/
+KERNEL_INLINE float eval_single
+(
+    int df,                 /* I: number of coefficients (constant)         */
+    const float *c,         /* I: coefficients of the band                  */
+    int stride,             /* I: distance between its coefficients         */
+    float t,                /* I: date                                      */
+    const float *hf,        /* I: float harmonic terms of the date          */
+    float *mag              /* O: sum of the magnitudes of the terms        */
+)
+{
+    int j;
+    float pred;
+    float term;
+
+    pred = c[0] + c[stride] * t;
+    *mag = fabsf(pred);
+    KERNEL_UNROLL
+    for (j = 2; j < df; j++)
+    {
+        term = c[j * stride] * hf[j - 2];
+        pred += term;
+        *mag += fabsf(term);
+    }
+
+    return pred;
+}
+
+/* A float prediction whose error bound exceeds SINGLE_PRED_TOL is redone */
+/* in double.                                                             */
+#define SINGLE_INACCURATE(df, mag) (FLT_EPSILON * (df) * (mag) > SINGLE_PRED_TOL)
+
+
+/******************************************************************************
+MODULE:  fit_resid_body
+
+PURPOSE:  Residuals and sums of squared residuals of the bands of a fit
+
+RETURN VALUE: None
+
+NOTES: In double, the same float/double operations in the same order as the
+       per band prediction and matlab_2d_array_norm, so results are
+       unchanged.  In single, the bands of an observation are redone in
+       double when one of them is inaccurate.
+******************************************************************************/
+KERNEL_INLINE void fit_resid_body
+(
+    int nb,                        /* I: number of bands (constant)          */
+    int df,                        /* I: number of coefficients (constant)   */
+    Precision_t precision,         /* I: precision (constant)                */
+    const Obs_store_t *obs,        /* I: clear observations                  */
+    const Harmonic_basis_t *basis, /* I: harmonic terms of every date        */
+    const int *band_list,          /* I: bands of the fit                    */
+    const int *idx,                /* I: observation indices                 */
+    int nums,                      /* I: number of observations              */
+    const float *cf,               /* I: [df][nb] coefficients, band lanes   */
+    float **v_dif,                 /* O: residuals of each band              */
+    float *sum                     /* O: [nb] sum of squared residuals       */
+)
+{
+    int i, k;
+    int row;                    /* basis row of the current date */
+    float t;
+    float pred_y[nb];
+    float mag, max_mag;
+    float d;
+
+    for (k = 0; k < nb; k++)
+        sum[k] = 0.0;
+
+    for (i = 0; i < nums; i++)
+    {
+        t = (float)obs->t[idx[i]];
+        row = HARMONIC_ROW(basis, obs->t[idx[i]]);
+        if (precision == PRECISION_SINGLE)
+        {
+            max_mag = 0.0;
+            KERNEL_UNROLL
+            for (k = 0; k < nb; k++)
+            {
+                pred_y[k] = eval_single(df, cf + k, nb, t,
+                                        basis->pred_terms_f[row], &mag);
+                max_mag = (mag > max_mag) ? mag : max_mag;
+            }
+        }
+        if (precision == PRECISION_DOUBLE || SINGLE_INACCURATE(df, max_mag))
+        {
+            KERNEL_UNROLL
+            for (k = 0; k < nb; k++)
+                pred_y[k] = eval_double(df, cf + k, nb, t,
+                                        basis->pred_terms[row]);
+        }
+
+        KERNEL_UNROLL
+        for (k = 0; k < nb; k++)
+        {
+            d = obs->y[band_list[k]][idx[i]] - pred_y[k];
+            v_dif[band_list[k]][i] = d;
+            sum[k] += d * d;
+        }
+    }
+}
+
+
+/******************************************************************************
+MODULE:  predict_body
+
+PURPOSE:  Model value of one band at one date
+
+RETURN VALUE:
+Type = float
+Value           Description
+-----           -----------
+pred_y          predicted value
+******************************************************************************/
+KERNEL_INLINE float predict_body
+(
+    int df,                        /* I: number of coefficients (constant)   */
+    Precision_t precision,         /* I: precision (constant)                */
+    const float *coefs,            /* I: coefficients of the band            */
+    const Harmonic_basis_t *basis, /* I: harmonic terms of every date        */
+    int date                       /* I: date                                */
+)
+{
+    int row = HARMONIC_ROW(basis, date);
+    float pred_y;
+    float mag;
+
+    if (precision == PRECISION_SINGLE)
+    {
+        pred_y = eval_single(df, coefs, 1, (float)date,
+                             basis->pred_terms_f[row], &mag);
+        if (!SINGLE_INACCURATE(df, mag))
+            return pred_y;
+    }
+
+    return eval_double(df, coefs, 1, (float)date, basis->pred_terms[row]);
+}
+
+
+/******************************************************************************
+MODULE:  predict_conse_body
+
+PURPOSE:  Residuals of the first nb bands and squared z-score norm of the
+          detection bands for CONSE window slots
+
+RETURN VALUE: None
+
+NOTES: See auto_ts_predict_conse.  In single, the bands of an observation
+       are redone in double when one of them is inaccurate.
+******************************************************************************/
+KERNEL_INLINE void predict_conse_body
+(
+    int nb,                        /* I: number of bands (constant)          */
+    int df,                        /* I: number of coefficients (constant)   */
+    Precision_t precision,         /* I: precision (constant)                */
+    const Obs_store_t *obs,        /* I: clear observations                  */
+    const Harmonic_basis_t *basis, /* I: harmonic terms of every date        */
+    float **coefs,                 /* I: coefficients of all bands           */
+    int start,                     /* I: first observation to evaluate       */
+    int nums,                      /* I: number of observations to evaluate  */
+    const int *blist,              /* I: change detection band indices       */
+    int num_blist,                 /* I: number of change detection bands    */
+    const float *blist_rmse,       /* I: z-score rmse of each detection band */
+    int slot,                      /* I: window slot of the first observation*/
+    int conse,                     /* I: number of window slots              */
+    float *vec_mag,                /* O: squared z-score norm per slot       */
+    float **v_dif_mag              /* O: residual per band per slot          */
+)
+{
+    int i, i_b, b;
+    int s;
+    int idx;                    /* observation index */
+    int row;                    /* basis row of the current date */
+    float t;
+    float pred_y[nb];
+    float mag, max_mag;
+    float z;
+    float v_dif_norm;
+
+    for (i = 0; i < nums; i++)
+    {
+        s = (slot + i) % conse;
+        idx = OBS_INDEX(obs, i+start);
+        t = (float)obs->t[idx];
+        row = HARMONIC_ROW(basis, obs->t[idx]);
+
+        if (precision == PRECISION_SINGLE)
+        {
+            max_mag = 0.0;
+            KERNEL_UNROLL
+            for (i_b = 0; i_b < nb; i_b++)
+            {
+                pred_y[i_b] = eval_single(df, coefs[i_b], 1, t,
+                                          basis->pred_terms_f[row], &mag);
+                max_mag = (mag > max_mag) ? mag : max_mag;
+            }
+        }
+        if (precision == PRECISION_DOUBLE || SINGLE_INACCURATE(df, max_mag))
+        {
+            KERNEL_UNROLL
+            for (i_b = 0; i_b < nb; i_b++)
+                pred_y[i_b] = eval_double(df, coefs[i_b], 1, t,
+                                          basis->pred_terms[row]);
+        }
+
+        KERNEL_UNROLL
+        for (i_b = 0; i_b < nb; i_b++)
+            v_dif_mag[i_b][s] = obs->y[i_b][idx] - pred_y[i_b];
+
+        v_dif_norm = 0.0;
+        for (b = 0; b < num_blist; b++)
+        {
+            z = v_dif_mag[blist[b]][s] / blist_rmse[b];
+            v_dif_norm += z * z;
+        }
+        vec_mag[s] = v_dif_norm;
+    }
+}
+
+
+/******************************************************************************
+Instances of the kernels, one set per configuration and precision, each with
+CPU variants in a release build.
+******************************************************************************/
+#define DEFINE_TS_KERNELS_P(nb, df, sfx, precision) \
+CPU_DISPATCH static void fit_resid_##nb##_##df##sfx \
+( \
+    const Obs_store_t *obs, const Harmonic_basis_t *basis, \
+    const int *band_list, const int *idx, int nums, const float *cf, \
+    float **v_dif, float *sum \
+) \
+{ \
+    fit_resid_body(nb, df, precision, obs, basis, band_list, idx, nums, cf, \
+                   v_dif, sum); \
+} \
+CPU_DISPATCH static float predict_##nb##_##df##sfx \
+( \
+    const float *coefs, const Harmonic_basis_t *basis, int date \
+) \
+{ \
+    return predict_body(df, precision, coefs, basis, date); \
+} \
+CPU_DISPATCH static void predict_conse_##nb##_##df##sfx \
+( \
+    const Obs_store_t *obs, const Harmonic_basis_t *basis, float **coefs, \
+    int start, int nums, const int *blist, int num_blist, \
+    const float *blist_rmse, int slot, int conse, float *vec_mag, \
+    float **v_dif_mag \
+) \
+{ \
+    predict_conse_body(nb, df, precision, obs, basis, coefs, start, nums, \
+                       blist, num_blist, blist_rmse, slot, conse, vec_mag, \
+                       v_dif_mag); \
+}
+
+#define DEFINE_TS_KERNELS(nb, df) \
+    DEFINE_TS_KERNELS_P(nb, df, _d, PRECISION_DOUBLE) \
+    DEFINE_TS_KERNELS_P(nb, df, _s, PRECISION_SINGLE)
+
+#define TS_KERNEL_ENTRY(nb, df) \
+    {nb, df, PRECISION_DOUBLE, fit_resid_##nb##_##df##_d, \
+     predict_##nb##_##df##_d, predict_conse_##nb##_##df##_d}, \
+    {nb, df, PRECISION_SINGLE, fit_resid_##nb##_##df##_s, \
+     predict_##nb##_##df##_s, predict_conse_##nb##_##df##_s},
+
+TS_KERNEL_CONFIGS(DEFINE_TS_KERNELS)
+
+static const Ts_kernels_t ts_kernel_table[] =
+{
+    TS_KERNEL_CONFIGS(TS_KERNEL_ENTRY)
+};
+
+
+/******************************************************************************
+MODULE:  select_ts_kernels
+
+PURPOSE:  Find the kernels specialized for a band count, df and precision
+
+RETURN VALUE:
+Type = const Ts_kernels_t *
+Value           Description
+-----           -----------
+NULL            no such configuration is compiled in
+kernels         kernels of the configuration
+
+NOTES: Called once per fit (or per df change while monitoring), not per
+       observation.
+******************************************************************************/
+const Ts_kernels_t *select_ts_kernels
+(
+    int num_bands,          /* I: bands evaluated together                  */
+    int df,                 /* I: number of model coefficients              */
+    Precision_t precision   /* I: precision policy                          */
+)
+{
+    size_t k;
+
+    for (k = 0; k < sizeof(ts_kernel_table) / sizeof(ts_kernel_table[0]); k++)
+    {
+        if (ts_kernel_table[k].num_bands == num_bands &&
+            ts_kernel_table[k].df == df &&
+            ts_kernel_table[k].precision == precision)
+            return &ts_kernel_table[k];
+    }
+
+    return NULL;
+}
@@ -0,0 +1,73 @@
+#ifndef TS_KERNELS_H
+#define TS_KERNELS_H
+
+
+#include "harmonic.h"
+#include "obs_store.h"
+
+/* Time series model kernels specialized for one band count and number of */
+/* coefficients (df).  Each instance is compiled with both as constants,  */
+/* so its band and coefficient loops are fixed size and fully unrolled,   */
+/* and the df branch is gone from the inner loops.  A fit selects its     */
+/* instance once; the configurations compiled in are listed in            */
+/* TS_KERNEL_CONFIGS (ts_kernels.c), which is where another sensor's band */
+/* count is added.  Each configuration has a double instance and a        */
+/* single precision one (twice the SIMD width), which redoes in double    */
+/* the observations whose float rounding error bound is above             */
+/* SINGLE_PRED_TOL.                                                       */
+typedef struct
+{
+    int num_bands;        /* bands evaluated together                       */
+    int df;               /* number of model coefficients                   */
+    Precision_t precision;/* float or double accumulation                   */
+
+    /* Residuals of the bands of a fit over its observations, and the sum */
+    /* of their squares per band.  cf holds the coefficients band lane by */
+    /* band lane: cf[j * num_bands + k] is coefficient j of band k.       */
+    void (*fit_resid)
+    (
+        const Obs_store_t *obs,        /* I: clear observations           */
+        const Harmonic_basis_t *basis, /* I: harmonic terms of every date */
+        const int *band_list,          /* I: bands of the fit             */
+        const int *idx,                /* I: observation indices          */
+        int nums,                      /* I: number of observations       */
+        const float *cf,               /* I: [df][num_bands] coefficients */
+        float **v_dif,                 /* O: residuals of each band       */
+        float *sum                     /* O: [num_bands] sum of squares   */
+    );
+
+    /* Model value of one band at one date. */
+    float (*predict)
+    (
+        const float *coefs,            /* I: coefficients of the band     */
+        const Harmonic_basis_t *basis, /* I: harmonic terms of every date */
+        int date                       /* I: date                         */
+    );
+
+    /* Residuals of the first num_bands bands and squared z-score norm of */
+    /* the detection bands for CONSE window slots (auto_ts_predict_conse).*/
+    void (*predict_conse)
+    (
+        const Obs_store_t *obs,        /* I: clear observations           */
+        const Harmonic_basis_t *basis, /* I: harmonic terms of every date */
+        float **coefs,                 /* I: coefficients of all bands    */
+        int start,                     /* I: first observation            */
+        int nums,                      /* I: number of observations       */
+        const int *blist,              /* I: change detection bands       */
+        int num_blist,                 /* I: number of detection bands    */
+        const float *blist_rmse,       /* I: z-score rmse of each band    */
+        int slot,                      /* I: slot of the first observation*/
+        int conse,                     /* I: number of window slots       */
+        float *vec_mag,                /* O: squared z-score norm per slot*/
+        float **v_dif_mag              /* O: residual per band per slot   */
+    );
+} Ts_kernels_t;
+
+const Ts_kernels_t *select_ts_kernels
+(
+    int num_bands,          /* I: bands evaluated together                  */
+    int df,                 /* I: number of model coefficients              */
+    Precision_t precision   /* I: precision policy                          */
+);
+
+#endif /* TS_KERNELS_H */
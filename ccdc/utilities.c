@@ -1,6 +1,9 @@
 
 #include <stdio.h>
 #include <stdlib.h>
+#include <stdarg.h>
+#include <string.h>
+#include <pthread.h>
 #include <errno.h>
 #include <time.h>
 #include <sys/types.h>
@@ -8,13 +11,226 @@
 #include <libgen.h>
 
 
+#include "const.h"
 #include "utilities.h"
 
 
+/* Run time threshold: the most verbose level written.                    */
+int log_threshold = LOG_LEVEL_WARN;
+
+/* Log stream, stdout until log_open says otherwise.                      */
+static FILE *log_fd = NULL;
+
+typedef struct
+{
+    size_t len;                   /* bytes of text waiting to be written   */
+    char text[LOG_BUFFER_SIZE];
+} Log_buffer_t;
+
+static __thread Log_buffer_t *log_buf = NULL;
+static pthread_key_t log_key;
+static pthread_once_t log_once = PTHREAD_ONCE_INIT;
+
+static const char *log_level_names[] = {"ERROR", "WARNING", "INFO", "DEBUG",
+                                        "TRACE"};
+
+
+static FILE *log_stream (void)
+{
+    return (log_fd != NULL) ? log_fd : stdout;
+}
+
+
+static void log_write_buffer (Log_buffer_t *b)
+{
+    if (b->len > 0)
+    {
+        fwrite (b->text, 1, b->len, log_stream ());
+        b->len = 0;
+    }
+}
+
+
+/* Thread exit: whatever the thread logged last still gets written.       */
+static void log_thread_exit (void *arg)
+{
+    log_write_buffer ((Log_buffer_t *) arg);
+    free (arg);
+}
+
+
+static void log_init_once (void)
+{
+    pthread_key_create (&log_key, log_thread_exit);
+    atexit (log_flush);
+}
+
+
+static Log_buffer_t *log_buffer (void)
+{
+    if (log_buf == NULL)
+    {
+        pthread_once (&log_once, log_init_once);
+        log_buf = malloc (sizeof (Log_buffer_t));
+        if (log_buf == NULL)
+            return NULL;
+        log_buf->len = 0;
+        pthread_setspecific (log_key, log_buf);
+    }
+    return log_buf;
+}
+
+
+/*****************************************************************************
+  NAME:  log_open
+
+  PURPOSE:  Sets the log stream and the run time threshold.
+
+  RETURN VALUE:  SUCCESS, or FAILURE when the log file cannot be opened
+
+  NOTES:
+      - Call it before any thread logs; the stream is not switched under
+        them.
+*****************************************************************************/
+
+int log_open
+(
+    const char *log_file,   /* I: file to append the log to, NULL or "" for */
+                            /*    default_fd                                */
+    FILE *default_fd,       /* I: log stream without a log file             */
+    int threshold           /* I: most verbose level written                */
+)
+{
+    log_flush ();
+    log_threshold = threshold;
+
+    if ((log_file == NULL) || (log_file[0] == '\0'))
+    {
+        log_fd = default_fd;
+        return SUCCESS;
+    }
+
+    log_fd = fopen (log_file, "a");
+    if (log_fd == NULL)
+    {
+        log_fd = default_fd;
+        return FAILURE;
+    }
+
+    return SUCCESS;
+}
+
+
+/*****************************************************************************
+  NAME:  log_level_from_name
+
+  PURPOSE:  Maps a --log-level= name to its LOG_LEVEL_.
+
+  RETURN VALUE:  The level, or -1 for an unknown name
+*****************************************************************************/
+
+int log_level_from_name
+(
+    const char *name        /* I: error, warn, info, debug or trace         */
+)
+{
+    if (strcmp (name, "error") == 0)
+        return LOG_LEVEL_ERROR;
+    if ((strcmp (name, "warn") == 0) || (strcmp (name, "warning") == 0))
+        return LOG_LEVEL_WARN;
+    if (strcmp (name, "info") == 0)
+        return LOG_LEVEL_INFO;
+    if (strcmp (name, "debug") == 0)
+        return LOG_LEVEL_DEBUG;
+    if (strcmp (name, "trace") == 0)
+        return LOG_LEVEL_TRACE;
+    return -1;
+}
+
+
+/*****************************************************************************
+  NAME:  log_printf
+
+  PURPOSE:  Appends a formatted message to the calling thread's log buffer.
+
+  RETURN VALUE:  None
+
+  NOTES:
+      - The buffer goes to the log stream when the next message does not
+        fit, at log_flush, at thread exit and at program exit.  Warnings
+        and errors are flushed at once, so they are not lost when the
+        caller gives up.
+      - Text is copied as is: messages that are meant to be lines end in
+        a newline, and a buffer is only ever written whole, so the lines
+        of different threads do not interleave.
+      - Callers go through the LOG_ macros, which test the level first.
+*****************************************************************************/
+
+void log_printf
+(
+    int level,              /* I: level of the message                      */
+    const char *format,     /* I: printf format of the message              */
+    ...                     /* I: its arguments                             */
+)
+{
+    Log_buffer_t *b = log_buffer ();
+    va_list ap;
+    size_t avail;
+    int n;
+
+    va_start (ap, format);
+    if (b == NULL)
+    {
+        vfprintf (log_stream (), format, ap);
+        va_end (ap);
+        return;
+    }
+
+    avail = LOG_BUFFER_SIZE - b->len;
+    n = vsnprintf (b->text + b->len, avail, format, ap);
+    va_end (ap);
+    if ((n >= 0) && ((size_t) n >= avail))
+    {
+        /* Did not fit: write what is there, and this message on its own  */
+        /* when it is larger than the whole buffer.                       */
+        log_write_buffer (b);
+        va_start (ap, format);
+        if ((size_t) n >= LOG_BUFFER_SIZE)
+            vfprintf (log_stream (), format, ap);
+        else
+            b->len = vsnprintf (b->text, LOG_BUFFER_SIZE, format, ap);
+        va_end (ap);
+    }
+    else if (n > 0)
+    {
+        b->len += n;
+    }
+
+    if (level <= LOG_LEVEL_WARN)
+        log_flush ();
+}
+
+
+/*****************************************************************************
+  NAME:  log_flush
+
+  PURPOSE:  Writes the calling thread's log buffer to the log stream.
+
+  RETURN VALUE:  None
+*****************************************************************************/
+
+void log_flush (void)
+{
+    if (log_buf != NULL)
+        log_write_buffer (log_buf);
+    fflush (log_stream ());
+}
+
+
 /*****************************************************************************
   NAME:  write_message
 
-  PURPOSE:  Writes a formatted log message to the specified file handle.
+  PURPOSE:  Writes a formatted log message to the log.
 
   RETURN VALUE:  None
 
@@ -27,32 +243,33 @@ void write_message
 (
     const char *message, /* I: message to write to the log */
     const char *module,  /* I: module the message is from */
-    const char *type,    /* I: type of the error */
+    int level,           /* I: LOG_LEVEL_ of the message */
     char *file,          /* I: file the message was generated in */
-    int line,            /* I: line number in the file where the message was
+    int line             /* I: line number in the file where the message was
                                generated */
-    FILE *fd             /* I: where to write the log message */
 )
 {
     time_t current_time;
+    struct tm tm_buf;
     struct tm *time_info;
     int year;
     pid_t pid;
 
     time (&current_time);
-    time_info = localtime (&current_time);
+    time_info = localtime_r (&current_time, &tm_buf);
     year = time_info->tm_year + 1900;
 
     pid = getpid ();
 
-    fprintf (fd, "%04d:%02d:%02d %02d:%02d:%02d %d:%s [%s]:%d [%s]:%s\n",
-             year,
-             time_info->tm_mon,
-             time_info->tm_mday,
-             time_info->tm_hour,
-             time_info->tm_min,
-             time_info->tm_sec,
-             pid, module, basename (file), line, type, message);
+    log_printf (level, "%04d:%02d:%02d %02d:%02d:%02d %d:%s [%s]:%d [%s]:%s\n",
+                year,
+                time_info->tm_mon,
+                time_info->tm_mday,
+                time_info->tm_hour,
+                time_info->tm_min,
+                time_info->tm_sec,
+                pid, module, basename (file), line, log_level_names[level],
+                message);
 }
 
 
@@ -4,38 +4,98 @@
 
 
 #include <stdio.h>
+#include <stdbool.h>
+
+
+/* Message levels, most severe first.  A message is written when its level */
+/* is at or below both the compile time floor and the run time threshold.  */
+#define LOG_LEVEL_ERROR 0
+#define LOG_LEVEL_WARN  1
+#define LOG_LEVEL_INFO  2
+#define LOG_LEVEL_DEBUG 3
+#define LOG_LEVEL_TRACE 4
+
+/* Most verbose level compiled in.  Calls past it are constant false and   */
+/* the compiler drops them with their arguments; the release target sets  */
+/* it to LOG_LEVEL_DEBUG, which erases the per scene trace calls.          */
+#ifndef CCDC_LOG_FLOOR
+#define CCDC_LOG_FLOOR LOG_LEVEL_TRACE
+#endif
+
+/* Messages are collected in a per thread buffer and written to the log    */
+/* stream a buffer at a time.  Warnings and errors flush it at once.       */
+#define LOG_BUFFER_SIZE 65536
+
+extern int log_threshold;
+
+#define LOG_ENABLED(level) \
+            ((level) <= CCDC_LOG_FLOOR && (level) <= log_threshold)
+
+#define LOG_PRINTF(level, ...) \
+            do { if (LOG_ENABLED(level)) log_printf((level), __VA_ARGS__); } \
+            while (0)
+
+#define LOG_ERROR(...) LOG_PRINTF(LOG_LEVEL_ERROR, __VA_ARGS__)
+#define LOG_WARN(...)  LOG_PRINTF(LOG_LEVEL_WARN, __VA_ARGS__)
+#define LOG_INFO(...)  LOG_PRINTF(LOG_LEVEL_INFO, __VA_ARGS__)
+#define LOG_DEBUG(...) LOG_PRINTF(LOG_LEVEL_DEBUG, __VA_ARGS__)
+#define LOG_TRACE(...) LOG_PRINTF(LOG_LEVEL_TRACE, __VA_ARGS__)
 
 
 #define LOG_MESSAGE(message, module) \
-            write_message((message), (module), "INFO", \
-                          __FILE__, __LINE__, stdout);
+           {if (LOG_ENABLED(LOG_LEVEL_INFO)) \
+                write_message((message), (module), LOG_LEVEL_INFO, \
+                              __FILE__, __LINE__);}
 
 
 #define WARNING_MESSAGE(message, module) \
-            write_message((message), (module), "WARNING", \
-                          __FILE__, __LINE__, stdout);
+           {if (LOG_ENABLED(LOG_LEVEL_WARN)) \
+                write_message((message), (module), LOG_LEVEL_WARN, \
+                              __FILE__, __LINE__);}
 
 
 #define ERROR_MESSAGE(message, module) \
-            write_message((message), (module), "ERROR", \
-                          __FILE__, __LINE__, stdout);
+            write_message((message), (module), LOG_LEVEL_ERROR, \
+                          __FILE__, __LINE__);
 
 
 #define RETURN_ERROR(message, module, status) \
-           {write_message((message), (module), "ERROR", \
-                          __FILE__, __LINE__, stdout); \
+           {write_message((message), (module), LOG_LEVEL_ERROR, \
+                          __FILE__, __LINE__); \
             return (status);}
 
 
+int log_open
+(
+    const char *log_file,   /* I: file to append the log to, NULL or "" for */
+                            /*    default_fd                                */
+    FILE *default_fd,       /* I: log stream without a log file             */
+    int threshold           /* I: most verbose level written                */
+);
+
+int log_level_from_name
+(
+    const char *name        /* I: error, warn, info, debug or trace         */
+);
+
+void log_printf
+(
+    int level,              /* I: level of the message                      */
+    const char *format,     /* I: printf format of the message              */
+    ...                     /* I: its arguments                             */
+) __attribute__ ((format (printf, 2, 3)));
+
+void log_flush (void);
+
+
 void write_message
 (
     const char *message, /* I: message to write to the log */
     const char *module,  /* I: module the message is from */
-    const char *type,    /* I: type of the error */
+    int level,           /* I: LOG_LEVEL_ of the message */
     char *file,          /* I: file the message was generated in */
-    int line,            /* I: line number in the file where the message was
+    int line             /* I: line number in the file where the message was
                                generated */
-    FILE * fd            /* I: where to write the log message */
 );
 
 
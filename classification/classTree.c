@@ -145,6 +145,8 @@ void F77_NAME(catmaxb)
             tclasscat[i * *nclass] / catCount[i] : 0.0;
         kcat[i] = i + 1;
     }
+    /* At most 32 categories; R's quicksort is kept because the order it
+       leaves categories of equal proportion in decides ties of the split. */
     R_qsort_I(catProportion, kcat, 1, *nCat);
     for (i = 0; i < *nclass; ++i) {
         cp[i] = 0;
@@ -188,6 +190,7 @@ void F77_NAME(catmaxb)
 
 
 
+CPU_DISPATCH
 void predictClassTree(double *x, int n, int mdim, int *treemap,
 		      int *nodestatus, double *xbestsplit,
 		      int *bestvar, int *nodeclass,
@@ -20,6 +20,7 @@ Date        Programmer       Reason
 
 #include "classification.h"
 #include "utilities.h"
+#include "rf.h"
 #include "matio.h"
 
 int main(int argc, char *argv[])
@@ -54,6 +55,9 @@ int main(int argc, char *argv[])
     {
         RETURN_ERROR ("calling get_args", FUNC_NAME, EXIT_FAILURE);
     }
+    snprintf (msg_str, sizeof(msg_str),
+              "CPU kernel variant=%s\n", cpu_dispatch_variant());
+    LOG_MESSAGE (msg_str, FUNC_NAME);
 
     /* Allocate memory */
     x = malloc(rows * cols * sizeof(double));
@@ -40,6 +40,9 @@ void classRF(double *x, int *dimx, int *cl, int *ncl, int *cat, int *maxcat,
 	int *outclts, int *labelts, double *proxts, double *errts);
 */
 
+/* Runtime CPU dispatch of ccdc, CPU_DISPATCH and cpu_dispatch_variant */
+#include "cpu_dispatch.h"
+
 #define F77_CALL(x) x ## _
 #define F77_NAME(x) F77_CALL(x)
 #define F77_SUB(x) F77_CALL(x)
@@ -16,6 +16,7 @@
 #include "memory.h"
 #include "stdlib.h"
 #include "qsort.c"
+#include "sort.h"
 
 #define MAX_UINT_COKUS 4294967295  //basically 2^32-1
 
@@ -84,7 +85,7 @@ void makeA(double *x, const int mdim, const int nsample, int *cat, int *a,
                 v[j] = x[i + j * mdim];
                 index[j] = j + 1;
             }
-            R_qsort_I(v, index, 1, nsample);
+            sort_double_index(v, index, nsample);
 
             /*  this sorts the v(n) in ascending order. index(n) is the case 
                 number of that v(n) nth from the lowest (assume the original 